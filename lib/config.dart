@@ -170,6 +170,18 @@ class Config {
   /// redirected.
   static bool redirectStdOut = true;
 
+  /// Size in bytes of the redirected `stdout` and `stderr` log file to rotate
+  /// it after, or `0` to never rotate.
+  static int logRotateSize = 16 * 1024 * 1024;
+
+  /// Amount of the rotated `stdout` and `stderr` log files to keep.
+  static int logRotateCount = 5;
+
+  /// Compression to apply to the rotated `stdout` and `stderr` log files.
+  ///
+  /// Either `none`, `gzip` or `zstd`.
+  static String logRotateCompression = 'gzip';
+
   /// [UserId] of the [User]-support.
   static String supportId = 'gapopa';
 
@@ -309,6 +321,20 @@ class Config {
         ? const bool.fromEnvironment('SOCAPP_LOG_REDIRECT_STDOUT')
         : (document['log']?['redirect_stdout'] ?? true);
 
+    logRotateSize = const bool.hasEnvironment('SOCAPP_LOG_ROTATE_SIZE')
+        ? const int.fromEnvironment('SOCAPP_LOG_ROTATE_SIZE')
+        : (document['log']?['rotate']?['size'] ?? logRotateSize);
+
+    logRotateCount = const bool.hasEnvironment('SOCAPP_LOG_ROTATE_COUNT')
+        ? const int.fromEnvironment('SOCAPP_LOG_ROTATE_COUNT')
+        : (document['log']?['rotate']?['count'] ?? logRotateCount);
+
+    logRotateCompression =
+        const bool.hasEnvironment('SOCAPP_LOG_ROTATE_COMPRESSION')
+        ? const String.fromEnvironment('SOCAPP_LOG_ROTATE_COMPRESSION')
+        : (document['log']?['rotate']?['compression'] ??
+              logRotateCompression);
+
     try {
       final dynamic announcementsOrNull = document['announcement'];
       if (announcementsOrNull is Map<String, dynamic>) {
@@ -25,6 +25,7 @@ import 'package:uuid/uuid.dart';
 
 import '/ui/worker/cache.dart';
 import '/util/new_type.dart';
+import '/util/pause_token.dart';
 import '/util/platform_utils.dart';
 import 'file.dart';
 import 'native_file.dart';
@@ -261,6 +262,15 @@ class LocalAttachment extends Attachment {
   @JsonKey(includeToJson: false, includeFromJson: false)
   final CancelToken cancelToken = CancelToken();
 
+  /// [PauseToken] used to pause and resume the uploading of this
+  /// [LocalAttachment].
+  @JsonKey(includeToJson: false, includeFromJson: false)
+  final PauseToken pauseToken = PauseToken();
+
+  /// Indicator whether the [upload] is paused.
+  @JsonKey(includeToJson: false, includeFromJson: false)
+  final RxBool isPaused = RxBool(false);
+
   /// Upload progress of this [LocalAttachment].
   final Rx<double> progress = Rx(0);
 
@@ -273,9 +283,29 @@ class LocalAttachment extends Attachment {
   /// Indicator whether the [upload] was canceled.
   bool get isCanceled => cancelToken.isCancelled;
 
+  /// Indicates whether the [upload] may be paused, as only the files on the
+  /// disk streamed natively on Linux may be.
+  bool get isPausable =>
+      PlatformUtils.isLinux && !PlatformUtils.isWeb && file.path != null;
+
   /// Cancels the uploading of this [LocalAttachment].
   void cancelUpload() => cancelToken.cancel();
 
+  /// Pauses the uploading of this [LocalAttachment], if [isPausable].
+  void pauseUpload() {
+    if (isPausable) {
+      pauseToken.pause();
+      isPaused.value = true;
+    }
+  }
+
+  /// Resumes the uploading of this [LocalAttachment] paused by the
+  /// [pauseUpload].
+  void resumeUpload() {
+    pauseToken.resume();
+    isPaused.value = false;
+  }
+
   /// Returns a [Map] representing this [LocalAttachment].
   @override
   Map<String, dynamic> toJson() =>
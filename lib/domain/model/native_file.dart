@@ -115,6 +115,13 @@ class NativeFile {
   @JsonKey(includeFromJson: false, includeToJson: false)
   final Rx<ui.Size?> dimensions;
 
+  /// Path to a downscaled preview of the image this [NativeFile] represents,
+  /// if any is created.
+  ///
+  /// Intended to be displayed instead of decoding the whole [bytes].
+  @JsonKey(includeFromJson: false, includeToJson: false)
+  final Rx<String?> preview = Rx(null);
+
   /// [Mutex] for synchronized access to the [readFile].
   final Mutex _readGuard = Mutex();
 
@@ -244,7 +251,7 @@ class NativeFile {
 
   /// Converts the [NativeFile] to a [MultipartFile].
   Future<dio.MultipartFile> toMultipartFile() async {
-    final String filename = _resolveFilename();
+    final String filename = resolveFilename();
 
     if (path != null) {
       return await dio.MultipartFile.fromFile(
@@ -277,7 +284,7 @@ class NativeFile {
   }
 
   /// Returns a valid filename, using timestamp if the original name is empty.
-  String _resolveFilename() {
+  String resolveFilename() {
     final String result = name.trim();
     if (result.isNotEmpty) return result;
 
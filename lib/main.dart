@@ -16,6 +16,7 @@
 // <https://www.gnu.org/licenses/agpl-3.0.html>.
 
 import 'dart:async';
+import 'dart:developer' show Timeline;
 
 import 'package:app_links/app_links.dart';
 import 'package:firebase_core/firebase_core.dart';
@@ -88,7 +89,9 @@ Future<void> main() async {
     () async {
       final Stopwatch watch = Stopwatch()..start();
 
+      final int started = Timeline.now;
       await Config.init();
+      _traceStartup('Config.init', started);
 
       me.Log.options = me.LogOptions(
         level: Config.logLevel,
@@ -107,7 +110,11 @@ Future<void> main() async {
                 Log.warning('Unable to `MacosUtils.redirectStdOut()` -> $e'),
           );
         } else if (PlatformUtils.isLinux) {
-          LinuxUtils.redirectStdOut().onError(
+          LinuxUtils.redirectStdOut(
+            maxSize: Config.logRotateSize,
+            maxFiles: Config.logRotateCount,
+            compression: Config.logRotateCompression,
+          ).onError(
             (e, _) =>
                 Log.warning('Unable to `LinuxUtils.redirectStdOut()` -> $e'),
           );
@@ -230,6 +237,8 @@ Future<void> main() async {
 
 /// Initializes the dependencies and runs the [App].
 Future<void> _runApp() async {
+  int phase = Timeline.now;
+
   WebUtils.registerWith();
 
   fvp.registerWith(
@@ -290,6 +299,7 @@ Future<void> _runApp() async {
 
   final credentialsProvider = Get.put(CredentialsDriftProvider(Get.find()));
   await credentialsProvider.init();
+  phase = _traceStartup('providers', phase);
 
   if (PlatformUtils.isDesktop && !PlatformUtils.isWeb) {
     await windowManager.ensureInitialized();
@@ -313,6 +323,7 @@ Future<void> _runApp() async {
     WebUtils.ensureIsrgCertificate().onError((_, _) => false);
 
     Get.put(WindowWorker(preferences));
+    phase = _traceStartup('windowManager', phase);
   }
 
   final graphQlProvider = Get.put(GraphQlProvider());
@@ -347,6 +358,27 @@ Future<void> _runApp() async {
     initial: initial == null ? null : RouteInformation(uri: initial),
   );
 
+  // Subscribed after the [router] is assigned, as the arguments forwarded
+  // before are replayed right away.
+  if (PlatformUtils.isLinux && !PlatformUtils.isWeb) {
+    _argumentsSubscription?.cancel();
+    _argumentsSubscription = LinuxUtils.arguments.listen((arguments) async {
+      Log.debug('arguments -> $arguments', 'LinuxUtils');
+
+      for (var e in arguments) {
+        final Uri? uri = Uri.tryParse(e);
+        if (uri != null && uri.hasScheme) {
+          router.delegate.setNewRoutePath(
+            await router.parser.parseRouteInformation(
+              RouteInformation(uri: uri),
+            ),
+          );
+          break;
+        }
+      }
+    });
+  }
+
   try {
     PWAInstall().setup(
       installCallback: () {
@@ -359,6 +391,8 @@ Future<void> _runApp() async {
   }
 
   await authService.init();
+  phase = _traceStartup('authService.init', phase);
+
   await L10n.init();
 
   Get.put(
@@ -373,8 +407,30 @@ Future<void> _runApp() async {
   Get.put(AudioWorker());
 
   WebUtils.deleteLoader();
+  phase = _traceStartup('workers', phase);
 
   runApp(App(key: UniqueKey()));
+
+  if (PlatformUtils.isLinux && !PlatformUtils.isWeb) {
+    WidgetsBinding.instance.waitUntilFirstFrameRasterized.then((_) {
+      _traceStartup('runApp', phase);
+      LinuxUtils.writeStartupTrace();
+    });
+  }
+}
+
+/// Records the startup phase [name] lasted from the [start] till now into the
+/// native startup trace on Linux.
+///
+/// Returns the end of the phase to start the next one at.
+int _traceStartup(String name, int start) {
+  final int end = Timeline.now;
+
+  if (PlatformUtils.isLinux && !PlatformUtils.isWeb) {
+    LinuxUtils.traceStartup(name, start, end);
+  }
+
+  return end;
 }
 
 /// Initializes the [FlutterCallkitIncoming] and displays an incoming call
@@ -698,3 +754,6 @@ class App extends StatelessWidget {
 
 /// [AppLinks.uriLinkStream] subscription.
 StreamSubscription? _linkSubscription;
+
+/// [LinuxUtils.arguments] subscription.
+StreamSubscription? _argumentsSubscription;
@@ -62,6 +62,27 @@ class ChatItemDriftProvider extends DriftProviderBaseWithScope {
   /// [DtoChatItem]s that have started the [upsert]ing, but not yet finished it.
   final Map<ChatItemId, DtoChatItem> _cache = {};
 
+  /// [Duration] of the [upsert]s inactivity to wait for before indexing the
+  /// [DtoChatItem]s for the text search.
+  static const Duration _indexingDelay = Duration(seconds: 2);
+
+  /// [Timer] indexing the [DtoChatItem]s for the text search.
+  Timer? _indexingTimer;
+
+  @override
+  void onInit() {
+    _scheduleIndexing();
+    super.onInit();
+  }
+
+  @override
+  void onClose() {
+    _indexingTimer?.cancel();
+    _indexingTimer = null;
+
+    super.onClose();
+  }
+
   /// Creates or updates the a view for the provided [chatItemId] in [chatId].
   Future<void> upsertView(ChatId chatId, ChatItemId chatItemId) async {
     Log.debug('upsertView($chatId, $chatItemId)', '$runtimeType');
@@ -103,6 +124,8 @@ class ChatItemDriftProvider extends DriftProviderBaseWithScope {
       return stored;
     }, tag: 'chat_item.upsert(item, toView: $toView)');
 
+    _scheduleIndexing();
+
     return result ?? item;
   }
 
@@ -140,6 +163,8 @@ class ChatItemDriftProvider extends DriftProviderBaseWithScope {
       return items.toList();
     }, tag: 'chat_item.upsertBulk(${items.length} items, toView: $toView)');
 
+    _scheduleIndexing();
+
     return result ?? items;
   }
 
@@ -217,6 +242,25 @@ class ChatItemDriftProvider extends DriftProviderBaseWithScope {
     }, tag: 'chat_item.clear()');
   }
 
+  /// Schedules the [DtoChatItem]s pending to be indexed for the text search to
+  /// be indexed once the [upsert]s settle.
+  void _scheduleIndexing() {
+    _indexingTimer?.cancel();
+    _indexingTimer = Timer(_indexingDelay, () async {
+      _indexingTimer = null;
+
+      final int? indexed = await safe(
+        (db) => db.indexChatItems(),
+        tag: 'chat_item.indexChatItems()',
+      );
+
+      // Proceed with the rest, if not everything was indexed at once.
+      if (indexed != null && indexed > 0 && !isClosed) {
+        _scheduleIndexing();
+      }
+    });
+  }
+
   /// Returns the [DtoChatItem]s being in a historical view order of the
   /// provided [chatId].
   Future<List<DtoChatItem>> view(
@@ -262,7 +306,14 @@ class ChatItemDriftProvider extends DriftProviderBaseWithScope {
 
         stmt.where(db.chatItemViews.chatId.equals(chatId.val));
         if (withText != null) {
-          stmt.where(db.chatItems.data.like('%"text":"%$withText%"%'));
+          final String pattern = '%"text":"%$withText%"%';
+          final String? match = db.matchChatItems(withText.val, pattern);
+
+          if (match == null) {
+            stmt.where(db.chatItems.data.like(pattern));
+          } else {
+            stmt.where(CustomExpression<bool>(match));
+          }
         }
 
         stmt.orderBy([OrderingTerm.desc(db.chatItems.at)]);
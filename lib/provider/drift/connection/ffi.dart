@@ -15,6 +15,7 @@
 // along with this program. If not, see
 // <https://www.gnu.org/licenses/agpl-3.0.html>.
 
+import 'dart:ffi';
 import 'dart:io';
 
 import 'package:drift/drift.dart';
@@ -55,13 +56,48 @@ QueryExecutor connect([UserId? userId]) {
     // Explicitly tell it about the correct temporary directory.
     sqlite3.tempDirectory = cache;
 
+    if (PlatformUtils.isLinux) {
+      _registerExtension();
+    }
+
+    // Free pages are released by the native maintenance on Linux, which only
+    // takes effect for the newly created databases.
+    final bool incremental = PlatformUtils.isLinux;
+
     return NativeDatabase.createInBackground(
       file,
-      setup: (db) => db.execute('PRAGMA journal_mode = wal'),
+      setup: (db) {
+        if (incremental) {
+          db.execute('PRAGMA auto_vacuum = INCREMENTAL');
+        }
+
+        // Wait for the checkpoints and other writers instead of failing.
+        db.execute('PRAGMA busy_timeout = 1000');
+        db.execute('PRAGMA journal_mode = wal');
+      },
     );
   });
 }
 
+/// Registers the SQLite extension exported by the Linux runner for every
+/// database opened afterwards, if not registered already.
+///
+/// The extension provides the `messenger` FTS5 tokenizer used by the full-text
+/// search over the `ChatItems`, which falls back to the `LIKE` queries, if it
+/// isn't registered, and maintains the WAL of the databases.
+void _registerExtension() {
+  try {
+    sqlite3.ensureExtensionLoaded(
+      SqliteExtension.inLibrary(
+        DynamicLibrary.executable(),
+        'messenger_sqlite3_init',
+      ),
+    );
+  } catch (e) {
+    Log.warning('Unable to register the SQLite extension: $e', 'connect()');
+  }
+}
+
 /// Obtains an in-memory database connection for running `drift`.
 QueryExecutor inMemory() {
   return NativeDatabase.memory();
@@ -306,9 +306,38 @@ class ScopedDatabase extends _$ScopedDatabase {
   /// [UserId] this [ScopedDatabase] is linked to.
   final UserId userId;
 
+  /// Indicator whether the full-text search index of the [ChatItems] is
+  /// available, meaning the [searchTokenizer] is registered.
+  bool searchable = false;
+
+  /// FTS5 tokenizer the full-text search index of the [ChatItems] is created
+  /// with.
+  ///
+  /// Tests replace it with a built-in one, as the `messenger` tokenizer is
+  /// only registered by the Linux runner.
+  @visibleForTesting
+  static String searchTokenizer = 'messenger';
+
   /// Indicator whether this database has been already closed.
   bool _closed = false;
 
+  /// SQL expression of the text to index of the `chat_items` [row].
+  static String _searchedText(String row) =>
+      'coalesce('
+      "json_extract($row.data, '\$.value.text'), "
+      "json_extract($row.data, '\$.value.quote.text')"
+      ')';
+
+  /// SQL statement removing the `old` row of the `chat_items` from the search
+  /// index, unless it's not indexed yet.
+  static final String _unindexOld =
+      ''
+      'INSERT INTO chat_items_fts(chat_items_fts, rowid, text) '
+      "SELECT 'delete', old.rowid, t "
+      "FROM (SELECT ${_searchedText('old')} AS t) "
+      'WHERE t IS NOT NULL AND NOT EXISTS '
+      '(SELECT 1 FROM chat_items_fts_pending WHERE item = old.rowid);';
+
   @override
   int get schemaVersion => Config.scopedVersion;
 
@@ -390,10 +419,166 @@ class ScopedDatabase extends _$ScopedDatabase {
         } catch (e) {
           Log.error('Custom SQL statement has failed: $e', '$runtimeType');
         }
+
+        if (PlatformUtils.isLinux && !PlatformUtils.isWeb) {
+          await _createSearchIndex();
+        }
       },
     );
   }
 
+  /// Indexes up to the [count] of the most recent [ChatItems] pending to be
+  /// added to the full-text search index.
+  ///
+  /// Returns the number of the [ChatItems] indexed.
+  Future<int> indexChatItems([int count = 5000]) async {
+    if (!searchable) {
+      return 0;
+    }
+
+    return await transaction(() async {
+      final String pending =
+          'SELECT item FROM chat_items_fts_pending '
+          'ORDER BY item DESC LIMIT $count';
+
+      await customStatement(
+        ''
+        'INSERT INTO chat_items_fts(rowid, text) '
+        'SELECT item, t FROM '
+        '(SELECT item, ${_searchedText('chat_items')} AS t '
+        'FROM ($pending) CROSS JOIN chat_items ON chat_items.rowid = item) '
+        'WHERE t IS NOT NULL;',
+      );
+
+      return await customUpdate(
+        'DELETE FROM chat_items_fts_pending WHERE item IN ($pending);',
+      );
+    });
+  }
+
+  /// Returns the SQL condition matching the `chat_items` containing the words
+  /// starting with the ones of the provided [query], or `null`, if the search
+  /// index isn't [searchable].
+  ///
+  /// [ChatItems] not indexed yet are matched with a `LIKE` [pattern] instead,
+  /// the same way as all of them are without the index. Note, that these
+  /// match differently: the index matches only the beginnings of the words,
+  /// folding their case and diacritics, so "meet" matches "Meeting" and
+  /// "reunion" matches "Reunión", while `LIKE` matches any substring, folding
+  /// the case of ASCII letters only, so "eting" matches "Meeting", but
+  /// "reunion" doesn't match "Reunión". Such [ChatItems] stay pending only
+  /// until the next [indexChatItems], so the results converge to the ones of
+  /// the index.
+  String? matchChatItems(String query, String pattern) {
+    if (!searchable) {
+      return null;
+    }
+
+    final Iterable<String> words = query
+        .split(RegExp(r'\s+'))
+        .where((e) => e.isNotEmpty)
+        .map((e) => '"${e.replaceAll('"', '""')}"*');
+
+    if (words.isEmpty) {
+      return null;
+    }
+
+    String literal(String value) => "'${value.replaceAll("'", "''")}'";
+
+    return ''
+        '(chat_items.rowid IN (SELECT rowid FROM chat_items_fts '
+        'WHERE chat_items_fts MATCH ${literal(words.join(' '))}) OR '
+        '(chat_items.rowid IN (SELECT item FROM chat_items_fts_pending) AND '
+        'chat_items.data LIKE ${literal(pattern)}))';
+  }
+
+  /// Creates the full-text search index of the [ChatItems], if it doesn't
+  /// exist, along with the triggers maintaining it.
+  ///
+  /// The index is a contentless FTS5 table, while the triggers only queue the
+  /// new [ChatItems] to be indexed in batches by [indexChatItems], as indexing
+  /// within every statement is several times slower.
+  ///
+  /// Drops the triggers, if the [searchTokenizer] isn't registered, so the
+  /// [ChatItems] are still written, and queues all of them to be indexed again
+  /// once the triggers are created.
+  Future<void> _createSearchIndex() async {
+    const List<String> triggers = [
+      'chat_items_fts_insert',
+      'chat_items_fts_delete',
+      'chat_items_fts_update',
+    ];
+
+    try {
+      await customStatement(
+        ''
+        'CREATE VIRTUAL TABLE IF NOT EXISTS chat_items_fts USING fts5('
+        "text, content='', tokenize='$searchTokenizer', prefix='2 3');",
+      );
+
+      // Fails, if the table exists, but the tokenizer isn't registered.
+      await customSelect('SELECT rowid FROM chat_items_fts LIMIT 0;').get();
+
+      final bool exists = (await customSelect(
+        "SELECT 1 FROM sqlite_master WHERE type = 'trigger' AND name = ?;",
+        variables: [Variable.withString(triggers.last)],
+      ).get()).isNotEmpty;
+
+      if (!exists) {
+        await customStatement(
+          ''
+          'CREATE TABLE IF NOT EXISTS chat_items_fts_pending '
+          '(item INTEGER PRIMARY KEY);',
+        );
+
+        await customStatement(
+          "INSERT INTO chat_items_fts(chat_items_fts) VALUES ('delete-all');",
+        );
+        await customStatement(
+          ''
+          'INSERT OR IGNORE INTO chat_items_fts_pending '
+          'SELECT rowid FROM chat_items;',
+        );
+
+        await customStatement(
+          ''
+          'CREATE TRIGGER IF NOT EXISTS ${triggers[0]} '
+          'AFTER INSERT ON chat_items BEGIN '
+          'INSERT OR IGNORE INTO chat_items_fts_pending VALUES (new.rowid); '
+          'END;',
+        );
+        await customStatement(
+          ''
+          'CREATE TRIGGER IF NOT EXISTS ${triggers[1]} '
+          'AFTER DELETE ON chat_items BEGIN '
+          '$_unindexOld '
+          'DELETE FROM chat_items_fts_pending WHERE item = old.rowid; '
+          'END;',
+        );
+
+        // Created the last, as its existence indicates the rest are created.
+        await customStatement(
+          ''
+          'CREATE TRIGGER IF NOT EXISTS ${triggers[2]} '
+          'AFTER UPDATE OF data ON chat_items '
+          "WHEN ${_searchedText('old')} IS NOT ${_searchedText('new')} BEGIN "
+          '$_unindexOld '
+          'INSERT OR IGNORE INTO chat_items_fts_pending VALUES (new.rowid); '
+          'END;',
+        );
+      }
+
+      searchable = true;
+    } catch (e) {
+      Log.warning('Unable to create the search index: $e', '$runtimeType');
+
+      searchable = false;
+      for (var e in triggers) {
+        await customStatement('DROP TRIGGER IF EXISTS $e;');
+      }
+    }
+  }
+
   /// Creates all tables, triggers, views, indexes and everything else defined
   /// in the database, if they don't exist.
   Future<void> create() async {
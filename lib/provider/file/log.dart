@@ -16,11 +16,13 @@
 // <https://www.gnu.org/licenses/agpl-3.0.html>.
 
 import 'dart:async';
+import 'dart:convert';
 
 import 'package:get/get.dart';
 import 'package:universal_io/io.dart';
 
 import '/pubspec.g.dart';
+import '/util/linux_utils.dart';
 import '/util/log.dart';
 import '/util/platform_utils.dart';
 import '/util/web/web_utils.dart';
@@ -33,9 +35,28 @@ class LogFileProvider extends DisposableInterface {
   /// [IOSink] of a [_file] opened for writing.
   IOSink? _sink;
 
-  /// [LogEntry]ies that were [write]en while [_sink] wasn't available.
+  /// [LogEntry]ies that were [write]en while [_sink] wasn't available, or
+  /// weren't yet sent to the native sink.
   final List<LogEntry> _buffer = [];
 
+  /// Indicator whether the native [LinuxUtils] sink is used to write the
+  /// [LogEntry]ies instead of the [_sink].
+  bool _native = false;
+
+  /// [Timer] sending the [_buffer] to the native sink.
+  Timer? _batchTimer;
+
+  /// Maximum amount of [LogEntry]ies to send to the native sink at once.
+  static const int _batchSize = 512;
+
+  /// [Duration] to accumulate [LogEntry]ies for before sending them to the
+  /// native sink.
+  static const Duration _batchDelay = Duration(milliseconds: 500);
+
+  /// Size in bytes of the [File], after exceeding which it should be started
+  /// over.
+  static const int _truncateAt = 64 * 1024 * 1024; // 64 MB.
+
   /// Returns the [File] to write [LogEntry] to.
   File? get file => _file;
 
@@ -51,6 +72,14 @@ class LogFileProvider extends DisposableInterface {
   void onClose() {
     Log.debug('onClose()', '$runtimeType');
 
+    _batchTimer?.cancel();
+    _batchTimer = null;
+
+    if (_native) {
+      _native = false;
+      _send().whenComplete(() => LinuxUtils.closeLogs().onError((_, _) {}));
+    }
+
     _buffer.clear();
     _sink?.close();
     _sink = null;
@@ -61,6 +90,18 @@ class LogFileProvider extends DisposableInterface {
 
   /// Writes the [entry] to a [File].
   void write(LogEntry entry) {
+    if (_native) {
+      _buffer.add(entry);
+
+      if (_buffer.length >= _batchSize) {
+        _send();
+      } else {
+        _batchTimer ??= Timer(_batchDelay, _send);
+      }
+
+      return;
+    }
+
     if (_sink == null) {
       return _buffer.add(entry);
     }
@@ -70,9 +111,20 @@ class LogFileProvider extends DisposableInterface {
 
   /// Returns a [FileStat] of the currently opened logs [File], if any.
   Future<FileStat?> stat() async {
+    await flush();
     return await _file?.stat();
   }
 
+  /// Flushes the written [LogEntry]ies to the [File], so that it can be read.
+  Future<void> flush() async {
+    if (_native) {
+      await _send();
+      await LinuxUtils.flushLogs();
+    } else {
+      await _sink?.flush();
+    }
+  }
+
   /// Opens the [_file] and appends the initial payload.
   Future<void> _open() async {
     final FutureOr<Directory> futureOrTemp = PlatformUtils.temporaryDirectory;
@@ -81,12 +133,36 @@ class LogFileProvider extends DisposableInterface {
         : futureOrTemp;
 
     _file = File('${temp.path}/report.log');
+
+    if (PlatformUtils.isLinux && !PlatformUtils.isWeb) {
+      try {
+        final int size = await LinuxUtils.openLogs(
+          _file!.path,
+          truncateAt: _truncateAt,
+        );
+
+        Log.debug(
+          '_open() -> native, size(${size ~/ 1024} KB, logs will be placed at `${_file?.path}`',
+          '$runtimeType',
+        );
+
+        await LinuxUtils.appendLogs(utf8.encode('${_header()}\n'));
+
+        _native = true;
+        _send();
+
+        return;
+      } catch (e) {
+        Log.warning('_open() -> native sink failed: $e', '$runtimeType');
+      }
+    }
+
     final FileStat? stat = await _file?.stat();
     final int size = stat?.size ?? 0;
 
     _sink = _file?.openWrite(
       mode: switch (size) {
-        >= 64 * 1024 * 1024 => FileMode.writeOnly, // 64 MB.
+        >= _truncateAt => FileMode.writeOnly,
         (_) => FileMode.writeOnlyAppend,
       },
     );
@@ -96,7 +172,37 @@ class LogFileProvider extends DisposableInterface {
       '$runtimeType',
     );
 
-    _sink?.writeln('''\n
+    _sink?.writeln(_header());
+
+    _sink?.writeAll(_buffer, '\n');
+    _buffer.clear();
+  }
+
+  /// Sends the [_buffer] to the native sink in a single batch.
+  Future<void> _send() async {
+    _batchTimer?.cancel();
+    _batchTimer = null;
+
+    if (_buffer.isEmpty) {
+      return;
+    }
+
+    final StringBuffer batch = StringBuffer();
+    for (var e in _buffer) {
+      batch.writeln(e);
+    }
+    _buffer.clear();
+
+    try {
+      await LinuxUtils.appendLogs(utf8.encode(batch.toString()));
+    } catch (e) {
+      // No-op, as logging the failure would schedule another batch.
+    }
+  }
+
+  /// Returns the payload to write to the [File] when it's opened.
+  String _header() {
+    return '''\n
 ================ Launch ================
 
 Created at: ${DateTime.now().toUtc()}
@@ -104,9 +210,6 @@ Application: ${Pubspec.ref}
 Is PWA: ${WebUtils.isPwa}
 
 ========================================
-      ''');
-
-    _sink?.writeAll(_buffer, '\n');
-    _buffer.clear();
+      ''';
   }
 }
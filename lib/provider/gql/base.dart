@@ -16,12 +16,21 @@
 // <https://www.gnu.org/licenses/agpl-3.0.html>.
 
 import 'dart:async';
+import 'dart:convert';
+import 'dart:typed_data';
 
 import 'package:async/async.dart' show StreamGroup;
 import 'package:dio/dio.dart'
     as dio
-    show DioException, Options, Response, DioExceptionType, CancelToken;
+    show
+        DioException,
+        Options,
+        Response,
+        DioExceptionType,
+        CancelToken,
+        RequestOptions;
 import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart' show PlatformException;
 import 'package:get/get.dart';
 import 'package:graphql/client.dart';
 import 'package:http/http.dart';
@@ -34,7 +43,9 @@ import 'package:web_socket_channel/web_socket_channel.dart';
 import '/config.dart';
 import '/domain/model/session.dart';
 import '/store/model/version.dart';
+import '/util/linux_utils.dart';
 import '/util/log.dart';
+import '/util/pause_token.dart';
 import '/util/platform_utils.dart';
 import '/util/rate_limiter.dart';
 import '/util/web/web_utils.dart';
@@ -77,6 +88,111 @@ class GraphQlProviderBase extends DisposableInterface {
     super.onClose();
   }
 
+  /// Makes an HTTP POST request of the `multipart/form-data` with the [fields]
+  /// followed by the file at the [path] uploaded natively by the
+  /// [LinuxUtils.upload], so it's never read into the memory.
+  ///
+  /// [onChecksum] is invoked with the SHA-256 checksum of the file computed
+  /// while uploading it, once it's uploaded.
+  ///
+  /// Intended to be used on Linux only. Failures are thrown as the
+  /// [dio.DioException]s the same way the [post] does.
+  Future<dio.Response> upload(
+    String path, {
+    required Map<String, String> fields,
+    String field = 'file',
+    String? filename,
+    String? contentType,
+    String? operationName,
+    Exception Function(Map<String, dynamic>)? onException,
+    void Function(int, int)? onSendProgress,
+    void Function(String checksum)? onChecksum,
+    dio.CancelToken? cancelToken,
+    PauseToken? pauseToken,
+  }) {
+    return _middleware(() async {
+      return await _transaction(operationName, () async {
+        final String url = '${Config.url}:${Config.port}${Config.graphql}';
+        final dio.RequestOptions request = dio.RequestOptions(
+          path: url,
+          method: 'POST',
+        );
+
+        try {
+          final NativeUpload upload = await LinuxUtils.upload(
+            url,
+            path,
+            field: field,
+            filename: filename,
+            contentType: contentType,
+            fields: fields,
+            headers: {
+              'Authorization': 'Bearer $token',
+              'User-Agent': await PlatformUtils.userAgent,
+            },
+            onProgress: onSendProgress,
+            cancelToken: cancelToken,
+            pauseToken: pauseToken,
+          );
+
+          Log.debug(
+            'upload($path) -> ${upload.mime} of ${upload.size} bytes with '
+            '${upload.sha256} SHA-256',
+            '$runtimeType',
+          );
+
+          onChecksum?.call(upload.sha256);
+
+          return dio.Response(
+            requestOptions: request,
+            statusCode: upload.status,
+            data: _decodeBody(upload.response),
+          );
+        } on PlatformException catch (e) {
+          Log.warning(
+            'upload() -> `PlatformException` occurred: $e',
+            '$runtimeType',
+          );
+
+          switch (e.code) {
+            case 'CANCELLED':
+              throw dio.DioException.requestCancelled(
+                requestOptions: request,
+                reason: e.message,
+              );
+
+            case 'NETWORK_ERROR':
+              throw dio.DioException.connectionError(
+                requestOptions: request,
+                reason: e.message ?? '',
+              );
+
+            case 'HTTP_ERROR':
+              final dio.Response response = dio.Response(
+                requestOptions: request,
+                statusCode: e.details['status'],
+                data: _decodeBody(e.details['response']),
+              );
+
+              if (onException != null &&
+                  response.data is Map<String, dynamic> &&
+                  response.data['data'] != null) {
+                throw onException(response.data['data']);
+              }
+
+              throw dio.DioException.badResponse(
+                statusCode: response.statusCode!,
+                requestOptions: request,
+                response: response,
+              );
+          }
+
+          rethrow;
+        }
+      });
+    });
+  }
+
   /// Reconnects the [client] right away if the [token] mismatch is detected.
   Future<void> reconnect() => _client.reconnect();
 
@@ -559,9 +675,13 @@ class GraphQlClient {
             }
           }, onDone: _reconnect);
 
+          // Native connections send the pings on their own thread, so they
+          // don't depend on this isolate being responsive. Checked on every
+          // tick, as the native connection may fall back to the Dart one.
           _kaTimer?.cancel();
           _kaTimer = Timer.periodic(const Duration(seconds: 5), (_) {
-            if (_wsChannel?.closeCode == null &&
+            if (!websocket.pingsNatively &&
+                _wsChannel?.closeCode == null &&
                 _wsChannel?.closeReason == null) {
               _wsChannel?.sink.add('{"type":"ping"}');
             }
@@ -685,6 +805,21 @@ class GraphQlClient {
     }
   }
 
+  /// Returns the JSON decoded from the [body] of a response, or the [body] as
+  /// a [String], if it isn't a JSON.
+  static dynamic _decodeBody(Uint8List body) {
+    if (body.isEmpty) {
+      return null;
+    }
+
+    final String decoded = utf8.decode(body, allowMalformed: true);
+    try {
+      return jsonDecode(decoded);
+    } on FormatException {
+      return decoded;
+    }
+  }
+
   /// Handles the [exception] to determine the [connected] status of this
   /// client.
   void _reportException(Exception? exception) {
@@ -26,7 +26,8 @@ import 'package:dio/dio.dart'
         FormData,
         DioException,
         CancelToken,
-        DioExceptionType;
+        DioExceptionType,
+        Response;
 import 'package:graphql/client.dart';
 
 import '../base.dart';
@@ -39,6 +40,7 @@ import '/domain/model/user.dart';
 import '/store/model/chat_item.dart';
 import '/store/model/chat.dart';
 import '/util/log.dart';
+import '/util/pause_token.dart';
 
 /// [Chat] related functionality.
 mixin ChatGraphQlMixin {
@@ -929,6 +931,78 @@ mixin ChatGraphQlMixin {
   }) async {
     Log.debug('uploadAttachment($attachment, onSendProgress)', '$runtimeType');
 
+    return await _uploadAttachment(
+      (query, operations) => client.post(
+        dio.FormData.fromMap({
+          'operations': operations,
+          'map': '{ "file": ["variables.upload"] }',
+          'file': attachment,
+        }),
+        options: dio.Options(contentType: 'multipart/form-data'),
+        operationName: query.operationName,
+        onSendProgress: onSendProgress,
+        onException: _uploadAttachmentException,
+        cancelToken: cancelToken,
+      ),
+    );
+  }
+
+  /// Creates a new [Attachment] linked to the authenticated [MyUser] from the
+  /// file at the [path] for a later use in the [postChatMessage] mutation.
+  ///
+  /// The file is streamed natively via the [GraphQlClient.upload], so it's
+  /// never read into the memory, which is intended to be used on Linux only.
+  /// [onChecksum] is invoked with the SHA-256 checksum of the uploaded file,
+  /// and [pauseToken] may be used to pause and resume the uploading.
+  ///
+  /// ### Authentication
+  ///
+  /// Mandatory.
+  ///
+  /// ### Non-idempotent
+  ///
+  /// Each time creates a new unique [Attachment].
+  Future<UploadAttachment$Mutation$UploadAttachment$UploadAttachmentOk>
+  uploadAttachmentFile(
+    String path, {
+    String? filename,
+    String? contentType,
+    void Function(int count, int total)? onSendProgress,
+    void Function(String checksum)? onChecksum,
+    dio.CancelToken? cancelToken,
+    PauseToken? pauseToken,
+  }) async {
+    Log.debug(
+      'uploadAttachmentFile($path, $filename, $contentType, onSendProgress)',
+      '$runtimeType',
+    );
+
+    return await _uploadAttachment(
+      (query, operations) => client.upload(
+        path,
+        fields: {
+          'operations': operations,
+          'map': '{ "file": ["variables.upload"] }',
+        },
+        filename: filename,
+        contentType: contentType,
+        operationName: query.operationName,
+        onSendProgress: onSendProgress,
+        onChecksum: onChecksum,
+        onException: _uploadAttachmentException,
+        cancelToken: cancelToken,
+        pauseToken: pauseToken,
+      ),
+    );
+  }
+
+  /// Performs the `Mutation.uploadAttachment` by sending the `operations` of
+  /// the `multipart/form-data` request via the provided [send].
+  Future<UploadAttachment$Mutation$UploadAttachment$UploadAttachmentOk>
+  _uploadAttachment(
+    Future<dio.Response> Function(MutationOptions query, String operations)
+    send,
+  ) async {
     final variables = UploadAttachmentArguments(file: null);
     final query = MutationOptions(
       operationName: 'UploadAttachment',
@@ -941,22 +1015,7 @@ mixin ChatGraphQlMixin {
     final encodedBody = json.encode(body);
 
     try {
-      var response = await client.post(
-        dio.FormData.fromMap({
-          'operations': encodedBody,
-          'map': '{ "file": ["variables.upload"] }',
-          'file': attachment,
-        }),
-        options: dio.Options(contentType: 'multipart/form-data'),
-        operationName: query.operationName,
-        onSendProgress: onSendProgress,
-        onException: (data) => UploadAttachmentException(
-          (UploadAttachment$Mutation.fromJson(data).uploadAttachment
-                  as UploadAttachment$Mutation$UploadAttachment$UploadAttachmentError)
-              .code,
-        ),
-        cancelToken: cancelToken,
-      );
+      var response = await send(query, encodedBody);
 
       if (response.data['data'] == null) {
         throw GraphQlException([
@@ -991,6 +1050,16 @@ mixin ChatGraphQlMixin {
     }
   }
 
+  /// Returns the [UploadAttachmentException] described in the [data] of the
+  /// `Mutation.uploadAttachment` response.
+  static Exception _uploadAttachmentException(Map<String, dynamic> data) {
+    return UploadAttachmentException(
+      (UploadAttachment$Mutation.fromJson(data).uploadAttachment
+              as UploadAttachment$Mutation$UploadAttachment$UploadAttachmentError)
+          .code,
+    );
+  }
+
   /// Notifies [ChatMember]s about the authenticated [MyUser] typing in the
   /// specified [Chat] at the moment.
   ///
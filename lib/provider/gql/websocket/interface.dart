@@ -29,3 +29,7 @@ WebSocketChannel connect(
 }) {
   throw UnimplementedError();
 }
+
+/// Indicates whether the connections made by [connect] send and answer the
+/// pings of the `graphql-transport-ws` protocol by themselves.
+bool get pingsNatively => throw UnimplementedError();
@@ -16,21 +16,82 @@
 // <https://www.gnu.org/licenses/agpl-3.0.html>.
 
 import 'package:universal_io/io.dart';
+import 'package:web_socket/io_web_socket.dart' show IOWebSocket;
+import 'package:web_socket/web_socket.dart' as web_socket;
+import 'package:web_socket_channel/adapter_web_socket_channel.dart';
 import 'package:web_socket_channel/io.dart';
 import 'package:web_socket_channel/web_socket_channel.dart';
 
+import '/util/linux_utils.dart';
+import '/util/log.dart';
+import '/util/platform_utils.dart';
+
+/// Indicator whether a native connection has failed, while the `dart:io` one
+/// to the same [Uri] has succeeded, so the rest are made by the latter.
+bool _fallenBack = false;
+
 /// Creates a new WebSocket connection.
 ///
 /// Connects to the provided [uri] and returns a channel that can be used to
 /// communicate over the resulting socket.
+///
+/// Connects natively with the [LinuxUtils.connectWebSocket] on Linux, falling
+/// back to the [IOWebSocketChannel] once it fails.
 WebSocketChannel connect(
   Uri uri, {
   Iterable<String>? protocols,
   HttpClient? customClient,
 }) {
+  if (PlatformUtils.isLinux && !_fallenBack) {
+    return AdapterWebSocketChannel(
+      _connectNatively(uri, protocols: protocols, customClient: customClient),
+    );
+  }
+
   return IOWebSocketChannel.connect(
     uri,
     protocols: protocols,
     customClient: customClient,
   );
 }
+
+/// Indicates whether the connections made by [connect] send and answer the
+/// pings of the `graphql-transport-ws` protocol by themselves.
+///
+/// Becomes `false` once the native connection falls back to the `dart:io` one.
+bool get pingsNatively => PlatformUtils.isLinux && !_fallenBack;
+
+/// Connects to the [uri] with the [LinuxUtils.connectWebSocket], or with the
+/// `dart:io` [WebSocket] the [IOWebSocketChannel] wraps, if the native one
+/// fails, e.g. due to the TLS or the proxy not supported by it.
+Future<web_socket.WebSocket> _connectNatively(
+  Uri uri, {
+  Iterable<String>? protocols,
+  HttpClient? customClient,
+}) async {
+  final String? userAgent = customClient?.userAgent;
+
+  try {
+    return await LinuxUtils.connectWebSocket(
+      uri,
+      protocols: protocols,
+      headers: {if (userAgent != null) 'User-Agent': userAgent},
+    );
+  } catch (e) {
+    Log.warning(
+      'Failed to connect natively, falling back to `dart:io`: $e',
+      'WebSocket',
+    );
+
+    // Unreachable servers fail the `dart:io` connection as well, in which case
+    // the next one is made natively again.
+    final WebSocket socket = await WebSocket.connect(
+      uri.toString(),
+      protocols: protocols,
+      customClient: customClient,
+    );
+
+    _fallenBack = true;
+    return IOWebSocket.fromWebSocket(socket);
+  }
+}
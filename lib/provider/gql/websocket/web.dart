@@ -30,3 +30,7 @@ WebSocketChannel connect(
 }) {
   return HtmlWebSocketChannel.connect(uri, protocols: protocols);
 }
+
+/// Indicates whether the connections made by [connect] send and answer the
+/// pings of the `graphql-transport-ws` protocol by themselves.
+bool get pingsNatively => false;
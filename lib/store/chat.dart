@@ -16,6 +16,7 @@
 // <https://www.gnu.org/licenses/agpl-3.0.html>.
 
 import 'dart:async';
+import 'dart:typed_data';
 
 import 'package:async/async.dart';
 import 'package:collection/collection.dart';
@@ -80,10 +81,12 @@ import '/store/model/chat_item.dart';
 import '/store/pagination/combined_pagination.dart';
 import '/store/pagination/graphql.dart';
 import '/store/user.dart';
+import '/ui/worker/cache.dart';
 import '/util/backoff.dart';
 import '/util/log.dart';
 import '/util/new_type.dart';
 import '/util/obs/obs.dart';
+import '/util/platform_utils.dart';
 import '/util/stream_utils.dart';
 import '/util/web/web_utils.dart';
 import 'chat_rx.dart';
@@ -1400,16 +1403,39 @@ class ChatRepository extends DisposableInterface
     attachment.status.value = SendingStatus.sending;
     await attachment.file.ensureCorrectMediaType();
 
+    // Files on the disk are streamed natively on Linux without being read into
+    // the memory, unless being images, whose dimensions are needed.
+    final String? path = attachment.file.path;
+    final bool natively =
+        PlatformUtils.isLinux && !PlatformUtils.isWeb && path != null;
+
+    // SHA-256 checksum of the file computed while streaming it natively.
+    String? checksum;
+
     try {
-      await attachment.file.readFile();
+      if (!natively || attachment.file.isImage) {
+        await attachment.file.readFile();
+      }
       attachment.read.value?.complete(null);
       attachment.status.refresh();
 
-      var response = await _graphQlProvider.uploadAttachment(
-        await attachment.file.toMultipartFile(),
-        onSendProgress: (now, max) => attachment.progress.value = now / max,
-        cancelToken: attachment.cancelToken,
-      );
+      var response = natively
+          ? await _graphQlProvider.uploadAttachmentFile(
+              path!,
+              filename: attachment.file.resolveFilename(),
+              contentType: attachment.file.mime?.mimeType,
+              onSendProgress: (now, max) =>
+                  attachment.progress.value = now / max,
+              onChecksum: (sha256) => checksum = sha256,
+              cancelToken: attachment.cancelToken,
+              pauseToken: attachment.pauseToken,
+            )
+          : await _graphQlProvider.uploadAttachment(
+              await attachment.file.toMultipartFile(),
+              onSendProgress: (now, max) =>
+                  attachment.progress.value = now / max,
+              cancelToken: attachment.cancelToken,
+            );
 
       var model = response.attachment.toModel();
       attachment.id = model.id;
@@ -1418,6 +1444,15 @@ class ChatRepository extends DisposableInterface
       attachment.upload.value?.complete(model);
       attachment.status.value = SendingStatus.sent;
       attachment.progress.value = 1;
+      attachment.isPaused.value = false;
+
+      // Images read for their dimensions are cached without being hashed
+      // again in Dart.
+      final Uint8List? bytes = attachment.file.bytes.value;
+      if (checksum != null && bytes != null) {
+        CacheWorker.instance.add(bytes, checksum);
+      }
+
       return model;
     } on dio.DioException {
       if (attachment.isCanceled) {
@@ -17,6 +17,7 @@
 
 import 'dart:async';
 import 'dart:convert';
+import 'dart:io';
 
 import 'package:back_button_interceptor/back_button_interceptor.dart';
 import 'package:collection/collection.dart';
@@ -54,6 +55,7 @@ import '/provider/gql/exceptions.dart';
 import '/routes.dart';
 import '/ui/page/support/log/controller.dart';
 import '/ui/widget/text_field.dart';
+import '/util/linux_utils.dart';
 import '/util/log.dart';
 import '/util/message_popup.dart';
 import '/util/platform_utils.dart';
@@ -167,6 +169,10 @@ class MessageFieldController extends GetxController {
   /// Maximum allowed [NativeFile.size] of an [Attachment].
   static const int maxAttachmentSize = 15 * 1024 * 1024;
 
+  /// Maximum width and height of the [NativeFile.preview]s created, covering
+  /// the attachments displayed at up to `300` pixels on HiDPI screens.
+  static const int _previewSize = 600;
+
   /// [Chat]s service uploading the [attachments].
   final ChatService? _chatService;
 
@@ -212,6 +218,13 @@ class MessageFieldController extends GetxController {
   /// registered.
   bool _handlersRegistered = false;
 
+  /// [NativeFile]s having their [NativeFile.preview]s created by
+  /// [_createPreview] and not yet deleted.
+  final Set<NativeFile> _previewed = {};
+
+  /// [NativeFile]s of the [attachments] being uploaded.
+  final Set<NativeFile> _uploading = {};
+
   /// Returns [MyUser]'s [UserId].
   UserId? get me => _chatService?.me;
 
@@ -338,7 +351,10 @@ class MessageFieldController extends GetxController {
     _repliesSubscription = replied.listen((_) => onChanged?.call());
 
     _attachmentsSubscription?.cancel();
-    _attachmentsSubscription = attachments.listen((_) => onChanged?.call());
+    _attachmentsSubscription = attachments.listen((_) {
+      _prunePreviews();
+      onChanged?.call();
+    });
 
     _editedSubscription?.cancel();
     _editedSubscription = edited.listen((item) {
@@ -386,6 +402,12 @@ class MessageFieldController extends GetxController {
 
     field.focus.removeListener(_focusListener);
 
+    // Previews of the [attachments] left unsent are not displayed anymore,
+    // while the ones being uploaded are deleted once uploaded.
+    for (NativeFile file in _previewed.difference(_uploading)) {
+      _deletePreview(file);
+    }
+
     if (_handlersRegistered) {
       _handlersRegistered = false;
       ClipboardEvents.instance?.unregisterPasteEventListener(
@@ -697,6 +719,15 @@ class MessageFieldController extends GetxController {
     );
 
     if (file.size < maxAttachmentSize && _chatService != null) {
+      _uploading.add(file);
+
+      if (PlatformUtils.isLinux &&
+          file.path != null &&
+          file.isImage &&
+          !file.isSvg) {
+        _createPreview(file);
+      }
+
       try {
         var attachment = LocalAttachment(file, status: SendingStatus.sending);
         attachments.add(MapEntry(GlobalKey(), attachment));
@@ -719,12 +750,81 @@ class MessageFieldController extends GetxController {
         MessagePopup.error(e);
       } on ConnectionException {
         // No-op.
+      } finally {
+        _uploading.remove(file);
+        _prunePreviews();
       }
     } else {
       MessagePopup.error('err_size_too_big'.l10n);
     }
   }
 
+  /// Creates the [NativeFile.preview] of the provided image [file] natively,
+  /// so that it's displayed without the whole image being read and decoded.
+  Future<void> _createPreview(NativeFile file) async {
+    try {
+      final Directory directory = await PlatformUtils.temporaryDirectory;
+      await directory.create(recursive: true);
+
+      final List<ImagePreviews?> previews =
+          await LinuxUtils.createImagePreviews(
+            [file.path!],
+            sizes: [_previewSize],
+            directory: directory.path,
+          );
+
+      final ImagePreviews? created = previews.firstOrNull;
+      if (created != null) {
+        file.dimensions.value ??= Size(
+          created.width.toDouble(),
+          created.height.toDouble(),
+        );
+        file.preview.value = created.previews.first;
+
+        // The [file] may have been uploaded or removed in the meantime.
+        _previewed.add(file);
+        _prunePreviews();
+      }
+    } catch (e) {
+      Log.warning('Failed to create preview of $file: $e', '$runtimeType');
+    }
+  }
+
+  /// Deletes the [NativeFile.preview]s of the [_previewed] files not being
+  /// uploaded and not displayed in the [attachments] anymore.
+  ///
+  /// Uploaded [LocalAttachment]s are replaced with the [Attachment]s returned,
+  /// so their previews are deleted as well.
+  void _prunePreviews() {
+    for (NativeFile file in _previewed.difference(_uploading)) {
+      final bool displayed = attachments.any((e) {
+        final Attachment attachment = e.value;
+        return attachment is LocalAttachment && attachment.file == file;
+      });
+
+      if (!displayed) {
+        _deletePreview(file);
+      }
+    }
+  }
+
+  /// Deletes the [NativeFile.preview] of the provided [file], so that its
+  /// [NativeFile.bytes] are displayed instead, if still needed.
+  Future<void> _deletePreview(NativeFile file) async {
+    _previewed.remove(file);
+
+    final String? path = file.preview.value;
+    file.preview.value = null;
+
+    if (path != null) {
+      try {
+        await File(path).delete();
+      } catch (e) {
+        Log.warning('Failed to delete preview of $file: $e', '$runtimeType');
+      }
+    }
+  }
+
   /// Invokes [toggleMore], if [moreOpened].
   ///
   /// Intended to be used as a [BackButtonInterceptor] callback, thus returns
@@ -83,13 +83,31 @@ class _DataAttachmentState extends State<DataAttachment> {
         };
       } else if (e is LocalAttachment) {
         leading = switch (e.status.value) {
-          SendingStatus.sending => WidgetButton(
-            key: const Key('CancelUploading'),
-            onPressed: e.cancelUpload,
-            child: _Progress(
-              key: const Key('Sending'),
-              progress: e.progress.value,
-            ),
+          SendingStatus.sending => Row(
+            mainAxisSize: MainAxisSize.min,
+            spacing: 6,
+            children: [
+              if (e.isPausable)
+                WidgetButton(
+                  key: e.isPaused.value
+                      ? const Key('ResumeUploading')
+                      : const Key('PauseUploading'),
+                  onPressed: e.isPaused.value ? e.resumeUpload : e.pauseUpload,
+                  child: SvgIcon(
+                    e.isPaused.value
+                        ? SvgIcons.previewPlay
+                        : SvgIcons.previewPause,
+                  ),
+                ),
+              WidgetButton(
+                key: const Key('CancelUploading'),
+                onPressed: e.cancelUpload,
+                child: _Progress(
+                  key: const Key('Sending'),
+                  progress: e.progress.value,
+                ),
+              ),
+            ],
           ),
           SendingStatus.sent => SvgIcon(
             key: const Key('Sent'),
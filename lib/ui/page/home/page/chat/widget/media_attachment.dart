@@ -15,6 +15,7 @@
 // along with this program. If not, see
 // <https://www.gnu.org/licenses/agpl-3.0.html>.
 
+import 'dart:io';
 import 'dart:math';
 import 'dart:typed_data';
 import 'dart:ui' show ImageFilter;
@@ -74,7 +75,12 @@ class _MediaAttachmentState extends State<MediaAttachment> {
       final int size = (oldWidget.attachment as LocalAttachment).file.size;
       final Uint8List? bytes =
           (oldWidget.attachment as LocalAttachment).file.bytes.value;
-      if (bytes != null && size == bytes.length) {
+
+      // Attachments uploaded natively on Linux are already cached.
+      final String? checksum = widget.attachment.original.checksum;
+      if (bytes != null &&
+          size == bytes.length &&
+          (checksum == null || !CacheWorker.instance.exists(checksum))) {
         CacheWorker.instance.add(bytes);
       }
     }
@@ -105,14 +111,35 @@ class _MediaAttachmentState extends State<MediaAttachment> {
           return ratio > 3 || ratio < 0.33;
         }
 
+        // Displays the downscaled [NativeFile.preview], if any, or decodes
+        // the whole [NativeFile.bytes] otherwise.
+        Widget image({BoxFit? fit, double? width, double? height}) {
+          final String? path = attachment.file.preview.value;
+          if (path != null) {
+            return Image.file(
+              File(path),
+              fit: fit,
+              width: width,
+              height: height,
+            );
+          }
+
+          return Image.memory(
+            attachment.file.bytes.value!,
+            fit: fit,
+            width: width,
+            height: height,
+          );
+        }
+
         preview = Obx(() {
-          if (attachment.file.bytes.value != null &&
+          if ((attachment.file.preview.value != null ||
+                  attachment.file.bytes.value != null) &&
               !attachment.file.isSvg &&
               isNarrow(attachment.file.dimensions.value)) {
             return ImageFiltered(
               imageFilter: ImageFilter.blur(sigmaX: 10, sigmaY: 10),
-              child: Image.memory(
-                attachment.file.bytes.value!,
+              child: image(
                 fit: BoxFit.cover,
                 width: double.infinity,
                 height: double.infinity,
@@ -124,7 +151,8 @@ class _MediaAttachmentState extends State<MediaAttachment> {
         });
 
         child = Obx(() {
-          if (attachment.file.bytes.value == null) {
+          if (attachment.file.preview.value == null &&
+              attachment.file.bytes.value == null) {
             return const Center(
               child: SizedBox(
                 width: 40,
@@ -143,8 +171,7 @@ class _MediaAttachmentState extends State<MediaAttachment> {
               final Size? dimensions = attachment.file.dimensions.value;
               final bool narrow = isNarrow(dimensions);
 
-              return Image.memory(
-                attachment.file.bytes.value!,
+              return image(
                 fit: widget.fit ?? (narrow ? BoxFit.contain : BoxFit.cover),
                 width: widget.width,
                 height:
@@ -15,6 +15,7 @@
 // along with this program. If not, see
 // <https://www.gnu.org/licenses/agpl-3.0.html>.
 
+import 'dart:async';
 import 'dart:convert';
 
 import 'package:file_picker/file_picker.dart';
@@ -37,6 +38,7 @@ import '/domain/service/notification.dart';
 import '/domain/service/session.dart';
 import '/provider/file/log.dart';
 import '/pubspec.g.dart';
+import '/util/linux_utils.dart';
 import '/util/log.dart';
 import '/util/message_popup.dart';
 import '/util/platform_utils.dart';
@@ -68,6 +70,13 @@ class LogController extends GetxController {
   /// [FileStat] of a application logs forwarded from stdout/stderr, if any.
   final Rx<FileStat?> appLogs = Rx(null);
 
+  /// [DatabaseMaintenanceStats] of the databases maintained natively.
+  final RxList<DatabaseMaintenanceStats> databases = RxList();
+
+  /// [ProcessSummary] of the CPU time, RSS and I/O of the process and its
+  /// threads sampled natively.
+  final Rx<ProcessSummary?> process = Rx(null);
+
   /// [AuthService] used to retrieve the current [sessionId].
   final AuthService _authService;
 
@@ -87,6 +96,12 @@ class LogController extends GetxController {
   /// [LogFileProvider] to read a [File] of the [LogEntry] from.
   final LogFileProvider? _logProvider;
 
+  /// [Timer] refreshing the [process].
+  Timer? _samplingTimer;
+
+  /// [Duration] of the window the [process] is summarized over.
+  static const Duration _samplingWindow = Duration(seconds: 30);
+
   /// Returns the currently authenticated [MyUser], if any.
   Rx<MyUser?>? get myUser => _myUserService?.myUser;
 
@@ -113,9 +128,21 @@ class LogController extends GetxController {
     getNotificationSettings().then((e) => notificationSettings.value = e);
     _tryFile();
     _tryAppLogs();
+    _tryDatabases();
+    _trySampling();
     super.onInit();
   }
 
+  @override
+  void onClose() {
+    if (_samplingTimer != null) {
+      _samplingTimer?.cancel();
+      LinuxUtils.stopSampling();
+    }
+
+    super.onClose();
+  }
+
   /// Sets the [ApplicationSettings.logLevel] to the provided [value].
   Future<void> setLogLevel(int value) async {
     await _settingsRepository?.setLogLevel(value);
@@ -245,7 +272,10 @@ ${Log.logs.map((e) => e.toString()).join('\n')}
   }
 
   /// Downloads the [File] with the whole dump of logs, if any.
-  Future<void> downloadArchive() async => _download(_logProvider?.file);
+  Future<void> downloadArchive() async {
+    await _logProvider?.flush();
+    await _download(_logProvider?.file);
+  }
 
   /// Downloads the [File] with the `stdout` and `stderr` streams, if any.
   Future<void> downloadAppLogs() async {
@@ -317,4 +347,47 @@ ${Log.logs.map((e) => e.toString()).join('\n')}
     final File file = File('${library.path}/app.log');
     appLogs.value = await file.stat();
   }
+
+  /// Retrieves the [DatabaseMaintenanceStats] of the databases.
+  Future<void> _tryDatabases() async {
+    if (!PlatformUtils.isLinux || PlatformUtils.isWeb) {
+      return;
+    }
+
+    try {
+      databases.value = await LinuxUtils.databaseMaintenance();
+    } catch (e) {
+      Log.warning(
+        'Unable to get the database maintenance: $e',
+        '$runtimeType',
+      );
+    }
+  }
+
+  /// Starts sampling the process natively and refreshing its [process].
+  Future<void> _trySampling() async {
+    if (!PlatformUtils.isLinux || PlatformUtils.isWeb) {
+      return;
+    }
+
+    try {
+      await LinuxUtils.startSampling(perf: true);
+    } catch (e) {
+      Log.warning('Unable to start sampling: $e', '$runtimeType');
+      return;
+    }
+
+    if (isClosed) {
+      await LinuxUtils.stopSampling();
+      return;
+    }
+
+    _samplingTimer = Timer.periodic(const Duration(seconds: 2), (_) async {
+      try {
+        process.value = await LinuxUtils.processSummary(_samplingWindow);
+      } catch (e) {
+        Log.warning('Unable to get the process summary: $e', '$runtimeType');
+      }
+    });
+  }
 }
@@ -36,6 +36,7 @@ import '/ui/widget/safe_area/safe_area.dart';
 import '/ui/widget/svg/svg.dart';
 import '/ui/widget/widget_button.dart';
 import '/util/get.dart';
+import '/util/linux_utils.dart';
 import '/util/log.dart';
 import '/util/message_popup.dart';
 import '/util/platform_utils.dart';
@@ -104,6 +105,8 @@ class LogView extends StatelessWidget {
                           _myUser(context, c),
                           _session(context, c),
                           _token(context, c),
+                          _databases(context, c),
+                          _threads(context, c),
 
                           // Logs.
                           ListTile(
@@ -401,4 +404,59 @@ class LogView extends StatelessWidget {
       ],
     );
   }
+
+  /// Builds the technical information about the maintenance of the databases.
+  Widget _databases(BuildContext context, LogController c) {
+    if (c.databases.isEmpty) {
+      return const SizedBox();
+    }
+
+    return Column(
+      crossAxisAlignment: CrossAxisAlignment.start,
+      children: [
+        ListTile(
+          leading: WidgetButton(
+            onPressed: () {},
+            onPressedWithDetails: (u) {
+              PlatformUtils.copy(text: c.databases.join('\n'));
+              MessagePopup.success('label_copied'.l10n, at: u.globalPosition);
+            },
+            child: SvgIcon(SvgIcons.copy),
+          ),
+          title: Text('Databases'),
+        ),
+        ...c.databases.map((e) => Text('$e')),
+      ],
+    );
+  }
+
+  /// Builds the technical information about the CPU time, memory and I/O of
+  /// the process and its threads.
+  Widget _threads(BuildContext context, LogController c) {
+    final ProcessSummary? process = c.process.value;
+    if (process == null || process.samples < 2) {
+      return const SizedBox();
+    }
+
+    return Column(
+      crossAxisAlignment: CrossAxisAlignment.start,
+      children: [
+        ListTile(
+          leading: WidgetButton(
+            onPressed: () {},
+            onPressedWithDetails: (u) {
+              PlatformUtils.copy(
+                text: [process, ...process.threads].join('\n'),
+              );
+              MessagePopup.success('label_copied'.l10n, at: u.globalPosition);
+            },
+            child: SvgIcon(SvgIcons.copy),
+          ),
+          title: Text('Threads'),
+        ),
+        Text('$process'),
+        ...process.threads.map((e) => Text('$e')),
+      ],
+    );
+  }
 }
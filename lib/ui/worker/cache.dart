@@ -20,7 +20,6 @@ import 'dart:collection';
 import 'dart:io';
 
 import 'package:collection/collection.dart';
-import 'package:crypto/crypto.dart';
 import 'package:dio/dio.dart';
 import 'package:flutter/foundation.dart';
 import 'package:flutter/material.dart';
@@ -35,9 +34,12 @@ import '/domain/service/disposable_service.dart';
 import '/provider/drift/cache.dart';
 import '/provider/drift/download.dart';
 import '/util/backoff.dart';
+import '/util/linux_utils.dart';
 import '/util/log.dart';
+import '/util/mapped_file.dart';
 import '/util/obs/rxmap.dart';
 import '/util/platform_utils.dart';
+import '/util/thumbhash.dart';
 
 /// Worker maintaining [File]s cache and downloads.
 ///
@@ -78,21 +80,57 @@ class CacheWorker extends Dependency {
   /// [Directory.list] subscription used in [_updateInfo].
   StreamSubscription? _cacheSubscription;
 
+  /// [LinuxUtils.memoryPressure] subscription dropping the caches held in
+  /// memory.
+  StreamSubscription? _pressureSubscription;
+
   /// [Mutex] guarding access to [PlatformUtilsImpl.cacheDirectory].
   final Mutex _mutex = Mutex();
 
+  /// Indicator whether the native cache index is used to track the [hashes]
+  /// instead of the [_cacheLocal] and [FileStat]s.
+  ///
+  /// Only available on Linux.
+  bool _indexed = false;
+
   @override
   Future<void> onInit() async {
-    _cacheLocal?.checksums().then((v) => hashes.addAll(v));
-
     info.value = await _cacheLocal?.read() ?? info.value;
 
     final Directory? cache = cacheDirectory.value ??=
         await PlatformUtils.cacheDirectory;
 
-    // Recalculate the [info], if [FileStat.modified] mismatch is detected.
-    if (cache != null && info.value.modified != (await cache.stat()).modified) {
-      _updateInfo();
+    // Indicator whether the index has failed to open, so the checksums in
+    // the [_cacheLocal] may be missing, as they aren't stored while indexed.
+    bool unindexed = false;
+
+    if (PlatformUtils.isLinux && cache != null) {
+      try {
+        final CacheScan scan = await LinuxUtils.openCacheIndex(
+          '${cache.path}.index',
+          cache.path,
+        );
+
+        // Cleared only once the index tracking the checksums is opened.
+        await _cacheLocal?.clear();
+
+        _indexed = true;
+        await _applyInfo(cache, HashSet.of(scan.checksums), scan.size);
+      } catch (e) {
+        unindexed = true;
+        Log.warning('Failed to open cache index: $e', '$runtimeType');
+      }
+    }
+
+    if (!_indexed) {
+      _cacheLocal?.checksums().then((v) => hashes.addAll(v));
+
+      // Recalculate the [info], if [FileStat.modified] mismatch is detected.
+      if (cache != null &&
+          (unindexed ||
+              info.value.modified != (await cache.stat()).modified)) {
+        _updateInfo();
+      }
     }
 
     if (!PlatformUtils.isWeb) {
@@ -101,12 +139,32 @@ class CacheWorker extends Dependency {
       );
     }
 
+    if (PlatformUtils.isLinux && !PlatformUtils.isWeb) {
+      _pressureSubscription = LinuxUtils.memoryPressure.listen(
+        _shed,
+        onError: (e) => Log.warning(
+          'Failed to listen to the memory pressure: $e',
+          '$runtimeType',
+        ),
+      );
+    }
+
     super.onInit();
   }
 
   @override
   void onClose() {
     _cacheSubscription?.cancel();
+    _pressureSubscription?.cancel();
+
+    if (_indexed) {
+      unawaited(
+        LinuxUtils.closeCacheIndex().catchError((e) {
+          Log.warning('Failed to close cache index: $e', '$runtimeType');
+        }),
+      );
+    }
+
     super.onClose();
   }
 
@@ -116,6 +174,9 @@ class CacheWorker extends Dependency {
   ///
   /// Retries itself using exponential backoff algorithm on a failure, which can
   /// be canceled with a [cancelToken].
+  ///
+  /// Cached files are mapped into memory without being copied, where
+  /// supported, according to the [advice].
   FutureOr<CacheEntry> get({
     String? url,
     String? checksum,
@@ -123,6 +184,7 @@ class CacheWorker extends Dependency {
     CancelToken? cancelToken,
     Future<void> Function()? onForbidden,
     CacheResponseType responseType = CacheResponseType.bytes,
+    MappedFileAdvice advice = MappedFileAdvice.willNeed,
   }) {
     // Web does not support file caching.
     if (PlatformUtils.isWeb) {
@@ -138,12 +200,26 @@ class CacheWorker extends Dependency {
           final File file = File('${cache.path}/$checksum');
 
           if (await file.exists()) {
+            if (_indexed) {
+              unawaited(
+                LinuxUtils.touchCache(checksum).catchError((e) {
+                  Log.warning(
+                    'Failed to touch `$checksum` in cache index: $e',
+                    '$runtimeType',
+                  );
+                  return false;
+                }),
+              );
+            }
+
             switch (responseType) {
               case CacheResponseType.file:
                 return CacheEntry(file: file);
 
               case CacheResponseType.bytes:
-                final Uint8List bytes = await file.readAsBytes();
+                final Uint8List bytes =
+                    mapFile(file.path, advice: advice) ??
+                    await file.readAsBytes();
 
                 if (bytes.lengthInBytes != 0) {
                   return CacheEntry(bytes: bytes);
@@ -211,13 +287,42 @@ class CacheWorker extends Dependency {
     });
   }
 
+  /// Drops the caches held in memory according to the provided [pressure].
+  ///
+  /// [MemoryPressure.critical] is also reported to the
+  /// [WidgetsBindingObserver.didHaveMemoryPressure]s, so the rest of the
+  /// application sheds its caches as well.
+  void _shed(MemoryPressure pressure) {
+    if (pressure == MemoryPressure.none) {
+      return;
+    }
+
+    Log.info(
+      '_shed(${pressure.name}) -> ${_thumbhashProviders.length} thumbhashes, '
+      '${PaintingBinding.instance.imageCache.currentSizeBytes} image bytes',
+      '$runtimeType',
+    );
+
+    _thumbhashProviders.clear();
+
+    if (pressure == MemoryPressure.critical) {
+      // Clears the [ImageCache] as well.
+      // ignore: invalid_use_of_protected_member
+      WidgetsBinding.instance.handleMemoryPressure();
+    } else {
+      PaintingBinding.instance.imageCache.clear();
+    }
+  }
+
   /// Returns the [ImageProvider] for the provided [thumbhash].
+  ///
+  /// ThumbHashes are decoded natively in batches, where supported.
   ImageProvider getThumbhashProvider(ThumbHash thumbhash) {
     final ImageProvider thumbhashProvider =
         _thumbhashProviders[thumbhash] ??
-        (_thumbhashProviders[thumbhash] = t.ThumbHash.fromBase64(
-          thumbhash.val,
-        ).toImage());
+        (_thumbhashProviders[thumbhash] = ThumbHashImage.isSupported
+            ? ThumbHashImage(thumbhash.val)
+            : t.ThumbHash.fromBase64(thumbhash.val).toImage());
 
     if (_thumbhashProviders.length > 100) {
       _thumbhashProviders.remove(_thumbhashProviders.keys.first);
@@ -227,10 +332,10 @@ class CacheWorker extends Dependency {
   }
 
   /// Adds the provided [data] to the cache.
-  FutureOr<File?> add(Uint8List data, [String? checksum, String? url]) {
+  Future<File?> add(Uint8List data, [String? checksum, String? url]) async {
     // Calculating SHA-256 hash from [data] on Web freezes the application.
     if (!PlatformUtils.isWeb) {
-      checksum ??= sha256.convert(data).toString();
+      checksum ??= await PlatformUtils.sha256(data);
     }
 
     return _mutex.protect(() async {
@@ -242,12 +347,30 @@ class CacheWorker extends Dependency {
         if (!(await file.exists())) {
           await file.writeAsBytes(data);
 
-          info.value.size = info.value.size + data.length;
+          int? size;
+          if (_indexed) {
+            try {
+              size = await LinuxUtils.addCache(checksum!, data.length);
+            } catch (e) {
+              // The file is still cached, and the index picks it up once
+              // it's rebuilt.
+              Log.warning(
+                'Failed to add `$checksum` to cache index: $e',
+                '$runtimeType',
+              );
+            }
+          }
+
+          info.value.size = size ?? info.value.size + data.length;
+
           info.value.modified = (await cache.stat()).modified;
           info.refresh();
           hashes.add('$checksum');
           await _cacheLocal?.upsert(info.value);
-          await _cacheLocal?.register([checksum!]);
+
+          if (!_indexed) {
+            await _cacheLocal?.register([checksum!]);
+          }
 
           _optimizeCache();
         }
@@ -419,6 +542,44 @@ class CacheWorker extends Dependency {
       if (overflow > 0 && cache != null) {
         overflow += (info.value.maxSize! * 0.05).floor();
 
+        // Evict by the logical access clocks of the index, as the
+        // [FileStat.accessed] isn't updated on `noatime` and `relatime` mounts.
+        if (_indexed) {
+          try {
+            final CacheScan scan = await LinuxUtils.evictCacheIndex(overflow);
+
+            info.value.size = scan.size;
+            info.value.modified = (await cache.stat()).modified;
+            info.refresh();
+            hashes.removeAll(scan.removed);
+            await _cacheLocal?.upsert(info.value);
+            return;
+          } catch (e) {
+            Log.warning('Failed to evict cache index: $e', '$runtimeType');
+          }
+        }
+
+        // Scan and evict natively on Linux, as awaiting [File.stat] for every
+        // file blocks the isolate on large caches.
+        if (PlatformUtils.isLinux) {
+          try {
+            final CacheScan scan = await LinuxUtils.evictCache(
+              cache.path,
+              overflow,
+            );
+
+            info.value.size = scan.size;
+            info.value.modified = (await cache.stat()).modified;
+            info.refresh();
+            hashes.removeAll(scan.removed);
+            await _cacheLocal?.upsert(info.value);
+            await _cacheLocal?.unregister(scan.removed);
+            return;
+          } catch (e) {
+            Log.warning('Failed to evict cache natively: $e', '$runtimeType');
+          }
+        }
+
         final List<File> files = hashes
             .map((e) => File('${cache.path}/$e'))
             .toList();
@@ -472,6 +633,18 @@ class CacheWorker extends Dependency {
         await PlatformUtils.cacheDirectory;
 
     if (cache != null) {
+      if (PlatformUtils.isLinux) {
+        try {
+          final CacheScan scan = _indexed
+              ? await LinuxUtils.rebuildCacheIndex()
+              : await LinuxUtils.scanCache(cache.path);
+          await _applyInfo(cache, HashSet.of(scan.checksums), scan.size);
+          return;
+        } catch (e) {
+          Log.warning('Failed to scan cache natively: $e', '$runtimeType');
+        }
+      }
+
       final HashSet<String> checksums = HashSet();
       int size = 0;
 
@@ -487,15 +660,7 @@ class CacheWorker extends Dependency {
               }
             },
             onDone: () async {
-              await _cacheLocal?.clear();
-              info.value.size = size;
-              info.value.modified = (await cache.stat()).modified;
-              info.refresh();
-              hashes.addAll(checksums);
-              await _cacheLocal?.upsert(info.value);
-              await _cacheLocal?.register(checksums.toList());
-
-              _optimizeCache();
+              await _applyInfo(cache, checksums, size);
 
               _cacheSubscription?.cancel();
               _cacheSubscription = null;
@@ -503,6 +668,31 @@ class CacheWorker extends Dependency {
           );
     }
   }
+
+  /// Stores the [checksums] and [size] of the [cache] as the current [info].
+  Future<void> _applyInfo(
+    Directory cache,
+    HashSet<String> checksums,
+    int size,
+  ) async {
+    // The index tracks the checksums itself.
+    if (!_indexed) {
+      await _cacheLocal?.clear();
+    }
+
+    info.value.size = size;
+    info.value.modified = (await cache.stat()).modified;
+    info.refresh();
+    hashes.addAll(checksums);
+    await _cacheLocal?.upsert(info.value);
+
+    // The index tracks the checksums itself.
+    if (!_indexed) {
+      await _cacheLocal?.register(checksums.toList());
+    }
+
+    _optimizeCache();
+  }
 }
 
 /// [File] downloading entry.
@@ -21,7 +21,9 @@ import 'dart:io';
 import 'package:collection/collection.dart';
 import 'package:dio/dio.dart';
 import 'package:flutter/scheduler.dart';
+import 'package:flutter/services.dart';
 import 'package:get/get.dart';
+import 'package:path/path.dart' as p;
 import 'package:pub_semver/pub_semver.dart';
 import 'package:url_launcher/url_launcher_string.dart';
 import 'package:uuid/uuid.dart';
@@ -34,6 +36,7 @@ import '/provider/drift/skipped_version.dart';
 import '/pubspec.g.dart';
 import '/routes.dart';
 import '/ui/widget/upgrade_popup/view.dart';
+import '/util/linux_utils.dart';
 import '/util/log.dart';
 import '/util/message_popup.dart';
 import '/util/platform_utils.dart';
@@ -115,7 +118,10 @@ class UpgradeWorker extends Dependency {
   Future<void> download(ReleaseArtifact release) async {
     Log.debug('download($release)', '$runtimeType()');
 
-    final releaseDownload = ReleaseDownload(release.url);
+    final releaseDownload = ReleaseDownload(
+      release.url,
+      delta: release.deltas.firstWhereOrNull((e) => e.from == Pubspec.ref),
+    );
     activeDownload.value?.cancel();
     activeDownload.value = releaseDownload;
 
@@ -396,9 +402,15 @@ class Release {
         xml.findElements('description').firstOrNull?.innerText;
 
     final String date = xml.findElements('pubDate').first.innerText;
+    final List<ReleaseDelta> deltas = xml
+        .findElements('sparkle:deltas')
+        .expand((e) => e.findElements('enclosure'))
+        .map((e) => ReleaseDelta.fromXml(e))
+        .toList();
+
     final List<ReleaseArtifact> assets = xml
         .findElements('enclosure')
-        .map((e) => ReleaseArtifact.fromXml(e))
+        .map((e) => ReleaseArtifact.fromXml(e, deltas: deltas))
         .toList();
 
     return Release(
@@ -441,14 +453,27 @@ class Release {
 
 /// Artifact of the [Release].
 class ReleaseArtifact {
-  const ReleaseArtifact({required this.url, required this.os});
+  const ReleaseArtifact({
+    required this.url,
+    required this.os,
+    this.deltas = const [],
+  });
 
   /// Constructs a [ReleaseArtifact] from the provided [xml].
-  factory ReleaseArtifact.fromXml(XmlElement xml) {
+  ///
+  /// Only the [deltas] for the same [os] are kept.
+  factory ReleaseArtifact.fromXml(
+    XmlElement xml, {
+    List<ReleaseDelta> deltas = const [],
+  }) {
     final String url = xml.getAttribute('url')!;
     final String os = xml.getAttribute('sparkle:os')!;
 
-    return ReleaseArtifact(url: url, os: os);
+    return ReleaseArtifact(
+      url: url,
+      os: os,
+      deltas: deltas.where((e) => e.os == os).toList(),
+    );
   }
 
   /// URL of the binary this [ReleaseArtifact] is about.
@@ -457,8 +482,12 @@ class ReleaseArtifact {
   /// Operating system this [ReleaseArtifact] is for.
   final String os;
 
+  /// [ReleaseDelta]s reconstructing this [ReleaseArtifact] from the previous
+  /// releases.
+  final List<ReleaseDelta> deltas;
+
   @override
-  String toString() => 'ReleaseArtifact(url: $url, os: $os)';
+  String toString() => 'ReleaseArtifact(url: $url, os: $os, deltas: $deltas)';
 
   @override
   bool operator ==(Object other) {
@@ -469,14 +498,87 @@ class ReleaseArtifact {
   int get hashCode => Object.hash(url, os);
 }
 
+/// Delta patch reconstructing a [ReleaseArtifact] from the installed
+/// application bundle of the [from] release.
+///
+/// Listed in the `sparkle:deltas` element of the appcast item:
+///
+/// ```xml
+/// <sparkle:deltas>
+///   <enclosure
+///     sparkle:os="linux"
+///     sparkle:deltaFrom="1.2.3"
+///     url="messenger-linux-1.2.3.delta"
+///     sha256="..."
+///   />
+/// </sparkle:deltas>
+/// ```
+class ReleaseDelta {
+  const ReleaseDelta({
+    required this.url,
+    required this.os,
+    required this.from,
+    this.sha256,
+  });
+
+  /// Constructs a [ReleaseDelta] from the provided [xml].
+  factory ReleaseDelta.fromXml(XmlElement xml) {
+    String from = xml.getAttribute('sparkle:deltaFrom')!;
+
+    // Omit the leading `v` of the release version, if any.
+    if (from.startsWith('v')) {
+      from = from.substring(1);
+    }
+
+    return ReleaseDelta(
+      url: xml.getAttribute('url')!,
+      os: xml.getAttribute('sparkle:os')!,
+      from: from,
+      sha256: xml.getAttribute('sha256'),
+    );
+  }
+
+  /// URL of the patch this [ReleaseDelta] is about.
+  final String url;
+
+  /// Operating system this [ReleaseDelta] is for.
+  final String os;
+
+  /// Version of the release this [ReleaseDelta] is applied to.
+  final String from;
+
+  /// SHA-256 hash of the [ReleaseArtifact] reconstructed, if provided.
+  final String? sha256;
+
+  @override
+  String toString() =>
+      'ReleaseDelta(url: $url, os: $os, from: $from, sha256: $sha256)';
+
+  @override
+  bool operator ==(Object other) {
+    return other is ReleaseDelta &&
+        url == other.url &&
+        os == other.os &&
+        from == other.from &&
+        sha256 == other.sha256;
+  }
+
+  @override
+  int get hashCode => Object.hash(url, os, from, sha256);
+}
+
 /// [Release] being downloaded, exposing its [url], [progress] and [file]
 /// parameters.
 class ReleaseDownload {
-  ReleaseDownload(this.url);
+  ReleaseDownload(this.url, {this.delta});
 
   /// URL to download from.
   final String url;
 
+  /// [ReleaseDelta] to try reconstructing the [file] from the installed
+  /// application bundle with, before downloading it whole.
+  final ReleaseDelta? delta;
+
   /// Progress of the downloading.
   final RxDouble progress = RxDouble(0);
 
@@ -499,7 +601,11 @@ class ReleaseDownload {
     Log.debug('start()...', '$runtimeType($url)');
 
     try {
-      file.value = await PlatformUtils.download(
+      if (PlatformUtils.isLinux && delta != null) {
+        file.value = await _patch(delta!);
+      }
+
+      file.value ??= await PlatformUtils.download(
         url,
         url.split('/').lastOrNull ?? 'file',
         null,
@@ -523,6 +629,76 @@ class ReleaseDownload {
     }
   }
 
+  /// Downloads the [delta] and applies it to the installed application bundle.
+  ///
+  /// Returns `null` if the [delta] is missing, doesn't result in the expected
+  /// file or fails in any other way, so it should be downloaded whole instead.
+  Future<File?> _patch(ReleaseDelta delta) async {
+    Log.debug('_patch($delta)', '$runtimeType($url)');
+
+    File? patch;
+
+    try {
+      final Directory temporary = await PlatformUtils.temporaryDirectory;
+      await temporary.create(recursive: true);
+
+      patch = File(
+        '${temporary.path}/${delta.url.split('/').lastOrNull ?? 'delta'}',
+      );
+
+      await LinuxUtils.download(
+        delta.url,
+        patch.path,
+        headers: {'User-Agent': await PlatformUtils.userAgent},
+        onProgress: (a, b) {
+          if (b > 0) {
+            progress.value = a / b;
+          }
+        },
+        cancelToken: _cancelToken,
+      );
+
+      final String filename = url.split('/').lastOrNull ?? 'file';
+      final String name = p.basenameWithoutExtension(filename);
+      final String extension = p.extension(filename);
+      final Directory directory = await PlatformUtils.downloadsDirectory;
+      await directory.create(recursive: true);
+
+      File file = File('${directory.path}/$filename');
+      for (int i = 1; await file.exists(); ++i) {
+        file = File('${directory.path}/$name ($i)$extension');
+      }
+
+      await LinuxUtils.applyDeltaPatch(
+        source: File(Platform.resolvedExecutable).parent.path,
+        patch: patch.path,
+        target: file.path,
+        sha256: delta.sha256,
+      );
+
+      return file;
+    } on Exception catch (e) {
+      if (e is PlatformException && e.code == 'CANCELLED') {
+        throw DioException.requestCancelled(
+          requestOptions: RequestOptions(path: delta.url),
+          reason: e,
+        );
+      }
+
+      Log.warning(
+        '_patch($delta) -> failed with $e, downloading in full',
+        '$runtimeType($url)',
+      );
+
+      progress.value = 0;
+      return null;
+    } finally {
+      if (await patch?.exists() == true) {
+        await patch?.delete();
+      }
+    }
+  }
+
   /// Cancels the download.
   void cancel() {
     Log.debug('cancel()', '$runtimeType($url)');
@@ -25,6 +25,7 @@ import 'package:uuid/uuid.dart';
 
 import '/pubspec.g.dart';
 import '/util/media_utils.dart';
+import 'linux_utils.dart';
 import 'log.dart';
 import 'new_type.dart';
 import 'platform_utils.dart';
@@ -72,6 +73,12 @@ class AudioUtilsImpl {
   /// [AudioSessionConfiguration] previously applied during [reconfigure].
   AudioSessionConfiguration? _previousConfiguration;
 
+  /// Assets of the [AssetAudioSource]s preloaded to be played natively.
+  final Set<String> _preloaded = {};
+
+  /// Assets of the [AssetAudioSource]s requested to be preloaded.
+  final Set<String> _preloading = {};
+
   /// Returns [Stream] of [AVAudioSessionRouteChange]s.
   Stream<AVAudioSessionRouteChange> get routeChangeStream =>
       AVAudioSession().routeChangeStream;
@@ -79,6 +86,9 @@ class AudioUtilsImpl {
   /// Indicates whether the [_jaPlayer] should be used.
   bool get _isMobile => PlatformUtils.isMobile && !PlatformUtils.isWeb;
 
+  /// Indicates whether the [AssetAudioSource]s should be played natively.
+  bool get _isLinux => PlatformUtils.isLinux && !PlatformUtils.isWeb;
+
   /// Ensures the underlying resources are initialized to reduce possible delays
   /// when playing [once].
   void ensureInitialized() {
@@ -121,7 +131,7 @@ class AudioUtilsImpl {
             '$url?v=${Pubspec.ref}',
           )).listen((_) {}).asFuture();
         }
-      } else {
+      } else if (!await _playNatively(sound)) {
         await _jaPlayer?.setAudioSource(sound.source);
         await _jaPlayer?.play();
       }
@@ -531,6 +541,51 @@ class AudioUtilsImpl {
     });
   }
 
+  /// Plays the provided [sound] natively, if it's an [AssetAudioSource]
+  /// preloaded, or starts preloading it otherwise.
+  ///
+  /// Native playback mixes the [sound] with the ones being played without
+  /// creating a player, and drops the same [sound] played too recently.
+  ///
+  /// Returns `false`, if the [sound] should be played by the [_jaPlayer].
+  Future<bool> _playNatively(AudioSource sound) async {
+    if (!_isLinux || sound is! AssetAudioSource) {
+      return false;
+    }
+
+    if (!_preloaded.contains(sound.asset)) {
+      if (_preloading.add(sound.asset)) {
+        LinuxUtils.preloadSounds([sound.asset]).then(
+          _preloaded.addAll,
+          onError: (e) => Log.warning(
+            'Failed to `preloadSounds(${sound.asset})`: $e',
+            '$runtimeType',
+          ),
+        );
+      }
+
+      return false;
+    }
+
+    try {
+      final Duration? duration = await LinuxUtils.playSound(sound.asset);
+      if (duration == null) {
+        return false;
+      }
+
+      // Completes once the [sound] is played, as the [_jaPlayer] does.
+      await Future.delayed(duration);
+      return true;
+    } catch (e) {
+      Log.warning(
+        'Failed to `playSound(${sound.asset})`: $e',
+        '$runtimeType',
+      );
+
+      return false;
+    }
+  }
+
   /// Invokes a [MediaUtilsImpl.setOutputDevice] method.
   Future<void> _setOutputDevice() async {
     // If the [_mutex] is locked, the output device is already being set.
@@ -0,0 +1,316 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+import 'dart:collection';
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'package:dio/dio.dart';
+import 'package:flutter/services.dart';
+
+import 'linux_utils.dart';
+
+/// JSON document parsed natively by [LinuxUtils.parseJson] into a flat tape,
+/// read lazily through the typed views.
+///
+/// Tape is the 32-bit number of the nodes and the 32-bit byte length of the
+/// strings, followed by the 16-byte nodes and the UTF-8 strings, all in
+/// [Endian.host]. Each node is the 8-bit [_JsonTapeType], the 32-bit length
+/// at the offset of 4, and the 64-bit value at the offset of 8.
+///
+/// Arrays and objects are exposed as the [List] and the [Map] views creating
+/// their values only once accessed, so the ones never read (e.g. the fields
+/// not displayed) are never created.
+class JsonTape {
+  JsonTape(Uint8List bytes)
+    : _bytes = bytes,
+      _data = ByteData.sublistView(bytes),
+      _strings =
+          _headerSize +
+          ByteData.sublistView(bytes).getUint32(0, Endian.host) * _nodeSize;
+
+  /// Size of the header of the tape.
+  static const int _headerSize = 8;
+
+  /// Size of a single node of the tape.
+  static const int _nodeSize = 16;
+
+  /// Bytes of the tape.
+  final Uint8List _bytes;
+
+  /// [ByteData] view of the [_bytes].
+  final ByteData _data;
+
+  /// Offset of the strings in the [_bytes].
+  final int _strings;
+
+  /// Returns the root value of the document.
+  Object? get root => _value(0);
+
+  /// Returns the value of the node at the [index].
+  Object? _value(int index) {
+    final int offset = _headerSize + index * _nodeSize;
+
+    switch (_JsonTapeType.values[_data.getUint8(offset)]) {
+      case _JsonTapeType.nullValue:
+        return null;
+
+      case _JsonTapeType.falseValue:
+        return false;
+
+      case _JsonTapeType.trueValue:
+        return true;
+
+      case _JsonTapeType.intValue:
+        return _data.getInt64(offset + 8, Endian.host);
+
+      case _JsonTapeType.doubleValue:
+        return _data.getFloat64(offset + 8, Endian.host);
+
+      case _JsonTapeType.stringValue:
+        return _string(index);
+
+      case _JsonTapeType.arrayValue:
+        return _JsonTapeList(this, index);
+
+      case _JsonTapeType.objectValue:
+        return _JsonTapeMap(this, index);
+    }
+  }
+
+  /// Returns the string of the node at the [index].
+  String _string(int index) {
+    final int offset = _headerSize + index * _nodeSize;
+    final int start =
+        _strings + _data.getUint64(offset + 8, Endian.host);
+
+    return utf8.decode(
+      Uint8List.sublistView(
+        _bytes,
+        start,
+        start + _data.getUint32(offset + 4, Endian.host),
+      ),
+    );
+  }
+
+  /// Returns the index of the node following the one at the [index] with all
+  /// of its descendants.
+  int _next(int index) {
+    final int offset = _headerSize + index * _nodeSize;
+
+    switch (_JsonTapeType.values[_data.getUint8(offset)]) {
+      case _JsonTapeType.arrayValue:
+      case _JsonTapeType.objectValue:
+        return _data.getUint64(offset + 8, Endian.host);
+
+      default:
+        return index + 1;
+    }
+  }
+
+  /// Returns the [_JsonTapeNode]s of the elements of the array at the
+  /// [index].
+  List<Object?> _elements(int index) {
+    final int length = _data.getUint32(
+      _headerSize + index * _nodeSize + 4,
+      Endian.host,
+    );
+
+    final List<Object?> elements = List.filled(length, null, growable: true);
+    for (int i = 0, node = index + 1; i < length; ++i) {
+      elements[i] = _JsonTapeNode(node);
+      node = _next(node);
+    }
+
+    return elements;
+  }
+
+  /// Returns the [_JsonTapeNode]s of the values of the object at the [index]
+  /// by their keys.
+  Map<String, Object?> _members(int index) {
+    final int length = _data.getUint32(
+      _headerSize + index * _nodeSize + 4,
+      Endian.host,
+    );
+
+    final Map<String, Object?> members = {};
+    for (int i = 0, node = index + 1; i < length; ++i) {
+      members[_string(node)] = _JsonTapeNode(node + 1);
+      node = _next(node + 1);
+    }
+
+    return members;
+  }
+}
+
+/// [BackgroundTransformer] parsing the large JSON responses natively with the
+/// [LinuxUtils.parseJson] into the lazy [JsonTape] views.
+class JsonTapeTransformer extends BackgroundTransformer {
+  JsonTapeTransformer({this.threshold = 64 * 1024});
+
+  /// Size of the responses in bytes to parse natively starting from.
+  ///
+  /// Smaller ones are decoded by the [BackgroundTransformer], as passing them
+  /// to the runner costs more than decoding them.
+  final int threshold;
+
+  @override
+  Future transformResponse(
+    RequestOptions options,
+    ResponseBody responseBody,
+  ) async {
+    final String? contentType =
+        responseBody.headers[Headers.contentTypeHeader]?.first;
+
+    if (options.responseType != ResponseType.json ||
+        !Transformer.isJsonMimeType(contentType)) {
+      return super.transformResponse(options, responseBody);
+    }
+
+    final BytesBuilder builder = BytesBuilder(copy: false);
+    await for (Uint8List chunk in responseBody.stream) {
+      builder.add(chunk);
+    }
+    final Uint8List bytes = builder.takeBytes();
+
+    if (bytes.length < threshold) {
+      return super.transformResponse(options, _replay(responseBody, bytes));
+    }
+
+    try {
+      return await LinuxUtils.parseJson(bytes);
+    } on PlatformException {
+      // Throws the [FormatException] describing the malformed JSON.
+      return super.transformResponse(options, _replay(responseBody, bytes));
+    }
+  }
+
+  /// Returns the [ResponseBody] of the [bytes] already read from the
+  /// [responseBody].
+  ResponseBody _replay(ResponseBody responseBody, Uint8List bytes) {
+    return ResponseBody.fromBytes(
+      bytes,
+      responseBody.statusCode,
+      headers: responseBody.headers,
+      statusMessage: responseBody.statusMessage,
+      isRedirect: responseBody.isRedirect,
+      redirects: responseBody.redirects,
+    );
+  }
+}
+
+/// Types of the nodes of a [JsonTape].
+enum _JsonTapeType {
+  nullValue,
+  falseValue,
+  trueValue,
+  intValue,
+  doubleValue,
+  stringValue,
+  arrayValue,
+  objectValue,
+}
+
+/// Node of a [JsonTape] not read yet.
+class _JsonTapeNode {
+  const _JsonTapeNode(this.index);
+
+  /// Index of this node in the [JsonTape].
+  final int index;
+}
+
+/// [Map] view of an object of a [JsonTape].
+class _JsonTapeMap extends MapBase<String, dynamic> {
+  _JsonTapeMap(this._tape, this._index);
+
+  /// [JsonTape] this object is of.
+  final JsonTape _tape;
+
+  /// Index of the node of this object in the [_tape].
+  final int _index;
+
+  /// Values by their keys, being [_JsonTapeNode]s until read.
+  late final Map<String, Object?> _members = _tape._members(_index);
+
+  @override
+  Iterable<String> get keys => _members.keys;
+
+  @override
+  int get length => _members.length;
+
+  @override
+  bool containsKey(Object? key) => _members.containsKey(key);
+
+  @override
+  dynamic operator [](Object? key) {
+    final Object? value = _members[key];
+    if (value is _JsonTapeNode) {
+      return _members[key as String] = _tape._value(value.index);
+    }
+
+    return value;
+  }
+
+  @override
+  void operator []=(String key, dynamic value) => _members[key] = value;
+
+  @override
+  dynamic remove(Object? key) {
+    final Object? value = _members.remove(key);
+    if (value is _JsonTapeNode) {
+      return _tape._value(value.index);
+    }
+
+    return value;
+  }
+
+  @override
+  void clear() => _members.clear();
+}
+
+/// [List] view of an array of a [JsonTape].
+class _JsonTapeList extends ListBase<dynamic> {
+  _JsonTapeList(this._tape, this._index);
+
+  /// [JsonTape] this array is of.
+  final JsonTape _tape;
+
+  /// Index of the node of this array in the [_tape].
+  final int _index;
+
+  /// Elements of this array, being [_JsonTapeNode]s until read.
+  late final List<Object?> _elements = _tape._elements(_index);
+
+  @override
+  int get length => _elements.length;
+
+  @override
+  set length(int length) => _elements.length = length;
+
+  @override
+  dynamic operator [](int index) {
+    final Object? value = _elements[index];
+    if (value is _JsonTapeNode) {
+      return _elements[index] = _tape._value(value.index);
+    }
+
+    return value;
+  }
+
+  @override
+  void operator []=(int index, dynamic value) => _elements[index] = value;
+}
@@ -15,15 +15,1234 @@
 // along with this program. If not, see
 // <https://www.gnu.org/licenses/agpl-3.0.html>.
 
+import 'dart:async';
+import 'dart:convert';
+import 'dart:developer' show Timeline;
+import 'dart:typed_data';
+
+import 'package:dio/dio.dart' show CancelToken;
 import 'package:flutter/services.dart';
+import 'package:web_socket/web_socket.dart';
+
+import 'json_tape.dart';
+import 'pause_token.dart';
 
 /// Helper providing direct access to Linux-only features.
 class LinuxUtils {
   /// [MethodChannel] to communicate with Linux via.
   static const _platform = MethodChannel('team113.flutter.dev/linux_utils');
 
+  /// [EventChannel] reporting the progress of the [download]s.
+  static const _downloads = EventChannel(
+    'team113.flutter.dev/linux_utils/downloads',
+  );
+
+  /// [EventChannel] reporting the progress of the [upload]s.
+  static const _uploads = EventChannel(
+    'team113.flutter.dev/linux_utils/uploads',
+  );
+
+  /// [EventChannel] receiving the command line [arguments] forwarded by the
+  /// application launched again while running.
+  static const _arguments = EventChannel(
+    'team113.flutter.dev/linux_utils/arguments',
+  );
+
+  /// [EventChannel] reporting the [memoryPressure] changes.
+  static const _memoryPressure = EventChannel(
+    'team113.flutter.dev/linux_utils/memory_pressure',
+  );
+
+  /// [EventChannel] reporting the events of the [connectWebSocket]s.
+  static const _webSocket = EventChannel(
+    'team113.flutter.dev/linux_utils/websocket',
+  );
+
+  /// Name of the channel exchanging the raw binary frames with the runner via
+  /// the [BinaryMessenger], so the large payloads aren't boxed and copied by
+  /// the [StandardMethodCodec].
+  ///
+  /// Requests are framed as the 32-bit request ID and [_BulkOpcode] followed
+  /// by the payload, and are replied to with the same request ID and a 32-bit
+  /// status followed by the payload of the result, both in [Endian.host].
+  static const String _bulk = 'team113.flutter.dev/linux_utils/bulk';
+
+  /// Size of the header of the [_bulk] frames.
+  static const int _bulkHeaderSize = 8;
+
+  /// ID of the last request sent over the [_bulk] channel.
+  static int _bulkId = 0;
+
+  /// Broadcast [Stream] of the [_downloads] events.
+  static Stream<Map>? _downloadEvents;
+
+  /// ID of the last started [download].
+  static int _downloadId = 0;
+
+  /// Broadcast [Stream] of the [_uploads] events.
+  static Stream<Map>? _uploadEvents;
+
+  /// ID of the last started [upload].
+  static int _uploadId = 0;
+
+  /// Broadcast [Stream] of the [_webSocket] events.
+  static Stream<Map>? _webSocketEvents;
+
+  /// ID of the last [LinuxWebSocket] connected.
+  static int _webSocketId = 0;
+
+  /// Indicator whether the native startup trace is being recorded, or `null`
+  /// if not known yet.
+  static bool? _tracing;
+
+  /// Returns the [Stream] of the command line arguments the application is
+  /// launched with again (e.g. to open a link), while this instance is
+  /// running.
+  ///
+  /// Such launches don't start another instance, but forward the arguments to
+  /// this one and raise its window instead.
+  static Stream<List<String>> get arguments => _arguments
+      .receiveBroadcastStream()
+      .map((e) => (e as List).cast<String>());
+
+  /// Returns the [Stream] of the [MemoryPressure] changes, starting with the
+  /// current one.
+  ///
+  /// Pressure is detected natively via the PSI triggers and cgroup v2 memory
+  /// events, and is reported again, if it lasts, so the caches are shed before
+  /// the kernel starts killing the processes.
+  static Stream<MemoryPressure> get memoryPressure =>
+      _memoryPressure.receiveBroadcastStream().map(
+        (e) => MemoryPressure.values.firstWhere(
+          (p) => p.name == (e as Map)['level'],
+          orElse: () => MemoryPressure.none,
+        ),
+      );
+
   /// Redirects `stdout` and `stderr` streams to a `app.log` file.
-  static Future<void> redirectStdOut() async {
-    await _platform.invokeMethod('redirectStdOut');
+  ///
+  /// The file is rotated once it exceeds the [maxSize] bytes (or never, if
+  /// it's `0`), keeping the [maxFiles] of the rotated ones compressed with the
+  /// provided [compression] (either `none`, `gzip` or `zstd`).
+  static Future<void> redirectStdOut({
+    int maxSize = 16 * 1024 * 1024,
+    int maxFiles = 5,
+    String compression = 'gzip',
+  }) async {
+    await _platform.invokeMethod('redirectStdOut', {
+      'maxSize': maxSize,
+      'maxFiles': maxFiles,
+      'compression': compression,
+    });
+  }
+
+  /// Opens the native log sink appending to the file at the provided [path].
+  ///
+  /// The file is started over, if it's already exceeding the [truncateAt] bytes.
+  ///
+  /// Returns the size of the file.
+  static Future<int> openLogs(
+    String path, {
+    int truncateAt = 64 * 1024 * 1024,
+  }) async {
+    return await _platform.invokeMethod('openLogs', {
+      'path': path,
+      'truncateAt': truncateAt,
+    });
+  }
+
+  /// Appends the UTF-8 encoded [bytes] to the native log sink opened via
+  /// [openLogs].
+  static Future<void> appendLogs(Uint8List bytes) async {
+    await _platform.invokeMethod('appendLogs', bytes);
+  }
+
+  /// Flushes the native log sink opened via [openLogs] to the disk, so that
+  /// its file can be read.
+  ///
+  /// Returns the size of the file.
+  static Future<int> flushLogs() async {
+    return await _platform.invokeMethod('flushLogs');
+  }
+
+  /// Closes the native log sink opened via [openLogs].
+  static Future<void> closeLogs() async {
+    await _platform.invokeMethod('closeLogs');
+  }
+
+  /// Records the startup phase [name] lasted from the [start] to the [end],
+  /// or the moment [start], if [end] is `null`, into the native startup trace.
+  ///
+  /// Both are in [Timeline.now] microseconds, sharing the clock with the
+  /// runner's phases.
+  ///
+  /// No-op, unless the application is launched with the
+  /// `--startup-trace=<path>` argument or the `MESSENGER_STARTUP_TRACE`
+  /// environment variable.
+  static Future<void> traceStartup(String name, int start, [int? end]) async {
+    if (_tracing == false) {
+      return;
+    }
+
+    _tracing = await _platform.invokeMethod('traceStartup', {
+      'name': name,
+      'start': start,
+      'end': end,
+    });
+  }
+
+  /// Writes the native startup trace in the Chrome trace JSON format to the
+  /// path it's enabled with.
+  ///
+  /// Returns `false`, if the trace isn't enabled or can't be written.
+  static Future<bool> writeStartupTrace() async {
+    if (_tracing == false) {
+      return false;
+    }
+
+    return await _platform.invokeMethod('writeStartupTrace') ?? false;
+  }
+
+  /// Registers the plugins the runner defers registering until after the
+  /// first frame (e.g. `medea_jason`), if not registered yet.
+  ///
+  /// Must be awaited before using those plugins, as their calls aren't
+  /// handled until then.
+  static Future<void> registerDeferredPlugins() async {
+    await _platform.invokeMethod('registerDeferredPlugins');
+  }
+
+  /// Returns the [DatabaseMaintenanceStats] of the SQLite databases being
+  /// maintained natively: checkpointed, vacuumed and optimized when idle.
+  static Future<List<DatabaseMaintenanceStats>> databaseMaintenance() async {
+    final List? result = await _platform.invokeMethod('databaseMaintenance');
+    return result?.map((e) => DatabaseMaintenanceStats._fromMap(e)).toList() ??
+        [];
+  }
+
+  /// Starts sampling the CPU time, RSS, storage I/O, context switches and file
+  /// descriptors of the process and its threads natively every [interval],
+  /// keeping the last [capacity] samples, discarding the ones taken before, if
+  /// any.
+  ///
+  /// Hardware counters of the user space are sampled as well, if [perf] is
+  /// `true` and the `perf_event_open` is permitted.
+  ///
+  /// Returns `true`, if the [perf] counters are sampled.
+  static Future<bool> startSampling({
+    Duration interval = const Duration(seconds: 1),
+    int capacity = 120,
+    bool perf = false,
+  }) async {
+    return await _platform.invokeMethod('startSampling', {
+          'interval': interval.inMilliseconds,
+          'capacity': capacity,
+          'perf': perf,
+        }) ??
+        false;
+  }
+
+  /// Stops sampling started with the [startSampling], keeping the samples.
+  static Future<void> stopSampling() async {
+    await _platform.invokeMethod('stopSampling');
+  }
+
+  /// Returns the [ProcessSummary] of the samples taken within the last
+  /// [window], or of all of them, if it's `null`.
+  static Future<ProcessSummary> processSummary([Duration? window]) async {
+    final Map? result = await _platform.invokeMethod('processSummary', {
+      'window': window?.inMilliseconds ?? 0,
+    });
+
+    return result == null
+        ? const ProcessSummary()
+        : ProcessSummary._fromMap(result);
+  }
+
+  /// Returns the [FrameTimings] of the window recorded natively since the last
+  /// [resetFrameTimings].
+  static Future<FrameTimings> frameTimings() async {
+    final Map? result = await _platform.invokeMethod('frameTimings');
+    return result == null
+        ? const FrameTimings()
+        : FrameTimings._fromMap(result);
+  }
+
+  /// Resets the [FrameTimings] recorded natively.
+  static Future<void> resetFrameTimings() async {
+    await _platform.invokeMethod('resetFrameTimings');
+  }
+
+  /// Decodes the provided sound [assets] natively into the memory, so they
+  /// are played with [playSound] without any decoding.
+  ///
+  /// Returns the [assets] decoded, which are none, if the runner is built
+  /// without the decoders.
+  static Future<List<String>> preloadSounds(List<String> assets) async {
+    final List? result = await _platform.invokeMethod('preloadSounds', {
+      'assets': assets,
+    });
+
+    return result?.cast<String>() ?? [];
+  }
+
+  /// Plays the sound [asset] preloaded with [preloadSounds] natively, mixing
+  /// it with the ones being played, with the provided [gain] from 0 to 1.
+  ///
+  /// Returns the [Duration] of the sound, or [Duration.zero], if it's dropped
+  /// as the same sound was played too recently, or `null`, if the [asset]
+  /// can't be played natively.
+  static Future<Duration?> playSound(String asset, {double gain = 1}) async {
+    final int? result = await _platform.invokeMethod('playSound', {
+      'asset': asset,
+      'gain': gain,
+    });
+
+    return result == null ? null : Duration(microseconds: result);
+  }
+
+  /// Returns the SHA-256 hash of the provided [bytes] as a hex string.
+  ///
+  /// Calculated natively on a worker thread, passing the [bytes] without
+  /// boxing them.
+  static Future<String> sha256(Uint8List bytes) async {
+    final Uint8List digest = await _sendBulk(_BulkOpcode.sha256, bytes);
+    return String.fromCharCodes(digest);
+  }
+
+  /// Returns the SHA-256 hashes of the files at the provided [paths] as hex
+  /// strings, or `null`s for the ones failed to be read.
+  ///
+  /// Calculated natively on worker threads, without reading the files into
+  /// memory.
+  static Future<List<String?>> sha256Files(List<String> paths) async {
+    final List? hashes = await _platform.invokeMethod('sha256Files', {
+      'paths': paths,
+    });
+
+    return hashes?.cast<String?>() ?? [];
+  }
+
+  /// Scans the cache [directory] recursively, returning its total size and
+  /// the names of its files sorted from the least to the most recently
+  /// accessed.
+  ///
+  /// Files are stat-ed natively on worker threads.
+  static Future<CacheScan> scanCache(String directory) async {
+    final Map? result = await _platform.invokeMethod('scanCache', {
+      'path': directory,
+    });
+
+    return CacheScan._fromMap(result);
+  }
+
+  /// Removes the least recently accessed files from the cache [directory]
+  /// until at least [bytes] are freed, skipping the files named in [keep].
+  ///
+  /// Returns the [CacheScan] of the [directory] after the eviction.
+  static Future<CacheScan> evictCache(
+    String directory,
+    int bytes, {
+    List<String> keep = const [],
+  }) async {
+    final Map? result = await _platform.invokeMethod('evictCache', {
+      'path': directory,
+      'target': bytes,
+      'keep': keep,
+    });
+
+    return CacheScan._fromMap(result);
+  }
+
+  /// Opens the persistent cache index at [path] indexing the files of the
+  /// cache [directory], populating it from the [directory] if it's new.
+  ///
+  /// Returns the [CacheScan] of the indexed files.
+  static Future<CacheScan> openCacheIndex(String path, String directory) async {
+    final Map? result = await _platform.invokeMethod('openCacheIndex', {
+      'path': path,
+      'directory': directory,
+    });
+
+    return CacheScan._fromMap(result);
+  }
+
+  /// Rebuilds the opened cache index from its directory.
+  static Future<CacheScan> rebuildCacheIndex() async {
+    final Map? result = await _platform.invokeMethod('rebuildCacheIndex');
+    return CacheScan._fromMap(result);
+  }
+
+  /// Marks the file with the provided [checksum] as the most recently used in
+  /// the opened cache index.
+  static Future<bool> touchCache(String checksum) async {
+    return await _platform.invokeMethod('touchCache', {'checksum': checksum});
+  }
+
+  /// Adds the file with the provided [checksum] of [size] bytes to the opened
+  /// cache index.
+  ///
+  /// Returns the total size of the indexed files.
+  static Future<int> addCache(String checksum, int size) async {
+    return await _platform.invokeMethod('addCache', {
+      'checksum': checksum,
+      'size': size,
+    });
+  }
+
+  /// Removes the least recently used files of the opened cache index until at
+  /// least [bytes] are freed.
+  ///
+  /// Returns the [CacheScan] with the new size and the removed files.
+  static Future<CacheScan> evictCacheIndex(int bytes) async {
+    final Map? result = await _platform.invokeMethod('evictCacheIndex', {
+      'target': bytes,
+    });
+
+    return CacheScan._fromMap(result);
+  }
+
+  /// Closes the opened cache index.
+  static Future<void> closeCacheIndex() async {
+    await _platform.invokeMethod('closeCacheIndex');
+  }
+
+  /// Downloads the file from the provided [url] to the [path] over up to the
+  /// [connections] parallel HTTP Range requests.
+  ///
+  /// Resumes the download interrupted previously, if the `.part` file of the
+  /// [path] is left and the file on the server hasn't changed since.
+  ///
+  /// Returns the SHA-256 hash of the downloaded file, computed natively while
+  /// downloading.
+  ///
+  /// Throws a [PlatformException] with the `HTTP_ERROR` code and the HTTP
+  /// status as its details, if the server responds with an error.
+  static Future<String> download(
+    String url,
+    String path, {
+    int connections = 4,
+    Map<String, String> headers = const {},
+    void Function(int received, int total)? onProgress,
+    CancelToken? cancelToken,
+  }) async {
+    final int id = ++_downloadId;
+
+    _downloadEvents ??= _downloads.receiveBroadcastStream().cast<Map>();
+    final StreamSubscription? subscription = onProgress == null
+        ? null
+        : _downloadEvents!
+              .where((e) => e['id'] == id)
+              .listen((e) => onProgress(e['received'], e['total']));
+
+    cancelToken?.whenCancel.then((_) {
+      _platform.invokeMethod('cancelDownload', {'id': id});
+    });
+
+    try {
+      final Map? result = await _platform.invokeMethod('download', {
+        'id': id,
+        'url': url,
+        'path': path,
+        'connections': connections,
+        'headers': headers,
+      });
+
+      return result?['sha256'];
+    } finally {
+      await subscription?.cancel();
+    }
+  }
+
+  /// Uploads the file at the [path] to the provided [url] as the [field] of a
+  /// `multipart/form-data` POST request following the [fields], streaming it
+  /// natively without reading it into the memory.
+  ///
+  /// SHA-256 hash and the MIME-type of the file are determined natively while
+  /// uploading, with the [contentType] used if the latter isn't recognized by
+  /// the magic numbers.
+  ///
+  /// [pauseToken] may be used to pause and resume sending the file.
+  ///
+  /// Throws a [PlatformException] with the `HTTP_ERROR` code and the
+  /// `{status, response}` of the response as its details, if the server
+  /// responds with an error.
+  static Future<NativeUpload> upload(
+    String url,
+    String path, {
+    String field = 'file',
+    String? filename,
+    String? contentType,
+    Map<String, String> fields = const {},
+    Map<String, String> headers = const {},
+    void Function(int sent, int total)? onProgress,
+    CancelToken? cancelToken,
+    PauseToken? pauseToken,
+  }) async {
+    final int id = ++_uploadId;
+
+    _uploadEvents ??= _uploads.receiveBroadcastStream().cast<Map>();
+    final StreamSubscription? subscription = onProgress == null
+        ? null
+        : _uploadEvents!
+              .where((e) => e['id'] == id)
+              .listen((e) => onProgress(e['sent'], e['total']));
+
+    final StreamSubscription? pauses = pauseToken?.changes.listen((paused) {
+      _platform.invokeMethod(paused ? 'pauseUpload' : 'resumeUpload', {
+        'id': id,
+      });
+    });
+
+    cancelToken?.whenCancel.then((_) {
+      _platform.invokeMethod('cancelUpload', {'id': id});
+    });
+
+    try {
+      final Map result = await _platform.invokeMethod('upload', {
+        'id': id,
+        'url': url,
+        'path': path,
+        'field': field,
+        'filename': filename,
+        'contentType': contentType,
+        'fields': fields,
+        'headers': headers,
+        'paused': pauseToken?.isPaused ?? false,
+      });
+
+      return NativeUpload._fromMap(result);
+    } finally {
+      await pauses?.cancel();
+      await subscription?.cancel();
+    }
+  }
+
+  /// Reconstructs the [target] file from the files in the [source] directory
+  /// (e.g. the installed application bundle) and the delta [patch] made
+  /// against them.
+  ///
+  /// Returns the SHA-256 hash of the [target], verified against the one
+  /// recorded in the [patch] and the provided [sha256], if any.
+  ///
+  /// Throws a [PlatformException] with the `SOURCE_MISMATCH` code, if the
+  /// [source] files differ from the ones the [patch] was made against, or
+  /// with the `PATCH_ERROR` or `CHECKSUM_ERROR` codes, if the [patch] is
+  /// malformed or results in an unexpected file, which isn't left then.
+  static Future<String> applyDeltaPatch({
+    required String source,
+    required String patch,
+    required String target,
+    String? sha256,
+  }) async {
+    return await _platform.invokeMethod('applyDeltaPatch', {
+      'source': source,
+      'patch': patch,
+      'target': target,
+      'sha256': sha256,
+    });
+  }
+
+  /// Decodes the images at the provided [paths] and writes their previews
+  /// fitting each of the [sizes] to the [directory].
+  ///
+  /// Returns the [ImagePreviews] of each of the [paths], or `null`s for the
+  /// ones failed to be decoded.
+  ///
+  /// Decoded, oriented according to their EXIF and downscaled natively on
+  /// worker threads, so only the paths to the previews are passed back.
+  static Future<List<ImagePreviews?>> createImagePreviews(
+    List<String> paths, {
+    required List<int> sizes,
+    required String directory,
+    int quality = 85,
+    ImagePreviewFilter filter = ImagePreviewFilter.lanczos,
+  }) async {
+    final List? result = await _platform.invokeMethod('createImagePreviews', {
+      'paths': paths,
+      'sizes': sizes,
+      'directory': directory,
+      'quality': quality,
+      'filter': filter.name,
+    });
+
+    return result
+            ?.map((e) => e == null ? null : ImagePreviews._fromMap(e))
+            .toList() ??
+        [];
+  }
+
+  /// Connects a [LinuxWebSocket] to the provided `ws` or `wss` [url] with the
+  /// [protocols] and the additional [headers].
+  ///
+  /// The connection runs its own event loop on a native thread, answering the
+  /// pings of the `graphql-transport-ws` protocol and sending its own ones
+  /// every 5 seconds there, and delivering the messages received in batches.
+  ///
+  /// Throws a [WebSocketException], if the connection fails.
+  static Future<LinuxWebSocket> connectWebSocket(
+    Uri url, {
+    Iterable<String>? protocols,
+    Map<String, String> headers = const {},
+  }) async {
+    final LinuxWebSocket socket = LinuxWebSocket._(++_webSocketId);
+
+    _webSocketEvents ??= _webSocket.receiveBroadcastStream().cast<Map>();
+    socket._subscription = _webSocketEvents!
+        .where((e) => e['id'] == socket._id)
+        .listen(socket._handle);
+
+    try {
+      await _platform.invokeMethod('connectWebSocket', {
+        'id': socket._id,
+        'url': url.toString(),
+        'protocols': protocols?.toList() ?? [],
+        'headers': headers,
+      });
+    } catch (_) {
+      await socket._subscription?.cancel();
+      rethrow;
+    }
+
+    await socket._opened.future;
+    return socket;
+  }
+
+  /// Parses the JSON [bytes] natively on a worker thread into a [JsonTape],
+  /// returning its root value.
+  ///
+  /// Arrays and objects are returned as the lazy [List] and [Map] views,
+  /// creating their values once accessed.
+  ///
+  /// Throws a [PlatformException], if the [bytes] aren't a valid JSON.
+  static Future<Object?> parseJson(Uint8List bytes) async {
+    return JsonTape(await _sendBulk(_BulkOpcode.parseJson, bytes)).root;
+  }
+
+  /// Sends the [payload] with the [opcode] over the [_bulk] channel, returning
+  /// the payload of the reply.
+  ///
+  /// Throws a [PlatformException], if the request isn't handled.
+  static Future<Uint8List> _sendBulk(
+    _BulkOpcode opcode,
+    Uint8List payload,
+  ) async {
+    final int id = _bulkId = (_bulkId + 1) & 0xFFFFFFFF;
+
+    final Uint8List request = Uint8List(_bulkHeaderSize + payload.length);
+    ByteData.sublistView(request)
+      ..setUint32(0, id, Endian.host)
+      ..setUint32(4, opcode.index, Endian.host);
+    request.setRange(_bulkHeaderSize, request.length, payload);
+
+    final ByteData? reply = await ServicesBinding
+        .instance
+        .defaultBinaryMessenger
+        .send(_bulk, ByteData.sublistView(request));
+
+    if (reply == null) {
+      throw MissingPluginException('No handler for `$_bulk` channel');
+    }
+
+    if (reply.lengthInBytes < _bulkHeaderSize) {
+      throw PlatformException(
+        code: 'BULK_ERROR',
+        message: 'Reply to request $id with `${opcode.name}` is truncated',
+      );
+    }
+
+    final int status = reply.getUint32(4, Endian.host);
+    if (status != 0 || reply.getUint32(0, Endian.host) != id) {
+      throw PlatformException(
+        code: 'BULK_ERROR',
+        message: 'Request $id with `${opcode.name}` failed: $status',
+      );
+    }
+
+    return Uint8List.sublistView(reply, _bulkHeaderSize);
+  }
+}
+
+/// [WebSocket] connected natively by [LinuxUtils.connectWebSocket].
+class LinuxWebSocket implements WebSocket {
+  LinuxWebSocket._(this._id);
+
+  /// ID of this [LinuxWebSocket] in the [LinuxUtils._webSocket] events.
+  final int _id;
+
+  /// [StreamController] of the [events].
+  final StreamController<WebSocketEvent> _events = StreamController();
+
+  /// [Completer] resolving once this [LinuxWebSocket] is connected.
+  final Completer<void> _opened = Completer();
+
+  /// [StreamSubscription] to the [LinuxUtils._webSocket] events of this
+  /// [LinuxWebSocket].
+  StreamSubscription? _subscription;
+
+  /// Subprotocol negotiated with the server.
+  String _protocol = '';
+
+  @override
+  Stream<WebSocketEvent> get events => _events.stream;
+
+  @override
+  String get protocol => _protocol;
+
+  @override
+  void sendText(String s) {
+    if (_events.isClosed) {
+      throw WebSocketConnectionClosed();
+    }
+
+    LinuxUtils._platform.invokeMethod('sendWebSocket', {'id': _id, 'text': s});
   }
+
+  @override
+  void sendBytes(Uint8List b) {
+    if (_events.isClosed) {
+      throw WebSocketConnectionClosed();
+    }
+
+    throw WebSocketException('Binary messages are not supported');
+  }
+
+  @override
+  Future<void> close([int? code, String? reason]) async {
+    if (code != null && code != 1000 && (code < 3000 || code > 4999)) {
+      throw ArgumentError('Invalid argument: $code', 'code');
+    }
+
+    if (reason != null && utf8.encode(reason).length > 123) {
+      throw ArgumentError.value(reason, 'reason', 'Must be <= 123 bytes');
+    }
+
+    if (_events.isClosed) {
+      throw WebSocketConnectionClosed();
+    }
+
+    unawaited(_events.close());
+    await LinuxUtils._platform.invokeMethod('closeWebSocket', {
+      'id': _id,
+      'code': code ?? 1000,
+      'reason': reason ?? '',
+    });
+  }
+
+  /// Handles the [event] of the [LinuxUtils._webSocket] channel.
+  void _handle(Map event) {
+    switch (event['type']) {
+      case 'open':
+        _protocol = event['protocol'];
+        _opened.complete();
+        break;
+
+      case 'messages':
+        if (!_events.isClosed) {
+          for (String message in event['messages']) {
+            _events.add(TextDataReceived(message));
+          }
+        }
+        break;
+
+      case 'closed':
+        _subscription?.cancel();
+
+        if (!_opened.isCompleted) {
+          _opened.completeError(WebSocketException(event['reason']));
+        } else if (!_events.isClosed) {
+          _events.add(CloseReceived(event['code'], event['reason']));
+          _events.close();
+        }
+        break;
+    }
+  }
+}
+
+/// Result of [LinuxUtils.upload].
+class NativeUpload {
+  const NativeUpload({
+    required this.status,
+    required this.response,
+    required this.sha256,
+    required this.mime,
+    required this.size,
+  });
+
+  /// Constructs a [NativeUpload] from the [map] received from the platform.
+  factory NativeUpload._fromMap(Map map) {
+    return NativeUpload(
+      status: map['status'],
+      response: map['response'],
+      sha256: map['sha256'],
+      mime: map['mime'],
+      size: map['size'],
+    );
+  }
+
+  /// HTTP status of the response.
+  final int status;
+
+  /// Body of the response.
+  final Uint8List response;
+
+  /// SHA-256 hash of the uploaded file.
+  final String sha256;
+
+  /// MIME-type the file was uploaded with.
+  final String mime;
+
+  /// Size of the uploaded file in bytes.
+  final int size;
+}
+
+/// Result of [LinuxUtils.scanCache], [LinuxUtils.evictCache] and the cache
+/// index methods.
+class CacheScan {
+  const CacheScan({
+    this.size = 0,
+    this.checksums = const [],
+    this.removed = const [],
+  });
+
+  /// Constructs a [CacheScan] from the [map] received from the platform.
+  factory CacheScan._fromMap(Map? map) {
+    return CacheScan(
+      size: map?['size'] ?? 0,
+      checksums: (map?['checksums'] as List?)?.cast<String>() ?? [],
+      removed: (map?['removed'] as List?)?.cast<String>() ?? [],
+    );
+  }
+
+  /// Total size of the scanned files in bytes.
+  final int size;
+
+  /// Names of the scanned files sorted from the least to the most recently
+  /// accessed.
+  final List<String> checksums;
+
+  /// Names of the files removed by [LinuxUtils.evictCache].
+  final List<String> removed;
+}
+
+/// Memory pressure reported by [LinuxUtils.memoryPressure].
+enum MemoryPressure {
+  /// Memory is reclaimed without stalling.
+  none,
+
+  /// Memory is reclaimed with stalls, so the caches being cheap to restore
+  /// should be dropped.
+  moderate,
+
+  /// Memory is about to run out, so everything that can be restored should be
+  /// dropped.
+  critical,
+}
+
+/// Filter to downscale the images with in [LinuxUtils.createImagePreviews].
+enum ImagePreviewFilter {
+  /// Averages the covered pixels, fast and suitable for large downscaling.
+  area,
+
+  /// Lanczos windowed sinc, keeping the details sharp.
+  lanczos,
+}
+
+/// Result of [LinuxUtils.createImagePreviews] for a single image.
+class ImagePreviews {
+  const ImagePreviews({
+    required this.width,
+    required this.height,
+    this.previews = const [],
+  });
+
+  /// Constructs [ImagePreviews] from the [map] received from the platform.
+  factory ImagePreviews._fromMap(Map map) {
+    return ImagePreviews(
+      width: map['width'],
+      height: map['height'],
+      previews: (map['previews'] as List?)?.cast<String>() ?? [],
+    );
+  }
+
+  /// Width of the original image with its orientation applied.
+  final int width;
+
+  /// Height of the original image with its orientation applied.
+  final int height;
+
+  /// Paths to the previews in the order of the requested sizes.
+  final List<String> previews;
+}
+
+/// Statistics of the native maintenance of a single SQLite database.
+class DatabaseMaintenanceStats {
+  const DatabaseMaintenanceStats({
+    required this.path,
+    this.walSize = 0,
+    this.passiveCheckpoints = 0,
+    this.truncateCheckpoints = 0,
+    this.checkpointedFrames = 0,
+    this.truncatedBytes = 0,
+    this.vacuumedPages = 0,
+    this.optimizations = 0,
+    this.busy = 0,
+    this.lastRun,
+    this.lastError,
+  });
+
+  /// Constructs [DatabaseMaintenanceStats] from the [map] received from the
+  /// platform.
+  factory DatabaseMaintenanceStats._fromMap(Map map) {
+    final int lastRun = map['lastRun'] ?? 0;
+
+    return DatabaseMaintenanceStats(
+      path: map['path'],
+      walSize: map['walSize'] ?? 0,
+      passiveCheckpoints: map['passiveCheckpoints'] ?? 0,
+      truncateCheckpoints: map['truncateCheckpoints'] ?? 0,
+      checkpointedFrames: map['checkpointedFrames'] ?? 0,
+      truncatedBytes: map['truncatedBytes'] ?? 0,
+      vacuumedPages: map['vacuumedPages'] ?? 0,
+      optimizations: map['optimizations'] ?? 0,
+      busy: map['busy'] ?? 0,
+      lastRun: lastRun == 0
+          ? null
+          : DateTime.fromMillisecondsSinceEpoch(lastRun),
+      lastError: map['lastError'],
+    );
+  }
+
+  /// Path to the database file.
+  final String path;
+
+  /// Size of the `-wal` file in bytes as of the last check.
+  final int walSize;
+
+  /// Number of the `PASSIVE` checkpoints completed.
+  final int passiveCheckpoints;
+
+  /// Number of the `TRUNCATE` checkpoints completed.
+  final int truncateCheckpoints;
+
+  /// Number of the WAL frames copied into the database.
+  final int checkpointedFrames;
+
+  /// Number of the `-wal` file bytes released by truncating it.
+  final int truncatedBytes;
+
+  /// Number of the free pages released by the `incremental_vacuum`.
+  final int vacuumedPages;
+
+  /// Number of the `PRAGMA optimize` completed.
+  final int optimizations;
+
+  /// Number of the operations skipped, as the database was locked.
+  final int busy;
+
+  /// [DateTime] of the last maintenance, if any.
+  final DateTime? lastRun;
+
+  /// Message of the last error, if any.
+  final String? lastError;
+
+  @override
+  String toString() =>
+      '${path.split('/').last}: WAL ${walSize ~/ 1024} KB, '
+      'checkpoints $passiveCheckpoints passive ($checkpointedFrames frames) '
+      'and $truncateCheckpoints truncate (${truncatedBytes ~/ 1024} KB), '
+      'vacuumed $vacuumedPages pages, optimized $optimizations times, '
+      'busy $busy times, last at $lastRun'
+      '${lastError == null ? '' : ', error: $lastError'}';
+}
+
+/// Usage of the process over a window of the native samples.
+class ProcessSummary {
+  const ProcessSummary({
+    this.samples = 0,
+    this.duration = Duration.zero,
+    this.cpu = 0,
+    this.rss = 0,
+    this.maxRss = 0,
+    this.fds = 0,
+    this.perf = false,
+    this.threads = const [],
+  });
+
+  /// Constructs [ProcessSummary] from the [map] received from the platform.
+  factory ProcessSummary._fromMap(Map map) {
+    return ProcessSummary(
+      samples: map['samples'] ?? 0,
+      duration: Duration(milliseconds: map['duration'] ?? 0),
+      cpu: map['cpu'] ?? 0,
+      rss: map['rss'] ?? 0,
+      maxRss: map['maxRss'] ?? 0,
+      fds: map['fds'] ?? 0,
+      perf: map['perf'] ?? false,
+      threads:
+          (map['threads'] as List?)
+              ?.map((e) => ThreadSummary._fromMap(e))
+              .toList() ??
+          [],
+    );
+  }
+
+  /// Number of the samples summarized.
+  final int samples;
+
+  /// [Duration] between the first and the last sample.
+  final Duration duration;
+
+  /// CPU time of the process in percents of a single core.
+  final double cpu;
+
+  /// Resident set size in bytes as of the last sample.
+  final int rss;
+
+  /// Maximum resident set size in bytes over the samples.
+  final int maxRss;
+
+  /// Number of the open file descriptors as of the last sample.
+  final int fds;
+
+  /// Indicator whether the `perf_event_open` counters are sampled.
+  final bool perf;
+
+  /// [ThreadSummary]s sorted by their CPU time descending.
+  final List<ThreadSummary> threads;
+
+  @override
+  String toString() =>
+      'CPU ${cpu.toStringAsFixed(1)}% over ${duration.inSeconds}s, '
+      'RSS ${rss ~/ (1024 * 1024)} MB (max ${maxRss ~/ (1024 * 1024)} MB), '
+      '$fds fds';
+}
+
+/// Usage of the threads sharing the same label, e.g. `flutter.ui`, over a
+/// window of the native samples.
+class ThreadSummary {
+  const ThreadSummary({
+    required this.label,
+    this.count = 1,
+    this.cpu = 0,
+    this.minorFaults = 0,
+    this.majorFaults = 0,
+    this.readBytes = 0,
+    this.writeBytes = 0,
+    this.cycles,
+    this.instructions,
+    this.contextSwitches,
+  });
+
+  /// Constructs [ThreadSummary] from the [map] received from the platform.
+  factory ThreadSummary._fromMap(Map map) {
+    return ThreadSummary(
+      label: map['label'],
+      count: map['count'] ?? 1,
+      cpu: map['cpu'] ?? 0,
+      minorFaults: map['minorFaults'] ?? 0,
+      majorFaults: map['majorFaults'] ?? 0,
+      readBytes: map['readBytes'] ?? 0,
+      writeBytes: map['writeBytes'] ?? 0,
+      cycles: map['cycles'],
+      instructions: map['instructions'],
+      contextSwitches: map['contextSwitches'],
+    );
+  }
+
+  /// Label of the threads.
+  final String label;
+
+  /// Number of the threads with the [label].
+  final int count;
+
+  /// CPU time in percents of a single core.
+  final double cpu;
+
+  /// Number of the page faults not requiring the storage I/O.
+  final int minorFaults;
+
+  /// Number of the page faults requiring the storage I/O.
+  final int majorFaults;
+
+  /// Number of the bytes read from the storage.
+  final int readBytes;
+
+  /// Number of the bytes written to the storage.
+  final int writeBytes;
+
+  /// Number of the CPU cycles in the user space, if sampled.
+  final int? cycles;
+
+  /// Number of the CPU instructions in the user space, if sampled.
+  final int? instructions;
+
+  /// Number of the voluntary and involuntary context switches, if sampled.
+  final int? contextSwitches;
+
+  @override
+  String toString() {
+    final StringBuffer buffer = StringBuffer(
+      '$label${count > 1 ? ' x$count' : ''}: CPU ${cpu.toStringAsFixed(1)}%, '
+      'faults $minorFaults/$majorFaults, '
+      'I/O ${readBytes ~/ 1024}/${writeBytes ~/ 1024} KB',
+    );
+
+    if (cycles != null && instructions != null && cycles != 0) {
+      buffer.write(', IPC ${(instructions! / cycles!).toStringAsFixed(2)}');
+    }
+
+    if (contextSwitches != null) {
+      buffer.write(', $contextSwitches switches');
+    }
+
+    return buffer.toString();
+  }
+}
+
+/// Frame pacing of the window recorded natively by its frame clock.
+class FrameTimings {
+  const FrameTimings({
+    this.frames = 0,
+    this.missedVsyncs = 0,
+    this.refreshInterval = Duration.zero,
+    this.intervals = const TimingHistogram(),
+    this.paint = const TimingHistogram(),
+    this.latency = const TimingHistogram(),
+  });
+
+  /// Constructs [FrameTimings] from the [map] received from the platform.
+  factory FrameTimings._fromMap(Map map) {
+    return FrameTimings(
+      frames: map['frames'] ?? 0,
+      missedVsyncs: map['missedVsyncs'] ?? 0,
+      refreshInterval: Duration(microseconds: map['refreshInterval'] ?? 0),
+      intervals: TimingHistogram._fromMap(map['intervals'] ?? {}),
+      paint: TimingHistogram._fromMap(map['paint'] ?? {}),
+      latency: TimingHistogram._fromMap(map['latency'] ?? {}),
+    );
+  }
+
+  /// Number of the frames painted.
+  final int frames;
+
+  /// Number of the vertical refreshes passed without a frame being painted,
+  /// while the frames were painted continuously.
+  final int missedVsyncs;
+
+  /// Refresh interval of the monitor as of the last frame.
+  final Duration refreshInterval;
+
+  /// [TimingHistogram] of the intervals between the frames painted
+  /// continuously.
+  final TimingHistogram intervals;
+
+  /// [TimingHistogram] of the time from the start of a frame till it's
+  /// painted.
+  final TimingHistogram paint;
+
+  /// [TimingHistogram] of the time from the start of a frame till it's
+  /// presented on the monitor, if reported by the compositor.
+  final TimingHistogram latency;
+
+  /// Returns a JSON representation of these [FrameTimings] in microseconds.
+  Map<String, dynamic> toJson() => {
+    'frames': frames,
+    'missedVsyncs': missedVsyncs,
+    'refreshInterval': refreshInterval.inMicroseconds,
+    'intervals': intervals.toJson(),
+    'paint': paint.toJson(),
+    'latency': latency.toJson(),
+  };
+
+  @override
+  String toString() =>
+      '$frames frames, $missedVsyncs missed vsyncs of '
+      '${refreshInterval.inMicroseconds} us, intervals: $intervals, '
+      'paint: $paint, latency: $latency';
+}
+
+/// Percentiles of the [Duration]s recorded into a native histogram.
+class TimingHistogram {
+  const TimingHistogram({
+    this.count = 0,
+    this.min = Duration.zero,
+    this.max = Duration.zero,
+    this.mean = Duration.zero,
+    this.p50 = Duration.zero,
+    this.p90 = Duration.zero,
+    this.p99 = Duration.zero,
+    this.p999 = Duration.zero,
+  });
+
+  /// Constructs [TimingHistogram] from the [map] received from the platform.
+  factory TimingHistogram._fromMap(Map map) {
+    return TimingHistogram(
+      count: map['count'] ?? 0,
+      min: Duration(microseconds: map['min'] ?? 0),
+      max: Duration(microseconds: map['max'] ?? 0),
+      mean: Duration(microseconds: (map['mean'] as num? ?? 0).round()),
+      p50: Duration(microseconds: map['p50'] ?? 0),
+      p90: Duration(microseconds: map['p90'] ?? 0),
+      p99: Duration(microseconds: map['p99'] ?? 0),
+      p999: Duration(microseconds: map['p999'] ?? 0),
+    );
+  }
+
+  /// Number of the [Duration]s recorded.
+  final int count;
+
+  /// Minimal [Duration] recorded.
+  final Duration min;
+
+  /// Maximal [Duration] recorded.
+  final Duration max;
+
+  /// Mean of the [Duration]s recorded.
+  final Duration mean;
+
+  /// [Duration] at the 50th percentile.
+  final Duration p50;
+
+  /// [Duration] at the 90th percentile.
+  final Duration p90;
+
+  /// [Duration] at the 99th percentile.
+  final Duration p99;
+
+  /// [Duration] at the 99.9th percentile.
+  final Duration p999;
+
+  /// Returns a JSON representation of this [TimingHistogram] in microseconds.
+  Map<String, dynamic> toJson() => {
+    'count': count,
+    'min': min.inMicroseconds,
+    'max': max.inMicroseconds,
+    'mean': mean.inMicroseconds,
+    'p50': p50.inMicroseconds,
+    'p90': p90.inMicroseconds,
+    'p99': p99.inMicroseconds,
+    'p999': p999.inMicroseconds,
+  };
+
+  @override
+  String toString() =>
+      'p50 ${_ms(p50)}, p99 ${_ms(p99)}, p99.9 ${_ms(p999)}, '
+      'max ${_ms(max)} of $count';
+
+  /// Returns the [duration] formatted in milliseconds.
+  static String _ms(Duration duration) =>
+      '${(duration.inMicroseconds / 1000).toStringAsFixed(1)} ms';
+}
+
+/// Opcodes of the requests sent over the [LinuxUtils._bulk] channel.
+enum _BulkOpcode {
+  /// Replies with the request as is.
+  echo,
+
+  /// Replies with the lowercase hex SHA-256 digest of the payload.
+  sha256,
+
+  /// Replies with the [JsonTape] of the JSON payload.
+  parseJson,
 }
@@ -0,0 +1,34 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+export 'mapped_file/interface.dart'
+    if (dart.library.ffi) 'mapped_file/io.dart';
+
+/// Hint on how the bytes of a file mapped with `mapFile()` are going to be
+/// read.
+enum MappedFileAdvice {
+  /// No special treatment.
+  normal,
+
+  /// Bytes are read sequentially, e.g. when being written to another file, so
+  /// may be read ahead aggressively and freed soon after being read.
+  sequential,
+
+  /// Bytes are going to be read in whole soon, e.g. when decoding an image, so
+  /// should be read ahead right away.
+  willNeed,
+}
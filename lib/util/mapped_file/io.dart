@@ -0,0 +1,111 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+import '../mapped_file.dart';
+
+/// Returns the contents of the file at the provided [path] mapped into memory
+/// without being copied, or `null` if mapping isn't supported or failed.
+///
+/// The returned [Uint8List] is backed by the mapping, which is unmapped once
+/// the [Uint8List] is garbage collected. Writes to it are never written back
+/// to the file.
+///
+/// The file must not be truncated while being mapped, yet may be deleted.
+Uint8List? mapFile(
+  String path, {
+  MappedFileAdvice advice = MappedFileAdvice.normal,
+}) {
+  final _MappedFileBindings? bindings = _MappedFileBindings.instance;
+  if (bindings == null) {
+    return null;
+  }
+
+  return using((Arena arena) {
+    final Pointer<Int64> length = arena<Int64>();
+    final Pointer<Pointer<Void>> token = arena<Pointer<Void>>();
+
+    final Pointer<Uint8> bytes = bindings.map(
+      path.toNativeUtf8(allocator: arena),
+      advice.index,
+      length,
+      token,
+    );
+
+    if (bytes == nullptr) {
+      return null;
+    }
+
+    return bytes.asTypedList(
+      length.value,
+      finalizer: bindings.unmap,
+      token: token.value,
+    );
+  });
+}
+
+/// Bindings to the file mapping functions exported by the Linux runner.
+class _MappedFileBindings {
+  _MappedFileBindings(DynamicLibrary library)
+    : map = library
+          .lookupFunction<
+            Pointer<Uint8> Function(
+              Pointer<Utf8>,
+              Int32,
+              Pointer<Int64>,
+              Pointer<Pointer<Void>>,
+            ),
+            Pointer<Uint8> Function(
+              Pointer<Utf8>,
+              int,
+              Pointer<Int64>,
+              Pointer<Pointer<Void>>,
+            )
+          >('messenger_map_file'),
+      unmap = library.lookup<NativeFinalizerFunction>('messenger_unmap_file');
+
+  /// Maps the file, returning its address, length and unmapping token.
+  final Pointer<Uint8> Function(
+    Pointer<Utf8> path,
+    int advice,
+    Pointer<Int64> length,
+    Pointer<Pointer<Void>> token,
+  )
+  map;
+
+  /// Unmaps the file by the token returned from the [map].
+  final Pointer<NativeFinalizerFunction> unmap;
+
+  /// [_MappedFileBindings] of the current process, or `null`, if the
+  /// functions aren't exported.
+  static final _MappedFileBindings? instance = () {
+    if (!Platform.isLinux) {
+      return null;
+    }
+
+    try {
+      return _MappedFileBindings(DynamicLibrary.executable());
+    } on ArgumentError {
+      return null;
+    }
+  }();
+}
@@ -22,6 +22,7 @@ import 'package:medea_jason/medea_jason.dart';
 import 'package:mutex/mutex.dart';
 
 import '/l10n/l10n.dart';
+import 'linux_utils.dart';
 import 'log.dart';
 import 'platform_utils.dart';
 import 'web/web_utils.dart';
@@ -69,6 +70,7 @@ class MediaUtilsImpl {
         }
 
         try {
+          await _ensurePluginsRegistered();
           await Jason.ensureInitialized();
           _jason = Jason.create();
         } catch (e) {
@@ -340,6 +342,7 @@ class MediaUtilsImpl {
 
     try {
       // Initialize [Jason] first.
+      await _ensurePluginsRegistered();
       await Jason.ensureInitialized();
       await Logging.setLogLevel(level);
     } catch (e) {
@@ -350,6 +353,15 @@ class MediaUtilsImpl {
     }
   }
 
+  /// Ensures the `medea_jason` and `medea_flutter_webrtc` plugins are
+  /// registered, as the Linux runner defers their registration until after
+  /// the first frame.
+  Future<void> _ensurePluginsRegistered() async {
+    if (PlatformUtils.isLinux && !PlatformUtils.isWeb) {
+      await LinuxUtils.registerDeferredPlugins();
+    }
+  }
+
   /// Returns [MediaStreamSettings] with [audio], [video], [screen] enabled or
   /// not.
   MediaStreamSettings _mediaStreamSettings({
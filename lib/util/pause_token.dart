@@ -0,0 +1,55 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+import 'dart:async';
+
+/// Token pausing and resuming the uploads it's passed to, similarly to how a
+/// `CancelToken` cancels them.
+///
+/// __Note:__ Only the uploads performed natively on Linux may be paused, the
+///           other ones ignore this token.
+class PauseToken {
+  /// [StreamController] of the [changes].
+  final StreamController<bool> _controller = StreamController.broadcast(
+    sync: true,
+  );
+
+  /// Indicator whether this [PauseToken] is paused.
+  bool _paused = false;
+
+  /// Indicates whether this [PauseToken] is paused.
+  bool get isPaused => _paused;
+
+  /// Returns a [Stream] of the [isPaused] changes.
+  Stream<bool> get changes => _controller.stream;
+
+  /// Pauses the uploads this [PauseToken] is passed to.
+  void pause() {
+    if (!_paused) {
+      _paused = true;
+      _controller.add(true);
+    }
+  }
+
+  /// Resumes the uploads this [PauseToken] is passed to.
+  void resume() {
+    if (_paused) {
+      _paused = false;
+      _controller.add(false);
+    }
+  }
+}
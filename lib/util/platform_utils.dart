@@ -21,6 +21,7 @@ import 'dart:ui';
 
 import 'package:app_badge_plus/app_badge_plus.dart';
 import 'package:async/async.dart';
+import 'package:crypto/crypto.dart' as crypto;
 import 'package:dio/dio.dart';
 import 'package:file_picker/file_picker.dart';
 import 'package:flutter_custom_cursor/cursor_manager.dart';
@@ -46,6 +47,9 @@ import '/routes.dart';
 import '/ui/worker/cache.dart';
 import '/util/log.dart';
 import 'backoff.dart';
+import 'json_tape.dart';
+import 'linux_utils.dart';
+import 'mapped_file.dart';
 import 'web/web_utils.dart';
 
 /// Global variable to access [PlatformUtilsImpl].
@@ -100,10 +104,19 @@ class PlatformUtilsImpl {
   String? _userAgent;
 
   /// Returns a [Dio] client to use in queries.
+  ///
+  /// Large JSON responses (e.g. the pages of the chat items) are parsed
+  /// natively on Linux with the [JsonTapeTransformer].
   Future<Dio> get dio async {
-    client ??= Dio(
-      BaseOptions(headers: {if (!isWeb) 'User-Agent': await userAgent}),
-    );
+    if (client == null) {
+      client = Dio(
+        BaseOptions(headers: {if (!isWeb) 'User-Agent': await userAgent}),
+      );
+
+      if (isLinux && !isWeb) {
+        client!.transformer = JsonTapeTransformer();
+      }
+    }
 
     return client!;
   }
@@ -385,6 +398,21 @@ class PlatformUtilsImpl {
   /// Indicates whether the application is in active state.
   Future<bool> get isActive async => _isActive && await isFocused;
 
+  /// Returns the SHA-256 hash of the provided [bytes] as a hex string.
+  ///
+  /// Calculated natively off the UI isolate, when possible.
+  Future<String> sha256(Uint8List bytes) async {
+    if (isLinux && !isWeb) {
+      try {
+        return await LinuxUtils.sha256(bytes);
+      } catch (_) {
+        // No-op, as the native implementation may be unavailable.
+      }
+    }
+
+    return crypto.sha256.convert(bytes).toString();
+  }
+
   /// Enters fullscreen mode.
   Future<void> enterFullscreen() async {
     if (isWeb) {
@@ -489,6 +517,10 @@ class PlatformUtilsImpl {
   }
 
   /// Downloads a file from the provided [url].
+  ///
+  /// Throws a [ChecksumMismatchException], if the SHA-256 hash of the file
+  /// downloaded natively on Linux differs from the provided [checksum], with
+  /// the file deleted.
   Future<File?> download(
     String url,
     String filename,
@@ -508,8 +540,14 @@ class PlatformUtilsImpl {
       Future(() async {
         // Rethrows the [exception], if any other than `404` is thrown.
         void onError(dynamic exception) {
-          if (exception is! DioException ||
-              exception.response?.statusCode != 404) {
+          final bool notFound =
+              (exception is DioException &&
+                  exception.response?.statusCode == 404) ||
+              (exception is PlatformException &&
+                  exception.code == 'HTTP_ERROR' &&
+                  exception.details == 404);
+
+          if (!notFound) {
             completeWith = exception;
             operation?.cancel();
           } else {
@@ -555,7 +593,10 @@ class PlatformUtilsImpl {
           if (file == null) {
             Uint8List? data;
             if (checksum != null && CacheWorker.instance.exists(checksum)) {
-              data = (await CacheWorker.instance.get(checksum: checksum)).bytes;
+              data = (await CacheWorker.instance.get(
+                checksum: checksum,
+                advice: MappedFileAdvice.sequential,
+              )).bytes;
             }
 
             if (path == null) {
@@ -578,13 +619,36 @@ class PlatformUtilsImpl {
               // thrown.
               await Backoff.run(() async {
                 try {
-                  // TODO: Cache the response.
-                  await (await dio).download(
-                    url,
-                    file!.path,
-                    onReceiveProgress: onReceiveProgress,
-                    cancelToken: cancelToken,
-                  );
+                  if (isLinux) {
+                    // Downloads natively over several connections, resuming
+                    // from the already downloaded parts on retries.
+                    final String sha256 = await LinuxUtils.download(
+                      url,
+                      file!.path,
+                      headers: {'User-Agent': await userAgent},
+                      onProgress: onReceiveProgress,
+                      cancelToken: cancelToken,
+                    );
+
+                    if (checksum != null && sha256 != checksum) {
+                      Log.warning(
+                        'download($url) -> SHA-256 `$sha256` differs from the '
+                        'expected `$checksum`, deleting the file',
+                        '$runtimeType',
+                      );
+
+                      await file!.delete();
+                      throw ChecksumMismatchException(checksum, sha256);
+                    }
+                  } else {
+                    // TODO: Cache the response.
+                    await (await dio).download(
+                      url,
+                      file!.path,
+                      onReceiveProgress: onReceiveProgress,
+                      cancelToken: cancelToken,
+                    );
+                  }
                 } catch (e) {
                   onError(e);
                 }
@@ -651,7 +715,10 @@ class PlatformUtilsImpl {
     // Provided file might already be cached.
     Uint8List? data;
     if (checksum != null && CacheWorker.instance.exists(checksum)) {
-      data = (await CacheWorker.instance.get(checksum: checksum)).bytes;
+      data = (await CacheWorker.instance.get(
+        checksum: checksum,
+        advice: MappedFileAdvice.sequential,
+      )).bytes;
     }
 
     if (data == null) {
@@ -949,6 +1016,23 @@ class PlatformUtilsImpl {
 /// Kind of a [PlatformUtilsImpl.haptic] feedback.
 enum HapticKind { click, light }
 
+/// Exception of a downloaded file having the SHA-256 hash different from the
+/// [expected] one.
+class ChecksumMismatchException implements Exception {
+  const ChecksumMismatchException(this.expected, this.actual);
+
+  /// SHA-256 hash the file was expected to have.
+  final String expected;
+
+  /// SHA-256 hash the downloaded file has.
+  final String actual;
+
+  @override
+  String toString() =>
+      'ChecksumMismatchException: SHA-256 `$actual` differs from the '
+      'expected `$expected`';
+}
+
 /// Determining whether a [BuildContext] is mobile or not.
 extension MobileExtensionOnContext on BuildContext {
   /// Returns `true` if [PlatformUtilsImpl.isMobile] and [MediaQuery]'s shortest
@@ -0,0 +1,134 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+import 'dart:async';
+import 'dart:convert';
+import 'dart:ui' as ui;
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter/painting.dart';
+
+import 'thumbhash/interface.dart'
+    if (dart.library.ffi) 'thumbhash/io.dart';
+
+export 'thumbhash/interface.dart'
+    if (dart.library.ffi) 'thumbhash/io.dart';
+
+/// ThumbHash decoded into raw RGBA pixels.
+class DecodedThumbHash {
+  const DecodedThumbHash(this.width, this.height, this.rgba);
+
+  /// Width of the image in pixels.
+  final int width;
+
+  /// Height of the image in pixels.
+  final int height;
+
+  /// Straight (not premultiplied) RGBA pixels of the image.
+  final Uint8List rgba;
+}
+
+/// [ImageProvider] of a ThumbHash decoded natively with [decodeThumbHashes].
+///
+/// ThumbHashes requested during the same frame are decoded in a single batch.
+class ThumbHashImage extends ImageProvider<ThumbHashImage> {
+  const ThumbHashImage(this.hash);
+
+  /// Base64 encoded ThumbHash to decode.
+  final String hash;
+
+  /// Indicator whether [decodeThumbHashes] is supported on this platform.
+  static final bool isSupported = decodeThumbHashes(const []) != null;
+
+  /// ThumbHashes waiting to be decoded in the next batch.
+  static final List<(Uint8List, Completer<DecodedThumbHash?>)> _pending = [];
+
+  @override
+  Future<ThumbHashImage> obtainKey(ImageConfiguration configuration) =>
+      SynchronousFuture(this);
+
+  @override
+  ImageStreamCompleter loadImage(
+    ThumbHashImage key,
+    ImageDecoderCallback decode,
+  ) => OneFrameImageStreamCompleter(_load());
+
+  @override
+  bool operator ==(Object other) =>
+      other is ThumbHashImage && other.hash == hash;
+
+  @override
+  int get hashCode => hash.hashCode;
+
+  /// Decodes the [hash] into an [ImageInfo].
+  Future<ImageInfo> _load() async {
+    final DecodedThumbHash? decoded = await _decode(base64.decode(hash));
+    if (decoded == null) {
+      throw ArgumentError.value(hash, 'hash', 'Malformed ThumbHash');
+    }
+
+    final ui.ImmutableBuffer buffer = await ui.ImmutableBuffer.fromUint8List(
+      decoded.rgba,
+    );
+
+    final ui.ImageDescriptor descriptor = ui.ImageDescriptor.raw(
+      buffer,
+      width: decoded.width,
+      height: decoded.height,
+      pixelFormat: ui.PixelFormat.rgba8888,
+    );
+
+    final ui.Codec codec = await descriptor.instantiateCodec();
+    final ui.FrameInfo frame = await codec.getNextFrame();
+
+    codec.dispose();
+    descriptor.dispose();
+    buffer.dispose();
+
+    return ImageInfo(image: frame.image);
+  }
+
+  /// Schedules the [bytes] to be decoded in the next batch.
+  static Future<DecodedThumbHash?> _decode(Uint8List bytes) {
+    final Completer<DecodedThumbHash?> completer = Completer();
+
+    // Images are resolved while building the frame, so the microtask runs
+    // once every [ThumbHashImage] of the frame is requested.
+    if (_pending.isEmpty) {
+      scheduleMicrotask(_flush);
+    }
+
+    _pending.add((bytes, completer));
+    return completer.future;
+  }
+
+  /// Decodes the [_pending] ThumbHashes in a single batch.
+  static void _flush() {
+    final List<(Uint8List, Completer<DecodedThumbHash?>)> batch = List.of(
+      _pending,
+    );
+    _pending.clear();
+
+    final List<DecodedThumbHash?> decoded =
+        decodeThumbHashes(batch.map((e) => e.$1).toList()) ??
+        List.filled(batch.length, null);
+
+    for (int i = 0; i < batch.length; ++i) {
+      batch[i].$2.complete(decoded[i]);
+    }
+  }
+}
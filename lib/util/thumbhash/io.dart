@@ -0,0 +1,131 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+import '../thumbhash.dart';
+
+/// Size of the RGBA buffer fitting any decoded ThumbHash, as in the Linux
+/// runner.
+const int _maxRgbaSize = 32 * 32 * 4;
+
+/// Decodes the provided ThumbHash [hashes] in a single batch, returning
+/// `null`s for the malformed ones, or `null` if it's not supported.
+///
+/// Decoded natively with the vectorized decoder of the Linux runner into a
+/// single native buffer, which the returned pixels are views of, so it's
+/// freed once none of them are referenced anymore.
+List<DecodedThumbHash?>? decodeThumbHashes(List<Uint8List> hashes) {
+  final _ThumbHashBindings? bindings = _ThumbHashBindings.instance;
+  if (bindings == null) {
+    return null;
+  } else if (hashes.isEmpty) {
+    return [];
+  }
+
+  final int total = hashes.fold(0, (sum, e) => sum + e.length);
+
+  return using((Arena arena) {
+    final Pointer<Uint8> input = arena<Uint8>(total == 0 ? 1 : total);
+    final Pointer<Int32> lengths = arena<Int32>(hashes.length);
+    final Pointer<Int32> sizes = arena<Int32>(hashes.length * 2);
+
+    final Uint8List bytes = input.asTypedList(total);
+    int offset = 0;
+    for (int i = 0; i < hashes.length; ++i) {
+      bytes.setAll(offset, hashes[i]);
+      lengths[i] = hashes[i].length;
+      offset += hashes[i].length;
+    }
+
+    final Pointer<Uint8> output = malloc<Uint8>(hashes.length * _maxRgbaSize);
+    final Uint8List pixels = output.asTypedList(
+      hashes.length * _maxRgbaSize,
+      finalizer: malloc.nativeFree,
+    );
+
+    bindings.decode(input, lengths, hashes.length, output, sizes);
+
+    return List.generate(hashes.length, (i) {
+      final int width = sizes[i * 2];
+      final int height = sizes[i * 2 + 1];
+      if (width == 0 || height == 0) {
+        return null;
+      }
+
+      return DecodedThumbHash(
+        width,
+        height,
+        Uint8List.sublistView(
+          pixels,
+          i * _maxRgbaSize,
+          i * _maxRgbaSize + width * height * 4,
+        ),
+      );
+    });
+  });
+}
+
+/// Bindings to the ThumbHash decoder exported by the Linux runner.
+class _ThumbHashBindings {
+  _ThumbHashBindings(DynamicLibrary library)
+    : decode = library
+          .lookupFunction<
+            Int32 Function(
+              Pointer<Uint8>,
+              Pointer<Int32>,
+              Int32,
+              Pointer<Uint8>,
+              Pointer<Int32>,
+            ),
+            int Function(
+              Pointer<Uint8>,
+              Pointer<Int32>,
+              int,
+              Pointer<Uint8>,
+              Pointer<Int32>,
+            )
+          >('messenger_thumbhash_decode', isLeaf: true);
+
+  /// Decodes the concatenated hashes into the RGBA slots and their sizes.
+  final int Function(
+    Pointer<Uint8> hashes,
+    Pointer<Int32> lengths,
+    int count,
+    Pointer<Uint8> rgba,
+    Pointer<Int32> sizes,
+  )
+  decode;
+
+  /// [_ThumbHashBindings] of the current process, or `null`, if the decoder
+  /// isn't exported.
+  static final _ThumbHashBindings? instance = () {
+    if (!Platform.isLinux) {
+      return null;
+    }
+
+    try {
+      return _ThumbHashBindings(DynamicLibrary.executable());
+    } on ArgumentError {
+      return null;
+    }
+  }();
+}
@@ -19,7 +19,6 @@ import 'dart:async';
 import 'dart:io';
 import 'dart:typed_data';
 
-import 'package:crypto/crypto.dart';
 import 'package:video_player/video_player.dart';
 
 import '../platform_utils.dart';
@@ -32,7 +31,7 @@ extension VideoPlayerControllerExt on VideoPlayerController {
     String? checksum,
     VideoPlayerOptions? videoPlayerOptions,
   }) async {
-    final String hash = checksum ?? sha256.convert(bytes).toString();
+    final String hash = checksum ?? await PlatformUtils.sha256(bytes);
 
     final File file = File(
       '${(await PlatformUtils.temporaryDirectory).path}/$hash',
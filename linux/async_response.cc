@@ -0,0 +1,38 @@
+#include "async_response.h"
+
+#include <string.h>
+
+struct AsyncResponse {
+  FlMethodCall* method_call;
+  FlMethodResponse* response;
+};
+
+static gboolean respond_on_main_thread(gpointer user_data) {
+  AsyncResponse* data = static_cast<AsyncResponse*>(user_data);
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(data->method_call, data->response, &error)) {
+    g_warning("Failed to send response: %s", error->message);
+  }
+
+  g_object_unref(data->method_call);
+  g_object_unref(data->response);
+  delete data;
+
+  return G_SOURCE_REMOVE;
+}
+
+void method_call_respond_async(FlMethodCall* method_call,
+                               FlMethodResponse* response) {
+  g_main_context_invoke(nullptr, respond_on_main_thread,
+                        new AsyncResponse{method_call, response});
+}
+
+FlMethodResponse* method_error_response_errno(const gchar* code,
+                                              const gchar* prefix,
+                                              int error) {
+  g_autofree gchar* message =
+      g_strdup_printf("%s: %s", prefix, strerror(error));
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(code, message,
+                                                          nullptr));
+}
@@ -0,0 +1,32 @@
+#ifndef RUNNER_ASYNC_RESPONSE_H_
+#define RUNNER_ASYNC_RESPONSE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * method_call_respond_async:
+ * @method_call: (transfer full): #FlMethodCall to respond to.
+ * @response: (transfer full): #FlMethodResponse to respond with.
+ *
+ * Responds to the @method_call on the main thread. May be called from any
+ * thread, e.g. from a #WorkerPool task.
+ *
+ * The caller must hold a reference to the @method_call obtained on the main
+ * thread with g_object_ref(), which is released after responding.
+ */
+void method_call_respond_async(FlMethodCall* method_call,
+                               FlMethodResponse* response);
+
+/**
+ * method_error_response_errno:
+ * @code: error code of the response.
+ * @prefix: message describing what has failed.
+ * @error: `errno` value describing why it has failed.
+ *
+ * Returns: (transfer full): a new #FlMethodResponse with the error.
+ */
+FlMethodResponse* method_error_response_errno(const gchar* code,
+                                              const gchar* prefix,
+                                              int error);
+
+#endif  // RUNNER_ASYNC_RESPONSE_H_
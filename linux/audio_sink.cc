@@ -0,0 +1,189 @@
+#include "audio_sink.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef HAVE_PULSE
+#include <pulse/simple.h>
+#endif
+
+#include <string>
+
+// Bytes of a single frame.
+static const size_t kFrameSize = kAudioChannels * sizeof(int16_t);
+
+// Size of the RIFF and WAVE headers preceding the frames in a WAV file.
+static const long kWavHeaderSize = 44;
+
+#ifdef HAVE_PULSE
+// Audio buffered by the server ahead of the playback, in microseconds, short
+// enough for the sounds to be heard as soon as they are mixed.
+static const uint32_t kPulseLatency = 20000;
+#endif
+
+// Discards the frames, taking as long as playing them would.
+class NullAudioSink : public AudioSink {
+ public:
+  bool Write(const int16_t* frames, size_t count) override {
+    int64_t now = Now();
+
+    // Frames written after a pause start playing right away.
+    if (deadline_ < now) {
+      deadline_ = now;
+    }
+    deadline_ += static_cast<int64_t>(count) * 1000000000 / kAudioSampleRate;
+
+    struct timespec until = {static_cast<time_t>(deadline_ / 1000000000),
+                             static_cast<long>(deadline_ % 1000000000)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) ==
+           EINTR) {
+    }
+
+    return true;
+  }
+
+ private:
+  // Returns the monotonic time in nanoseconds.
+  static int64_t Now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+
+  // Time the frames written so far are played till, in nanoseconds.
+  int64_t deadline_ = 0;
+};
+
+// Writes the frames to a WAV file, completing its header once closed.
+class WavFileAudioSink : public AudioSink {
+ public:
+  explicit WavFileAudioSink(FILE* file) : file_(file) { WriteHeader(); }
+
+  ~WavFileAudioSink() override {
+    WriteHeader();
+    fclose(file_);
+  }
+
+  bool Write(const int16_t* frames, size_t count) override {
+    if (fwrite(frames, kFrameSize, count, file_) != count) {
+      return false;
+    }
+
+    data_size_ += count * kFrameSize;
+    return true;
+  }
+
+ private:
+  // Writes the header describing the |data_size_| bytes of the frames.
+  void WriteHeader() {
+    uint8_t header[kWavHeaderSize];
+    uint8_t* position = header;
+
+    auto put = [&](const char* tag) {
+      memcpy(position, tag, 4);
+      position += 4;
+    };
+    auto put_le = [&](uint32_t value, int bytes) {
+      for (int i = 0; i < bytes; ++i) {
+        *position++ = static_cast<uint8_t>(value >> (8 * i));
+      }
+    };
+
+    put("RIFF");
+    put_le(static_cast<uint32_t>(kWavHeaderSize - 8 + data_size_), 4);
+    put("WAVE");
+    put("fmt ");
+    put_le(16, 4);
+    put_le(1, 2);  // PCM.
+    put_le(kAudioChannels, 2);
+    put_le(kAudioSampleRate, 4);
+    put_le(kAudioSampleRate * kFrameSize, 4);
+    put_le(kFrameSize, 2);
+    put_le(16, 2);
+    put("data");
+    put_le(static_cast<uint32_t>(data_size_), 4);
+
+    long end = ftell(file_);
+    fseek(file_, 0, SEEK_SET);
+    fwrite(header, 1, sizeof(header), file_);
+    if (end > kWavHeaderSize) {
+      fseek(file_, end, SEEK_SET);
+    }
+  }
+
+  FILE* file_;
+  size_t data_size_ = 0;
+};
+
+#ifdef HAVE_PULSE
+// Plays the frames via the PulseAudio server, or the PipeWire one speaking
+// its protocol.
+class PulseAudioSink : public AudioSink {
+ public:
+  explicit PulseAudioSink(pa_simple* stream) : stream_(stream) {}
+
+  ~PulseAudioSink() override {
+    pa_simple_drain(stream_, nullptr);
+    pa_simple_free(stream_);
+  }
+
+  bool Write(const int16_t* frames, size_t count) override {
+    int error = 0;
+    return pa_simple_write(stream_, frames, count * kFrameSize, &error) == 0;
+  }
+
+ private:
+  pa_simple* stream_;
+};
+#endif
+
+std::unique_ptr<AudioSink> AudioSink::Open(const char* spec) {
+  std::string value = spec == nullptr ? "pulse" : spec;
+
+  if (value == "null") {
+    return std::unique_ptr<AudioSink>(new NullAudioSink());
+  }
+
+  if (value.compare(0, 4, "wav:") == 0) {
+    FILE* file = fopen(value.c_str() + 4, "wbe");
+    if (file == nullptr) {
+      return nullptr;
+    }
+
+    return std::unique_ptr<AudioSink>(new WavFileAudioSink(file));
+  }
+
+#ifdef HAVE_PULSE
+  if (value == "pulse") {
+    pa_sample_spec sample_spec;
+    sample_spec.format = PA_SAMPLE_S16NE;
+    sample_spec.rate = kAudioSampleRate;
+    sample_spec.channels = kAudioChannels;
+
+    // Only the target length is lowered, leaving the server to pick the
+    // rest of the buffering for it.
+    pa_buffer_attr attributes;
+    attributes.maxlength = static_cast<uint32_t>(-1);
+    attributes.tlength = static_cast<uint32_t>(
+        kPulseLatency * kAudioSampleRate / 1000000 * kFrameSize);
+    attributes.prebuf = static_cast<uint32_t>(-1);
+    attributes.minreq = static_cast<uint32_t>(-1);
+    attributes.fragsize = static_cast<uint32_t>(-1);
+
+    int error = 0;
+    pa_simple* stream =
+        pa_simple_new(nullptr, APPLICATION_ID, PA_STREAM_PLAYBACK, nullptr,
+                      "Notification sounds", &sample_spec, nullptr,
+                      &attributes, &error);
+    if (stream == nullptr) {
+      return nullptr;
+    }
+
+    return std::unique_ptr<AudioSink>(new PulseAudioSink(stream));
+  }
+#endif
+
+  return nullptr;
+}
@@ -0,0 +1,37 @@
+#ifndef RUNNER_AUDIO_SINK_H_
+#define RUNNER_AUDIO_SINK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+// Sample rate of the frames written to an AudioSink.
+static const int kAudioSampleRate = 48000;
+
+// Number of the interleaved channels of the frames written to an AudioSink.
+static const int kAudioChannels = 2;
+
+// Output of the interleaved signed 16-bit frames of |kAudioChannels| at the
+// |kAudioSampleRate|.
+//
+// Sinks are written to from a single thread, being paced by the Write()
+// blocking until the sink is able to accept more frames.
+class AudioSink {
+ public:
+  // Opens the AudioSink described by the |spec|:
+  // - `null`, discarding the frames in real time;
+  // - `wav:<path>`, writing the frames to the WAV file at the `<path>` as fast
+  //   as they are written;
+  // - `pulse` or nullptr, playing the frames via PulseAudio, if built with it.
+  //
+  // Returns nullptr, if the sink can't be opened.
+  static std::unique_ptr<AudioSink> Open(const char* spec);
+
+  virtual ~AudioSink() = default;
+
+  // Writes the |count| frames, returning false on failure.
+  virtual bool Write(const int16_t* frames, size_t count) = 0;
+};
+
+#endif  // RUNNER_AUDIO_SINK_H_
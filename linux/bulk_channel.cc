@@ -0,0 +1,170 @@
+#include "bulk_channel.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+
+#include "json_tape.h"
+#include "sha256.h"
+#include "worker_pool.h"
+
+static const char kBulkChannel[] = "team113.flutter.dev/linux_utils/bulk";
+
+// Size of the request ID and the opcode or the status framing the payloads.
+static const size_t kHeaderSize = 2 * sizeof(uint32_t);
+
+enum BulkOpcode : uint32_t {
+  kEcho = 0,
+  kSha256 = 1,
+  kParseJson = 2,
+};
+
+enum BulkStatus : uint32_t {
+  kOk = 0,
+  kUnknownOpcode = 1,
+  kMalformed = 2,
+  kInvalidPayload = 3,
+};
+
+// Reply to send on the main thread.
+struct BulkReply {
+  FlBinaryMessengerResponseHandle* response_handle;
+  GBytes* reply;
+};
+
+static FlBinaryMessenger* bulk_messenger = nullptr;
+
+static gboolean send_reply(gpointer user_data) {
+  std::unique_ptr<BulkReply> data(static_cast<BulkReply*>(user_data));
+
+  // Replies left after bulk_channel_dispose() aren't sent, as the engine is
+  // gone.
+  if (bulk_messenger != nullptr) {
+    g_autoptr(GError) error = nullptr;
+    if (!fl_binary_messenger_send_response(bulk_messenger,
+                                           data->response_handle, data->reply,
+                                           &error)) {
+      g_warning("Failed to send response: %s", error->message);
+    }
+  }
+
+  g_object_unref(data->response_handle);
+  g_bytes_unref(data->reply);
+  return G_SOURCE_REMOVE;
+}
+
+// Sends the |reply| on the main thread. May be called from any thread.
+//
+// The caller must hold a reference to the |response_handle| obtained on the
+// main thread with g_object_ref(), which is released after replying, along
+// with the |reply|.
+static void reply_async(FlBinaryMessengerResponseHandle* response_handle,
+                        GBytes* reply) {
+  g_main_context_invoke(nullptr, send_reply,
+                        new BulkReply{response_handle, reply});
+}
+
+// Returns a new reply to the request |id| with the |status| and the |size|
+// bytes of the |payload|.
+static GBytes* new_reply(uint32_t id,
+                         uint32_t status,
+                         const void* payload,
+                         size_t size) {
+  uint8_t* frame = static_cast<uint8_t*>(g_malloc(kHeaderSize + size));
+  memcpy(frame, &id, sizeof(id));
+  memcpy(frame + sizeof(id), &status, sizeof(status));
+  if (size > 0) {
+    memcpy(frame + kHeaderSize, payload, size);
+  }
+
+  return g_bytes_new_take(frame, kHeaderSize + size);
+}
+
+static void bulk_message_cb(FlBinaryMessenger* messenger,
+                            const gchar* channel,
+                            GBytes* message,
+                            FlBinaryMessengerResponseHandle* response_handle,
+                            gpointer user_data) {
+  FlBinaryMessengerResponseHandle* held =
+      static_cast<FlBinaryMessengerResponseHandle*>(
+          g_object_ref(response_handle));
+
+  gsize size = 0;
+  const uint8_t* frame =
+      static_cast<const uint8_t*>(g_bytes_get_data(message, &size));
+  if (frame == nullptr || size < kHeaderSize) {
+    reply_async(held, new_reply(0, kMalformed, nullptr, 0));
+    return;
+  }
+
+  uint32_t id;
+  uint32_t opcode;
+  memcpy(&id, frame, sizeof(id));
+  memcpy(&opcode, frame + sizeof(id), sizeof(opcode));
+
+  switch (opcode) {
+    case kEcho:
+      // Opcode of the echo is the same as the `kOk` status, so the request is
+      // the reply itself.
+      reply_async(held, g_bytes_ref(message));
+      break;
+
+    case kSha256: {
+      // Payload is hashed in place, while the reference to the |message| is
+      // held.
+      GBytes* payload = g_bytes_ref(message);
+      WorkerPool::Shared()->Post([held, payload, id] {
+        gsize size = 0;
+        const uint8_t* frame =
+            static_cast<const uint8_t*>(g_bytes_get_data(payload, &size));
+
+        Sha256 hasher;
+        hasher.Update(frame + kHeaderSize, size - kHeaderSize);
+        std::string digest = hasher.FinishHex();
+        g_bytes_unref(payload);
+
+        reply_async(held,
+                    new_reply(id, kOk, digest.data(), digest.size()));
+      });
+      break;
+    }
+
+    case kParseJson: {
+      GBytes* payload = g_bytes_ref(message);
+      WorkerPool::Shared()->Post([held, payload, id] {
+        gsize size = 0;
+        const char* frame =
+            static_cast<const char*>(g_bytes_get_data(payload, &size));
+
+        std::string tape;
+        bool parsed =
+            ParseJsonTape(frame + kHeaderSize, size - kHeaderSize, &tape);
+        g_bytes_unref(payload);
+
+        reply_async(held, parsed ? new_reply(id, kOk, tape.data(), tape.size())
+                                 : new_reply(id, kInvalidPayload, nullptr, 0));
+      });
+      break;
+    }
+
+    default:
+      reply_async(held, new_reply(id, kUnknownOpcode, nullptr, 0));
+      break;
+  }
+}
+
+void bulk_channel_init(FlBinaryMessenger* messenger) {
+  bulk_messenger = FL_BINARY_MESSENGER(g_object_ref(messenger));
+  fl_binary_messenger_set_message_handler_on_channel(
+      bulk_messenger, kBulkChannel, bulk_message_cb, nullptr, nullptr);
+}
+
+void bulk_channel_dispose() {
+  if (bulk_messenger != nullptr) {
+    fl_binary_messenger_set_message_handler_on_channel(
+        bulk_messenger, kBulkChannel, nullptr, nullptr, nullptr);
+  }
+  g_clear_object(&bulk_messenger);
+}
@@ -0,0 +1,37 @@
+#ifndef RUNNER_BULK_CHANNEL_H_
+#define RUNNER_BULK_CHANNEL_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * bulk_channel_init:
+ * @messenger: #FlBinaryMessenger to handle the bulk channel on.
+ *
+ * Handles the `team113.flutter.dev/linux_utils/bulk` channel exchanging raw
+ * binary frames, so the large payloads are passed as #GBytes without being
+ * boxed into the #FlValues and copied by the #FlStandardMethodCodec.
+ *
+ * Requests are framed as the 32-bit request ID and opcode followed by the
+ * payload, and replied to, possibly from the #WorkerPool, with the same
+ * request ID and a 32-bit status followed by the payload of the result, both
+ * in the host byte order. Opcodes are:
+ * - `0`, echoing the request back as is;
+ * - `1`, replying with the lowercase hex SHA-256 digest of the payload;
+ * - `2`, parsing the JSON payload with ParseJsonTape() and replying with the
+ *   tape.
+ *
+ * Statuses are `0` on success, `1` for an unknown opcode, `2` for a request
+ * too short to be framed, which is replied to with the ID of `0`, and `3`
+ * for a payload failed to be processed.
+ */
+void bulk_channel_init(FlBinaryMessenger* messenger);
+
+/**
+ * bulk_channel_dispose:
+ *
+ * Stops handling the bulk channel. Replies still being prepared on the
+ * #WorkerPool are dropped.
+ */
+void bulk_channel_dispose();
+
+#endif  // RUNNER_BULK_CHANNEL_H_
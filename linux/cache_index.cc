@@ -0,0 +1,503 @@
+#include "cache_index.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+static const char kMagic[8] = {'C', 'A', 'C', 'H', 'E', 'I', 'D', 'X'};
+static const uint32_t kVersion = 1;
+
+// Number of entries a new index is created with.
+static const uint64_t kInitialCapacity = 4096;
+
+static const size_t kKeySize = 32;
+
+enum EntryState : uint32_t {
+  kEmpty = 0,
+  kUsed = 1,
+  kRemoved = 2,
+};
+
+struct CacheIndexHeader {
+  char magic[8];
+  uint32_t version;
+
+  // Whether the index was closed cleanly, so the totals below can be trusted.
+  uint32_t clean;
+
+  // Number of the entries following the header, always a power of two.
+  uint64_t capacity;
+
+  uint64_t count;
+  uint64_t removed;
+  int64_t size;
+
+  // Logical clock the access times are taken from.
+  uint64_t clock;
+
+  uint8_t reserved[8];
+};
+
+struct CacheIndexEntry {
+  uint8_t key[kKeySize];
+  int64_t size;
+
+  // Insertion time in milliseconds since the epoch.
+  int64_t inserted;
+
+  // Value of the Header::clock at the last access.
+  uint64_t accessed;
+
+  uint32_t state;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(CacheIndexHeader) == 64, "Header must be 64 bytes");
+static_assert(sizeof(CacheIndexEntry) == 64, "Entry must be 64 bytes");
+
+static size_t FileSize(uint64_t capacity) {
+  return sizeof(CacheIndexHeader) + capacity * sizeof(CacheIndexEntry);
+}
+
+static int HexDigit(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+static bool ParseKey(const std::string& checksum, uint8_t key[kKeySize]) {
+  if (checksum.size() != kKeySize * 2) {
+    return false;
+  }
+
+  for (size_t i = 0; i < kKeySize; ++i) {
+    int high = HexDigit(checksum[i * 2]);
+    int low = HexDigit(checksum[i * 2 + 1]);
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    key[i] = static_cast<uint8_t>(high << 4 | low);
+  }
+
+  return true;
+}
+
+static std::string FormatKey(const uint8_t key[kKeySize]) {
+  static const char kDigits[] = "0123456789abcdef";
+
+  std::string checksum(kKeySize * 2, '0');
+  for (size_t i = 0; i < kKeySize; ++i) {
+    checksum[i * 2] = kDigits[key[i] >> 4];
+    checksum[i * 2 + 1] = kDigits[key[i] & 0xf];
+  }
+  return checksum;
+}
+
+static int64_t NowMilliseconds() {
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+static uint32_t LoadState(const CacheIndexEntry* entry) {
+  return __atomic_load_n(&entry->state, __ATOMIC_ACQUIRE);
+}
+
+// Publishes the |state| after the rest of the |entry| is written.
+static void StoreState(CacheIndexEntry* entry, uint32_t state) {
+  __atomic_store_n(&entry->state, state, __ATOMIC_RELEASE);
+}
+
+// Maps the |fd| of |capacity| entries, returning nullptr on failure.
+static void* MapFile(int fd, uint64_t capacity) {
+  void* base = mmap(nullptr, FileSize(capacity), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+  return base == MAP_FAILED ? nullptr : base;
+}
+
+// Creates a new empty index of |capacity| entries in the |fd|.
+static bool InitializeFile(int fd, uint64_t capacity) {
+  if (ftruncate(fd, 0) != 0 || ftruncate(fd, FileSize(capacity)) != 0) {
+    return false;
+  }
+
+  CacheIndexHeader header = {};
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.capacity = capacity;
+  return pwrite(fd, &header, sizeof(header), 0) == sizeof(header);
+}
+
+CacheIndex* CacheIndex::Open(const char* path, bool* created) {
+  int fd = open(path, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  Header header = {};
+  ssize_t bytes_read = pread(fd, &header, sizeof(header), 0);
+
+  struct stat st;
+  bool valid = bytes_read == sizeof(header) &&
+               memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+               header.version == kVersion && header.capacity != 0 &&
+               (header.capacity & (header.capacity - 1)) == 0 &&
+               fstat(fd, &st) == 0 &&
+               static_cast<uint64_t>(st.st_size) >= FileSize(header.capacity);
+
+  *created = !valid;
+  if (!valid) {
+    header.capacity = kInitialCapacity;
+    if (!InitializeFile(fd, header.capacity)) {
+      int error = errno;
+      close(fd);
+      errno = error;
+      return nullptr;
+    }
+  }
+
+  CacheIndex* index = new CacheIndex(path, fd);
+
+  std::lock_guard<std::mutex> lock(index->mutex_);
+  if (!index->Map(header.capacity)) {
+    int error = errno;
+    delete index;
+    errno = error;
+    return nullptr;
+  }
+
+  if (!index->header_->clean) {
+    index->Recount();
+  }
+
+  // Cleared until the index is closed, so a crash is detected on next Open().
+  index->header_->clean = 0;
+  msync(index->header_, sizeof(Header), MS_ASYNC);
+
+  return index;
+}
+
+CacheIndex::CacheIndex(const std::string& path, int fd)
+    : path_(path), fd_(fd) {}
+
+CacheIndex::~CacheIndex() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (header_ != nullptr) {
+    msync(header_, mapped_size_, MS_SYNC);
+    header_->clean = 1;
+    msync(header_, sizeof(Header), MS_SYNC);
+    munmap(header_, mapped_size_);
+  }
+  close(fd_);
+}
+
+bool CacheIndex::Map(uint64_t capacity) {
+  void* base = MapFile(fd_, capacity);
+  if (base == nullptr) {
+    return false;
+  }
+
+  if (header_ != nullptr) {
+    munmap(header_, mapped_size_);
+  }
+
+  header_ = static_cast<Header*>(base);
+  entries_ = reinterpret_cast<Entry*>(header_ + 1);
+  mapped_size_ = FileSize(capacity);
+  return true;
+}
+
+CacheIndex::Entry* CacheIndex::Find(const uint8_t* key, bool* found) {
+  // Keys are SHA-256 digests, so their leading bytes are uniformly distributed.
+  uint64_t hash;
+  memcpy(&hash, key, sizeof(hash));
+
+  uint64_t mask = header_->capacity - 1;
+  Entry* free_slot = nullptr;
+  for (uint64_t i = 0; i <= mask; ++i) {
+    Entry* entry = &entries_[(hash + i) & mask];
+    uint32_t state = LoadState(entry);
+    if (state == kEmpty) {
+      *found = false;
+      return free_slot != nullptr ? free_slot : entry;
+    }
+
+    if (state == kRemoved) {
+      if (free_slot == nullptr) {
+        free_slot = entry;
+      }
+    } else if (memcmp(entry->key, key, kKeySize) == 0) {
+      *found = true;
+      return entry;
+    }
+  }
+
+  *found = false;
+  return free_slot;
+}
+
+void CacheIndex::Recount() {
+  header_->count = 0;
+  header_->removed = 0;
+  header_->size = 0;
+  header_->clock = 0;
+
+  for (uint64_t i = 0; i < header_->capacity; ++i) {
+    const Entry& entry = entries_[i];
+    switch (LoadState(&entry)) {
+      case kUsed:
+        ++header_->count;
+        header_->size += entry.size;
+        header_->clock = std::max(header_->clock, entry.accessed);
+        break;
+      case kRemoved:
+        ++header_->removed;
+        break;
+    }
+  }
+}
+
+bool CacheIndex::Rehash(uint64_t capacity) {
+  std::string temporary = path_ + ".tmp";
+  int fd = open(temporary.c_str(), O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC,
+                0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  void* base = nullptr;
+  if (InitializeFile(fd, capacity)) {
+    base = MapFile(fd, capacity);
+  }
+
+  if (base == nullptr) {
+    close(fd);
+    unlink(temporary.c_str());
+    return false;
+  }
+
+  Header* header = static_cast<Header*>(base);
+  Entry* entries = reinterpret_cast<Entry*>(header + 1);
+  uint64_t mask = capacity - 1;
+  for (uint64_t i = 0; i < header_->capacity; ++i) {
+    const Entry& entry = entries_[i];
+    if (LoadState(&entry) != kUsed) {
+      continue;
+    }
+
+    uint64_t hash;
+    memcpy(&hash, entry.key, sizeof(hash));
+    while (entries[hash & mask].state != kEmpty) {
+      ++hash;
+    }
+    entries[hash & mask] = entry;
+  }
+
+  header->count = header_->count;
+  header->size = header_->size;
+  header->clock = header_->clock;
+
+  bool succeeded = msync(base, FileSize(capacity), MS_SYNC) == 0 &&
+                   rename(temporary.c_str(), path_.c_str()) == 0;
+  munmap(base, FileSize(capacity));
+
+  if (!succeeded) {
+    close(fd);
+    unlink(temporary.c_str());
+    return false;
+  }
+
+  close(fd_);
+  fd_ = fd;
+  return Map(capacity);
+}
+
+bool CacheIndex::Insert(const std::string& checksum, int64_t size) {
+  uint8_t key[kKeySize];
+  if (!ParseKey(checksum, key)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  bool found = false;
+  Entry* entry = Find(key, &found);
+  if (found) {
+    header_->size += size - entry->size;
+    entry->size = size;
+    entry->accessed = ++header_->clock;
+    return true;
+  }
+
+  // Keep the load factor under 3/4, counting the removed entries as well, as
+  // they lengthen the probes the same way.
+  uint64_t occupied = header_->count + header_->removed + 1;
+  if (entry == nullptr || occupied * 4 > header_->capacity * 3) {
+    uint64_t capacity = header_->capacity;
+    if ((header_->count + 1) * 2 > capacity) {
+      capacity *= 2;
+    }
+
+    if (!Rehash(capacity)) {
+      return false;
+    }
+
+    entry = Find(key, &found);
+  }
+
+  if (LoadState(entry) == kRemoved) {
+    --header_->removed;
+  }
+
+  memcpy(entry->key, key, kKeySize);
+  entry->size = size;
+  entry->inserted = NowMilliseconds();
+  entry->accessed = ++header_->clock;
+  StoreState(entry, kUsed);
+
+  ++header_->count;
+  header_->size += size;
+  return true;
+}
+
+bool CacheIndex::Touch(const std::string& checksum) {
+  uint8_t key[kKeySize];
+  if (!ParseKey(checksum, key)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  bool found = false;
+  Entry* entry = Find(key, &found);
+  if (!found) {
+    return false;
+  }
+
+  entry->accessed = ++header_->clock;
+  return true;
+}
+
+bool CacheIndex::Remove(const std::string& checksum) {
+  uint8_t key[kKeySize];
+  if (!ParseKey(checksum, key)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  bool found = false;
+  Entry* entry = Find(key, &found);
+  if (!found) {
+    return false;
+  }
+
+  StoreState(entry, kRemoved);
+  --header_->count;
+  ++header_->removed;
+  header_->size -= entry->size;
+  return true;
+}
+
+bool CacheIndex::Contains(const std::string& checksum) {
+  uint8_t key[kKeySize];
+  if (!ParseKey(checksum, key)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  bool found = false;
+  Find(key, &found);
+  return found;
+}
+
+std::vector<std::string> CacheIndex::Evict(int64_t target) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::vector<Entry*> used;
+  used.reserve(header_->count);
+  for (uint64_t i = 0; i < header_->capacity; ++i) {
+    if (LoadState(&entries_[i]) == kUsed) {
+      used.push_back(&entries_[i]);
+    }
+  }
+
+  std::sort(used.begin(), used.end(), [](const Entry* a, const Entry* b) {
+    return a->accessed < b->accessed;
+  });
+
+  std::vector<std::string> removed;
+  int64_t freed = 0;
+  for (Entry* entry : used) {
+    if (freed >= target) {
+      break;
+    }
+
+    StoreState(entry, kRemoved);
+    --header_->count;
+    ++header_->removed;
+    header_->size -= entry->size;
+    freed += entry->size;
+    removed.push_back(FormatKey(entry->key));
+  }
+
+  return removed;
+}
+
+std::vector<std::string> CacheIndex::Checksums() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::vector<const Entry*> used;
+  used.reserve(header_->count);
+  for (uint64_t i = 0; i < header_->capacity; ++i) {
+    if (LoadState(&entries_[i]) == kUsed) {
+      used.push_back(&entries_[i]);
+    }
+  }
+
+  std::sort(used.begin(), used.end(),
+            [](const Entry* a, const Entry* b) {
+              return a->accessed < b->accessed;
+            });
+
+  std::vector<std::string> checksums;
+  checksums.reserve(used.size());
+  for (const Entry* entry : used) {
+    checksums.push_back(FormatKey(entry->key));
+  }
+  return checksums;
+}
+
+void CacheIndex::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (uint64_t i = 0; i < header_->capacity; ++i) {
+    StoreState(&entries_[i], kEmpty);
+  }
+
+  header_->count = 0;
+  header_->removed = 0;
+  header_->size = 0;
+}
+
+int64_t CacheIndex::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return header_->size;
+}
+
+size_t CacheIndex::count() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return header_->count;
+}
@@ -0,0 +1,103 @@
+#ifndef RUNNER_CACHE_INDEX_H_
+#define RUNNER_CACHE_INDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+// On-disk layout of the CacheIndex, defined in the implementation.
+struct CacheIndexHeader;
+struct CacheIndexEntry;
+
+// Persistent index of the cached files keyed by their SHA-256 checksums.
+//
+// Stored as an open addressing hash table in a memory mapped file, so every
+// lookup is a few probes into the shared mapping. Each entry records the size
+// of the file, the time it was inserted, and a logical access clock bumped by
+// Touch(), which is used for LRU eviction instead of unreliable atime.
+//
+// Entries are published by their state being written last, and the header
+// totals are recounted on Open() if the index wasn't closed cleanly, so the
+// index stays consistent if the application crashes.
+class CacheIndex {
+ public:
+  // Opens or creates the index at |path|. Sets |created| to true if a new
+  // index was created. Returns nullptr with errno set on failure.
+  static CacheIndex* Open(const char* path, bool* created);
+
+  ~CacheIndex();
+
+  CacheIndex(const CacheIndex&) = delete;
+  CacheIndex& operator=(const CacheIndex&) = delete;
+
+  // Inserts the file with the hex |checksum| of |size| bytes, or updates its
+  // size if it's present already, marking it as the most recently used.
+  // Returns false if the |checksum| isn't a SHA-256 hex string or the index
+  // can't be grown.
+  bool Insert(const std::string& checksum, int64_t size);
+
+  // Marks the file with the |checksum| as the most recently used. Returns
+  // false if it's not present.
+  bool Touch(const std::string& checksum);
+
+  // Removes the file with the |checksum|. Returns false if it's not present.
+  bool Remove(const std::string& checksum);
+
+  // Indicates whether the file with the |checksum| is present.
+  bool Contains(const std::string& checksum);
+
+  // Removes the least recently used files until at least |target| bytes are
+  // freed, returning their checksums. Doesn't touch the files themselves.
+  std::vector<std::string> Evict(int64_t target);
+
+  // Returns the checksums of all the files, from the least to the most
+  // recently used.
+  std::vector<std::string> Checksums();
+
+  // Removes all the files.
+  void Clear();
+
+  // Returns the total size of the files in bytes.
+  int64_t size();
+
+  // Returns the number of the files.
+  size_t count();
+
+ private:
+  using Header = CacheIndexHeader;
+  using Entry = CacheIndexEntry;
+
+  CacheIndex(const std::string& path, int fd);
+
+  // Maps the |fd_| of |capacity| entries.
+  bool Map(uint64_t capacity);
+
+  // Returns the entry of the |key| or the free slot it should be put to.
+  //
+  // Must be called with |mutex_| held.
+  Entry* Find(const uint8_t* key, bool* found);
+
+  // Recounts the header totals from the entries.
+  //
+  // Must be called with |mutex_| held.
+  void Recount();
+
+  // Moves the live entries into a new file of |capacity| entries, replacing
+  // the current one atomically.
+  //
+  // Must be called with |mutex_| held.
+  bool Rehash(uint64_t capacity);
+
+  const std::string path_;
+  int fd_;
+
+  std::mutex mutex_;
+  Header* header_ = nullptr;
+  Entry* entries_ = nullptr;
+  size_t mapped_size_ = 0;
+};
+
+#endif  // RUNNER_CACHE_INDEX_H_
@@ -0,0 +1,202 @@
+#include "cache_scanner.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+
+// Size of the buffer the directory entries are read into at once.
+static const size_t kDirentBufferSize = 256 * 1024;
+
+// Minimum amount of files worth spawning an additional thread for.
+static const size_t kFilesPerThread = 512;
+
+// Entry of the getdents64() result, not exposed by glibc headers.
+struct LinuxDirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+// Appends the regular files of the |fd| directory to the |names| prefixed
+// with the |prefix|, descending into the subdirectories.
+static void ListDirectory(int fd,
+                          const std::string& prefix,
+                          std::vector<std::string>* names) {
+  std::vector<char> buffer(kDirentBufferSize);
+
+  while (true) {
+    long bytes_read =
+        syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes_read <= 0) {
+      break;
+    }
+
+    for (long offset = 0; offset < bytes_read;) {
+      const LinuxDirent64* entry =
+          reinterpret_cast<const LinuxDirent64*>(buffer.data() + offset);
+      offset += entry->d_reclen;
+
+      const char* name = entry->d_name;
+      if (name[0] == '.' &&
+          (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+        continue;
+      }
+
+      unsigned char type = entry->d_type;
+      if (type == DT_UNKNOWN) {
+        // Some filesystems don't report the types in the entries.
+        struct stat st;
+        if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+          continue;
+        }
+        type = S_ISDIR(st.st_mode)   ? DT_DIR
+               : S_ISREG(st.st_mode) ? DT_REG
+                                     : DT_UNKNOWN;
+      }
+
+      if (type == DT_REG) {
+        names->push_back(prefix + name);
+      } else if (type == DT_DIR) {
+        int child = openat(fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (child >= 0) {
+          ListDirectory(child, prefix + name + "/", names);
+          close(child);
+        }
+      }
+    }
+  }
+}
+
+// Stats the |file| relative to the |dir_fd| directory. Returns false if it no
+// longer exists.
+static bool StatFile(int dir_fd, CacheFile* file) {
+#ifdef STATX_SIZE
+  struct statx stx;
+  if (statx(dir_fd, file->name.c_str(),
+            AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, STATX_SIZE | STATX_ATIME,
+            &stx) == 0) {
+    file->size = stx.stx_size;
+    file->accessed = static_cast<int64_t>(stx.stx_atime.tv_sec) * 1000000000 +
+                     stx.stx_atime.tv_nsec;
+    return true;
+  }
+
+  if (errno != ENOSYS) {
+    return false;
+  }
+#endif
+
+  struct stat st;
+  if (fstatat(dir_fd, file->name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+    return false;
+  }
+
+  file->size = st.st_size;
+  file->accessed =
+      static_cast<int64_t>(st.st_atim.tv_sec) * 1000000000 + st.st_atim.tv_nsec;
+  return true;
+}
+
+bool ScanCacheDirectory(const char* directory, int threads, CacheScan* scan) {
+  int fd = open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  std::vector<std::string> names;
+  ListDirectory(fd, "", &names);
+
+  std::vector<CacheFile> files(names.size());
+  std::vector<char> found(names.size(), 0);
+  for (size_t i = 0; i < names.size(); ++i) {
+    files[i].name = std::move(names[i]);
+  }
+
+  // Each thread stats its own contiguous slice of the |files|.
+  size_t count = std::max<size_t>(
+      1, std::min<size_t>(threads, files.size() / kFilesPerThread));
+  size_t slice = (files.size() + count - 1) / count;
+
+  auto stat_slice = [fd, &files, &found, slice](size_t index) {
+    size_t end = std::min(files.size(), (index + 1) * slice);
+    for (size_t i = index * slice; i < end; ++i) {
+      found[i] = StatFile(fd, &files[i]);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < count; ++i) {
+    workers.emplace_back(stat_slice, i);
+  }
+  stat_slice(0);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  close(fd);
+
+  scan->size = 0;
+  scan->files.clear();
+  scan->files.reserve(files.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (found[i]) {
+      scan->size += files[i].size;
+      scan->files.push_back(std::move(files[i]));
+    }
+  }
+
+  std::sort(scan->files.begin(), scan->files.end(),
+            [](const CacheFile& a, const CacheFile& b) {
+              return a.accessed < b.accessed;
+            });
+
+  return true;
+}
+
+bool RemoveCacheFile(int directory_fd, const std::string& name) {
+  return unlinkat(directory_fd, name.c_str(), 0) == 0;
+}
+
+std::vector<std::string> EvictCacheFiles(const char* directory,
+                                         off_t target,
+                                         const std::vector<std::string>& keep,
+                                         CacheScan* scan) {
+  std::vector<std::string> removed;
+
+  int fd = open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return removed;
+  }
+
+  std::unordered_set<std::string> kept(keep.begin(), keep.end());
+
+  off_t freed = 0;
+  std::vector<CacheFile> remaining;
+  for (CacheFile& file : scan->files) {
+    if (freed < target && kept.count(file.name) == 0 &&
+        RemoveCacheFile(fd, file.name)) {
+      freed += file.size;
+      removed.push_back(std::move(file.name));
+    } else {
+      remaining.push_back(std::move(file));
+    }
+  }
+  close(fd);
+
+  scan->size -= freed;
+  scan->files = std::move(remaining);
+
+  return removed;
+}
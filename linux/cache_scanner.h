@@ -0,0 +1,52 @@
+#ifndef RUNNER_CACHE_SCANNER_H_
+#define RUNNER_CACHE_SCANNER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+// File found by ScanCacheDirectory().
+struct CacheFile {
+  // Path of the file relative to the scanned directory.
+  std::string name;
+
+  off_t size;
+
+  // Last access time in nanoseconds since the epoch.
+  int64_t accessed;
+};
+
+struct CacheScan {
+  // Total size of the |files| in bytes.
+  off_t size = 0;
+
+  // Files sorted from the least to the most recently accessed.
+  std::vector<CacheFile> files;
+};
+
+// Lists the |directory| recursively with getdents64() and stats the found
+// files with statx() on up to |threads| threads. Returns false with errno set
+// if the |directory| can't be opened.
+bool ScanCacheDirectory(const char* directory, int threads, CacheScan* scan);
+
+// Removes the file |name| of the cache directory opened as |directory_fd|.
+// Returns false with errno set on failure.
+//
+// Cached files are only ever unlinked, and never truncated, as they may be
+// mapped by messenger_map_file(): an unlinked file stays readable until it's
+// unmapped, while reading a mapping past the end of a truncated file raises
+// `SIGBUS`.
+bool RemoveCacheFile(int directory_fd, const std::string& name);
+
+// Removes the least recently accessed files from the |scan| of the
+// |directory| until at least |target| bytes are freed, skipping the files
+// named in |keep|, with RemoveCacheFile(). Updates the |scan| and returns
+// the names of the removed files.
+std::vector<std::string> EvictCacheFiles(const char* directory,
+                                         off_t target,
+                                         const std::vector<std::string>& keep,
+                                         CacheScan* scan);
+
+#endif  // RUNNER_CACHE_SCANNER_H_
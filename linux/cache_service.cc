@@ -0,0 +1,372 @@
+#include "cache_service.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_response.h"
+#include "cache_index.h"
+#include "cache_scanner.h"
+#include "worker_pool.h"
+
+// Maximum number of threads to stat the cache files on.
+static const int kMaxScanThreads = 4;
+
+// CacheIndex opened by `openCacheIndex`, shared with the worker tasks, so
+// closing it doesn't pull it out from under them.
+static std::shared_ptr<CacheIndex> cache_index;
+
+// Directory the files of the |cache_index| are stored in.
+static std::string cache_index_directory;
+
+static int scan_threads() {
+  return std::max(1, std::min(static_cast<int>(
+                                  std::thread::hardware_concurrency()),
+                              kMaxScanThreads));
+}
+
+// Returns the `{size, checksums}` map describing the |scan|, with the
+// checksums sorted from the least to the most recently accessed.
+static FlValue* scan_to_value(const CacheScan& scan) {
+  FlValue* checksums = fl_value_new_list();
+  for (const CacheFile& file : scan.files) {
+    fl_value_append_take(checksums, fl_value_new_string(file.name.c_str()));
+  }
+
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "size", fl_value_new_int(scan.size));
+  fl_value_set_string_take(result, "checksums", checksums);
+  return result;
+}
+
+static const gchar* lookup_path(FlValue* args) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return nullptr;
+  }
+
+  FlValue* path = fl_value_lookup_string(args, "path");
+  if (path == nullptr || fl_value_get_type(path) != FL_VALUE_TYPE_STRING) {
+    return nullptr;
+  }
+
+  return fl_value_get_string(path);
+}
+
+static FlMethodResponse* scan_cache(FlMethodCall* method_call, FlValue* args) {
+  const gchar* path = lookup_path(args);
+  if (path == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`path` must be a string", nullptr));
+  }
+
+  FlMethodCall* held = FL_METHOD_CALL(g_object_ref(method_call));
+  std::string directory = path;
+  WorkerPool::Shared()->Post([held, directory] {
+    CacheScan scan;
+    if (!ScanCacheDirectory(directory.c_str(), scan_threads(), &scan)) {
+      method_call_respond_async(
+          held, method_error_response_errno(
+                    "FILE_ERROR", "Failed to scan cache directory", errno));
+      return;
+    }
+
+    g_autoptr(FlValue) result = scan_to_value(scan);
+    method_call_respond_async(
+        held, FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+  });
+
+  return nullptr;
+}
+
+static FlMethodResponse* evict_cache(FlMethodCall* method_call, FlValue* args) {
+  const gchar* path = lookup_path(args);
+  FlValue* target = path == nullptr ? nullptr
+                                    : fl_value_lookup_string(args, "target");
+  if (target == nullptr || fl_value_get_type(target) != FL_VALUE_TYPE_INT) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`path` and `target` must be provided", nullptr));
+  }
+
+  std::vector<std::string> keep;
+  FlValue* keep_value = fl_value_lookup_string(args, "keep");
+  if (keep_value != nullptr &&
+      fl_value_get_type(keep_value) == FL_VALUE_TYPE_LIST) {
+    for (size_t i = 0; i < fl_value_get_length(keep_value); ++i) {
+      FlValue* name = fl_value_get_list_value(keep_value, i);
+      if (fl_value_get_type(name) == FL_VALUE_TYPE_STRING) {
+        keep.push_back(fl_value_get_string(name));
+      }
+    }
+  }
+
+  FlMethodCall* held = FL_METHOD_CALL(g_object_ref(method_call));
+  std::string directory = path;
+  off_t bytes = fl_value_get_int(target);
+  WorkerPool::Shared()->Post([held, directory, bytes, keep] {
+    CacheScan scan;
+    if (!ScanCacheDirectory(directory.c_str(), scan_threads(), &scan)) {
+      method_call_respond_async(
+          held, method_error_response_errno(
+                    "FILE_ERROR", "Failed to scan cache directory", errno));
+      return;
+    }
+
+    std::vector<std::string> removed =
+        EvictCacheFiles(directory.c_str(), bytes, keep, &scan);
+
+    g_autoptr(FlValue) result = scan_to_value(scan);
+    FlValue* removed_value = fl_value_new_list();
+    for (const std::string& name : removed) {
+      fl_value_append_take(removed_value, fl_value_new_string(name.c_str()));
+    }
+    fl_value_set_string_take(result, "removed", removed_value);
+
+    method_call_respond_async(
+        held, FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+  });
+
+  return nullptr;
+}
+
+// Returns the `{size, checksums}` map describing the |index|.
+static FlValue* index_to_value(CacheIndex* index) {
+  FlValue* checksums = fl_value_new_list();
+  for (const std::string& checksum : index->Checksums()) {
+    fl_value_append_take(checksums, fl_value_new_string(checksum.c_str()));
+  }
+
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "size", fl_value_new_int(index->size()));
+  fl_value_set_string_take(result, "checksums", checksums);
+  return result;
+}
+
+// Fills the |index| with the files of the |directory| in their LRU order, so
+// the existing cache is carried over into a new index.
+static bool populate_index(CacheIndex* index, const std::string& directory) {
+  CacheScan scan;
+  if (!ScanCacheDirectory(directory.c_str(), scan_threads(), &scan)) {
+    return false;
+  }
+
+  index->Clear();
+  for (const CacheFile& file : scan.files) {
+    // Files not named by their checksums aren't the cache entries.
+    index->Insert(file.name, file.size);
+  }
+
+  return true;
+}
+
+// Responds to the |held| call with the contents of the |index|, populating
+// it from the |directory| first if |populate| is true.
+static void respond_index_async(FlMethodCall* held,
+                                std::shared_ptr<CacheIndex> index,
+                                const std::string& directory,
+                                bool populate) {
+  WorkerPool::Shared()->Post([held, index, directory, populate] {
+    if (populate && !populate_index(index.get(), directory)) {
+      method_call_respond_async(
+          held, method_error_response_errno(
+                    "FILE_ERROR", "Failed to scan cache directory", errno));
+      return;
+    }
+
+    g_autoptr(FlValue) result = index_to_value(index.get());
+    method_call_respond_async(
+        held, FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+  });
+}
+
+static FlMethodResponse* index_not_opened_error() {
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(
+      "STATE_ERROR", "Cache index is not opened", nullptr));
+}
+
+static FlMethodResponse* open_cache_index(FlMethodCall* method_call,
+                                          FlValue* args) {
+  const gchar* path = lookup_path(args);
+  FlValue* directory = path == nullptr
+                           ? nullptr
+                           : fl_value_lookup_string(args, "directory");
+  if (directory == nullptr ||
+      fl_value_get_type(directory) != FL_VALUE_TYPE_STRING) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`path` and `directory` must be strings", nullptr));
+  }
+
+  // Release the previous index first, as it may be the same file.
+  cache_index.reset();
+
+  bool created = false;
+  CacheIndex* index = CacheIndex::Open(path, &created);
+  if (index == nullptr) {
+    return method_error_response_errno("FILE_ERROR",
+                                       "Failed to open cache index", errno);
+  }
+
+  cache_index.reset(index);
+  cache_index_directory = fl_value_get_string(directory);
+
+  respond_index_async(FL_METHOD_CALL(g_object_ref(method_call)), cache_index,
+                      cache_index_directory, created);
+  return nullptr;
+}
+
+static FlMethodResponse* rebuild_cache_index(FlMethodCall* method_call) {
+  if (cache_index == nullptr) {
+    return index_not_opened_error();
+  }
+
+  respond_index_async(FL_METHOD_CALL(g_object_ref(method_call)), cache_index,
+                      cache_index_directory, true);
+  return nullptr;
+}
+
+static const gchar* lookup_checksum(FlValue* args) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return nullptr;
+  }
+
+  FlValue* checksum = fl_value_lookup_string(args, "checksum");
+  if (checksum == nullptr ||
+      fl_value_get_type(checksum) != FL_VALUE_TYPE_STRING) {
+    return nullptr;
+  }
+
+  return fl_value_get_string(checksum);
+}
+
+// Touching and adding are just a few probes into the mapped index, so are
+// done right on the main thread.
+static FlMethodResponse* touch_cache(FlValue* args) {
+  const gchar* checksum = lookup_checksum(args);
+  if (checksum == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`checksum` must be a string", nullptr));
+  } else if (cache_index == nullptr) {
+    return index_not_opened_error();
+  }
+
+  g_autoptr(FlValue) result =
+      fl_value_new_bool(cache_index->Touch(checksum));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* add_cache(FlValue* args) {
+  const gchar* checksum = lookup_checksum(args);
+  FlValue* size = checksum == nullptr ? nullptr
+                                      : fl_value_lookup_string(args, "size");
+  if (size == nullptr || fl_value_get_type(size) != FL_VALUE_TYPE_INT) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`checksum` and `size` must be provided", nullptr));
+  } else if (cache_index == nullptr) {
+    return index_not_opened_error();
+  }
+
+  if (!cache_index->Insert(checksum, fl_value_get_int(size))) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "Failed to add the checksum to cache index",
+        nullptr));
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_int(cache_index->size());
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* evict_cache_index(FlMethodCall* method_call,
+                                           FlValue* args) {
+  FlValue* target = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    target = fl_value_lookup_string(args, "target");
+  }
+
+  if (target == nullptr || fl_value_get_type(target) != FL_VALUE_TYPE_INT) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`target` must be an integer", nullptr));
+  } else if (cache_index == nullptr) {
+    return index_not_opened_error();
+  }
+
+  FlMethodCall* held = FL_METHOD_CALL(g_object_ref(method_call));
+  std::shared_ptr<CacheIndex> index = cache_index;
+  std::string directory = cache_index_directory;
+  int64_t bytes = fl_value_get_int(target);
+  WorkerPool::Shared()->Post([held, index, directory, bytes] {
+    std::vector<std::string> removed = index->Evict(bytes);
+
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    FlValue* removed_value = fl_value_new_list();
+    for (const std::string& checksum : removed) {
+      if (fd >= 0) {
+        RemoveCacheFile(fd, checksum);
+      }
+      fl_value_append_take(removed_value,
+                           fl_value_new_string(checksum.c_str()));
+    }
+    if (fd >= 0) {
+      close(fd);
+    }
+
+    g_autoptr(FlValue) result = fl_value_new_map();
+    fl_value_set_string_take(result, "size", fl_value_new_int(index->size()));
+    fl_value_set_string_take(result, "removed", removed_value);
+    method_call_respond_async(
+        held, FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+  });
+
+  return nullptr;
+}
+
+static FlMethodResponse* close_cache_index() {
+  cache_index.reset();
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+gboolean cache_service_handle_method_call(FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "scanCache") == 0) {
+    response = scan_cache(method_call, args);
+  } else if (strcmp(method, "evictCache") == 0) {
+    response = evict_cache(method_call, args);
+  } else if (strcmp(method, "openCacheIndex") == 0) {
+    response = open_cache_index(method_call, args);
+  } else if (strcmp(method, "rebuildCacheIndex") == 0) {
+    response = rebuild_cache_index(method_call);
+  } else if (strcmp(method, "touchCache") == 0) {
+    response = touch_cache(args);
+  } else if (strcmp(method, "addCache") == 0) {
+    response = add_cache(args);
+  } else if (strcmp(method, "evictCacheIndex") == 0) {
+    response = evict_cache_index(method_call, args);
+  } else if (strcmp(method, "closeCacheIndex") == 0) {
+    response = close_cache_index();
+  } else {
+    return FALSE;
+  }
+
+  // Errors and synchronous results are responded to right away.
+  if (response != nullptr) {
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(method_call, response, &error)) {
+      g_warning("Failed to send response: %s", error->message);
+    }
+  }
+
+  return TRUE;
+}
+
+void cache_service_dispose() {
+  cache_index.reset();
+}
@@ -0,0 +1,27 @@
+#ifndef RUNNER_CACHE_SERVICE_H_
+#define RUNNER_CACHE_SERVICE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * cache_service_handle_method_call:
+ * @method_call: #FlMethodCall received on the utils channel.
+ *
+ * Handles the `scanCache` and `evictCache` methods maintaining the
+ * `CacheWorker` directory, and the `*CacheIndex`, `touchCache` and
+ * `addCache` methods maintaining its persistent #CacheIndex. Scanning and
+ * evicting are done on the #WorkerPool and responded to asynchronously.
+ *
+ * Returns: %TRUE if the @method_call was handled by this service.
+ */
+gboolean cache_service_handle_method_call(FlMethodCall* method_call);
+
+/**
+ * cache_service_dispose:
+ *
+ * Closes the cache index opened by the `openCacheIndex` method, if any,
+ * marking it as closed cleanly.
+ */
+void cache_service_dispose();
+
+#endif  // RUNNER_CACHE_SERVICE_H_
@@ -0,0 +1,254 @@
+#include "database_maintenance.h"
+
+#include <pthread.h>
+#include <sqlite3ext.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <chrono>
+#include <thread>
+
+// Routines of the SQLite library the watched databases are opened with, used
+// by the `sqlite3_*` macros of the `sqlite3ext.h`.
+static const sqlite3_api_routines* sqlite3_api = nullptr;
+
+// Interval between the maintenance passes.
+static const std::chrono::seconds kInterval(30);
+
+// Seconds the `-wal` file must not be written for to checkpoint it, so the
+// bursts of writes are done by then.
+static const int64_t kIdleSeconds = 5;
+
+// Seconds the `-wal` file must not be written for to run the operations taking
+// the write lock.
+static const int64_t kLongIdleSeconds = 60;
+
+// Size of the `-wal` file to checkpoint it at, matching the SQLite's own
+// `wal_autocheckpoint` of 1000 pages.
+static const int64_t kCheckpointSize = 4 * 1024 * 1024;
+
+// Size of the fully checkpointed `-wal` file to truncate it at.
+static const int64_t kTruncateSize = 16 * 1024 * 1024;
+
+// Size of the `-wal` file to truncate it at even when the window is focused.
+static const int64_t kLargeWalSize = 64 * 1024 * 1024;
+
+// Number of the free pages to run the `incremental_vacuum` at, and the most
+// pages released by a single pass.
+static const int64_t kVacuumPages = 256;
+static const int64_t kVacuumStep = 2048;
+
+// Seconds between the `PRAGMA optimize` of the same database.
+static const int64_t kOptimizeSeconds = 6 * 60 * 60;
+
+// Returns the current CLOCK_REALTIME time in milliseconds.
+static int64_t NowMillis() {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+// Returns the first column of the first row of the |sql| over the |db|, or
+// the |fallback|, if there is none.
+static int64_t QueryInt(sqlite3* db, const char* sql, int64_t fallback) {
+  int64_t result = fallback;
+
+  sqlite3_stmt* statement = nullptr;
+  if (sqlite3_prepare_v2(db, sql, -1, &statement, nullptr) == SQLITE_OK &&
+      sqlite3_step(statement) == SQLITE_ROW) {
+    result = sqlite3_column_int64(statement, 0);
+  }
+  sqlite3_finalize(statement);
+
+  return result;
+}
+
+// Records the result |rc| of an operation over the |db| into the |stats|,
+// returning whether it succeeded.
+static bool Check(int rc, sqlite3* db, DatabaseMaintenanceStats* stats) {
+  if (rc == SQLITE_OK) {
+    return true;
+  }
+
+  if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+    ++stats->busy;
+  } else {
+    stats->last_error = sqlite3_errmsg(db);
+  }
+
+  return false;
+}
+
+DatabaseMaintenance* DatabaseMaintenance::Shared() {
+  // Intentionally leaked, as the maintenance may still be running on exit,
+  // which is safe to be interrupted at any point.
+  static DatabaseMaintenance* maintenance = new DatabaseMaintenance();
+  return maintenance;
+}
+
+void DatabaseMaintenance::Watch(sqlite3* db,
+                                const sqlite3_api_routines* api) {
+  const char* path = api->db_filename(db, "main");
+  if (path == nullptr || path[0] == '\0') {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sqlite3_api == nullptr) {
+      sqlite3_api = api;
+      std::thread(&DatabaseMaintenance::Run, this).detach();
+    }
+
+    DatabaseMaintenanceStats& stats = databases_[path];
+    stats.path = path;
+  }
+}
+
+void DatabaseMaintenance::SetFocused(bool focused) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    focused_ = focused;
+  }
+  changed_.notify_one();
+}
+
+std::vector<DatabaseMaintenanceStats> DatabaseMaintenance::Stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::vector<DatabaseMaintenanceStats> stats;
+  for (const auto& entry : databases_) {
+    stats.push_back(entry.second);
+  }
+  return stats;
+}
+
+void DatabaseMaintenance::Run() {
+  pthread_setname_np(pthread_self(), "db_maintenance");
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    changed_.wait_for(lock, kInterval);
+
+    // Databases are maintained without the lock, as it may take a while.
+    bool focused = focused_;
+    std::vector<DatabaseMaintenanceStats> databases;
+    for (const auto& entry : databases_) {
+      databases.push_back(entry.second);
+    }
+    lock.unlock();
+
+    std::vector<bool> exist;
+    for (DatabaseMaintenanceStats& stats : databases) {
+      exist.push_back(Maintain(&stats, focused));
+    }
+
+    lock.lock();
+    for (size_t i = 0; i < databases.size(); ++i) {
+      if (exist[i]) {
+        databases_[databases[i].path] = databases[i];
+      } else {
+        databases_.erase(databases[i].path);
+      }
+    }
+  }
+}
+
+bool DatabaseMaintenance::Maintain(DatabaseMaintenanceStats* stats,
+                                   bool focused) {
+  struct stat database;
+  if (stat(stats->path.c_str(), &database) != 0) {
+    return false;
+  }
+
+  // Nothing to checkpoint, if the `-wal` file doesn't exist, as the database
+  // isn't opened or isn't in the WAL mode.
+  std::string wal_path = stats->path + "-wal";
+  struct stat wal;
+  if (stat(wal_path.c_str(), &wal) != 0) {
+    stats->wal_size = 0;
+    return true;
+  }
+
+  stats->wal_size = wal.st_size;
+  int64_t idle = time(nullptr) - wal.st_mtime;
+  if (idle < kIdleSeconds) {
+    return true;
+  }
+
+  bool blocking = !focused && idle >= kLongIdleSeconds;
+  int64_t& optimized = optimized_[stats->path];
+  bool optimize = blocking && time(nullptr) - optimized >= kOptimizeSeconds;
+  if (stats->wal_size < kCheckpointSize && !optimize) {
+    return true;
+  }
+
+  // Opened without creating, so the databases deleted since are not.
+  sqlite3* db = nullptr;
+  if (sqlite3_open_v2(stats->path.c_str(), &db,
+                      SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX,
+                      nullptr) != SQLITE_OK) {
+    stats->last_error = db == nullptr ? "out of memory" : sqlite3_errmsg(db);
+    sqlite3_close(db);
+    return true;
+  }
+
+  stats->last_run = NowMillis();
+  sqlite3_busy_timeout(db, 0);
+
+  // The connection only finds out the database is in the WAL mode once it
+  // reads it, until then the checkpoints are no-op.
+  QueryInt(db, "PRAGMA schema_version", 0);
+
+  int log = 0;
+  int checkpointed = 0;
+  if (stats->wal_size >= kCheckpointSize &&
+      Check(sqlite3_wal_checkpoint_v2(db, "main", SQLITE_CHECKPOINT_PASSIVE,
+                                      &log, &checkpointed),
+            db, stats)) {
+    ++stats->passive_checkpoints;
+    stats->checkpointed_frames += checkpointed;
+
+    // Truncating the fully checkpointed `-wal` file only takes the write lock
+    // for a moment, as no frames are left to be copied.
+    if (log == checkpointed && stats->wal_size >= kTruncateSize &&
+        (blocking || stats->wal_size >= kLargeWalSize) &&
+        Check(sqlite3_wal_checkpoint_v2(db, "main",
+                                        SQLITE_CHECKPOINT_TRUNCATE, nullptr,
+                                        nullptr),
+              db, stats)) {
+      ++stats->truncate_checkpoints;
+      stats->truncated_bytes += stats->wal_size;
+      stats->wal_size = 0;
+    }
+  }
+
+  // `PRAGMA auto_vacuum` is `2` for the `INCREMENTAL` mode.
+  if (blocking && QueryInt(db, "PRAGMA auto_vacuum", 0) == 2) {
+    int64_t pages = QueryInt(db, "PRAGMA freelist_count", 0);
+    if (pages >= kVacuumPages) {
+      std::string sql =
+          "PRAGMA incremental_vacuum(" + std::to_string(kVacuumStep) + ")";
+      if (Check(sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr), db,
+                stats)) {
+        stats->vacuumed_pages +=
+            pages - QueryInt(db, "PRAGMA freelist_count", pages);
+      }
+    }
+  }
+
+  // Analyzes the tables of the database, not of the queries of this fresh
+  // connection, limiting the rows scanned for each index.
+  if (optimize &&
+      Check(sqlite3_exec(db,
+                         "PRAGMA analysis_limit = 400;"
+                         "PRAGMA optimize = 0x10002;",
+                         nullptr, nullptr, nullptr),
+            db, stats)) {
+    ++stats->optimizations;
+    optimized = time(nullptr);
+  }
+
+  sqlite3_close(db);
+  return true;
+}
@@ -0,0 +1,109 @@
+#ifndef RUNNER_DATABASE_MAINTENANCE_H_
+#define RUNNER_DATABASE_MAINTENANCE_H_
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_api_routines;
+
+// Statistics of the maintenance of a single database since the start.
+struct DatabaseMaintenanceStats {
+  // Path to the database file.
+  std::string path;
+
+  // Size of the `-wal` file as of the last check, in bytes.
+  int64_t wal_size = 0;
+
+  // Number of the `PASSIVE` and `TRUNCATE` checkpoints completed.
+  int64_t passive_checkpoints = 0;
+  int64_t truncate_checkpoints = 0;
+
+  // Number of the WAL frames copied into the database by the checkpoints.
+  int64_t checkpointed_frames = 0;
+
+  // Number of the WAL bytes released by the `TRUNCATE` checkpoints.
+  int64_t truncated_bytes = 0;
+
+  // Number of the free pages released by the `incremental_vacuum`.
+  int64_t vacuumed_pages = 0;
+
+  // Number of the `PRAGMA optimize` completed.
+  int64_t optimizations = 0;
+
+  // Number of the operations skipped, as the database was locked.
+  int64_t busy = 0;
+
+  // Time of the last maintenance pass, in Unix milliseconds, or zero.
+  int64_t last_run = 0;
+
+  // Message of the last error, if any.
+  std::string last_error;
+};
+
+// Keeps the SQLite databases opened by the application compact by running
+// the maintenance on its own thread and connections, when they aren't
+// written to for a while:
+//
+// - `PASSIVE` checkpoints, once the `-wal` file grows, never waiting for nor
+//   blocking the readers and writers;
+// - `TRUNCATE` checkpoints, shrinking the `-wal` file, as SQLite only reuses
+//   it from the start, but never makes it smaller;
+// - `incremental_vacuum`, if the database is created with the
+//   `auto_vacuum = INCREMENTAL`;
+// - `PRAGMA optimize`, once in a while.
+//
+// Everything but the `PASSIVE` checkpoints takes the write lock, so is only
+// done while the window isn't focused, or, for a `TRUNCATE` checkpoint, if the
+// `-wal` file grows huge. The connections never wait for the locks, skipping
+// the operations for the next pass instead.
+class DatabaseMaintenance {
+ public:
+  // Returns the DatabaseMaintenance of the process.
+  static DatabaseMaintenance* Shared();
+
+  DatabaseMaintenance(const DatabaseMaintenance&) = delete;
+  DatabaseMaintenance& operator=(const DatabaseMaintenance&) = delete;
+
+  // Starts maintaining the file of the |db| being opened, if it's not an
+  // in-memory or a temporary one. The maintenance connections are opened via
+  // the |api| routines of the first database watched.
+  void Watch(sqlite3* db, const sqlite3_api_routines* api);
+
+  // Updates whether the application's window is focused, which postpones any
+  // blocking maintenance.
+  void SetFocused(bool focused);
+
+  // Returns the statistics of the databases being maintained.
+  std::vector<DatabaseMaintenanceStats> Stats();
+
+ private:
+  DatabaseMaintenance() = default;
+
+  // Body of the maintenance thread, started by the first Watch().
+  void Run();
+
+  // Runs a maintenance pass over the database of the |stats|, updating them.
+  //
+  // Returns false, if the database doesn't exist anymore.
+  bool Maintain(DatabaseMaintenanceStats* stats, bool focused);
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+
+  // Statistics of the databases being maintained by their paths.
+  std::map<std::string, DatabaseMaintenanceStats> databases_;
+
+  // Times of the last `PRAGMA optimize` of the databases by their paths, in
+  // Unix seconds, accessed by the maintenance thread only.
+  std::map<std::string, int64_t> optimized_;
+
+  bool focused_ = true;
+};
+
+#endif  // RUNNER_DATABASE_MAINTENANCE_H_
@@ -0,0 +1,91 @@
+#include "deferred_plugins.h"
+
+#include <flutter_linux/flutter_linux.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "startup_trace.h"
+
+typedef void (*RegisterFunction)(FlPluginRegistrar* registrar);
+
+// Plugin whose registration is deferred.
+struct DeferredPlugin {
+  RegisterFunction register_function;
+  FlPluginRegistrar* registrar;
+};
+
+static std::vector<DeferredPlugin> pending_plugins;
+static gboolean plugins_registered = FALSE;
+static guint idle_source = 0;
+
+// Indicates whether the registration is deferred, unless disabled by the
+// `MESSENGER_DEFERRED_PLUGINS=0` environment variable.
+static gboolean deferring_enabled() {
+  const char* value = getenv("MESSENGER_DEFERRED_PLUGINS");
+  return value == nullptr || strcmp(value, "0") != 0;
+}
+
+static void defer_plugin(RegisterFunction register_function,
+                         FlPluginRegistrar* registrar) {
+  if (plugins_registered || !deferring_enabled()) {
+    register_function(registrar);
+    return;
+  }
+
+  // Unreferenced by the generated registrant right after this call.
+  pending_plugins.push_back(
+      DeferredPlugin{register_function,
+                     FL_PLUGIN_REGISTRAR(g_object_ref(registrar))});
+}
+
+// Defines the linker `--wrap` of the |function| deferring the registration.
+#define DEFER_PLUGIN(function)                                            \
+  extern "C" void __real_##function(FlPluginRegistrar* registrar);        \
+  extern "C" void __wrap_##function(FlPluginRegistrar* registrar) {       \
+    defer_plugin(__real_##function, registrar);                           \
+  }
+
+DEFER_PLUGIN(medea_flutter_webrtc_plugin_register_with_registrar)
+DEFER_PLUGIN(medea_jason_plugin_register_with_registrar)
+DEFER_PLUGIN(media_kit_video_plugin_register_with_registrar)
+
+static gboolean register_on_idle(gpointer user_data) {
+  idle_source = 0;
+  deferred_plugins_register();
+  return G_SOURCE_REMOVE;
+}
+
+void deferred_plugins_schedule() {
+  if (!plugins_registered && idle_source == 0) {
+    idle_source = g_idle_add_full(G_PRIORITY_LOW, register_on_idle, nullptr,
+                                  nullptr);
+  }
+}
+
+void deferred_plugins_register() {
+  if (plugins_registered) {
+    return;
+  }
+
+  plugins_registered = TRUE;
+  g_clear_handle_id(&idle_source, g_source_remove);
+
+  int64_t started = StartupTrace::Now();
+  for (const DeferredPlugin& plugin : pending_plugins) {
+    plugin.register_function(plugin.registrar);
+    g_object_unref(plugin.registrar);
+  }
+  pending_plugins.clear();
+  StartupTrace::Shared()->Mark("deferred_plugins", started);
+}
+
+void deferred_plugins_dispose() {
+  g_clear_handle_id(&idle_source, g_source_remove);
+
+  for (const DeferredPlugin& plugin : pending_plugins) {
+    g_object_unref(plugin.registrar);
+  }
+  pending_plugins.clear();
+}
@@ -0,0 +1,36 @@
+#ifndef RUNNER_DEFERRED_PLUGINS_H_
+#define RUNNER_DEFERRED_PLUGINS_H_
+
+// Plugins not needed until a call is started or a video is played are kept
+// out of the `fl_register_plugins()` before the first frame: their
+// `*_register_with_registrar()` functions listed in `DEFERRED_PLUGINS` of the
+// CMakeLists.txt are wrapped by the linker, so the generated registrant only
+// remembers their registrars, and the plugins are registered later.
+//
+// Setting the `MESSENGER_DEFERRED_PLUGINS=0` environment variable registers
+// them right away instead, e.g. to compare the startup with and without.
+
+/**
+ * deferred_plugins_schedule:
+ *
+ * Registers the deferred plugins once the main loop is idle, e.g. after the
+ * first frame is shown.
+ */
+void deferred_plugins_schedule();
+
+/**
+ * deferred_plugins_register:
+ *
+ * Registers the deferred plugins right away, if not registered yet. Must be
+ * called on the main thread.
+ */
+void deferred_plugins_register();
+
+/**
+ * deferred_plugins_dispose:
+ *
+ * Releases the registrars of the plugins never registered.
+ */
+void deferred_plugins_dispose();
+
+#endif  // RUNNER_DEFERRED_PLUGINS_H_
@@ -0,0 +1,592 @@
+#include "delta_patch.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include "sha256.h"
+
+static const char kMagic[8] = {'M', 'D', 'E', 'L', 'T', 'A', '0', '1'};
+
+// Compression of the control records following the header.
+enum class PatchCompression : uint32_t {
+  kNone = 0,
+  kZlib = 1,
+  kZstd = 2,
+};
+
+// Size of the chunks the patch is read and the target is written in.
+static const size_t kChunkSize = 256 * 1024;
+
+// Limits of the header fields, rejecting the garbage before allocating.
+static const uint32_t kMaxSources = 65536;
+static const uint32_t kMaxPathLength = 4096;
+
+static uint32_t ReadLe32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) |
+         static_cast<uint32_t>(data[1]) << 8 |
+         static_cast<uint32_t>(data[2]) << 16 |
+         static_cast<uint32_t>(data[3]) << 24;
+}
+
+static uint64_t ReadLe64(const uint8_t* data) {
+  return static_cast<uint64_t>(ReadLe32(data)) |
+         static_cast<uint64_t>(ReadLe32(data + 4)) << 32;
+}
+
+static bool WriteAll(int fd, const uint8_t* data, size_t length) {
+  while (length > 0) {
+    ssize_t written = write(fd, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+
+    data += written;
+    length -= written;
+  }
+
+  return true;
+}
+
+// Indicates whether the |path| stays within the directory it's relative to.
+static bool IsContainedPath(const std::string& path) {
+  if (path.empty() || path[0] == '/') {
+    return false;
+  }
+
+  size_t start = 0;
+  while (start <= path.size()) {
+    size_t end = path.find('/', start);
+    if (end == std::string::npos) {
+      end = path.size();
+    }
+
+    if (path.compare(start, end - start, "..") == 0) {
+      return false;
+    }
+    start = end + 1;
+  }
+
+  return true;
+}
+
+// Sequential reader of the patch file, decompressing the control records
+// after the header is read.
+class PatchStream {
+ public:
+  explicit PatchStream(int fd) : fd_(fd), input_(kChunkSize) {}
+
+  ~PatchStream() {
+    if (zlib_initialized_) {
+      inflateEnd(&zlib_);
+    }
+#ifdef HAVE_ZSTD
+    ZSTD_freeDCtx(zstd_);
+#endif
+  }
+
+  PatchStream(const PatchStream&) = delete;
+  PatchStream& operator=(const PatchStream&) = delete;
+
+  // Switches to decompressing the rest of the file with the |compression|,
+  // returning false if it isn't supported.
+  bool SetCompression(uint32_t compression) {
+    switch (static_cast<PatchCompression>(compression)) {
+      case PatchCompression::kNone:
+        break;
+
+      case PatchCompression::kZlib:
+        memset(&zlib_, 0, sizeof(zlib_));
+        if (inflateInit(&zlib_) != Z_OK) {
+          return false;
+        }
+        zlib_initialized_ = true;
+        break;
+
+      case PatchCompression::kZstd:
+#ifdef HAVE_ZSTD
+        zstd_ = ZSTD_createDCtx();
+        if (zstd_ == nullptr) {
+          return false;
+        }
+        break;
+#else
+        return false;
+#endif
+
+      default:
+        return false;
+    }
+
+    compression_ = static_cast<PatchCompression>(compression);
+    return true;
+  }
+
+  // Reads exactly the |length| bytes into |data|, returning false if the
+  // file ends before or can't be read, which is reported by io_error().
+  bool Read(uint8_t* data, size_t length) {
+    switch (compression_) {
+      case PatchCompression::kNone:
+        return ReadRaw(data, length);
+      case PatchCompression::kZlib:
+        return Inflate(data, length);
+      case PatchCompression::kZstd:
+#ifdef HAVE_ZSTD
+        return DecompressZstd(data, length);
+#else
+        break;
+#endif
+    }
+    return false;
+  }
+
+  // Returns the `errno` of the failed read, or zero if the file is just
+  // truncated or malformed.
+  int io_error() const { return io_error_; }
+
+ private:
+  // Reads the next chunk of the file once the buffered one is consumed,
+  // returning false if there's nothing left.
+  bool Fill() {
+    if (position_ < end_) {
+      return true;
+    }
+
+    while (true) {
+      ssize_t bytes_read = read(fd_, input_.data(), input_.size());
+      if (bytes_read < 0 && errno == EINTR) {
+        continue;
+      }
+
+      if (bytes_read < 0) {
+        io_error_ = errno;
+      }
+
+      position_ = 0;
+      end_ = bytes_read > 0 ? bytes_read : 0;
+      return bytes_read > 0;
+    }
+  }
+
+  bool ReadRaw(uint8_t* data, size_t length) {
+    while (length > 0) {
+      if (!Fill()) {
+        return false;
+      }
+
+      size_t count = std::min(length, end_ - position_);
+      memcpy(data, input_.data() + position_, count);
+      position_ += count;
+      data += count;
+      length -= count;
+    }
+
+    return true;
+  }
+
+  bool Inflate(uint8_t* data, size_t length) {
+    zlib_.next_out = data;
+    zlib_.avail_out = length;
+    while (zlib_.avail_out > 0) {
+      if (!Fill()) {
+        return false;
+      }
+
+      zlib_.next_in = input_.data() + position_;
+      zlib_.avail_in = end_ - position_;
+      int status = inflate(&zlib_, Z_NO_FLUSH);
+      position_ = end_ - zlib_.avail_in;
+
+      if (status == Z_STREAM_END) {
+        return zlib_.avail_out == 0;
+      } else if (status != Z_OK && status != Z_BUF_ERROR) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+#ifdef HAVE_ZSTD
+  bool DecompressZstd(uint8_t* data, size_t length) {
+    ZSTD_outBuffer out = {data, length, 0};
+    while (out.pos < out.size) {
+      if (!Fill()) {
+        return false;
+      }
+
+      ZSTD_inBuffer in = {input_.data() + position_, end_ - position_, 0};
+      size_t status = ZSTD_decompressStream(zstd_, &out, &in);
+      position_ += in.pos;
+
+      if (ZSTD_isError(status)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+#endif
+
+  int fd_;
+  int io_error_ = 0;
+
+  std::vector<uint8_t> input_;
+  size_t position_ = 0;
+  size_t end_ = 0;
+
+  PatchCompression compression_ = PatchCompression::kNone;
+  z_stream zlib_;
+  bool zlib_initialized_ = false;
+#ifdef HAVE_ZSTD
+  ZSTD_DCtx* zstd_ = nullptr;
+#endif
+};
+
+// Source files of the patch mapped into memory as a single stream.
+class SourceStream {
+ public:
+  SourceStream() = default;
+
+  ~SourceStream() {
+    for (const File& file : files_) {
+      munmap(const_cast<uint8_t*>(file.data), file.size);
+    }
+  }
+
+  SourceStream(const SourceStream&) = delete;
+  SourceStream& operator=(const SourceStream&) = delete;
+
+  // Maps the file at |path| to the end of the stream, verifying it has the
+  // expected |size| and |digest|.
+  DeltaPatchResult Append(const std::string& path,
+                          int64_t size,
+                          const uint8_t digest[Sha256::kDigestSize],
+                          std::string* error) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      *error = path + ": " + strerror(errno);
+      return errno == ENOENT ? DeltaPatchResult::kSourceMismatch
+                             : DeltaPatchResult::kFileError;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size != size) {
+      close(fd);
+      *error = path + " differs in size";
+      return DeltaPatchResult::kSourceMismatch;
+    }
+
+    const uint8_t* data = nullptr;
+    if (size > 0) {
+      void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping == MAP_FAILED) {
+        *error = path + ": " + strerror(errno);
+        close(fd);
+        return DeltaPatchResult::kFileError;
+      }
+
+      // Hashed sequentially first, and then read around the patch positions.
+      madvise(mapping, size, MADV_SEQUENTIAL);
+      data = static_cast<uint8_t*>(mapping);
+      files_.push_back(File{data, size_, size});
+    }
+    close(fd);
+
+    Sha256 hasher;
+    hasher.Update(data, size);
+
+    uint8_t actual[Sha256::kDigestSize];
+    hasher.Finish(actual);
+    if (memcmp(actual, digest, Sha256::kDigestSize) != 0) {
+      *error = path + " differs in SHA-256";
+      return DeltaPatchResult::kSourceMismatch;
+    }
+
+    if (data != nullptr) {
+      madvise(const_cast<uint8_t*>(data), size, MADV_NORMAL);
+    }
+    size_ += size;
+
+    return DeltaPatchResult::kApplied;
+  }
+
+  // Adds the |length| bytes of the stream at the |position| to the |data|,
+  // leaving the bytes out of the stream as is, same as bspatch does.
+  void AddTo(int64_t position, uint8_t* data, size_t length) const {
+    if (position < 0) {
+      int64_t skipped = std::min<int64_t>(-position, length);
+      position += skipped;
+      data += skipped;
+      length -= skipped;
+    }
+
+    // Finds the file containing the |position|.
+    auto it = std::upper_bound(
+        files_.begin(), files_.end(), position,
+        [](int64_t value, const File& file) { return value < file.offset; });
+    if (it == files_.begin()) {
+      return;
+    }
+
+    for (--it; it != files_.end() && length > 0; ++it) {
+      int64_t offset = position - it->offset;
+      if (offset >= it->size) {
+        continue;
+      }
+
+      size_t count = std::min<int64_t>(length, it->size - offset);
+      const uint8_t* source = it->data + offset;
+      for (size_t i = 0; i < count; ++i) {
+        data[i] += source[i];
+      }
+
+      position += count;
+      data += count;
+      length -= count;
+    }
+  }
+
+ private:
+  struct File {
+    const uint8_t* data;
+
+    // Position of the file in the stream.
+    int64_t offset;
+    int64_t size;
+  };
+
+  std::vector<File> files_;
+  int64_t size_ = 0;
+};
+
+// Reads the header and the source list of the patch, mapping the sources.
+static DeltaPatchResult ReadHeader(PatchStream* stream,
+                                   const std::string& directory,
+                                   SourceStream* sources,
+                                   uint64_t* target_size,
+                                   uint8_t target_digest[Sha256::kDigestSize],
+                                   std::string* error) {
+  // Magic, compression, number of sources, target size and digest.
+  uint8_t header[sizeof(kMagic) + 4 + 4 + 8 + Sha256::kDigestSize];
+  if (!stream->Read(header, sizeof(header)) ||
+      memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+    *error = "Not a delta patch";
+    return DeltaPatchResult::kCorrupted;
+  }
+
+  const uint8_t* field = header + sizeof(kMagic);
+  uint32_t compression = ReadLe32(field);
+  uint32_t count = ReadLe32(field + 4);
+  *target_size = ReadLe64(field + 8);
+  memcpy(target_digest, field + 16, Sha256::kDigestSize);
+
+  if (count > kMaxSources || *target_size > INT64_MAX) {
+    *error = "Malformed patch header";
+    return DeltaPatchResult::kCorrupted;
+  }
+
+  for (uint32_t i = 0; i < count; ++i) {
+    uint8_t length[4];
+    if (!stream->Read(length, sizeof(length)) ||
+        ReadLe32(length) > kMaxPathLength) {
+      *error = "Malformed patch source";
+      return DeltaPatchResult::kCorrupted;
+    }
+
+    // Path, size and digest of the source.
+    std::vector<uint8_t> entry(ReadLe32(length) + 8 + Sha256::kDigestSize);
+    if (!stream->Read(entry.data(), entry.size())) {
+      *error = "Malformed patch source";
+      return DeltaPatchResult::kCorrupted;
+    }
+
+    size_t path_length = entry.size() - 8 - Sha256::kDigestSize;
+    std::string path(entry.begin(), entry.begin() + path_length);
+    uint64_t size = ReadLe64(entry.data() + path_length);
+    if (!IsContainedPath(path) || size > INT64_MAX) {
+      *error = "Malformed patch source";
+      return DeltaPatchResult::kCorrupted;
+    }
+
+    DeltaPatchResult result =
+        sources->Append(directory + "/" + path, size,
+                        entry.data() + path_length + 8, error);
+    if (result != DeltaPatchResult::kApplied) {
+      return result;
+    }
+  }
+
+  if (!stream->SetCompression(compression)) {
+    *error = "Unsupported patch compression";
+    return DeltaPatchResult::kCorrupted;
+  }
+
+  return DeltaPatchResult::kApplied;
+}
+
+// Applies the control records of the |stream| to the |sources|, writing the
+// |target_size| bytes of the target to the |fd| and the |hasher|.
+static DeltaPatchResult ApplyRecords(PatchStream* stream,
+                                     const SourceStream& sources,
+                                     uint64_t target_size,
+                                     int fd,
+                                     Sha256* hasher,
+                                     std::string* error) {
+  std::vector<uint8_t> buffer(kChunkSize);
+  size_t buffered = 0;
+
+  // Writes the |buffered| bytes out.
+  auto flush = [&]() {
+    hasher->Update(buffer.data(), buffered);
+    bool written = WriteAll(fd, buffer.data(), buffered);
+    buffered = 0;
+    return written;
+  };
+
+  uint64_t produced = 0;
+  int64_t position = 0;
+  while (produced < target_size) {
+    uint8_t control[24];
+    if (!stream->Read(control, sizeof(control))) {
+      break;
+    }
+
+    uint64_t diff = ReadLe64(control);
+    uint64_t extra = ReadLe64(control + 8);
+    int64_t seek = static_cast<int64_t>(ReadLe64(control + 16));
+
+    uint64_t left = target_size - produced;
+    if (diff > left || extra > left - diff) {
+      *error = "Patch exceeds the target size";
+      return DeltaPatchResult::kCorrupted;
+    }
+
+    for (int pass = 0; pass < 2; ++pass) {
+      uint64_t remaining = pass == 0 ? diff : extra;
+      while (remaining > 0) {
+        if (buffered == buffer.size() && !flush()) {
+          *error = strerror(errno);
+          return DeltaPatchResult::kFileError;
+        }
+
+        size_t count = std::min<uint64_t>(remaining, buffer.size() - buffered);
+        uint8_t* data = buffer.data() + buffered;
+        if (!stream->Read(data, count)) {
+          break;
+        }
+
+        if (pass == 0) {
+          sources.AddTo(position, data, count);
+          position += count;
+        }
+
+        buffered += count;
+        produced += count;
+        remaining -= count;
+      }
+
+      if (remaining > 0) {
+        break;
+      }
+    }
+
+    if (__builtin_add_overflow(position, seek, &position)) {
+      *error = "Patch seeks out of range";
+      return DeltaPatchResult::kCorrupted;
+    }
+  }
+
+  if (produced < target_size) {
+    if (stream->io_error() != 0) {
+      *error = strerror(stream->io_error());
+      return DeltaPatchResult::kFileError;
+    }
+
+    *error = "Patch is truncated";
+    return DeltaPatchResult::kCorrupted;
+  }
+
+  if (!flush()) {
+    *error = strerror(errno);
+    return DeltaPatchResult::kFileError;
+  }
+
+  return DeltaPatchResult::kApplied;
+}
+
+DeltaPatchResult ApplyDeltaPatch(const DeltaPatchOptions& options,
+                                 std::string* sha256,
+                                 std::string* error) {
+  int patch_fd = open(options.patch.c_str(), O_RDONLY | O_CLOEXEC);
+  if (patch_fd < 0) {
+    *error = options.patch + ": " + strerror(errno);
+    return DeltaPatchResult::kFileError;
+  }
+  posix_fadvise(patch_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  PatchStream stream(patch_fd);
+  SourceStream sources;
+  uint64_t target_size = 0;
+  uint8_t target_digest[Sha256::kDigestSize];
+  DeltaPatchResult result = ReadHeader(&stream, options.source, &sources,
+                                       &target_size, target_digest, error);
+  if (result != DeltaPatchResult::kApplied) {
+    close(patch_fd);
+    return result;
+  }
+
+  std::string part_path = options.target + ".part";
+  int fd = open(part_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC,
+                0644);
+  if (fd < 0) {
+    *error = part_path + ": " + strerror(errno);
+    close(patch_fd);
+    return DeltaPatchResult::kFileError;
+  }
+
+  Sha256 hasher;
+  result = ApplyRecords(&stream, sources, target_size, fd, &hasher, error);
+  close(patch_fd);
+
+  if (result == DeltaPatchResult::kApplied) {
+    *sha256 = hasher.FinishHex();
+
+    std::string expected = options.sha256;
+    std::transform(expected.begin(), expected.end(), expected.begin(),
+                   [](char c) { return tolower(c); });
+    if (*sha256 != Sha256Hex(target_digest) ||
+        (!expected.empty() && *sha256 != expected)) {
+      *error = "Patched file has unexpected SHA-256 " + *sha256;
+      result = DeltaPatchResult::kVerificationFailed;
+    }
+  }
+
+  if (result == DeltaPatchResult::kApplied &&
+      (fdatasync(fd) != 0 ||
+       rename(part_path.c_str(), options.target.c_str()) != 0)) {
+    *error = strerror(errno);
+    result = DeltaPatchResult::kFileError;
+  }
+  close(fd);
+
+  if (result != DeltaPatchResult::kApplied) {
+    unlink(part_path.c_str());
+  }
+
+  return result;
+}
@@ -0,0 +1,66 @@
+#ifndef RUNNER_DELTA_PATCH_H_
+#define RUNNER_DELTA_PATCH_H_
+
+#include <stdint.h>
+
+#include <string>
+
+// Outcome of ApplyDeltaPatch().
+enum class DeltaPatchResult {
+  kApplied,
+
+  // Patch is malformed, truncated or uses an unsupported compression.
+  kCorrupted,
+
+  // Source files differ from the ones the patch was made against.
+  kSourceMismatch,
+
+  // Patched file doesn't match the expected SHA-256 digest.
+  kVerificationFailed,
+
+  // Source, patch or target file can't be read or written.
+  kFileError,
+};
+
+struct DeltaPatchOptions {
+  // Directory the source paths listed in the patch are relative to, e.g. the
+  // installed application bundle.
+  std::string source;
+
+  // Path to the patch file.
+  std::string patch;
+
+  // Path to write the patched file to.
+  std::string target;
+
+  // Lowercase hex SHA-256 digest the patched file must have in addition to
+  // the one recorded in the patch, or empty to rely on the patch only.
+  std::string sha256;
+};
+
+// Reconstructs the |options.target| file from the source files and the
+// |options.patch|, returning kApplied once the result is verified.
+//
+// The patch starts with a header listing the target size and SHA-256 digest
+// along with the paths, sizes and SHA-256 digests of the source files, which
+// are treated as a single concatenated stream. It's followed by the bsdiff
+// style control records, optionally compressed with zlib or zstd:
+//
+//   u64 diff length, u64 extra length, i64 seek,
+//   diff bytes added to the source bytes at the current position,
+//   extra bytes copied as is,
+//
+// after which the position is advanced by the diff length and the seek.
+//
+// Source files are mapped and the patch is inflated in chunks, so neither of
+// them nor the target is held in memory whole. The target is written into a
+// `.part` file hashed along the way, which is renamed to the |options.target|
+// only if its digest matches, and removed otherwise.
+//
+// Writes the lowercase hex SHA-256 digest of the target to |sha256| and the
+// description of the failure to |error|.
+DeltaPatchResult ApplyDeltaPatch(const DeltaPatchOptions& options,
+                                 std::string* sha256,
+                                 std::string* error);
+
+#endif  // RUNNER_DELTA_PATCH_H_
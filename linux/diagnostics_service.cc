@@ -0,0 +1,164 @@
+#include "diagnostics_service.h"
+
+#include <string.h>
+
+#include "frame_monitor.h"
+#include "process_sampler.h"
+
+// Returns the integer |key| of the |args| map, or the |fallback|, if there is
+// none.
+static int64_t lookup_int(FlValue* args, const char* key, int64_t fallback) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return fallback;
+  }
+
+  FlValue* value = fl_value_lookup_string(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_INT) {
+    return fallback;
+  }
+
+  return fl_value_get_int(value);
+}
+
+static FlMethodResponse* start_sampling(FlValue* args) {
+  ProcessSamplerOptions options;
+  options.interval = lookup_int(args, "interval", options.interval);
+  options.capacity = lookup_int(args, "capacity", options.capacity);
+
+  FlValue* perf = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    perf = fl_value_lookup_string(args, "perf");
+  }
+  options.perf = perf != nullptr &&
+                 fl_value_get_type(perf) == FL_VALUE_TYPE_BOOL &&
+                 fl_value_get_bool(perf);
+
+  if (options.interval <= 0 || options.capacity <= 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`interval` and `capacity` must be positive",
+        nullptr));
+  }
+
+  // Responds whether the `perf_event_open(2)` counters are taken.
+  bool permitted = ProcessSampler::Shared()->Start(options);
+  g_autoptr(FlValue) result = fl_value_new_bool(options.perf && permitted);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* stop_sampling() {
+  ProcessSampler::Shared()->Stop();
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse* process_summary(FlValue* args) {
+  ProcessSummary summary =
+      ProcessSampler::Shared()->Summarize(lookup_int(args, "window", 0));
+
+  FlValue* threads = fl_value_new_list();
+  for (const ThreadSummary& thread : summary.threads) {
+    g_autoptr(FlValue) map = fl_value_new_map();
+    fl_value_set_string_take(map, "label",
+                             fl_value_new_string(thread.label.c_str()));
+    fl_value_set_string_take(map, "count", fl_value_new_int(thread.count));
+    fl_value_set_string_take(map, "cpu", fl_value_new_float(thread.cpu));
+    fl_value_set_string_take(map, "minorFaults",
+                             fl_value_new_int(thread.minor_faults));
+    fl_value_set_string_take(map, "majorFaults",
+                             fl_value_new_int(thread.major_faults));
+    fl_value_set_string_take(map, "readBytes",
+                             fl_value_new_int(thread.read_bytes));
+    fl_value_set_string_take(map, "writeBytes",
+                             fl_value_new_int(thread.write_bytes));
+    if (thread.cycles >= 0) {
+      fl_value_set_string_take(map, "cycles", fl_value_new_int(thread.cycles));
+    }
+    if (thread.instructions >= 0) {
+      fl_value_set_string_take(map, "instructions",
+                               fl_value_new_int(thread.instructions));
+    }
+    if (thread.context_switches >= 0) {
+      fl_value_set_string_take(map, "contextSwitches",
+                               fl_value_new_int(thread.context_switches));
+    }
+    fl_value_append(threads, map);
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "samples",
+                           fl_value_new_int(summary.samples));
+  fl_value_set_string_take(result, "duration",
+                           fl_value_new_int(summary.duration));
+  fl_value_set_string_take(result, "cpu", fl_value_new_float(summary.cpu));
+  fl_value_set_string_take(result, "rss", fl_value_new_int(summary.rss));
+  fl_value_set_string_take(result, "maxRss",
+                           fl_value_new_int(summary.max_rss));
+  fl_value_set_string_take(result, "fds", fl_value_new_int(summary.fds));
+  fl_value_set_string_take(result, "perf", fl_value_new_bool(summary.perf));
+  fl_value_set_string_take(result, "threads", threads);
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Returns the |summary| of a histogram as a map of its values.
+static FlValue* histogram_to_map(const HdrHistogramSummary& summary) {
+  FlValue* map = fl_value_new_map();
+  fl_value_set_string_take(map, "count", fl_value_new_int(summary.count));
+  fl_value_set_string_take(map, "min", fl_value_new_int(summary.min));
+  fl_value_set_string_take(map, "max", fl_value_new_int(summary.max));
+  fl_value_set_string_take(map, "mean", fl_value_new_float(summary.mean));
+  fl_value_set_string_take(map, "p50", fl_value_new_int(summary.p50));
+  fl_value_set_string_take(map, "p90", fl_value_new_int(summary.p90));
+  fl_value_set_string_take(map, "p99", fl_value_new_int(summary.p99));
+  fl_value_set_string_take(map, "p999", fl_value_new_int(summary.p999));
+  return map;
+}
+
+static FlMethodResponse* frame_timings() {
+  FrameTimings timings = FrameMonitor::Shared()->Timings();
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "frames", fl_value_new_int(timings.frames));
+  fl_value_set_string_take(result, "missedVsyncs",
+                           fl_value_new_int(timings.missed_vsyncs));
+  fl_value_set_string_take(result, "refreshInterval",
+                           fl_value_new_int(timings.refresh_interval));
+  fl_value_set_string_take(result, "intervals",
+                           histogram_to_map(timings.intervals));
+  fl_value_set_string_take(result, "paint", histogram_to_map(timings.paint));
+  fl_value_set_string_take(result, "latency",
+                           histogram_to_map(timings.latency));
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* reset_frame_timings() {
+  FrameMonitor::Shared()->Reset();
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+gboolean diagnostics_service_handle_method_call(FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "startSampling") == 0) {
+    response = start_sampling(args);
+  } else if (strcmp(method, "stopSampling") == 0) {
+    response = stop_sampling();
+  } else if (strcmp(method, "processSummary") == 0) {
+    response = process_summary(args);
+  } else if (strcmp(method, "frameTimings") == 0) {
+    response = frame_timings();
+  } else if (strcmp(method, "resetFrameTimings") == 0) {
+    response = reset_frame_timings();
+  } else {
+    return FALSE;
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send response: %s", error->message);
+  }
+
+  return TRUE;
+}
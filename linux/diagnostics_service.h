@@ -0,0 +1,19 @@
+#ifndef RUNNER_DIAGNOSTICS_SERVICE_H_
+#define RUNNER_DIAGNOSTICS_SERVICE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * diagnostics_service_handle_method_call:
+ * @method_call: #FlMethodCall received on the utils channel.
+ *
+ * Handles the `startSampling`, `stopSampling` and `processSummary` methods,
+ * controlling the #ProcessSampler and responding with the CPU time, RSS,
+ * storage I/O and file descriptors of the process and its threads, and the
+ * `frameTimings` and `resetFrameTimings` methods of the #FrameMonitor.
+ *
+ * Returns: %TRUE if the @method_call was handled by this service.
+ */
+gboolean diagnostics_service_handle_method_call(FlMethodCall* method_call);
+
+#endif  // RUNNER_DIAGNOSTICS_SERVICE_H_
@@ -0,0 +1,268 @@
+#include "download_service.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "segmented_download.h"
+
+// Download started by the `download` method.
+struct RunningDownload {
+  std::shared_ptr<SegmentedDownload> download;
+  std::thread thread;
+};
+
+// Progress of a download to report on the main thread.
+struct DownloadProgress {
+  int64_t id;
+  int64_t received;
+  int64_t total;
+};
+
+// Result of a download to respond with on the main thread.
+struct FinishedDownload {
+  int64_t id;
+  FlMethodCall* method_call;
+  FlMethodResponse* response;
+};
+
+static FlEventChannel* progress_channel = nullptr;
+static bool progress_listened = false;
+
+// Downloads by their IDs, accessed on the main thread only.
+static std::map<int64_t, RunningDownload> downloads;
+
+static FlMethodErrorResponse* on_progress_listen(FlEventChannel* channel,
+                                                 FlValue* args,
+                                                 gpointer user_data) {
+  progress_listened = true;
+  return nullptr;
+}
+
+static FlMethodErrorResponse* on_progress_cancel(FlEventChannel* channel,
+                                                 FlValue* args,
+                                                 gpointer user_data) {
+  progress_listened = false;
+  return nullptr;
+}
+
+static gboolean send_progress(gpointer user_data) {
+  std::unique_ptr<DownloadProgress> progress(
+      static_cast<DownloadProgress*>(user_data));
+  if (progress_channel == nullptr || !progress_listened) {
+    return G_SOURCE_REMOVE;
+  }
+
+  g_autoptr(FlValue) event = fl_value_new_map();
+  fl_value_set_string_take(event, "id", fl_value_new_int(progress->id));
+  fl_value_set_string_take(event, "received",
+                           fl_value_new_int(progress->received));
+  fl_value_set_string_take(event, "total", fl_value_new_int(progress->total));
+  fl_event_channel_send(progress_channel, event, nullptr, nullptr);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean finish_download(gpointer user_data) {
+  std::unique_ptr<FinishedDownload> finished(
+      static_cast<FinishedDownload*>(user_data));
+
+  // Downloads left after download_service_dispose() aren't responded to, as
+  // the engine is gone.
+  auto it = downloads.find(finished->id);
+  if (it != downloads.end()) {
+    it->second.thread.join();
+    downloads.erase(it);
+
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(finished->method_call, finished->response,
+                                &error)) {
+      g_warning("Failed to send response: %s", error->message);
+    }
+  }
+
+  g_object_unref(finished->method_call);
+  g_object_unref(finished->response);
+  return G_SOURCE_REMOVE;
+}
+
+static FlMethodResponse* result_to_response(
+    const SegmentedDownload& download,
+    DownloadResult result) {
+  const gchar* code;
+  switch (result) {
+    case DownloadResult::kCompleted: {
+      g_autoptr(FlValue) value = fl_value_new_map();
+      fl_value_set_string_take(value, "sha256",
+                               fl_value_new_string(download.sha256().c_str()));
+      fl_value_set_string_take(value, "size",
+                               fl_value_new_int(download.size()));
+      return FL_METHOD_RESPONSE(fl_method_success_response_new(value));
+    }
+
+    case DownloadResult::kCancelled:
+      code = "CANCELLED";
+      break;
+
+    case DownloadResult::kHttpError: {
+      g_autoptr(FlValue) status = fl_value_new_int(download.status());
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          "HTTP_ERROR", download.error().c_str(), status));
+    }
+
+    case DownloadResult::kNetworkError:
+      code = "NETWORK_ERROR";
+      break;
+
+    case DownloadResult::kFileError:
+    default:
+      code = "FILE_ERROR";
+      break;
+  }
+
+  return FL_METHOD_RESPONSE(
+      fl_method_error_response_new(code, download.error().c_str(), nullptr));
+}
+
+static FlMethodResponse* start_download(FlMethodCall* method_call,
+                                        FlValue* args) {
+  FlValue* id = nullptr;
+  FlValue* url = nullptr;
+  FlValue* path = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    id = fl_value_lookup_string(args, "id");
+    url = fl_value_lookup_string(args, "url");
+    path = fl_value_lookup_string(args, "path");
+  }
+
+  if (id == nullptr || fl_value_get_type(id) != FL_VALUE_TYPE_INT ||
+      url == nullptr || fl_value_get_type(url) != FL_VALUE_TYPE_STRING ||
+      path == nullptr || fl_value_get_type(path) != FL_VALUE_TYPE_STRING) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`id`, `url` and `path` must be provided", nullptr));
+  }
+
+  int64_t download_id = fl_value_get_int(id);
+  if (downloads.count(download_id) != 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "STATE_ERROR", "Download with this `id` is already running",
+        nullptr));
+  }
+
+  SegmentedDownload::Options options;
+  options.url = fl_value_get_string(url);
+  options.path = fl_value_get_string(path);
+
+  FlValue* connections = fl_value_lookup_string(args, "connections");
+  if (connections != nullptr &&
+      fl_value_get_type(connections) == FL_VALUE_TYPE_INT) {
+    options.connections = fl_value_get_int(connections);
+  }
+
+  FlValue* headers = fl_value_lookup_string(args, "headers");
+  if (headers != nullptr && fl_value_get_type(headers) == FL_VALUE_TYPE_MAP) {
+    for (size_t i = 0; i < fl_value_get_length(headers); ++i) {
+      FlValue* name = fl_value_get_map_key(headers, i);
+      FlValue* value = fl_value_get_map_value(headers, i);
+      if (fl_value_get_type(name) == FL_VALUE_TYPE_STRING &&
+          fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+        options.headers.push_back(std::string(fl_value_get_string(name)) +
+                                  ": " + fl_value_get_string(value));
+      }
+    }
+  }
+
+  std::shared_ptr<SegmentedDownload> download =
+      std::make_shared<SegmentedDownload>(std::move(options));
+  FlMethodCall* held = FL_METHOD_CALL(g_object_ref(method_call));
+
+  RunningDownload& running = downloads[download_id];
+  running.download = download;
+  running.thread = std::thread([download, download_id, held] {
+    pthread_setname_np(pthread_self(), "download");
+    DownloadResult result =
+        download->Run([download_id](int64_t received, int64_t total) {
+          g_main_context_invoke(
+              nullptr, send_progress,
+              new DownloadProgress{download_id, received, total});
+        });
+
+    g_main_context_invoke(
+        nullptr, finish_download,
+        new FinishedDownload{download_id, held,
+                             result_to_response(*download, result)});
+  });
+
+  return nullptr;
+}
+
+static FlMethodResponse* cancel_download(FlValue* args) {
+  FlValue* id = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    id = fl_value_lookup_string(args, "id");
+  }
+
+  if (id == nullptr || fl_value_get_type(id) != FL_VALUE_TYPE_INT) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`id` must be an integer", nullptr));
+  }
+
+  auto it = downloads.find(fl_value_get_int(id));
+  if (it != downloads.end()) {
+    it->second.download->Cancel();
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+void download_service_init(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  progress_channel = fl_event_channel_new(
+      messenger, "team113.flutter.dev/linux_utils/downloads",
+      FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(progress_channel, on_progress_listen,
+                                       on_progress_cancel, nullptr, nullptr);
+}
+
+gboolean download_service_handle_method_call(FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "download") == 0) {
+    response = start_download(method_call, args);
+  } else if (strcmp(method, "cancelDownload") == 0) {
+    response = cancel_download(args);
+  } else {
+    return FALSE;
+  }
+
+  // Errors and synchronous results are responded to right away.
+  if (response != nullptr) {
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(method_call, response, &error)) {
+      g_warning("Failed to send response: %s", error->message);
+    }
+  }
+
+  return TRUE;
+}
+
+void download_service_dispose() {
+  for (auto& entry : downloads) {
+    entry.second.download->Cancel();
+  }
+
+  for (auto& entry : downloads) {
+    entry.second.thread.join();
+  }
+  downloads.clear();
+
+  g_clear_object(&progress_channel);
+  progress_listened = false;
+}
@@ -0,0 +1,36 @@
+#ifndef RUNNER_DOWNLOAD_SERVICE_H_
+#define RUNNER_DOWNLOAD_SERVICE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * download_service_init:
+ * @messenger: #FlBinaryMessenger to create the progress event channel on.
+ *
+ * Creates the `team113.flutter.dev/linux_utils/downloads` event channel
+ * reporting the `{id, received, total}` progress of the running downloads.
+ */
+void download_service_init(FlBinaryMessenger* messenger);
+
+/**
+ * download_service_handle_method_call:
+ * @method_call: #FlMethodCall received on the utils channel.
+ *
+ * Handles the `download` method, downloading the file over several HTTP
+ * Range connections with a #SegmentedDownload on its own thread, and
+ * responding with its `{sha256, size}` once it's completed, and the
+ * `cancelDownload` method stopping it, keeping it to be resumed.
+ *
+ * Returns: %TRUE if the @method_call was handled by this service.
+ */
+gboolean download_service_handle_method_call(FlMethodCall* method_call);
+
+/**
+ * download_service_dispose:
+ *
+ * Cancels the running downloads, waiting for their threads to finish, and
+ * closes the progress event channel.
+ */
+void download_service_dispose();
+
+#endif  // RUNNER_DOWNLOAD_SERVICE_H_
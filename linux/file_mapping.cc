@@ -0,0 +1,75 @@
+#include "file_mapping.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Mapping created by messenger_map_file().
+struct FileMapping {
+  void* address;
+  size_t length;
+};
+
+uint8_t* messenger_map_file(const char* path,
+                            int32_t advice,
+                            int64_t* length,
+                            void** token) {
+  *length = 0;
+  *token = nullptr;
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int error = errno;
+    close(fd);
+    errno = error;
+    return nullptr;
+  }
+
+  // Empty files can't be mapped.
+  if (st.st_size == 0) {
+    close(fd);
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  // Private writable mapping, as Dart may write into the `Uint8List`, which
+  // then only copies the written pages without touching the file.
+  void* address = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, fd, 0);
+  int error = errno;
+
+  // The mapping keeps the file referenced.
+  close(fd);
+  if (address == MAP_FAILED) {
+    errno = error;
+    return nullptr;
+  }
+
+  switch (advice) {
+    case FILE_MAPPING_ADVICE_SEQUENTIAL:
+      madvise(address, st.st_size, MADV_SEQUENTIAL);
+      break;
+    case FILE_MAPPING_ADVICE_WILL_NEED:
+      madvise(address, st.st_size, MADV_WILLNEED);
+      break;
+  }
+
+  *length = st.st_size;
+  *token = new FileMapping{address, static_cast<size_t>(st.st_size)};
+  return static_cast<uint8_t*>(address);
+}
+
+void messenger_unmap_file(void* token) {
+  FileMapping* mapping = static_cast<FileMapping*>(token);
+  if (mapping != nullptr) {
+    munmap(mapping->address, mapping->length);
+    delete mapping;
+  }
+}
@@ -0,0 +1,48 @@
+#ifndef RUNNER_FILE_MAPPING_H_
+#define RUNNER_FILE_MAPPING_H_
+
+#include <stdint.h>
+
+#include "runner_export.h"
+
+// How the mapped file is going to be read, passed to `madvise(2)`.
+enum FileMappingAdvice {
+  FILE_MAPPING_ADVICE_NORMAL = 0,
+  FILE_MAPPING_ADVICE_SEQUENTIAL = 1,
+  FILE_MAPPING_ADVICE_WILL_NEED = 2,
+};
+
+/**
+ * messenger_map_file:
+ * @path: path of the file to map.
+ * @advice: #FileMappingAdvice describing how the file is going to be read.
+ * @length: (out): length of the mapped file in bytes.
+ * @token: (out): token to pass to messenger_unmap_file() once the mapping
+ *     isn't needed anymore.
+ *
+ * Maps the file at @path into memory privately, so writes to the mapping are
+ * never written back to the file.
+ *
+ * The file must not be truncated while it's mapped, as reading the pages past
+ * its new end raises `SIGBUS`, yet it may be unlinked. Cached files are only
+ * ever removed with RemoveCacheFile() for that reason.
+ *
+ * Returns: address of the mapping, or `nullptr` with `errno` set if the file
+ * can't be mapped or is empty.
+ */
+RUNNER_EXPORT uint8_t* messenger_map_file(const char* path,
+                                          int32_t advice,
+                                          int64_t* length,
+                                          void** token);
+
+/**
+ * messenger_unmap_file:
+ * @token: token returned by messenger_map_file().
+ *
+ * Unmaps the file mapped by messenger_map_file(). Matches the signature of a
+ * Dart `NativeFinalizerFunction`, so it may be attached to the external
+ * `Uint8List` viewing the mapping.
+ */
+RUNNER_EXPORT void messenger_unmap_file(void* token);
+
+#endif  // RUNNER_FILE_MAPPING_H_
@@ -0,0 +1,127 @@
+#include "frame_monitor.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+// Interval between the frames considered to be the clock being idle rather
+// than janky, in microseconds.
+static const int64_t kIdleInterval = 250000;
+
+// Refresh interval assumed, if the clock doesn't know it, in microseconds.
+static const int64_t kDefaultRefreshInterval = 16667;
+
+FrameMonitor* FrameMonitor::Shared() {
+  // Intentionally leaked, as the clock may still be painting on exit.
+  static FrameMonitor* monitor = new FrameMonitor();
+  return monitor;
+}
+
+void FrameMonitor::Attach(GtkWidget* widget) {
+  g_signal_connect(widget, "realize", G_CALLBACK(RealizeCb), this);
+  if (gtk_widget_get_realized(widget)) {
+    RealizeCb(widget, this);
+  }
+}
+
+FrameTimings FrameMonitor::Timings() const {
+  FrameTimings timings;
+  timings.frames = frames_.load(std::memory_order_relaxed);
+  timings.missed_vsyncs = missed_vsyncs_.load(std::memory_order_relaxed);
+  timings.refresh_interval = refresh_interval_.load(std::memory_order_relaxed);
+  timings.intervals = intervals_.Summarize();
+  timings.paint = paint_.Summarize();
+  timings.latency = latency_.Summarize();
+  return timings;
+}
+
+void FrameMonitor::Reset() {
+  intervals_.Reset();
+  paint_.Reset();
+  latency_.Reset();
+  frames_.store(0, std::memory_order_relaxed);
+  missed_vsyncs_.store(0, std::memory_order_relaxed);
+
+  // The frame painted next starts a new interval, while the ones painted
+  // already are not presented.
+  last_frame_time_ = 0;
+  if (clock_ != nullptr) {
+    last_completed_ = gdk_frame_clock_get_frame_counter(clock_);
+  }
+}
+
+void FrameMonitor::RealizeCb(GtkWidget* widget, gpointer user_data) {
+  FrameMonitor* self = static_cast<FrameMonitor*>(user_data);
+
+  // Widgets of the same window share its clock, and its handler is dropped
+  // along with it, so the destroyed one is only compared with here.
+  GdkFrameClock* clock = gtk_widget_get_frame_clock(widget);
+  if (clock == nullptr || clock == self->clock_) {
+    return;
+  }
+
+  self->clock_ = clock;
+  self->last_frame_time_ = 0;
+  self->last_completed_ = gdk_frame_clock_get_frame_counter(clock);
+  g_signal_connect(clock, "after-paint", G_CALLBACK(AfterPaintCb), self);
+}
+
+void FrameMonitor::AfterPaintCb(GdkFrameClock* clock, gpointer user_data) {
+  FrameMonitor* self = static_cast<FrameMonitor*>(user_data);
+
+  int64_t frame_time = gdk_frame_clock_get_frame_time(clock);
+  int64_t refresh_interval = 0;
+  gdk_frame_clock_get_refresh_info(clock, frame_time, &refresh_interval,
+                                   nullptr);
+  if (refresh_interval <= 0) {
+    refresh_interval = kDefaultRefreshInterval;
+  }
+
+  self->frames_.fetch_add(1, std::memory_order_relaxed);
+  self->refresh_interval_.store(refresh_interval, std::memory_order_relaxed);
+  self->paint_.Record(g_get_monotonic_time() - frame_time);
+
+  int64_t interval = frame_time - self->last_frame_time_;
+  if (self->last_frame_time_ != 0 && interval > 0 &&
+      interval <= kIdleInterval) {
+    self->intervals_.Record(interval);
+
+    // Frame times are aligned to the refreshes, so the interval is a whole
+    // number of them, give or take the clock's jitter.
+    int64_t missed = llround(static_cast<double>(interval) / refresh_interval);
+    if (missed > 1) {
+      self->missed_vsyncs_.fetch_add(missed - 1, std::memory_order_relaxed);
+    }
+  }
+  self->last_frame_time_ = frame_time;
+
+  self->RecordCompleted(clock);
+}
+
+void FrameMonitor::RecordCompleted(GdkFrameClock* clock) {
+  // Only the frames still kept in the history of the clock are known.
+  int64_t counter = std::max(last_completed_ + 1,
+                             gdk_frame_clock_get_history_start(clock));
+  int64_t current = gdk_frame_clock_get_frame_counter(clock);
+
+  for (; counter <= current; ++counter) {
+    GdkFrameTimings* timings = gdk_frame_clock_get_timings(clock, counter);
+    if (timings == nullptr) {
+      last_completed_ = counter;
+      continue;
+    }
+
+    // Presentation is reported by the compositor a few frames later.
+    if (!gdk_frame_timings_get_complete(timings)) {
+      break;
+    }
+
+    int64_t presented = gdk_frame_timings_get_presentation_time(timings);
+    int64_t started = gdk_frame_timings_get_frame_time(timings);
+    if (presented != 0 && presented >= started) {
+      latency_.Record(presented - started);
+    }
+
+    last_completed_ = counter;
+  }
+}
@@ -0,0 +1,86 @@
+#ifndef RUNNER_FRAME_MONITOR_H_
+#define RUNNER_FRAME_MONITOR_H_
+
+#include <gtk/gtk.h>
+
+#include <atomic>
+
+#include "hdr_histogram.h"
+
+// Frame pacing of the window since the last FrameMonitor::Reset().
+struct FrameTimings {
+  // Number of the frames painted.
+  int64_t frames = 0;
+
+  // Number of the vertical refreshes passed without a frame being painted,
+  // while the frames were painted continuously.
+  int64_t missed_vsyncs = 0;
+
+  // Refresh interval of the monitor as of the last frame, in microseconds.
+  int64_t refresh_interval = 0;
+
+  // Intervals between the continuously painted frames, in microseconds.
+  HdrHistogramSummary intervals;
+
+  // Time from the start of a frame till it's painted, in microseconds.
+  HdrHistogramSummary paint;
+
+  // Time from the start of a frame till it's presented on the monitor, in
+  // microseconds, if reported by the compositor.
+  HdrHistogramSummary latency;
+};
+
+// Records the frame pacing of a window by its #GdkFrameClock into the
+// HdrHistograms.
+//
+// Flutter engine presents its frames by queueing a redraw of the #FlView, so
+// the frames painted by the clock are the ones presented by the engine, while
+// the clock is idle, if the engine presents none. Intervals longer than a
+// quarter of a second are considered to be idle, not janky, so the periodic
+// frames, like the ones of a blinking cursor, are not counted.
+class FrameMonitor {
+ public:
+  // Returns the FrameMonitor of the application's window.
+  static FrameMonitor* Shared();
+
+  FrameMonitor(const FrameMonitor&) = delete;
+  FrameMonitor& operator=(const FrameMonitor&) = delete;
+
+  // Starts recording the frames of the toplevel window of the |widget|, once
+  // it's realized.
+  void Attach(GtkWidget* widget);
+
+  // Returns the FrameTimings recorded since the last Reset().
+  FrameTimings Timings() const;
+
+  // Forgets all the frames recorded.
+  void Reset();
+
+ private:
+  FrameMonitor() = default;
+
+  // Connects to the #GdkFrameClock of the realized |widget|.
+  static void RealizeCb(GtkWidget* widget, gpointer user_data);
+
+  // Records the frame just painted by the |clock|.
+  static void AfterPaintCb(GdkFrameClock* clock, gpointer user_data);
+
+  // Records the presentation times of the frames completed since the last
+  // ones recorded.
+  void RecordCompleted(GdkFrameClock* clock);
+
+  HdrHistogram intervals_;
+  HdrHistogram paint_;
+  HdrHistogram latency_;
+
+  std::atomic<int64_t> frames_{0};
+  std::atomic<int64_t> missed_vsyncs_{0};
+  std::atomic<int64_t> refresh_interval_{0};
+
+  // Accessed on the main thread only.
+  GdkFrameClock* clock_ = nullptr;
+  int64_t last_frame_time_ = 0;
+  int64_t last_completed_ = -1;
+};
+
+#endif  // RUNNER_FRAME_MONITOR_H_
@@ -0,0 +1,218 @@
+#include "hash_service.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "async_response.h"
+#include "sha256.h"
+#include "worker_pool.h"
+
+// Files up to this size are read whole and hashed in batches by the
+// multi-buffer kernel, while the larger ones are streamed one by one.
+static const off_t kBatchFileSize = 1024 * 1024;
+
+// Size of the chunks the large files are read in.
+static const size_t kReadChunkSize = 1024 * 1024;
+
+// Hashing of the files from a single `sha256Files` call, possibly split
+// across several WorkerPool tasks.
+struct FilesJob {
+  FlMethodCall* method_call;
+  std::vector<std::string> paths;
+
+  // Digests of the |paths|, or empty strings for the failed ones.
+  std::vector<std::string> digests;
+
+  // Number of the tasks still running.
+  std::atomic<int> pending{0};
+};
+
+static bool read_all(int fd, uint8_t* data, size_t length) {
+  while (length > 0) {
+    ssize_t bytes_read = read(fd, data, length);
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes_read <= 0) {
+      return false;
+    }
+
+    data += bytes_read;
+    length -= bytes_read;
+  }
+
+  return true;
+}
+
+// Streams the file at |path| through a Sha256, returning its digest, or an
+// empty string on failure.
+static std::string hash_file(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return std::string();
+  }
+
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  Sha256 hasher;
+  std::vector<uint8_t> buffer(kReadChunkSize);
+  bool succeeded = true;
+  while (true) {
+    ssize_t bytes_read = read(fd, buffer.data(), buffer.size());
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes_read <= 0) {
+      succeeded = bytes_read == 0;
+      break;
+    }
+
+    hasher.Update(buffer.data(), bytes_read);
+  }
+  close(fd);
+
+  return succeeded ? hasher.FinishHex() : std::string();
+}
+
+static void finish_files_job(const std::shared_ptr<FilesJob>& job) {
+  if (--job->pending > 0) {
+    return;
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_list();
+  for (const std::string& digest : job->digests) {
+    fl_value_append_take(result, digest.empty()
+                                     ? fl_value_new_null()
+                                     : fl_value_new_string(digest.c_str()));
+  }
+
+  method_call_respond_async(
+      job->method_call,
+      FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+}
+
+// Reads the small files at |indices| of the |job| whole and hashes them with
+// a single Sha256Batch() call.
+static void hash_small_files(const std::shared_ptr<FilesJob>& job,
+                             const std::vector<size_t>& indices) {
+  std::vector<std::vector<uint8_t>> contents;
+  std::vector<size_t> read;
+  for (size_t index : indices) {
+    int fd = open(job->paths[index].c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+
+    struct stat st;
+    std::vector<uint8_t> content;
+    bool succeeded = fstat(fd, &st) == 0;
+    if (succeeded) {
+      content.resize(st.st_size);
+      succeeded = read_all(fd, content.data(), content.size());
+    }
+    close(fd);
+
+    if (succeeded) {
+      contents.push_back(std::move(content));
+      read.push_back(index);
+    }
+  }
+
+  std::vector<Sha256Message> messages;
+  for (const std::vector<uint8_t>& content : contents) {
+    messages.push_back(Sha256Message{content.data(), content.size()});
+  }
+
+  std::vector<std::string> digests = Sha256Batch(messages);
+  for (size_t i = 0; i < read.size(); ++i) {
+    job->digests[read[i]] = std::move(digests[i]);
+  }
+}
+
+static FlMethodResponse* hash_files(FlMethodCall* method_call, FlValue* args) {
+  FlValue* paths = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    paths = fl_value_lookup_string(args, "paths");
+  }
+
+  if (paths == nullptr || fl_value_get_type(paths) != FL_VALUE_TYPE_LIST) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`paths` must be a list of strings", nullptr));
+  }
+
+  std::shared_ptr<FilesJob> job = std::make_shared<FilesJob>();
+  for (size_t i = 0; i < fl_value_get_length(paths); ++i) {
+    FlValue* path = fl_value_get_list_value(paths, i);
+    job->paths.push_back(fl_value_get_type(path) == FL_VALUE_TYPE_STRING
+                             ? fl_value_get_string(path)
+                             : "");
+  }
+  job->digests.resize(job->paths.size());
+  job->method_call = FL_METHOD_CALL(g_object_ref(method_call));
+
+  // Split the files into the small ones hashed in a batch and the large ones
+  // streamed each in its own task.
+  std::vector<size_t> small;
+  std::vector<size_t> large;
+  for (size_t i = 0; i < job->paths.size(); ++i) {
+    struct stat st;
+    if (job->paths[i].empty() || stat(job->paths[i].c_str(), &st) != 0) {
+      continue;
+    }
+
+    (st.st_size <= kBatchFileSize ? small : large).push_back(i);
+  }
+
+  // Holds the job until all the tasks are posted.
+  job->pending = 1 + large.size() + (small.empty() ? 0 : 1);
+
+  WorkerPool* pool = WorkerPool::Shared();
+  if (!small.empty()) {
+    pool->Post([job, small] {
+      hash_small_files(job, small);
+      finish_files_job(job);
+    });
+  }
+
+  for (size_t index : large) {
+    pool->Post([job, index] {
+      job->digests[index] = hash_file(job->paths[index]);
+      finish_files_job(job);
+    });
+  }
+
+  finish_files_job(job);
+  return nullptr;
+}
+
+gboolean hash_service_handle_method_call(FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "sha256Files") == 0) {
+    response = hash_files(method_call, args);
+  } else {
+    return FALSE;
+  }
+
+  // Errors are responded to synchronously.
+  if (response != nullptr) {
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(method_call, response, &error)) {
+      g_warning("Failed to send response: %s", error->message);
+    }
+  }
+
+  return TRUE;
+}
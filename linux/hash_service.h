@@ -0,0 +1,19 @@
+#ifndef RUNNER_HASH_SERVICE_H_
+#define RUNNER_HASH_SERVICE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * hash_service_handle_method_call:
+ * @method_call: #FlMethodCall received on the utils channel.
+ *
+ * Handles the `sha256Files` method, hashing the provided files on the
+ * #WorkerPool and responding with their lowercase hex SHA-256 digests
+ * asynchronously. Bytes are hashed over the bulk_channel_init() channel
+ * instead.
+ *
+ * Returns: %TRUE if the @method_call was handled by this service.
+ */
+gboolean hash_service_handle_method_call(FlMethodCall* method_call);
+
+#endif  // RUNNER_HASH_SERVICE_H_
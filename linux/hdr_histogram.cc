@@ -0,0 +1,130 @@
+#include "hdr_histogram.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+// Returns the index of the bucket of the |counts|, which the |percentile| of
+// the |total| values are counted in or before.
+static size_t BucketAtPercentile(const std::vector<int64_t>& counts,
+                                 int64_t total,
+                                 double percentile) {
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  int64_t target = std::max<int64_t>(
+      1, static_cast<int64_t>(ceil(percentile / 100 * total)));
+
+  int64_t seen = 0;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    seen += counts[i];
+    if (seen >= target) {
+      return i;
+    }
+  }
+
+  return counts.size() - 1;
+}
+
+HdrHistogram::HdrHistogram() {
+  Reset();
+}
+
+void HdrHistogram::Record(int64_t value) {
+  value = std::min(std::max<int64_t>(value, 0), kMaxValue);
+
+  counts_[IndexOf(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+
+  int64_t min = min_.load(std::memory_order_relaxed);
+  while (value < min &&
+         !min_.compare_exchange_weak(min, value, std::memory_order_relaxed)) {
+  }
+
+  int64_t max = max_.load(std::memory_order_relaxed);
+  while (value > max &&
+         !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+void HdrHistogram::Reset() {
+  for (std::atomic<int64_t>& count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  min_.store(kMaxValue, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+HdrHistogramSummary HdrHistogram::Summarize() const {
+  HdrHistogramSummary summary;
+
+  // Percentiles are taken from a copy, so they are consistent with each other
+  // and the |count| even when recorded concurrently.
+  std::vector<int64_t> counts(kBucketCount);
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    counts[i] = counts_[i].load(std::memory_order_relaxed);
+    summary.count += counts[i];
+  }
+
+  if (summary.count == 0) {
+    return summary;
+  }
+
+  summary.min = min_.load(std::memory_order_relaxed);
+  summary.max = max_.load(std::memory_order_relaxed);
+  summary.mean = static_cast<double>(sum_.load(std::memory_order_relaxed)) /
+                 std::max<int64_t>(count_.load(std::memory_order_relaxed), 1);
+
+  auto at = [&](double percentile) {
+    size_t index = BucketAtPercentile(counts, summary.count, percentile);
+    return std::min(std::max(HighestOf(index), summary.min), summary.max);
+  };
+  summary.p50 = at(50);
+  summary.p90 = at(90);
+  summary.p99 = at(99);
+  summary.p999 = at(99.9);
+
+  return summary;
+}
+
+int64_t HdrHistogram::ValueAtPercentile(double percentile) const {
+  std::vector<int64_t> counts(kBucketCount);
+  int64_t total = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    counts[i] = counts_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+
+  if (total == 0) {
+    return 0;
+  }
+
+  size_t index = BucketAtPercentile(counts, total, percentile);
+  return std::min(HighestOf(index), max_.load(std::memory_order_relaxed));
+}
+
+size_t HdrHistogram::IndexOf(int64_t value) {
+  // Values below the |kSubBucketCount| are counted each in its own bucket,
+  // while the greater ones are shifted to fit the upper half of it.
+  int magnitude = 63 - __builtin_clzll(value | (kSubBucketCount - 1));
+  int shift = magnitude - (kSubBucketBits - 1);
+  return shift * kSubBucketHalf + (value >> shift);
+}
+
+int64_t HdrHistogram::LowestOf(size_t index) {
+  if (index < static_cast<size_t>(kSubBucketCount)) {
+    return index;
+  }
+
+  int shift = index / kSubBucketHalf - 1;
+  return static_cast<int64_t>(index - shift * kSubBucketHalf) << shift;
+}
+
+int64_t HdrHistogram::HighestOf(size_t index) {
+  int shift = index < static_cast<size_t>(kSubBucketCount)
+                  ? 0
+                  : index / kSubBucketHalf - 1;
+  return LowestOf(index) + (int64_t{1} << shift) - 1;
+}
@@ -0,0 +1,82 @@
+#ifndef RUNNER_HDR_HISTOGRAM_H_
+#define RUNNER_HDR_HISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+// Statistics of the values recorded into a HdrHistogram.
+struct HdrHistogramSummary {
+  int64_t count = 0;
+  int64_t min = 0;
+  int64_t max = 0;
+  double mean = 0;
+
+  // Values at the 50th, 90th, 99th and 99.9th percentiles.
+  int64_t p50 = 0;
+  int64_t p90 = 0;
+  int64_t p99 = 0;
+  int64_t p999 = 0;
+};
+
+// High dynamic range histogram of the non-negative values up to |kMaxValue|,
+// recorded with the relative error below 1%.
+//
+// Values are counted in the log-linear buckets: the first 256 of the width of
+// one, followed by the groups of 128 buckets each twice as wide as the
+// previous group's ones, as in the HdrHistogram by Gil Tene.
+//
+// Recording is lock-free, so the histogram may be recorded and summarized on
+// different threads, while the summary may slightly lag behind the values
+// being recorded concurrently.
+class HdrHistogram {
+ public:
+  // Greatest value recorded, the greater ones being clamped to it, which is
+  // over a minute, when recording microseconds.
+  static const int64_t kMaxValue = (int64_t{1} << 26) - 1;
+
+  HdrHistogram();
+
+  HdrHistogram(const HdrHistogram&) = delete;
+  HdrHistogram& operator=(const HdrHistogram&) = delete;
+
+  // Records the |value|, clamping it to the [0, |kMaxValue|] range.
+  void Record(int64_t value);
+
+  // Forgets all the values recorded.
+  void Reset();
+
+  // Returns the HdrHistogramSummary of the values recorded.
+  HdrHistogramSummary Summarize() const;
+
+  // Returns the value, which the |percentile| of the values recorded are less
+  // than or equal to, within the precision of the histogram.
+  int64_t ValueAtPercentile(double percentile) const;
+
+ private:
+  // Bits of the values distinguished within each group of buckets.
+  static const int kSubBucketBits = 8;
+  static const int64_t kSubBucketCount = int64_t{1} << kSubBucketBits;
+  static const int64_t kSubBucketHalf = kSubBucketCount / 2;
+
+  // Number of the buckets covering the 26 bits of the values up to the
+  // |kMaxValue|.
+  static const size_t kBucketCount =
+      (26 - kSubBucketBits + 1) * kSubBucketHalf + kSubBucketHalf;
+
+  // Returns the index of the bucket the |value| is counted in.
+  static size_t IndexOf(int64_t value);
+
+  // Returns the lowest and the highest value counted in the bucket |index|.
+  static int64_t LowestOf(size_t index);
+  static int64_t HighestOf(size_t index);
+
+  std::atomic<int64_t> counts_[kBucketCount];
+  std::atomic<int64_t> count_;
+  std::atomic<int64_t> sum_;
+  std::atomic<int64_t> min_;
+  std::atomic<int64_t> max_;
+};
+
+#endif  // RUNNER_HDR_HISTOGRAM_H_
@@ -0,0 +1,564 @@
+#include "image_pipeline.h"
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// jpeglib.h relies on stdio.h being included before it.
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <jpeglib.h>
+#include <png.h>
+
+#include <algorithm>
+#include <numeric>
+
+// Maximum number of pixels of a decoded image, so a malicious one can't
+// exhaust the memory.
+static const uint64_t kMaxPixels = 128 * 1024 * 1024;
+
+// EXIF tag of the image orientation.
+static const uint16_t kOrientationTag = 0x0112;
+
+enum class ImageFormat { kJpeg, kPng, kOther };
+
+// Image decoded for downscaling.
+struct DecodedImage {
+  RgbaImage image;
+
+  // Dimensions of the original image, which the |image| may be decoded
+  // smaller than.
+  int width = 0;
+  int height = 0;
+
+  // EXIF orientation from 1 to 8.
+  int orientation = 1;
+
+  bool has_alpha = false;
+};
+
+static ImageFormat SniffFormat(const std::string& path) {
+  uint8_t magic[8] = {};
+  FILE* file = fopen(path.c_str(), "rbe");
+  if (file == nullptr) {
+    return ImageFormat::kOther;
+  }
+
+  size_t length = fread(magic, 1, sizeof(magic), file);
+  fclose(file);
+
+  static const uint8_t kPngMagic[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a,
+                                      '\n'};
+  if (length >= 3 && magic[0] == 0xff && magic[1] == 0xd8 &&
+      magic[2] == 0xff) {
+    return ImageFormat::kJpeg;
+  } else if (length == sizeof(kPngMagic) &&
+             memcmp(magic, kPngMagic, sizeof(kPngMagic)) == 0) {
+    return ImageFormat::kPng;
+  }
+
+  return ImageFormat::kOther;
+}
+
+static bool IsTooLarge(uint64_t width, uint64_t height) {
+  return width == 0 || height == 0 || width * height > kMaxPixels;
+}
+
+// Returns the orientation stored in the |exif| APP1 segment, or 1 if there's
+// none.
+static int ParseExifOrientation(const uint8_t* exif, size_t length) {
+  static const uint8_t kExifHeader[] = {'E', 'x', 'i', 'f', 0, 0};
+  if (length < sizeof(kExifHeader) + 8 ||
+      memcmp(exif, kExifHeader, sizeof(kExifHeader)) != 0) {
+    return 1;
+  }
+
+  const uint8_t* tiff = exif + sizeof(kExifHeader);
+  length -= sizeof(kExifHeader);
+
+  bool little_endian;
+  if (tiff[0] == 'I' && tiff[1] == 'I') {
+    little_endian = true;
+  } else if (tiff[0] == 'M' && tiff[1] == 'M') {
+    little_endian = false;
+  } else {
+    return 1;
+  }
+
+  auto read16 = [&](size_t offset) -> uint32_t {
+    return little_endian ? tiff[offset] | tiff[offset + 1] << 8
+                         : tiff[offset] << 8 | tiff[offset + 1];
+  };
+  auto read32 = [&](size_t offset) -> uint32_t {
+    return little_endian ? read16(offset) | read16(offset + 2) << 16
+                         : read16(offset) << 16 | read16(offset + 2);
+  };
+
+  // Only the first IFD is looked at, as it's where the orientation is.
+  size_t ifd = read32(4);
+  if (ifd > length - 2) {
+    return 1;
+  }
+
+  uint32_t count = read16(ifd);
+  for (uint32_t i = 0; i < count; ++i) {
+    size_t entry = ifd + 2 + i * 12;
+    if (entry + 12 > length) {
+      break;
+    }
+
+    if (read16(entry) == kOrientationTag) {
+      uint32_t orientation = read16(entry + 8);
+      return orientation >= 1 && orientation <= 8 ? orientation : 1;
+    }
+  }
+
+  return 1;
+}
+
+// libjpeg error manager jumping back out of the failed call.
+struct JpegError {
+  jpeg_error_mgr manager;
+  jmp_buf jump;
+};
+
+static void OnJpegError(j_common_ptr info) {
+  longjmp(reinterpret_cast<JpegError*>(info->err)->jump, 1);
+}
+
+// Silences the warnings of libjpeg, as the corrupt data is reported through
+// OnJpegError() anyway.
+static void OnJpegMessage(j_common_ptr info) {}
+
+// Returns the largest denominator the JPEG of the |width| x |height| can be
+// scaled down by while decoding, keeping it at least |size| pixels large.
+static int JpegScaleDenominator(int width, int height, int size) {
+  int edge = std::max(width, height);
+  int denominator = 8;
+  while (denominator > 1 &&
+         (edge + denominator - 1) / denominator < size) {
+    denominator /= 2;
+  }
+
+  return denominator;
+}
+
+// Decodes the JPEG from the |file| scaled down as much as fitting the
+// previews of the |size| allows.
+//
+// Nothing with a destructor may live in this function, as the errors
+// longjmp() out of the libjpeg calls.
+static bool DecodeJpeg(FILE* file, int size, DecodedImage* decoded) {
+  jpeg_decompress_struct info;
+  JpegError error;
+  info.err = jpeg_std_error(&error.manager);
+  error.manager.error_exit = OnJpegError;
+  error.manager.output_message = OnJpegMessage;
+
+  if (setjmp(error.jump)) {
+    jpeg_destroy_decompress(&info);
+    return false;
+  }
+
+  jpeg_create_decompress(&info);
+  jpeg_stdio_src(&info, file);
+  jpeg_save_markers(&info, JPEG_APP0 + 1, 0xffff);
+  jpeg_read_header(&info, TRUE);
+
+  if (IsTooLarge(info.image_width, info.image_height)) {
+    jpeg_destroy_decompress(&info);
+    return false;
+  }
+
+  decoded->width = info.image_width;
+  decoded->height = info.image_height;
+  decoded->has_alpha = false;
+
+  for (jpeg_saved_marker_ptr marker = info.marker_list; marker != nullptr;
+       marker = marker->next) {
+    if (marker->marker == JPEG_APP0 + 1) {
+      decoded->orientation =
+          ParseExifOrientation(marker->data, marker->data_length);
+      break;
+    }
+  }
+
+  // RGBA output is a libjpeg-turbo extension, saving the expansion pass.
+  info.out_color_space = JCS_EXT_RGBA;
+  info.scale_num = 1;
+  info.scale_denom =
+      JpegScaleDenominator(info.image_width, info.image_height, size);
+  jpeg_start_decompress(&info);
+
+  RgbaImage* image = &decoded->image;
+  image->width = info.output_width;
+  image->height = info.output_height;
+  image->pixels.resize(static_cast<size_t>(image->width) * image->height * 4);
+
+  while (info.output_scanline < info.output_height) {
+    JSAMPROW row = &image->pixels[static_cast<size_t>(info.output_scanline) *
+                                  image->width * 4];
+    jpeg_read_scanlines(&info, &row, 1);
+  }
+
+  jpeg_finish_decompress(&info);
+  jpeg_destroy_decompress(&info);
+  return true;
+}
+
+static bool DecodePng(const std::string& path, DecodedImage* decoded) {
+  png_image png;
+  memset(&png, 0, sizeof(png));
+  png.version = PNG_IMAGE_VERSION;
+
+  if (!png_image_begin_read_from_file(&png, path.c_str())) {
+    return false;
+  }
+
+  if (IsTooLarge(png.width, png.height)) {
+    png_image_free(&png);
+    return false;
+  }
+
+  decoded->has_alpha = (png.format & PNG_FORMAT_FLAG_ALPHA) != 0;
+  png.format = PNG_FORMAT_RGBA;
+
+  RgbaImage* image = &decoded->image;
+  image->width = png.width;
+  image->height = png.height;
+  image->pixels.resize(PNG_IMAGE_SIZE(png));
+  if (!png_image_finish_read(&png, nullptr, image->pixels.data(), 0,
+                             nullptr)) {
+    png_image_free(&png);
+    return false;
+  }
+
+  decoded->width = image->width;
+  decoded->height = image->height;
+  return true;
+}
+
+// Decodes the image with gdk-pixbuf, supporting the formats of the loaders
+// installed in the system.
+static bool DecodePixbuf(const std::string& path, DecodedImage* decoded) {
+  int width = 0;
+  int height = 0;
+  if (gdk_pixbuf_get_file_info(path.c_str(), &width, &height) == nullptr ||
+      IsTooLarge(width, height)) {
+    return false;
+  }
+
+  g_autoptr(GdkPixbuf) pixbuf = gdk_pixbuf_new_from_file(path.c_str(), nullptr);
+  if (pixbuf == nullptr || gdk_pixbuf_get_bits_per_sample(pixbuf) != 8) {
+    return false;
+  }
+
+  int channels = gdk_pixbuf_get_n_channels(pixbuf);
+  if (channels != 3 && channels != 4) {
+    return false;
+  }
+
+  RgbaImage* image = &decoded->image;
+  image->width = gdk_pixbuf_get_width(pixbuf);
+  image->height = gdk_pixbuf_get_height(pixbuf);
+  image->pixels.resize(static_cast<size_t>(image->width) * image->height * 4);
+
+  const guint8* pixels = gdk_pixbuf_read_pixels(pixbuf);
+  int stride = gdk_pixbuf_get_rowstride(pixbuf);
+  for (int y = 0; y < image->height; ++y) {
+    const guint8* in = pixels + static_cast<size_t>(y) * stride;
+    uint8_t* out = &image->pixels[static_cast<size_t>(y) * image->width * 4];
+    for (int x = 0; x < image->width; ++x) {
+      out[x * 4] = in[x * channels];
+      out[x * 4 + 1] = in[x * channels + 1];
+      out[x * 4 + 2] = in[x * channels + 2];
+      out[x * 4 + 3] = channels == 4 ? in[x * channels + 3] : 255;
+    }
+  }
+
+  const gchar* orientation = gdk_pixbuf_get_option(pixbuf, "orientation");
+  if (orientation != nullptr) {
+    int value = atoi(orientation);
+    decoded->orientation = value >= 1 && value <= 8 ? value : 1;
+  }
+
+  decoded->width = image->width;
+  decoded->height = image->height;
+  decoded->has_alpha = channels == 4;
+  return true;
+}
+
+static bool Decode(const std::string& path, int size, DecodedImage* decoded) {
+  switch (SniffFormat(path)) {
+    case ImageFormat::kJpeg: {
+      FILE* file = fopen(path.c_str(), "rbe");
+      if (file == nullptr) {
+        return false;
+      }
+
+      bool decoded_jpeg = DecodeJpeg(file, size, decoded);
+      fclose(file);
+
+      // Falls back to gdk-pixbuf for the JPEGs libjpeg can't convert to RGBA,
+      // e.g. the CMYK ones.
+      return decoded_jpeg || DecodePixbuf(path, decoded);
+    }
+
+    case ImageFormat::kPng:
+      return DecodePng(path, decoded);
+
+    case ImageFormat::kOther:
+      return DecodePixbuf(path, decoded);
+  }
+
+  return false;
+}
+
+// Returns whether the |orientation| swaps the width and height.
+static bool IsTransposed(int orientation) {
+  return orientation >= 5;
+}
+
+// Writes the |image| rotated and flipped according to the EXIF |orientation|
+// to the |result|.
+static void Orient(const RgbaImage& image, int orientation, RgbaImage* result) {
+  const int w = image.width;
+  const int h = image.height;
+  bool transposed = IsTransposed(orientation);
+  result->width = transposed ? h : w;
+  result->height = transposed ? w : h;
+  result->pixels.resize(image.pixels.size());
+
+  const uint32_t* in = reinterpret_cast<const uint32_t*>(image.pixels.data());
+  uint32_t* out = reinterpret_cast<uint32_t*>(result->pixels.data());
+  for (int y = 0; y < result->height; ++y) {
+    for (int x = 0; x < result->width; ++x) {
+      int sx;
+      int sy;
+      switch (orientation) {
+        case 2:
+          sx = w - 1 - x;
+          sy = y;
+          break;
+        case 3:
+          sx = w - 1 - x;
+          sy = h - 1 - y;
+          break;
+        case 4:
+          sx = x;
+          sy = h - 1 - y;
+          break;
+        case 5:
+          sx = y;
+          sy = x;
+          break;
+        case 6:
+          sx = y;
+          sy = h - 1 - x;
+          break;
+        case 7:
+          sx = w - 1 - y;
+          sy = h - 1 - x;
+          break;
+        case 8:
+          sx = w - 1 - y;
+          sy = x;
+          break;
+        default:
+          sx = x;
+          sy = y;
+          break;
+      }
+
+      *out++ = in[static_cast<size_t>(sy) * w + sx];
+    }
+  }
+}
+
+static bool HasTransparency(const RgbaImage& image) {
+  for (size_t i = 3; i < image.pixels.size(); i += 4) {
+    if (image.pixels[i] != 255) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Encodes the |image| as JPEG to the |file|.
+//
+// Nothing with a destructor may live in this function, as the errors
+// longjmp() out of the libjpeg calls.
+static bool EncodeJpeg(const RgbaImage& image, int quality, FILE* file) {
+  jpeg_compress_struct info;
+  JpegError error;
+  info.err = jpeg_std_error(&error.manager);
+  error.manager.error_exit = OnJpegError;
+  error.manager.output_message = OnJpegMessage;
+
+  if (setjmp(error.jump)) {
+    jpeg_destroy_compress(&info);
+    return false;
+  }
+
+  jpeg_create_compress(&info);
+  jpeg_stdio_dest(&info, file);
+
+  info.image_width = image.width;
+  info.image_height = image.height;
+  info.input_components = 4;
+  info.in_color_space = JCS_EXT_RGBA;
+  jpeg_set_defaults(&info);
+  jpeg_set_quality(&info, quality, TRUE);
+  jpeg_start_compress(&info, TRUE);
+
+  while (info.next_scanline < info.image_height) {
+    JSAMPROW row = const_cast<JSAMPROW>(
+        &image.pixels[static_cast<size_t>(info.next_scanline) * image.width *
+                      4]);
+    jpeg_write_scanlines(&info, &row, 1);
+  }
+
+  jpeg_finish_compress(&info);
+  jpeg_destroy_compress(&info);
+  return true;
+}
+
+static bool EncodePng(const RgbaImage& image, FILE* file) {
+  png_image png;
+  memset(&png, 0, sizeof(png));
+  png.version = PNG_IMAGE_VERSION;
+  png.width = image.width;
+  png.height = image.height;
+  png.format = PNG_FORMAT_RGBA;
+
+  return png_image_write_to_stdio(&png, file, 0, image.pixels.data(), 0,
+                                  nullptr) != 0;
+}
+
+// Encodes the |image| to the |path| through a temporary file, so a partially
+// written preview is never visible.
+static bool Encode(const RgbaImage& image,
+                   bool png,
+                   int quality,
+                   const std::string& path) {
+  std::string temporary = path + ".tmp";
+  FILE* file = fopen(temporary.c_str(), "wbe");
+  if (file == nullptr) {
+    return false;
+  }
+
+  bool encoded = png ? EncodePng(image, file)
+                     : EncodeJpeg(image, quality, file);
+  encoded = fclose(file) == 0 && encoded;
+
+  if (!encoded || rename(temporary.c_str(), path.c_str()) != 0) {
+    unlink(temporary.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+// Returns the FNV-1a hash identifying the image at |path| by its path, size
+// and modification time.
+static uint64_t HashImage(const std::string& path) {
+  uint64_t hash = 14695981039346656037ULL;
+  auto update = [&hash](const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < length; ++i) {
+      hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+  };
+
+  update(path.data(), path.size());
+
+  struct stat st;
+  if (stat(path.c_str(), &st) == 0) {
+    int64_t values[] = {st.st_size, st.st_mtim.tv_sec, st.st_mtim.tv_nsec};
+    update(values, sizeof(values));
+  }
+
+  return hash;
+}
+
+bool CreateImagePreviews(const std::string& path,
+                         const ImagePreviewOptions& options,
+                         ImagePreviews* previews) {
+  if (options.sizes.empty()) {
+    return false;
+  }
+
+  int largest = *std::max_element(options.sizes.begin(), options.sizes.end());
+
+  DecodedImage decoded;
+  if (largest <= 0 || !Decode(path, largest, &decoded)) {
+    return false;
+  }
+
+  bool transposed = IsTransposed(decoded.orientation);
+  previews->width = transposed ? decoded.height : decoded.width;
+  previews->height = transposed ? decoded.width : decoded.height;
+  previews->paths.clear();
+
+  char name[64];
+  snprintf(name, sizeof(name), "%016llx",
+           static_cast<unsigned long long>(HashImage(path)));
+
+  // Previews are created from the largest to the smallest one, each resampled
+  // from the previous one while it's at least twice as large, which is much
+  // cheaper than going over the whole decoded image again.
+  std::vector<size_t> order(options.sizes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&options](size_t a, size_t b) {
+    return options.sizes[a] > options.sizes[b];
+  });
+  previews->paths.resize(options.sizes.size());
+
+  const RgbaImage& source = decoded.image;
+  RgbaImage previous;
+  for (size_t index : order) {
+    int size = options.sizes[index];
+
+    // Fit the decoded image into the |size| without upscaling it, keeping
+    // the aspect ratio.
+    double scale = std::min(
+        1.0, static_cast<double>(size) / std::max(source.width, source.height));
+    int width = std::max(1, static_cast<int>(source.width * scale + 0.5));
+    int height = std::max(1, static_cast<int>(source.height * scale + 0.5));
+
+    const RgbaImage* input = &source;
+    if (previous.width >= width * 2 && previous.height >= height * 2) {
+      input = &previous;
+    }
+
+    RgbaImage resized;
+    if (width != input->width || height != input->height) {
+      ResizeRgba(*input, width, height, options.filter, decoded.has_alpha,
+                 &resized);
+    } else {
+      resized = *input;
+    }
+
+    const RgbaImage* output = &resized;
+    RgbaImage oriented;
+    if (decoded.orientation != 1) {
+      Orient(resized, decoded.orientation, &oriented);
+      output = &oriented;
+    }
+
+    bool png = decoded.has_alpha && HasTransparency(*output);
+    std::string preview = options.directory + "/" + name + "_" +
+                          std::to_string(size) + (png ? ".png" : ".jpg");
+    if (!Encode(*output, png, options.quality, preview)) {
+      return false;
+    }
+
+    previews->paths[index] = std::move(preview);
+    previous = std::move(resized);
+  }
+
+  return true;
+}
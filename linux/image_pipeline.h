@@ -0,0 +1,50 @@
+#ifndef RUNNER_IMAGE_PIPELINE_H_
+#define RUNNER_IMAGE_PIPELINE_H_
+
+#include <string>
+#include <vector>
+
+#include "image_resize.h"
+
+// Options of the previews created by CreateImagePreviews().
+struct ImagePreviewOptions {
+  // Maximum width and height of each of the previews to create.
+  std::vector<int> sizes;
+
+  // Directory to write the previews to.
+  std::string directory;
+
+  // Quality of the JPEG encoded previews, from 1 to 100.
+  int quality = 85;
+
+  ResizeFilter filter = ResizeFilter::kLanczos3;
+};
+
+// Previews created by CreateImagePreviews().
+struct ImagePreviews {
+  // Dimensions of the original image after its EXIF orientation is applied.
+  int width = 0;
+  int height = 0;
+
+  // Paths to the previews in the order of ImagePreviewOptions::sizes.
+  std::vector<std::string> paths;
+};
+
+// Decodes the image at |path|, downscales it to fit each of the
+// |options.sizes| and writes the encoded previews to the |options.directory|.
+// Returns false if the image can't be decoded or the previews can't be
+// written.
+//
+// JPEGs are decoded by libjpeg-turbo scaled down in the DCT domain as much as
+// the largest preview allows, and PNGs by libpng, while any other formats
+// (e.g. WebP) go through the installed gdk-pixbuf loaders. EXIF orientation
+// is applied to the downscaled previews. Opaque previews are encoded as JPEG
+// and the ones with transparency as PNG.
+//
+// Previews are named after the path, size and modification time of the
+// image, so an unchanged image resolves to the same files.
+bool CreateImagePreviews(const std::string& path,
+                         const ImagePreviewOptions& options,
+                         ImagePreviews* previews);
+
+#endif  // RUNNER_IMAGE_PIPELINE_H_
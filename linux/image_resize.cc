@@ -0,0 +1,247 @@
+#include "image_resize.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define IMAGE_RESIZE_X86 1
+#endif
+
+// Source pixels contributing to each of the resulting pixels along an axis.
+struct Contributions {
+  // Index of the first contributing source pixel of each resulting one.
+  std::vector<int> first;
+
+  // Number of the contributing source pixels of each resulting one.
+  std::vector<int> count;
+
+  // Weights of the contributing pixels, |stride| per each resulting one.
+  std::vector<float> weights;
+  int stride = 0;
+};
+
+static double Sinc(double x) {
+  if (x == 0) {
+    return 1;
+  }
+
+  x *= M_PI;
+  return sin(x) / x;
+}
+
+static double Lanczos3(double x) {
+  return fabs(x) < 3 ? Sinc(x) * Sinc(x / 3) : 0;
+}
+
+static Contributions ComputeContributions(int source,
+                                          int target,
+                                          ResizeFilter filter) {
+  Contributions contributions;
+  contributions.first.resize(target);
+  contributions.count.resize(target);
+
+  double scale = static_cast<double>(source) / target;
+
+  // Lanczos is stretched over the source pixels when downscaling, so that it
+  // averages all of them instead of skipping.
+  double filter_scale = std::max(scale, 1.0);
+  double support = filter == ResizeFilter::kArea ? scale / 2 + 1
+                                                 : 3 * filter_scale;
+
+  contributions.stride = static_cast<int>(ceil(support * 2)) + 2;
+  contributions.weights.assign(
+      static_cast<size_t>(target) * contributions.stride, 0);
+
+  for (int i = 0; i < target; ++i) {
+    double center = (i + 0.5) * scale;
+    int first = std::max(0, static_cast<int>(floor(center - support)));
+    int last = std::min(source, static_cast<int>(ceil(center + support)));
+
+    float* weights = &contributions.weights[i * contributions.stride];
+    double total = 0;
+    int count = 0;
+    for (int j = first; j < last && count < contributions.stride; ++j) {
+      double weight;
+      if (filter == ResizeFilter::kArea) {
+        // Part of the source pixel covered by the resulting one.
+        double begin = std::max<double>(j, i * scale);
+        double end = std::min<double>(j + 1, (i + 1) * scale);
+        weight = std::max(0.0, end - begin);
+      } else {
+        weight = Lanczos3((j + 0.5 - center) / filter_scale);
+      }
+
+      weights[count++] = static_cast<float>(weight);
+      total += weight;
+    }
+
+    if (total != 0) {
+      for (int k = 0; k < count; ++k) {
+        weights[k] = static_cast<float>(weights[k] / total);
+      }
+    }
+
+    // Drop the zero weights at the edges, which the area filter produces.
+    int skip = 0;
+    while (skip < count - 1 && weights[skip] == 0) {
+      ++skip;
+    }
+    while (count > skip + 1 && weights[count - 1] == 0) {
+      --count;
+    }
+    memmove(weights, weights + skip, (count - skip) * sizeof(float));
+
+    contributions.first[i] = first + skip;
+    contributions.count[i] = count - skip;
+  }
+
+  return contributions;
+}
+
+// Converts the |value| into [0, 255] rounding it.
+//
+// Clamped after the conversion, as integer selects are compiled into the
+// branchless vector code, while the float ones aren't due to trapping math.
+static inline uint8_t ToByte(float value) {
+  int32_t rounded = static_cast<int32_t>(value + 0.5f);
+  rounded = rounded > 0 ? rounded : 0;
+  return rounded < 255 ? rounded : 255;
+}
+
+// RGBA pixel of the accumulated floats.
+typedef float Pixel __attribute__((vector_size(16)));
+
+// Resamples the |source| into the |result| with the |rows| and |columns|
+// contributions.
+__attribute__((always_inline)) static inline void Resample(
+    const RgbaImage& source,
+    const Contributions& rows,
+    const Contributions& columns,
+    RgbaImage* result) {
+  const size_t source_stride = static_cast<size_t>(source.width) * 4;
+  const size_t result_stride = static_cast<size_t>(result->width) * 4;
+
+  std::vector<float> accumulator(source_stride);
+  std::vector<float> row(result_stride);
+
+  for (int y = 0; y < result->height; ++y) {
+    // Vertical pass blending the contributing rows over their whole width.
+    float* acc = accumulator.data();
+    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+
+    const float* weights = &rows.weights[y * rows.stride];
+    for (int t = 0; t < rows.count[y]; ++t) {
+      const float weight = weights[t];
+      const uint8_t* pixels =
+          &source.pixels[(rows.first[y] + t) * source_stride];
+      for (size_t i = 0; i < source_stride; ++i) {
+        acc[i] += weight * pixels[i];
+      }
+    }
+
+    // Horizontal pass blending the contributing RGBA pixels of the row, each
+    // held in a single vector.
+    for (int x = 0; x < result->width; ++x) {
+      const float* column_weights = &columns.weights[x * columns.stride];
+      const float* pixel = acc + columns.first[x] * 4;
+
+      Pixel sum = {};
+      for (int t = 0; t < columns.count[x]; ++t) {
+        Pixel value;
+        memcpy(&value, pixel + t * 4, sizeof(value));
+        sum += column_weights[t] * value;
+      }
+
+      memcpy(&row[x * 4], &sum, sizeof(sum));
+    }
+
+    uint8_t* out = &result->pixels[y * result_stride];
+    for (size_t i = 0; i < result_stride; ++i) {
+      out[i] = ToByte(row[i]);
+    }
+  }
+}
+
+static void ResampleDefault(const RgbaImage& source,
+                            const Contributions& rows,
+                            const Contributions& columns,
+                            RgbaImage* result) {
+  Resample(source, rows, columns, result);
+}
+
+#ifdef IMAGE_RESIZE_X86
+__attribute__((target("avx2,fma"))) static void ResampleAvx2(
+    const RgbaImage& source,
+    const Contributions& rows,
+    const Contributions& columns,
+    RgbaImage* result) {
+  Resample(source, rows, columns, result);
+}
+
+static bool CpuSupportsAvx2Fma() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+#endif  // IMAGE_RESIZE_X86
+
+static void Premultiply(std::vector<uint8_t>* pixels) {
+  for (size_t i = 0; i < pixels->size(); i += 4) {
+    uint32_t alpha = (*pixels)[i + 3];
+    for (int c = 0; c < 3; ++c) {
+      (*pixels)[i + c] = ((*pixels)[i + c] * alpha + 127) / 255;
+    }
+  }
+}
+
+static void Unpremultiply(std::vector<uint8_t>* pixels) {
+  for (size_t i = 0; i < pixels->size(); i += 4) {
+    uint32_t alpha = (*pixels)[i + 3];
+    if (alpha == 0 || alpha == 255) {
+      continue;
+    }
+
+    for (int c = 0; c < 3; ++c) {
+      (*pixels)[i + c] =
+          std::min<uint32_t>(255, ((*pixels)[i + c] * 255 + alpha / 2) / alpha);
+    }
+  }
+}
+
+void ResizeRgba(const RgbaImage& source,
+                int width,
+                int height,
+                ResizeFilter filter,
+                bool has_alpha,
+                RgbaImage* result) {
+  result->width = width;
+  result->height = height;
+  result->pixels.resize(static_cast<size_t>(width) * height * 4);
+
+  const RgbaImage* input = &source;
+  RgbaImage premultiplied;
+  if (has_alpha) {
+    premultiplied = source;
+    Premultiply(&premultiplied.pixels);
+    input = &premultiplied;
+  }
+
+  Contributions rows = ComputeContributions(source.height, height, filter);
+  Contributions columns = ComputeContributions(source.width, width, filter);
+
+#ifdef IMAGE_RESIZE_X86
+  static const bool avx2 = CpuSupportsAvx2Fma();
+  if (avx2) {
+    ResampleAvx2(*input, rows, columns, result);
+  } else {
+    ResampleDefault(*input, rows, columns, result);
+  }
+#else
+  ResampleDefault(*input, rows, columns, result);
+#endif
+
+  if (has_alpha) {
+    Unpremultiply(&result->pixels);
+  }
+}
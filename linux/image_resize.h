@@ -0,0 +1,39 @@
+#ifndef RUNNER_IMAGE_RESIZE_H_
+#define RUNNER_IMAGE_RESIZE_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+// Filter to resample the images with.
+enum class ResizeFilter {
+  // Averages the source pixels covered by each of the resulting ones, best
+  // suited for large downscaling factors.
+  kArea,
+
+  // Lanczos windowed sinc with 3 lobes, keeping the details sharp.
+  kLanczos3,
+};
+
+// Image of 8-bit RGBA pixels stored row by row without padding.
+struct RgbaImage {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> pixels;
+};
+
+// Resizes the |source| to |width| x |height| pixels with the |filter|,
+// writing the result to the |result|.
+//
+// The resampling is separated into the vertical pass over the whole rows and
+// the horizontal pass over the pixels, both vectorized, using AVX2 and FMA
+// when supported by the CPU. Colors are premultiplied by alpha while being
+// resampled if |has_alpha| is true, so the transparent pixels don't bleed.
+void ResizeRgba(const RgbaImage& source,
+                int width,
+                int height,
+                ResizeFilter filter,
+                bool has_alpha,
+                RgbaImage* result);
+
+#endif  // RUNNER_IMAGE_RESIZE_H_
@@ -0,0 +1,154 @@
+#include "image_service.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "async_response.h"
+#include "image_pipeline.h"
+#include "worker_pool.h"
+
+// Previews of the images from a single `createImagePreviews` call, each
+// created in its own WorkerPool task.
+struct PreviewsJob {
+  FlMethodCall* method_call;
+  ImagePreviewOptions options;
+  std::vector<std::string> paths;
+
+  // Previews of the |paths|, left without any paths if they have failed.
+  std::vector<ImagePreviews> previews;
+
+  // Number of the tasks still running.
+  std::atomic<int> pending{0};
+};
+
+static void finish_previews_job(const std::shared_ptr<PreviewsJob>& job) {
+  if (--job->pending > 0) {
+    return;
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_list();
+  for (size_t i = 0; i < job->paths.size(); ++i) {
+    const ImagePreviews& previews = job->previews[i];
+    if (previews.paths.empty()) {
+      fl_value_append_take(result, fl_value_new_null());
+      continue;
+    }
+
+    FlValue* paths = fl_value_new_list();
+    for (const std::string& path : previews.paths) {
+      fl_value_append_take(paths, fl_value_new_string(path.c_str()));
+    }
+
+    FlValue* value = fl_value_new_map();
+    fl_value_set_string_take(value, "width", fl_value_new_int(previews.width));
+    fl_value_set_string_take(value, "height",
+                             fl_value_new_int(previews.height));
+    fl_value_set_string_take(value, "previews", paths);
+    fl_value_append_take(result, value);
+  }
+
+  method_call_respond_async(
+      job->method_call,
+      FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+}
+
+static FlMethodResponse* create_image_previews(FlMethodCall* method_call,
+                                               FlValue* args) {
+  FlValue* paths = nullptr;
+  FlValue* sizes = nullptr;
+  FlValue* directory = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    paths = fl_value_lookup_string(args, "paths");
+    sizes = fl_value_lookup_string(args, "sizes");
+    directory = fl_value_lookup_string(args, "directory");
+  }
+
+  if (paths == nullptr || fl_value_get_type(paths) != FL_VALUE_TYPE_LIST ||
+      sizes == nullptr || fl_value_get_type(sizes) != FL_VALUE_TYPE_LIST ||
+      fl_value_get_length(sizes) == 0 || directory == nullptr ||
+      fl_value_get_type(directory) != FL_VALUE_TYPE_STRING) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR",
+        "`paths`, `sizes` and `directory` must be provided", nullptr));
+  }
+
+  std::shared_ptr<PreviewsJob> job = std::make_shared<PreviewsJob>();
+  job->options.directory = fl_value_get_string(directory);
+
+  for (size_t i = 0; i < fl_value_get_length(sizes); ++i) {
+    FlValue* size = fl_value_get_list_value(sizes, i);
+    if (fl_value_get_type(size) != FL_VALUE_TYPE_INT ||
+        fl_value_get_int(size) <= 0) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          "ARGUMENT_ERROR", "`sizes` must be positive integers", nullptr));
+    }
+
+    job->options.sizes.push_back(fl_value_get_int(size));
+  }
+
+  FlValue* quality = fl_value_lookup_string(args, "quality");
+  if (quality != nullptr && fl_value_get_type(quality) == FL_VALUE_TYPE_INT) {
+    job->options.quality =
+        std::max<int64_t>(1, std::min<int64_t>(100, fl_value_get_int(quality)));
+  }
+
+  FlValue* filter = fl_value_lookup_string(args, "filter");
+  if (filter != nullptr && fl_value_get_type(filter) == FL_VALUE_TYPE_STRING &&
+      strcmp(fl_value_get_string(filter), "area") == 0) {
+    job->options.filter = ResizeFilter::kArea;
+  }
+
+  for (size_t i = 0; i < fl_value_get_length(paths); ++i) {
+    FlValue* path = fl_value_get_list_value(paths, i);
+    job->paths.push_back(fl_value_get_type(path) == FL_VALUE_TYPE_STRING
+                             ? fl_value_get_string(path)
+                             : "");
+  }
+  job->previews.resize(job->paths.size());
+  job->method_call = FL_METHOD_CALL(g_object_ref(method_call));
+
+  // Holds the job until all the tasks are posted.
+  job->pending = 1 + job->paths.size();
+
+  WorkerPool* pool = WorkerPool::Shared();
+  for (size_t i = 0; i < job->paths.size(); ++i) {
+    pool->Post([job, i] {
+      ImagePreviews* previews = &job->previews[i];
+      if (job->paths[i].empty() ||
+          !CreateImagePreviews(job->paths[i], job->options, previews)) {
+        previews->paths.clear();
+      }
+      finish_previews_job(job);
+    });
+  }
+
+  finish_previews_job(job);
+  return nullptr;
+}
+
+gboolean image_service_handle_method_call(FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "createImagePreviews") == 0) {
+    response = create_image_previews(method_call, args);
+  } else {
+    return FALSE;
+  }
+
+  // Errors are responded to synchronously.
+  if (response != nullptr) {
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(method_call, response, &error)) {
+      g_warning("Failed to send response: %s", error->message);
+    }
+  }
+
+  return TRUE;
+}
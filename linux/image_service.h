@@ -0,0 +1,18 @@
+#ifndef RUNNER_IMAGE_SERVICE_H_
+#define RUNNER_IMAGE_SERVICE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * image_service_handle_method_call:
+ * @method_call: #FlMethodCall received on the utils channel.
+ *
+ * Handles the `createImagePreviews` method, decoding and downscaling the
+ * provided image files on the #WorkerPool, and responding asynchronously
+ * with the paths to the written previews instead of their bytes.
+ *
+ * Returns: %TRUE if the @method_call was handled by this service.
+ */
+gboolean image_service_handle_method_call(FlMethodCall* method_call);
+
+#endif  // RUNNER_IMAGE_SERVICE_H_
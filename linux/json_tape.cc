@@ -0,0 +1,831 @@
+#include "json_tape.h"
+
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <memory>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JSON_TAPE_X86 1
+#endif
+
+// Size of the blocks the structural characters are indexed in.
+static const size_t kBlockSize = 64;
+
+// Deepest nesting of the arrays and the objects parsed.
+static const size_t kMaxDepth = 1024;
+
+// Bitmasks of the characters of a block, a bit per byte.
+struct BlockMasks {
+  uint64_t quote;
+  uint64_t backslash;
+
+  // Structural operators `{`, `}`, `[`, `]`, `:` and `,`.
+  uint64_t op;
+
+  uint64_t space;
+};
+
+// State of the indexing carried over from a block to the next one.
+struct IndexState {
+  // Position of the block being indexed.
+  size_t position = 0;
+
+  // Indicator whether the first byte of the block is escaped by the last one
+  // of the previous block.
+  bool escaped = false;
+
+  // All ones, if the previous block has ended within a string.
+  uint64_t in_string = 0;
+
+  // Indicator whether the previous block has ended with a scalar, so the
+  // block doesn't start a new one.
+  uint64_t scalar = 0;
+
+  // Next structural index to write.
+  uint32_t* out = nullptr;
+};
+
+static inline void ClassifyScalar(const uint8_t* block, BlockMasks* masks) {
+  *masks = BlockMasks();
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    uint64_t bit = uint64_t{1} << i;
+    switch (block[i]) {
+      case '"':
+        masks->quote |= bit;
+        break;
+
+      case '\\':
+        masks->backslash |= bit;
+        break;
+
+      case '{':
+      case '}':
+      case '[':
+      case ']':
+      case ':':
+      case ',':
+        masks->op |= bit;
+        break;
+
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+        masks->space |= bit;
+        break;
+    }
+  }
+}
+
+#ifdef JSON_TAPE_X86
+__attribute__((target("sse2"))) static inline void ClassifySse2(
+    const uint8_t* block,
+    BlockMasks* masks) {
+  *masks = BlockMasks();
+  for (size_t i = 0; i < kBlockSize; i += 16) {
+    __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+
+    // Brackets differ from the braces in the 0x20 bit only.
+    __m128i lowered = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    __m128i op = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(lowered, _mm_set1_epi8('{')),
+                     _mm_cmpeq_epi8(lowered, _mm_set1_epi8('}'))),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(':')),
+                     _mm_cmpeq_epi8(bytes, _mm_set1_epi8(','))));
+    __m128i space = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                     _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')),
+                     _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))));
+    __m128i quote = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('"'));
+    __m128i backslash = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'));
+
+    masks->quote |= static_cast<uint64_t>(
+                        static_cast<uint16_t>(_mm_movemask_epi8(quote)))
+                    << i;
+    masks->backslash |= static_cast<uint64_t>(static_cast<uint16_t>(
+                            _mm_movemask_epi8(backslash)))
+                        << i;
+    masks->op |=
+        static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(op)))
+        << i;
+    masks->space |= static_cast<uint64_t>(
+                        static_cast<uint16_t>(_mm_movemask_epi8(space)))
+                    << i;
+  }
+}
+
+__attribute__((target("avx2"))) static inline void ClassifyAvx2(
+    const uint8_t* block,
+    BlockMasks* masks) {
+  *masks = BlockMasks();
+  for (size_t i = 0; i < kBlockSize; i += 32) {
+    __m256i bytes =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+
+    // Brackets differ from the braces in the 0x20 bit only.
+    __m256i lowered = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+    __m256i op = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(lowered, _mm256_set1_epi8('{')),
+                        _mm256_cmpeq_epi8(lowered, _mm256_set1_epi8('}'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(':')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(','))));
+    __m256i space = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r'))));
+    __m256i quote = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"'));
+    __m256i backslash = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'));
+
+    masks->quote |= static_cast<uint64_t>(
+                        static_cast<uint32_t>(_mm256_movemask_epi8(quote)))
+                    << i;
+    masks->backslash |= static_cast<uint64_t>(static_cast<uint32_t>(
+                            _mm256_movemask_epi8(backslash)))
+                        << i;
+    masks->op |= static_cast<uint64_t>(
+                     static_cast<uint32_t>(_mm256_movemask_epi8(op)))
+                 << i;
+    masks->space |= static_cast<uint64_t>(
+                        static_cast<uint32_t>(_mm256_movemask_epi8(space)))
+                    << i;
+  }
+}
+#endif  // JSON_TAPE_X86
+
+// Returns the |bits| with each one being the XOR of it and all the lower ones,
+// which turns the quotes into the bits of the strings they enclose.
+static inline uint64_t PrefixXor(uint64_t bits) {
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+// Writes the positions of the structural characters of the block classified
+// into the |masks| to the |state|: the operators and the starts of the strings
+// and the scalars outside of the strings.
+static inline void IndexBlock(const BlockMasks& masks, IndexState* state) {
+  // Backslashes are rare, so the ones escaping the next byte are found one by
+  // one.
+  uint64_t escaped = state->escaped ? 1 : 0;
+  uint64_t backslash = masks.backslash & ~escaped;
+  state->escaped = false;
+  while (backslash != 0) {
+    int i = __builtin_ctzll(backslash);
+    if (i == 63) {
+      state->escaped = true;
+      break;
+    }
+
+    escaped |= uint64_t{2} << i;
+    backslash &= ~(uint64_t{3} << i);
+  }
+
+  uint64_t quote = masks.quote & ~escaped;
+  uint64_t in_string = PrefixXor(quote) ^ state->in_string;
+  state->in_string =
+      static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+  uint64_t op = masks.op & ~in_string;
+  uint64_t scalar = ~(masks.op | masks.space | quote | in_string);
+  uint64_t scalar_start = scalar & ~(scalar << 1 | state->scalar);
+  state->scalar = scalar >> 63;
+
+  uint64_t structural = op | (quote & in_string) | scalar_start;
+  uint32_t* out = state->out;
+  uint32_t position = static_cast<uint32_t>(state->position);
+  while (structural != 0) {
+    *out++ = position + __builtin_ctzll(structural);
+    structural &= structural - 1;
+  }
+
+  state->out = out;
+  state->position += kBlockSize;
+}
+
+static void IndexBlocksScalar(const uint8_t* data,
+                              size_t blocks,
+                              IndexState* state) {
+  for (size_t i = 0; i < blocks; ++i) {
+    BlockMasks masks;
+    ClassifyScalar(data + i * kBlockSize, &masks);
+    IndexBlock(masks, state);
+  }
+}
+
+#ifdef JSON_TAPE_X86
+__attribute__((target("sse2"))) static void IndexBlocksSse2(
+    const uint8_t* data,
+    size_t blocks,
+    IndexState* state) {
+  for (size_t i = 0; i < blocks; ++i) {
+    BlockMasks masks;
+    ClassifySse2(data + i * kBlockSize, &masks);
+    IndexBlock(masks, state);
+  }
+}
+
+__attribute__((target("avx2"))) static void IndexBlocksAvx2(
+    const uint8_t* data,
+    size_t blocks,
+    IndexState* state) {
+  for (size_t i = 0; i < blocks; ++i) {
+    BlockMasks masks;
+    ClassifyAvx2(data + i * kBlockSize, &masks);
+    IndexBlock(masks, state);
+  }
+}
+
+static bool CpuSupports(const char* feature) {
+  __builtin_cpu_init();
+  return strcmp(feature, "avx2") == 0 ? __builtin_cpu_supports("avx2")
+                                      : __builtin_cpu_supports("sse2");
+}
+#endif  // JSON_TAPE_X86
+
+static void IndexBlocks(JsonIndexKernel kernel,
+                        const uint8_t* data,
+                        size_t blocks,
+                        IndexState* state) {
+  switch (kernel) {
+#ifdef JSON_TAPE_X86
+    case JsonIndexKernel::kAvx2:
+      IndexBlocksAvx2(data, blocks, state);
+      break;
+
+    case JsonIndexKernel::kSse2:
+      IndexBlocksSse2(data, blocks, state);
+      break;
+#endif
+
+    default:
+      IndexBlocksScalar(data, blocks, state);
+      break;
+  }
+}
+
+// Indicates whether the |size| bytes of the |data| are valid UTF-8.
+static bool IsValidUtf8(const uint8_t* data, size_t size) {
+  size_t i = 0;
+  while (i < size) {
+    // ASCII is skipped 8 bytes at a time.
+    if (size - i >= 8) {
+      uint64_t word;
+      memcpy(&word, data + i, sizeof(word));
+      if ((word & 0x8080808080808080ULL) == 0) {
+        i += 8;
+        continue;
+      }
+    }
+
+    uint8_t byte = data[i];
+    if (byte < 0x80) {
+      ++i;
+      continue;
+    }
+
+    size_t length;
+    uint32_t code_point;
+    if ((byte & 0xE0) == 0xC0) {
+      length = 2;
+      code_point = byte & 0x1F;
+    } else if ((byte & 0xF0) == 0xE0) {
+      length = 3;
+      code_point = byte & 0x0F;
+    } else if ((byte & 0xF8) == 0xF0) {
+      length = 4;
+      code_point = byte & 0x07;
+    } else {
+      return false;
+    }
+
+    if (size - i < length) {
+      return false;
+    }
+
+    for (size_t j = 1; j < length; ++j) {
+      if ((data[i + j] & 0xC0) != 0x80) {
+        return false;
+      }
+      code_point = code_point << 6 | (data[i + j] & 0x3F);
+    }
+
+    // Overlong encodings, surrogates and the code points out of the range
+    // aren't valid.
+    static const uint32_t kMinCodePoint[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (code_point < kMinCodePoint[length] || code_point > 0x10FFFF ||
+        (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+      return false;
+    }
+
+    i += length;
+  }
+
+  return true;
+}
+
+// Writes the |code_point| encoded in UTF-8 to the |out|, returning the end
+// of it.
+static uint8_t* WriteUtf8(uint32_t code_point, uint8_t* out) {
+  if (code_point < 0x80) {
+    *out++ = code_point;
+  } else if (code_point < 0x800) {
+    *out++ = 0xC0 | code_point >> 6;
+    *out++ = 0x80 | (code_point & 0x3F);
+  } else if (code_point < 0x10000) {
+    *out++ = 0xE0 | code_point >> 12;
+    *out++ = 0x80 | (code_point >> 6 & 0x3F);
+    *out++ = 0x80 | (code_point & 0x3F);
+  } else {
+    *out++ = 0xF0 | code_point >> 18;
+    *out++ = 0x80 | (code_point >> 12 & 0x3F);
+    *out++ = 0x80 | (code_point >> 6 & 0x3F);
+    *out++ = 0x80 | (code_point & 0x3F);
+  }
+
+  return out;
+}
+
+// Parses the 4 hex digits at the |p|, returning -1, if they aren't.
+static int32_t ParseHex4(const uint8_t* p, const uint8_t* end) {
+  if (end - p < 4) {
+    return -1;
+  }
+
+  int32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    uint8_t c = p[i];
+    int32_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+      digit = (c | 0x20) - 'a' + 10;
+    } else {
+      return -1;
+    }
+    value = value << 4 | digit;
+  }
+
+  return value;
+}
+
+// Builder of the tape from the structural indexes of a document.
+class TapeBuilder {
+ public:
+  // Strings unescaped are never longer than they're escaped, so the buffer
+  // of the |size| is enough for them, while the padding allows to copy them
+  // 16 bytes at a time.
+  TapeBuilder(const uint8_t* data, size_t size)
+      : data_(data), size_(size), strings_(new uint8_t[size + 16]) {}
+
+  // Builds the tape from the |count| structural |indexes|, returning false,
+  // if the document is malformed.
+  bool Build(const uint32_t* indexes, size_t count);
+
+  // Writes the tape built to the |out|.
+  void Write(std::string* out) const;
+
+ private:
+  // Container being parsed.
+  struct Scope {
+    size_t node;
+    uint32_t length;
+    bool object;
+  };
+
+  // Appends the string starting with the quote at the |position|.
+  bool ParseString(size_t position);
+
+  // Appends the literal or the number in [|position|, |end|).
+  bool ParseScalar(size_t position, size_t end);
+
+  void AppendNode(JsonTapeType type, uint32_t length, uint64_t value) {
+    nodes_.push_back(JsonTapeNode{type, {0, 0, 0}, length, value});
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+
+  std::vector<JsonTapeNode> nodes_;
+  std::unique_ptr<uint8_t[]> strings_;
+  size_t strings_size_ = 0;
+  std::vector<Scope> scopes_;
+};
+
+bool TapeBuilder::Build(const uint32_t* indexes, size_t count) {
+  enum class Expect {
+    kValue,
+    kValueOrEnd,
+    kKey,
+    kKeyOrEnd,
+    kColon,
+    kCommaOrEnd,
+    kNothing,
+  };
+
+  nodes_.reserve(count);
+  Expect expect = Expect::kValue;
+
+  for (size_t i = 0; i < count; ++i) {
+    size_t position = indexes[i];
+    uint8_t c = data_[position];
+
+    bool value_parsed = false;
+    switch (expect) {
+      case Expect::kKeyOrEnd:
+      case Expect::kKey:
+        if (c == '}' && expect == Expect::kKeyOrEnd) {
+          break;
+        }
+
+        if (c != '"' || !ParseString(position)) {
+          return false;
+        }
+        expect = Expect::kColon;
+        continue;
+
+      case Expect::kColon:
+        if (c != ':') {
+          return false;
+        }
+        expect = Expect::kValue;
+        continue;
+
+      case Expect::kValueOrEnd:
+      case Expect::kValue:
+        if (c == ']' && expect == Expect::kValueOrEnd) {
+          break;
+        }
+
+        if (c == '{' || c == '[') {
+          if (scopes_.size() == kMaxDepth) {
+            return false;
+          }
+
+          scopes_.push_back(Scope{nodes_.size(), 0, c == '{'});
+          AppendNode(c == '{' ? JsonTapeType::kObject : JsonTapeType::kArray,
+                     0, 0);
+          expect = c == '{' ? Expect::kKeyOrEnd : Expect::kValueOrEnd;
+          continue;
+        }
+
+        if (c == '"') {
+          if (!ParseString(position)) {
+            return false;
+          }
+        } else if (!ParseScalar(position,
+                                i + 1 < count ? indexes[i + 1] : size_)) {
+          return false;
+        }
+        value_parsed = true;
+        break;
+
+      case Expect::kCommaOrEnd:
+        if (c == ',') {
+          expect = scopes_.back().object ? Expect::kKey : Expect::kValue;
+          continue;
+        }
+        break;
+
+      case Expect::kNothing:
+        return false;
+    }
+
+    // Closes the container, unless a value is parsed.
+    if (!value_parsed) {
+      if (scopes_.empty() || c != (scopes_.back().object ? '}' : ']')) {
+        return false;
+      }
+
+      const Scope& scope = scopes_.back();
+      JsonTapeNode& node = nodes_[scope.node];
+      node.length = scope.length;
+      node.value = nodes_.size();
+      scopes_.pop_back();
+    }
+
+    if (scopes_.empty()) {
+      expect = Expect::kNothing;
+    } else {
+      ++scopes_.back().length;
+      expect = Expect::kCommaOrEnd;
+    }
+  }
+
+  return expect == Expect::kNothing;
+}
+
+bool TapeBuilder::ParseString(size_t position) {
+  const uint8_t* p = data_ + position + 1;
+  const uint8_t* end = data_ + size_;
+  uint8_t* start = strings_.get() + strings_size_;
+  uint8_t* out = start;
+
+  // Bytes are copied until a quote, a backslash or a control character is
+  // met, detecting any non-ASCII ones to validate the string after.
+  uint8_t high = 0;
+  while (true) {
+#ifdef __SSE2__
+    if (end - p >= 16) {
+      __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), bytes);
+
+      __m128i control = _mm_cmpeq_epi8(
+          _mm_min_epu8(bytes, _mm_set1_epi8(0x1F)), bytes);
+      int special = _mm_movemask_epi8(_mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')),
+                       _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))),
+          control));
+      int non_ascii = _mm_movemask_epi8(bytes);
+
+      if (special == 0) {
+        high |= non_ascii != 0;
+        p += 16;
+        out += 16;
+        continue;
+      }
+
+      int plain = __builtin_ctz(special);
+      high |= (non_ascii & ((1 << plain) - 1)) != 0;
+      p += plain;
+      out += plain;
+    } else
+#endif
+    {
+      while (p < end && *p != '"' && *p != '\\' && *p >= 0x20) {
+        high |= *p & 0x80;
+        *out++ = *p++;
+      }
+    }
+
+    if (p == end || *p < 0x20) {
+      return false;
+    }
+
+    if (*p++ == '"') {
+      break;
+    }
+
+    if (p == end) {
+      return false;
+    }
+
+    switch (*p++) {
+      case '"':
+        *out++ = '"';
+        break;
+      case '\\':
+        *out++ = '\\';
+        break;
+      case '/':
+        *out++ = '/';
+        break;
+      case 'b':
+        *out++ = '\b';
+        break;
+      case 'f':
+        *out++ = '\f';
+        break;
+      case 'n':
+        *out++ = '\n';
+        break;
+      case 'r':
+        *out++ = '\r';
+        break;
+      case 't':
+        *out++ = '\t';
+        break;
+
+      case 'u': {
+        int32_t code_point = ParseHex4(p, end);
+        if (code_point < 0) {
+          return false;
+        }
+        p += 4;
+
+        // Surrogate pairs are joined, while the lone surrogates can't be
+        // encoded in UTF-8, so are replaced.
+        if (code_point >= 0xD800 && code_point <= 0xDBFF && end - p >= 6 &&
+            p[0] == '\\' && p[1] == 'u') {
+          int32_t low = ParseHex4(p + 2, end);
+          if (low >= 0xDC00 && low <= 0xDFFF) {
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                         (low - 0xDC00);
+            p += 6;
+          }
+        }
+        if (code_point >= 0xD800 && code_point <= 0xDFFF) {
+          code_point = 0xFFFD;
+        }
+
+        out = WriteUtf8(code_point, out);
+        break;
+      }
+
+      default:
+        return false;
+    }
+  }
+
+  // Escapes are decoded into valid UTF-8, so the whole string is validated.
+  if (high != 0 && !IsValidUtf8(start, out - start)) {
+    return false;
+  }
+
+  AppendNode(JsonTapeType::kString, out - start, strings_size_);
+  strings_size_ += out - start;
+  return true;
+}
+
+bool TapeBuilder::ParseScalar(size_t position, size_t end) {
+  // Scalar is followed by the whitespace only till the next structural.
+  const char* token = reinterpret_cast<const char*>(data_ + position);
+  size_t length = 0;
+  while (position + length < end && token[length] != ' ' &&
+         token[length] != '\t' && token[length] != '\n' &&
+         token[length] != '\r') {
+    ++length;
+  }
+
+  if (length == 4 && memcmp(token, "null", 4) == 0) {
+    AppendNode(JsonTapeType::kNull, 0, 0);
+    return true;
+  }
+  if (length == 4 && memcmp(token, "true", 4) == 0) {
+    AppendNode(JsonTapeType::kTrue, 0, 0);
+    return true;
+  }
+  if (length == 5 && memcmp(token, "false", 5) == 0) {
+    AppendNode(JsonTapeType::kFalse, 0, 0);
+    return true;
+  }
+
+  const char* p = token;
+  const char* token_end = token + length;
+  bool negative = p < token_end && *p == '-';
+  if (negative) {
+    ++p;
+  }
+
+  // Integer part is accumulated, while it fits.
+  uint64_t magnitude = 0;
+  bool overflown = false;
+  if (p < token_end && *p == '0') {
+    ++p;
+  } else if (p < token_end && *p >= '1' && *p <= '9') {
+    while (p < token_end && *p >= '0' && *p <= '9') {
+      uint64_t digit = *p++ - '0';
+      if (magnitude > (UINT64_MAX - digit) / 10) {
+        overflown = true;
+      } else {
+        magnitude = magnitude * 10 + digit;
+      }
+    }
+  } else {
+    return false;
+  }
+
+  bool integer = true;
+  if (p < token_end && *p == '.') {
+    integer = false;
+    if (++p == token_end || *p < '0' || *p > '9') {
+      return false;
+    }
+    while (p < token_end && *p >= '0' && *p <= '9') {
+      ++p;
+    }
+  }
+
+  if (p < token_end && (*p == 'e' || *p == 'E')) {
+    integer = false;
+    if (++p < token_end && (*p == '+' || *p == '-')) {
+      ++p;
+    }
+    if (p == token_end || *p < '0' || *p > '9') {
+      return false;
+    }
+    while (p < token_end && *p >= '0' && *p <= '9') {
+      ++p;
+    }
+  }
+
+  if (p != token_end) {
+    return false;
+  }
+
+  // Negative zero is a double, as decoded by the `jsonDecode()`.
+  uint64_t limit = negative ? uint64_t{1} << 63 : (uint64_t{1} << 63) - 1;
+  if (integer && !overflown && magnitude <= limit &&
+      !(negative && magnitude == 0)) {
+    AppendNode(JsonTapeType::kInt, 0,
+               negative ? 0 - magnitude : magnitude);
+    return true;
+  }
+
+  // Numbers are always formatted with a dot, regardless of the locale the
+  // application is running in.
+  static const locale_t c_locale =
+      newlocale(LC_NUMERIC_MASK, "C", static_cast<locale_t>(0));
+  std::string copy(token, length);
+  double value = strtod_l(copy.c_str(), nullptr, c_locale);
+
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  AppendNode(JsonTapeType::kDouble, 0, bits);
+  return true;
+}
+
+void TapeBuilder::Write(std::string* out) const {
+  uint32_t header[2] = {static_cast<uint32_t>(nodes_.size()),
+                        static_cast<uint32_t>(strings_size_)};
+  size_t nodes_size = nodes_.size() * sizeof(JsonTapeNode);
+
+  out->resize(sizeof(header) + nodes_size + strings_size_);
+  char* data = &(*out)[0];
+  memcpy(data, header, sizeof(header));
+  if (nodes_size != 0) {
+    memcpy(data + sizeof(header), nodes_.data(), nodes_size);
+  }
+  if (strings_size_ != 0) {
+    memcpy(data + sizeof(header) + nodes_size, strings_.get(), strings_size_);
+  }
+}
+
+JsonIndexKernel JsonIndexDefaultKernel() {
+#ifdef JSON_TAPE_X86
+  static const JsonIndexKernel kernel =
+      CpuSupports("avx2")
+          ? JsonIndexKernel::kAvx2
+          : (CpuSupports("sse2") ? JsonIndexKernel::kSse2
+                                 : JsonIndexKernel::kScalar);
+  return kernel;
+#else
+  return JsonIndexKernel::kScalar;
+#endif
+}
+
+const char* JsonIndexKernelName(JsonIndexKernel kernel) {
+  switch (kernel) {
+    case JsonIndexKernel::kScalar:
+      return "scalar";
+    case JsonIndexKernel::kSse2:
+      return "sse2";
+    case JsonIndexKernel::kAvx2:
+      return "avx2";
+  }
+
+  return "unknown";
+}
+
+bool ParseJsonTape(const char* data,
+                   size_t size,
+                   std::string* out,
+                   JsonIndexKernel kernel) {
+  static_assert(sizeof(JsonTapeNode) == 16, "Nodes must be 16 bytes long");
+
+  // Positions are indexed as 32-bit.
+  if (size >= UINT32_MAX - kBlockSize) {
+    return false;
+  }
+
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+
+  // Each byte is indexed at most once.
+  std::unique_ptr<uint32_t[]> indexes(new uint32_t[size + kBlockSize]);
+  IndexState state;
+  state.out = indexes.get();
+
+  size_t blocks = size / kBlockSize;
+  IndexBlocks(kernel, bytes, blocks, &state);
+
+  // Last block is padded with the whitespace.
+  size_t tail = size % kBlockSize;
+  if (tail != 0) {
+    uint8_t block[kBlockSize];
+    memset(block, ' ', sizeof(block));
+    memcpy(block, bytes + blocks * kBlockSize, tail);
+    IndexBlocks(kernel, block, 1, &state);
+  }
+
+  if (state.in_string != 0) {
+    return false;
+  }
+
+  TapeBuilder builder(bytes, size);
+  if (!builder.Build(indexes.get(), state.out - indexes.get())) {
+    return false;
+  }
+
+  builder.Write(out);
+  return true;
+}
@@ -0,0 +1,77 @@
+#ifndef RUNNER_JSON_TAPE_H_
+#define RUNNER_JSON_TAPE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+// Implementation of the structural indexing of the JSON documents.
+enum class JsonIndexKernel {
+  // Portable C++ implementation, classifying a byte at a time.
+  kScalar,
+
+  // SSE2 implementation, classifying 16 bytes at a time.
+  kSse2,
+
+  // AVX2 implementation, classifying 32 bytes at a time.
+  kAvx2,
+};
+
+// Returns the fastest JsonIndexKernel supported by the current CPU.
+JsonIndexKernel JsonIndexDefaultKernel();
+
+// Returns the human-readable name of the |kernel|.
+const char* JsonIndexKernelName(JsonIndexKernel kernel);
+
+// Types of the nodes of a JSON tape.
+enum class JsonTapeType : uint8_t {
+  kNull = 0,
+  kFalse = 1,
+  kTrue = 2,
+
+  // Integer fitting into 64 bits.
+  kInt = 3,
+
+  // Number with a fraction or an exponent, or too large for a kInt.
+  kDouble = 4,
+
+  kString = 5,
+  kArray = 6,
+  kObject = 7,
+};
+
+// Node of a JSON tape, laid out as stored.
+struct JsonTapeNode {
+  JsonTapeType type;
+  uint8_t reserved[3];
+
+  // Byte length of a kString, or the number of the elements of a kArray or
+  // of the members of a kObject.
+  uint32_t length;
+
+  // Value of a kInt, bits of a kDouble, offset of a kString within the
+  // strings, or the index of the node following a kArray or a kObject with
+  // all of its descendants.
+  uint64_t value;
+};
+
+// Parses the |size| bytes of the JSON |data| into the |out| flat tape,
+// returning false, if it's malformed.
+//
+// Tape is laid out in the host byte order as the 32-bit number of the nodes
+// and the 32-bit byte length of the strings, followed by the 16-byte
+// JsonTapeNodes of the values in the document order, and then by the UTF-8
+// strings unescaped. Members of a kObject follow it as the pairs of the
+// kString key and its value, while elements of a kArray follow it as is, so
+// any value may be read or skipped without touching the rest of the tape.
+//
+// Structural characters are indexed in 64-byte blocks with the |kernel|,
+// and then the tape is built from them in a single pass, as done by the
+// simdjson library.
+bool ParseJsonTape(const char* data,
+                   size_t size,
+                   std::string* out,
+                   JsonIndexKernel kernel = JsonIndexDefaultKernel());
+
+#endif  // RUNNER_JSON_TAPE_H_
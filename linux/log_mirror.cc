@@ -0,0 +1,300 @@
+#include "log_mirror.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// Capacity requested for the mirroring pipes, so that bursts of output are
+// moved in large spans instead of 64 KiB default ones.
+static const int kPipeCapacity = 1 << 20;
+
+// Size of the buffer used when splicing isn't supported.
+static const size_t kCopyBufferSize = 64 * 1024;
+
+// Destination the mirrored data is written into.
+struct MirrorSink {
+  int fd;
+
+  // Indicator whether `splice(2)` should be tried for this sink.
+  bool splice;
+
+  // Indicator whether writing into this sink has failed, so the data should
+  // only be consumed and dropped.
+  bool broken;
+};
+
+struct LogMirror {
+  // Mirrored descriptor and the duplicate of its original stream.
+  int target_fd;
+
+  pthread_t thread;
+
+  // Read end of the pipe the mirrored descriptor is redirected into.
+  int pipe_read_end;
+
+  // Intermediate pipe `tee(2)` duplicates the data into, or `-1` if there's
+  // none and the copy loop should be used.
+  int tee_read_end;
+  int tee_write_end;
+
+  // File the data is mirrored into, with |log_sink| pointing to its
+  // descriptor while it's acquired.
+  RotatingLogFile* log_file;
+  MirrorSink log_sink;
+
+  // Sink of the original stream, which owns the duplicate of it.
+  MirrorSink original;
+};
+
+// Locks the log file for writing a span into it.
+static MirrorSink* acquire_log_sink(LogMirror* ctx) {
+  ctx->log_sink.fd = ctx->log_file->Acquire();
+
+  // Failures are retried on each span, as they may be temporary (e.g. the
+  // disk being full), or resolved by the rotation.
+  ctx->log_sink.broken = false;
+
+  return &ctx->log_sink;
+}
+
+static void set_pipe_capacity(int fd) {
+  // Failure is fine here, the default capacity just makes spans smaller.
+  fcntl(fd, F_SETPIPE_SZ, kPipeCapacity);
+}
+
+static bool write_all(int fd, const char* data, size_t length) {
+  while (length > 0) {
+    ssize_t written = write(fd, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+
+    data += written;
+    length -= written;
+  }
+
+  return true;
+}
+
+// Moves exactly `length` bytes from the `pipe_fd` into the `sink`, splicing
+// them when possible, and copying through user space otherwise.
+//
+// Returns `false` only if `pipe_fd` itself can no longer be read.
+static bool drain(int pipe_fd, MirrorSink* sink, size_t length) {
+  char buffer[kCopyBufferSize];
+
+  while (length > 0) {
+    if (sink->splice && !sink->broken) {
+      ssize_t moved =
+          splice(pipe_fd, nullptr, sink->fd, nullptr, length, SPLICE_F_MOVE);
+      if (moved > 0) {
+        length -= moved;
+        continue;
+      }
+
+      if (moved < 0 && errno == EINTR) {
+        continue;
+      }
+
+      // Either the sink doesn't support splicing (e.g. terminals or files
+      // opened with `O_APPEND`), or writing into it failed: let the copy
+      // path below decide which one it is.
+      sink->splice = false;
+    }
+
+    size_t chunk = length < sizeof(buffer) ? length : sizeof(buffer);
+    ssize_t bytes_read = read(pipe_fd, buffer, chunk);
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes_read <= 0) {
+      return false;
+    }
+
+    if (!sink->broken && !write_all(sink->fd, buffer, bytes_read)) {
+      sink->broken = true;
+    }
+
+    length -= bytes_read;
+  }
+
+  return true;
+}
+
+// Mirrors the data by copying it through user space, used when `tee(2)` isn't
+// available.
+static void copy_loop(LogMirror* ctx) {
+  char buffer[kCopyBufferSize];
+
+  while (true) {
+    ssize_t bytes_read = read(ctx->pipe_read_end, buffer, sizeof(buffer));
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes_read <= 0) {
+      break;
+    }
+
+    MirrorSink* log_sink = acquire_log_sink(ctx);
+    if (!write_all(log_sink->fd, buffer, bytes_read)) {
+      log_sink->broken = true;
+    }
+    ctx->log_file->Release(bytes_read);
+
+    if (!ctx->original.broken &&
+        !write_all(ctx->original.fd, buffer, bytes_read)) {
+      ctx->original.broken = true;
+    }
+  }
+}
+
+// Mirrors the data by duplicating it into the intermediate pipe with `tee(2)`
+// and then splicing both copies out, so it never leaves the kernel.
+//
+// Returns `false` if `tee(2)` isn't supported, so the copy loop should be used
+// instead.
+static bool tee_loop(LogMirror* ctx) {
+  while (true) {
+    ssize_t length = tee(ctx->pipe_read_end, ctx->tee_write_end,
+                         kPipeCapacity, 0);
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return errno != EINVAL && errno != ENOSYS;
+    }
+
+    // All the writers are closed.
+    if (length == 0) {
+      return true;
+    }
+
+    // Write to log file.
+    bool drained = drain(ctx->pipe_read_end, acquire_log_sink(ctx), length);
+    ctx->log_file->Release(length);
+    if (!drained) {
+      return true;
+    }
+
+    // Write back to original stream (stdout or stderr).
+    if (!drain(ctx->tee_read_end, &ctx->original, length)) {
+      return true;
+    }
+  }
+}
+
+static void* mirror_thread(void* arg) {
+  LogMirror* ctx = static_cast<LogMirror*>(arg);
+  pthread_setname_np(pthread_self(), "tee_thread");
+
+  if (ctx->tee_read_end < 0 || !tee_loop(ctx)) {
+    copy_loop(ctx);
+  }
+
+  return nullptr;
+}
+
+// Closes the descriptors of the |ctx| and frees it.
+static void destroy_mirror(LogMirror* ctx) {
+  close(ctx->original.fd);
+  close(ctx->pipe_read_end);
+  if (ctx->tee_read_end >= 0) {
+    close(ctx->tee_read_end);
+    close(ctx->tee_write_end);
+  }
+  delete ctx;
+}
+
+LogMirror* log_mirror_start(int target_fd, RotatingLogFile* log_file) {
+  int pipe_fds[2];
+  if (pipe2(pipe_fds, O_CLOEXEC) != 0) {
+    return nullptr;
+  }
+
+  int pipe_read_end = pipe_fds[0];
+  int pipe_write_end = pipe_fds[1];
+  set_pipe_capacity(pipe_write_end);
+
+  // Preserve original stream FD.
+  int original_fd = fcntl(target_fd, F_DUPFD_CLOEXEC, 0);
+  if (original_fd < 0) {
+    int error = errno;
+    close(pipe_read_end);
+    close(pipe_write_end);
+    errno = error;
+    return nullptr;
+  }
+
+  // The intermediate pipe is optional, as the copy loop works without it.
+  int tee_fds[2] = {-1, -1};
+  if (pipe2(tee_fds, O_CLOEXEC) == 0) {
+    set_pipe_capacity(tee_fds[1]);
+
+    // `tee(2)` may only duplicate as much as the intermediate pipe fits.
+    if (fcntl(tee_fds[1], F_GETPIPE_SZ) < fcntl(pipe_write_end,
+                                                F_GETPIPE_SZ)) {
+      close(tee_fds[0]);
+      close(tee_fds[1]);
+      tee_fds[0] = tee_fds[1] = -1;
+    }
+  }
+
+  LogMirror* ctx = new LogMirror{
+      target_fd,
+      pthread_t(),
+      pipe_read_end,
+      tee_fds[0],
+      tee_fds[1],
+      log_file,
+      MirrorSink{-1, true, false},
+      MirrorSink{original_fd, true, false},
+  };
+
+  // Spawn background mirror thread before redirecting, so that nothing is
+  // written into the pipe nobody is going to read.
+  int error = pthread_create(&ctx->thread, nullptr, mirror_thread, ctx);
+  if (error != 0) {
+    close(pipe_write_end);
+    destroy_mirror(ctx);
+    errno = error;
+    return nullptr;
+  }
+
+  // Redirect target FD into pipe.
+  if (dup2(pipe_write_end, target_fd) < 0) {
+    error = errno;
+
+    // The thread stops once the last write end of the pipe is closed.
+    close(pipe_write_end);
+    pthread_join(ctx->thread, nullptr);
+    destroy_mirror(ctx);
+    errno = error;
+    return nullptr;
+  }
+  close(pipe_write_end);
+
+  // Disable buffering so output appears immediately.
+  if (target_fd == STDOUT_FILENO) {
+    setbuf(stdout, nullptr);
+  } else if (target_fd == STDERR_FILENO) {
+    setbuf(stderr, nullptr);
+  }
+
+  return ctx;
+}
+
+void log_mirror_stop(LogMirror* mirror) {
+  // Replacing the write end of the pipe with the original stream closes it,
+  // so the thread drains the pipe and stops.
+  dup2(mirror->original.fd, mirror->target_fd);
+  pthread_join(mirror->thread, nullptr);
+  destroy_mirror(mirror);
+}
@@ -0,0 +1,36 @@
+#ifndef RUNNER_LOG_MIRROR_H_
+#define RUNNER_LOG_MIRROR_H_
+
+#include "rotating_log_file.h"
+
+// Mirror of a descriptor started by log_mirror_start().
+struct LogMirror;
+
+/**
+ * log_mirror_start:
+ * @target_fd: descriptor to mirror, e.g. `STDOUT_FILENO`.
+ * @log_file: #RotatingLogFile everything should be mirrored into.
+ *
+ * Redirects @target_fd into a pipe and spawns a thread writing everything
+ * from it into both @log_file and the original stream.
+ *
+ * Data is moved with `tee(2)`/`splice(2)`, so it never leaves the kernel,
+ * and falls back to a user-space copy loop for the descriptors not
+ * supporting splicing (e.g. terminals).
+ *
+ * Returns: #LogMirror running until log_mirror_stop(), or `nullptr` with
+ * `errno` set, leaving @target_fd untouched.
+ */
+LogMirror* log_mirror_start(int target_fd, RotatingLogFile* log_file);
+
+/**
+ * log_mirror_stop:
+ * @mirror: #LogMirror to stop.
+ *
+ * Restores the original stream of the mirrored descriptor and waits for the
+ * thread to mirror what was already written, so the #RotatingLogFile may be
+ * deleted afterwards.
+ */
+void log_mirror_stop(LogMirror* mirror);
+
+#endif  // RUNNER_LOG_MIRROR_H_
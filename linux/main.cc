@@ -1,6 +1,11 @@
 #include "my_application.h"
+#include "startup_prefetch.h"
+#include "startup_trace.h"
 
 int main(int argc, char** argv) {
+  StartupTrace::Shared()->Configure(&argc, argv);
+  StartStartupPrefetch();
+
   g_autoptr(MyApplication) app = my_application_new();
   return g_application_run(G_APPLICATION(app), argc, argv);
 }
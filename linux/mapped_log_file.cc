@@ -0,0 +1,226 @@
+#include "mapped_log_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+
+// Address space reserved for the mapping. The file is started over once it
+// grows beyond it.
+static const off_t kReservation = 256 * 1024 * 1024;
+
+// Step the pre-allocated region grows with.
+static const off_t kGrowth = 4 * 1024 * 1024;
+
+// Interval the background thread flushes the written data with.
+static const std::chrono::seconds kFlushInterval(1);
+
+// Returns the size of the |fd| file without the trailing zeros left by the
+// pre-allocation, as logs never contain them.
+static off_t WrittenSize(int fd, off_t size) {
+  char buffer[64 * 1024];
+
+  while (size > 0) {
+    off_t offset = size > static_cast<off_t>(sizeof(buffer))
+                       ? size - static_cast<off_t>(sizeof(buffer))
+                       : 0;
+
+    ssize_t bytes_read = pread(fd, buffer, size - offset, offset);
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes_read <= 0) {
+      break;
+    }
+
+    for (ssize_t i = bytes_read - 1; i >= 0; --i) {
+      if (buffer[i] != '\0') {
+        return offset + i + 1;
+      }
+    }
+
+    size = offset;
+  }
+
+  return 0;
+}
+
+MappedLogFile* MappedLogFile::Open(const char* path, off_t truncate_at) {
+  int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int error = errno;
+    close(fd);
+    errno = error;
+    return nullptr;
+  }
+
+  off_t size = WrittenSize(fd, st.st_size);
+  if (size >= truncate_at || size >= kReservation - kGrowth) {
+    size = 0;
+  }
+
+  // Drop the zeros left by a previous session, if any.
+  if (size != st.st_size && ftruncate(fd, size) != 0) {
+    int error = errno;
+    close(fd);
+    errno = error;
+    return nullptr;
+  }
+
+  void* base = mmap(nullptr, kReservation, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED) {
+    int error = errno;
+    close(fd);
+    errno = error;
+    return nullptr;
+  }
+
+  MappedLogFile* file = new MappedLogFile(fd, static_cast<char*>(base));
+
+  std::lock_guard<std::mutex> lock(file->mutex_);
+  file->size_ = size;
+  file->capacity_ = size;
+
+  return file;
+}
+
+MappedLogFile::MappedLogFile(int fd, char* base) : fd_(fd), base_(base) {
+  thread_ = std::thread(&MappedLogFile::Run, this);
+}
+
+MappedLogFile::~MappedLogFile() {
+  {
+    std::lock_guard<std::mutex> lock(flush_mutex_);
+    closing_ = true;
+  }
+  closing_changed_.notify_one();
+  thread_.join();
+
+  Flush();
+
+  munmap(base_, kReservation);
+  close(fd_);
+}
+
+bool MappedLogFile::Append(const char* data, size_t length) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (size_ + static_cast<off_t>(length) > kReservation) {
+    // Start over, the same way Open() does for the large files.
+    if (ftruncate(fd_, 0) != 0) {
+      return false;
+    }
+
+    size_ = capacity_ = 0;
+    dirty_from_ = dirty_to_ = 0;
+
+    if (static_cast<off_t>(length) > kReservation) {
+      errno = EFBIG;
+      return false;
+    }
+  }
+
+  if (!Reserve(size_ + length)) {
+    return false;
+  }
+
+  memcpy(base_ + size_, data, length);
+
+  if (dirty_from_ == dirty_to_) {
+    dirty_from_ = size_;
+  }
+  size_ += length;
+  dirty_to_ = size_;
+
+  return true;
+}
+
+off_t MappedLogFile::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (size_ > 0) {
+    msync(base_, size_, MS_SYNC);
+  }
+
+  // The mapping beyond the new end of the file is never touched until the
+  // file is grown back by Reserve().
+  if (capacity_ != size_ && ftruncate(fd_, size_) == 0) {
+    capacity_ = size_;
+  }
+
+  dirty_from_ = dirty_to_ = 0;
+
+  return size_;
+}
+
+off_t MappedLogFile::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+bool MappedLogFile::Reserve(off_t required) {
+  if (required <= capacity_) {
+    return true;
+  }
+
+  off_t capacity = (required + kGrowth - 1) / kGrowth * kGrowth;
+  if (capacity > kReservation) {
+    capacity = kReservation;
+  }
+
+  // Allocate the blocks upfront, so running out of space is reported here
+  // instead of as a SIGBUS while writing into the mapping.
+  int error = posix_fallocate(fd_, capacity_, capacity - capacity_);
+  if (error == EOPNOTSUPP || error == EINVAL) {
+    error = ftruncate(fd_, capacity) == 0 ? 0 : errno;
+  }
+
+  if (error != 0) {
+    errno = error;
+    return false;
+  }
+
+  // Replaces the previous mapping in place, so |base_| stays the same.
+  void* mapped = mmap(base_, capacity, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_FIXED, fd_, 0);
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+
+  capacity_ = capacity;
+  return true;
+}
+
+void MappedLogFile::Run() {
+  const off_t page_size = sysconf(_SC_PAGESIZE);
+
+  std::unique_lock<std::mutex> flush_lock(flush_mutex_);
+  while (!closing_changed_.wait_for(flush_lock, kFlushInterval,
+                                    [this] { return closing_; })) {
+    off_t from, to;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      from = dirty_from_;
+      to = dirty_to_;
+      dirty_from_ = dirty_to_ = 0;
+    }
+
+    if (from == to) {
+      continue;
+    }
+
+    from = from / page_size * page_size;
+    msync(base_ + from, to - from, MS_SYNC);
+  }
+}
@@ -0,0 +1,71 @@
+#ifndef RUNNER_MAPPED_LOG_FILE_H_
+#define RUNNER_MAPPED_LOG_FILE_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// An append-only log file written through a shared memory mapping of a
+// pre-allocated region, so appending a batch is a single memcpy().
+//
+// The mapped pages are flushed to the disk with msync() by a background
+// thread on a timer. Pre-allocated, but not yet written, tail of the file is
+// filled with zeros, which is trimmed by Flush() and Close(), and recovered
+// from on the next Open() if the application wasn't closed cleanly.
+class MappedLogFile {
+ public:
+  // Opens the log file at |path| for appending, truncating it if its size is
+  // exceeding |truncate_at| bytes. Returns nullptr with errno set on failure.
+  static MappedLogFile* Open(const char* path, off_t truncate_at);
+
+  ~MappedLogFile();
+
+  MappedLogFile(const MappedLogFile&) = delete;
+  MappedLogFile& operator=(const MappedLogFile&) = delete;
+
+  // Appends the |length| bytes of |data| to the file. Returns false with errno
+  // set if the file can't be grown.
+  bool Append(const char* data, size_t length);
+
+  // Synchronously flushes the written data and trims the pre-allocated tail,
+  // so the file can be read as is. Returns the size of the file.
+  off_t Flush();
+
+  // Returns the size of the written data.
+  off_t size();
+
+ private:
+  MappedLogFile(int fd, char* base);
+
+  // Grows the pre-allocated region to fit at least |required| bytes.
+  //
+  // Must be called with |mutex_| held.
+  bool Reserve(off_t required);
+
+  // Body of the background thread msync()-ing the written data.
+  void Run();
+
+  const int fd_;
+
+  // Start of the reserved address range the file is mapped into. Never moves,
+  // so the background thread may msync() it without holding |mutex_|.
+  char* const base_;
+
+  std::mutex mutex_;
+  off_t size_ = 0;
+  off_t capacity_ = 0;
+
+  // Range of the written data not yet flushed by the background thread.
+  off_t dirty_from_ = 0;
+  off_t dirty_to_ = 0;
+
+  std::mutex flush_mutex_;
+  std::condition_variable closing_changed_;
+  bool closing_ = false;
+  std::thread thread_;
+};
+
+#endif  // RUNNER_MAPPED_LOG_FILE_H_
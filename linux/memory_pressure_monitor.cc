@@ -0,0 +1,305 @@
+#include "memory_pressure_monitor.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+using Clock = std::chrono::steady_clock;
+
+// Stalls within the PSI window raising the moderate and critical pressure, in
+// microseconds.
+static const int64_t kModerateStall = 150000;
+static const int64_t kCriticalStall = 100000;
+
+// PSI tracking window, in microseconds. Unprivileged users are only allowed
+// to create triggers with the windows being multiples of two seconds.
+static const int64_t kWindow = 2000000;
+
+// Time the pressure is held for after its last event.
+static const std::chrono::seconds kHold(10);
+
+// Number of the MemoryPressure levels.
+static const int kLevels = static_cast<int>(MemoryPressure::kCritical) + 1;
+
+// Returns the directory of the cgroup v2 the process belongs to, or an empty
+// string, if there is none, e.g. on the cgroup v1 only systems.
+static std::string CgroupDirectory() {
+  std::string group;
+  std::ifstream cgroup("/proc/self/cgroup");
+  for (std::string line; std::getline(cgroup, line);) {
+    if (line.compare(0, 3, "0::") == 0) {
+      group = line.substr(3);
+      break;
+    }
+  }
+
+  // Root cgroup has no `memory.events`.
+  if (group.empty() || group == "/") {
+    return std::string();
+  }
+
+  // Mount point is the 5th field, while the filesystem type follows the `-`
+  // separator after the optional fields.
+  std::ifstream mounts("/proc/self/mountinfo");
+  for (std::string line; std::getline(mounts, line);) {
+    size_t separator = line.find(" - ");
+    if (separator == std::string::npos ||
+        line.compare(separator + 3, 8, "cgroup2 ") != 0) {
+      continue;
+    }
+
+    std::istringstream fields(line.substr(0, separator));
+    std::string field;
+    std::string root;
+    std::string mount_point;
+    for (int i = 0; i < 5 && fields >> field; ++i) {
+      if (i == 3) {
+        root = field;
+      } else if (i == 4) {
+        mount_point = field;
+      }
+    }
+
+    if (root == "/") {
+      return mount_point + group;
+    }
+  }
+
+  return std::string();
+}
+
+const char* MemoryPressureName(MemoryPressure pressure) {
+  switch (pressure) {
+    case MemoryPressure::kNone:
+      break;
+    case MemoryPressure::kModerate:
+      return "moderate";
+    case MemoryPressure::kCritical:
+      return "critical";
+  }
+  return "none";
+}
+
+MemoryPressureMonitor::MemoryPressureMonitor(Callback callback)
+    : callback_(std::move(callback)) {}
+
+MemoryPressureMonitor::~MemoryPressureMonitor() {
+  if (thread_.joinable()) {
+    uint64_t value = 1;
+    if (write(wake_, &value, sizeof(value)) != sizeof(value)) {
+      perror("write");
+    }
+    thread_.join();
+  }
+
+  for (int fd : {some_, full_, events_, wake_}) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+}
+
+bool MemoryPressureMonitor::Start() {
+  std::string cgroup = CgroupDirectory();
+
+  // System-wide pressure is preferred, as it's what the OOM killer acts on.
+  source_ = "psi";
+  some_ = CreateTrigger("/proc/pressure/memory", "some", kModerateStall);
+  full_ = CreateTrigger("/proc/pressure/memory", "full", kCriticalStall);
+  if (some_ == -1 && full_ == -1 && !cgroup.empty()) {
+    source_ = "cgroup psi";
+    some_ = CreateTrigger(cgroup + "/memory.pressure", "some", kModerateStall);
+    full_ = CreateTrigger(cgroup + "/memory.pressure", "full", kCriticalStall);
+  }
+
+  std::string events = cgroup + "/memory.events";
+  if (!cgroup.empty() && access(events.c_str(), R_OK) == 0) {
+    events_path_ = events;
+    events_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (events_ != -1 &&
+        inotify_add_watch(events_, events_path_.c_str(), IN_MODIFY) == -1) {
+      close(events_);
+      events_ = -1;
+    }
+
+    // Only the growth of the counters since the start is reported.
+    std::string reason;
+    ReadEvents(&reason);
+  }
+
+  if (some_ == -1 && full_ == -1 && events_ == -1) {
+    return false;
+  }
+
+  wake_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wake_ == -1) {
+    return false;
+  }
+
+  thread_ = std::thread(&MemoryPressureMonitor::Run, this);
+  return true;
+}
+
+void MemoryPressureMonitor::Run() {
+  pthread_setname_np(pthread_self(), "memory_pressure");
+
+  // Times of the last events of each level, and their reasons.
+  Clock::time_point last[kLevels];
+  std::string reasons[kLevels];
+  std::fill(last, last + kLevels, Clock::now() - kHold);
+
+  MemoryPressure reported = MemoryPressure::kNone;
+  Clock::time_point reported_at;
+
+  while (true) {
+    Clock::time_point now = Clock::now();
+
+    // Sleeps until the most severe pressure held is released.
+    int timeout = -1;
+    for (int i = kLevels - 1; i > 0; --i) {
+      if (now - last[i] < kHold) {
+        timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      last[i] + kHold - now)
+                      .count() +
+                  1;
+        break;
+      }
+    }
+
+    struct pollfd fds[] = {
+        {wake_, POLLIN, 0},
+        {some_, POLLPRI, 0},
+        {full_, POLLPRI, 0},
+        {events_, POLLIN, 0},
+    };
+    if (poll(fds, 4, timeout) == -1 && errno != EINTR) {
+      perror("poll");
+      return;
+    }
+
+    if (fds[0].revents != 0) {
+      return;
+    }
+
+    now = Clock::now();
+    MemoryPressure raised = MemoryPressure::kNone;
+    std::string reason;
+
+    // `POLLERR` means the trigger is gone along with its cgroup.
+    for (int i : {1, 2}) {
+      if (fds[i].revents & POLLERR) {
+        close(fds[i].fd);
+        (i == 1 ? some_ : full_) = -1;
+      } else if (fds[i].revents & POLLPRI) {
+        raised = i == 1 ? MemoryPressure::kModerate : MemoryPressure::kCritical;
+        reason = source_ + (i == 1 ? " some" : " full");
+      }
+    }
+
+    if (fds[3].revents & POLLIN) {
+      char buffer[4096];
+      while (read(events_, buffer, sizeof(buffer)) > 0) {
+      }
+
+      std::string cgroup_reason;
+      MemoryPressure cgroup = ReadEvents(&cgroup_reason);
+      if (cgroup > raised) {
+        raised = cgroup;
+        reason = cgroup_reason;
+      }
+    }
+
+    if (raised != MemoryPressure::kNone) {
+      last[static_cast<int>(raised)] = now;
+      reasons[static_cast<int>(raised)] = reason;
+    }
+
+    MemoryPressure held = MemoryPressure::kNone;
+    for (int i = kLevels - 1; i > 0; --i) {
+      if (now - last[i] < kHold) {
+        held = static_cast<MemoryPressure>(i);
+        break;
+      }
+    }
+
+    // Lasting pressure is reported again once it's held for long enough.
+    if (held != reported ||
+        (held != MemoryPressure::kNone && raised == held &&
+         now - reported_at >= kHold)) {
+      reported = held;
+      reported_at = now;
+      callback_(held, held == MemoryPressure::kNone
+                          ? std::string()
+                          : reasons[static_cast<int>(held)]);
+    }
+  }
+}
+
+int MemoryPressureMonitor::CreateTrigger(const std::string& path,
+                                         const char* kind,
+                                         int64_t stall) {
+  int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd == -1) {
+    return -1;
+  }
+
+  char trigger[64];
+  int length = snprintf(trigger, sizeof(trigger), "%s %lld %lld", kind,
+                        static_cast<long long>(stall),
+                        static_cast<long long>(kWindow));
+
+  // Written with the terminating null, as the kernel expects.
+  if (write(fd, trigger, length + 1) == -1) {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+MemoryPressure MemoryPressureMonitor::ReadEvents(std::string* reason) {
+  int64_t high = high_;
+  int64_t max = max_;
+  int64_t oom = 0;
+
+  std::ifstream events(events_path_);
+  std::string key;
+  int64_t value;
+  while (events >> key >> value) {
+    if (key == "high") {
+      high = value;
+    } else if (key == "max") {
+      max = value;
+    } else if (key == "oom" || key == "oom_kill") {
+      oom += value;
+    }
+  }
+
+  MemoryPressure pressure = MemoryPressure::kNone;
+  if (oom > oom_) {
+    pressure = MemoryPressure::kCritical;
+    *reason = "cgroup oom";
+  } else if (max > max_) {
+    pressure = MemoryPressure::kCritical;
+    *reason = "cgroup max";
+  } else if (high > high_) {
+    pressure = MemoryPressure::kModerate;
+    *reason = "cgroup high";
+  }
+
+  high_ = high;
+  max_ = max;
+  oom_ = std::max(oom, oom_);
+  return pressure;
+}
@@ -0,0 +1,99 @@
+#ifndef RUNNER_MEMORY_PRESSURE_MONITOR_H_
+#define RUNNER_MEMORY_PRESSURE_MONITOR_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <thread>
+
+// Graded memory pressure, ordered by severity.
+enum class MemoryPressure {
+  // Memory is reclaimed without stalling the tasks.
+  kNone,
+
+  // Tasks are stalled on the reclaim now and then, or the cgroup exceeds its
+  // `memory.high`, so the caches that are cheap to restore should be dropped.
+  kModerate,
+
+  // Every task is stalled on the reclaim, or the cgroup hits its `memory.max`
+  // or the OOM killer, so everything that can be restored should be dropped.
+  kCritical,
+};
+
+// Returns the name of the |pressure|: `none`, `moderate` or `critical`.
+const char* MemoryPressureName(MemoryPressure pressure);
+
+// Watches the memory pressure on its own thread, reporting its changes.
+//
+// The pressure is detected by the PSI triggers of the `/proc/pressure/memory`
+// or, if those can't be created by the user, of the `memory.pressure` of the
+// process's cgroup, and by the `high`, `max`, `oom` and `oom_kill` counters
+// of the cgroup v2 `memory.events`, when the memory controller is available.
+//
+// Neither of them reports the pressure going away, so the level is held for a
+// few seconds after the last event, while the reclaim is usually still going.
+class MemoryPressureMonitor {
+ public:
+  // Invoked on the monitor's thread with the new |pressure| and the |reason|
+  // of it, e.g. `psi some` or `cgroup oom_kill`. Invoked again with the same
+  // |pressure|, if it lasts longer than it's held for, so the caches filled
+  // up since are dropped as well.
+  using Callback =
+      std::function<void(MemoryPressure pressure, const std::string& reason)>;
+
+  explicit MemoryPressureMonitor(Callback callback);
+
+  // Stops the thread, if started.
+  ~MemoryPressureMonitor();
+
+  MemoryPressureMonitor(const MemoryPressureMonitor&) = delete;
+  MemoryPressureMonitor& operator=(const MemoryPressureMonitor&) = delete;
+
+  // Creates the triggers and starts the thread waiting on them.
+  //
+  // Returns false, if neither the PSI nor the cgroup events are available, in
+  // which case nothing is ever reported.
+  bool Start();
+
+ private:
+  // Body of the |thread_|.
+  void Run();
+
+  // Creates a PSI trigger at the |path| stalled for the |stall| microseconds
+  // of the |kind| (`some` or `full`) within a window of two seconds.
+  //
+  // Returns the file descriptor to poll for `POLLPRI`, or -1.
+  static int CreateTrigger(const std::string& path, const char* kind,
+                           int64_t stall);
+
+  // Reads the `memory.events` of the cgroup, returning the most severe
+  // pressure its counters grew by since the previous read, and the |reason|
+  // of it.
+  MemoryPressure ReadEvents(std::string* reason);
+
+  Callback callback_;
+
+  // PSI triggers of the moderate and critical pressure.
+  int some_ = -1;
+  int full_ = -1;
+
+  // Source of the PSI triggers, either `psi` or `cgroup psi`.
+  std::string source_;
+
+  // Path to the cgroup v2 `memory.events`, and the inotify watching it.
+  std::string events_path_;
+  int events_ = -1;
+
+  // Counters of the |events_path_| as of the previous read.
+  int64_t high_ = 0;
+  int64_t max_ = 0;
+  int64_t oom_ = 0;
+
+  // Wakes up the |thread_| to stop.
+  int wake_ = -1;
+
+  std::thread thread_;
+};
+
+#endif  // RUNNER_MEMORY_PRESSURE_MONITOR_H_
@@ -0,0 +1,89 @@
+#include "memory_pressure_service.h"
+
+#include <memory>
+#include <string>
+
+#include "memory_pressure_monitor.h"
+
+// Change of the pressure to report on the main thread.
+struct PressureChange {
+  MemoryPressure pressure;
+  std::string reason;
+};
+
+static FlEventChannel* pressure_channel = nullptr;
+static bool pressure_listened = false;
+
+static MemoryPressureMonitor* monitor = nullptr;
+
+// Last reported change, accessed on the main thread only.
+static PressureChange current = {MemoryPressure::kNone, std::string()};
+
+static void send_pressure() {
+  g_autoptr(FlValue) event = fl_value_new_map();
+  fl_value_set_string_take(event, "level",
+                           fl_value_new_string(
+                               MemoryPressureName(current.pressure)));
+  fl_value_set_string_take(event, "reason",
+                           fl_value_new_string(current.reason.c_str()));
+  fl_event_channel_send(pressure_channel, event, nullptr, nullptr);
+}
+
+static FlMethodErrorResponse* on_pressure_listen(FlEventChannel* channel,
+                                                 FlValue* args,
+                                                 gpointer user_data) {
+  pressure_listened = true;
+  send_pressure();
+  return nullptr;
+}
+
+static FlMethodErrorResponse* on_pressure_cancel(FlEventChannel* channel,
+                                                 FlValue* args,
+                                                 gpointer user_data) {
+  pressure_listened = false;
+  return nullptr;
+}
+
+static gboolean update_pressure(gpointer user_data) {
+  std::unique_ptr<PressureChange> change(
+      static_cast<PressureChange*>(user_data));
+
+  // Changes left after memory_pressure_service_dispose() aren't reported, as
+  // the engine is gone.
+  if (pressure_channel == nullptr) {
+    return G_SOURCE_REMOVE;
+  }
+
+  current = *change;
+  if (pressure_listened) {
+    send_pressure();
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+void memory_pressure_service_init(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  pressure_channel = fl_event_channel_new(
+      messenger, "team113.flutter.dev/linux_utils/memory_pressure",
+      FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(pressure_channel, on_pressure_listen,
+                                       on_pressure_cancel, nullptr, nullptr);
+
+  monitor = new MemoryPressureMonitor(
+      [](MemoryPressure pressure, const std::string& reason) {
+        g_idle_add(update_pressure, new PressureChange{pressure, reason});
+      });
+  if (!monitor->Start()) {
+    g_warning("Failed to monitor memory pressure: no PSI nor cgroup v2");
+  }
+}
+
+void memory_pressure_service_dispose() {
+  delete monitor;
+  monitor = nullptr;
+
+  g_clear_object(&pressure_channel);
+  pressure_listened = false;
+  current = {MemoryPressure::kNone, std::string()};
+}
@@ -0,0 +1,29 @@
+#ifndef RUNNER_MEMORY_PRESSURE_SERVICE_H_
+#define RUNNER_MEMORY_PRESSURE_SERVICE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * memory_pressure_service_init:
+ * @messenger: #FlBinaryMessenger to create the pressure event channel on.
+ *
+ * Starts a #MemoryPressureMonitor and creates the
+ * `team113.flutter.dev/linux_utils/memory_pressure` event channel reporting
+ * its `{level, reason}` changes, with the `level` being either `none`,
+ * `moderate` or `critical`. The current level is sent right away to every new
+ * listener.
+ *
+ * Nothing is reported, if neither the PSI nor the cgroup v2 memory events are
+ * available.
+ */
+void memory_pressure_service_init(FlBinaryMessenger* messenger);
+
+/**
+ * memory_pressure_service_dispose:
+ *
+ * Stops the #MemoryPressureMonitor, waiting for its thread to finish, and
+ * closes the pressure event channel.
+ */
+void memory_pressure_service_dispose();
+
+#endif  // RUNNER_MEMORY_PRESSURE_SERVICE_H_
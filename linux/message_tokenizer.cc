@@ -0,0 +1,241 @@
+#include "message_tokenizer.h"
+
+#include <sqlite3ext.h>
+
+#include <iterator>
+#include <vector>
+
+// Routines of the SQLite library the extension is loaded into, used by the
+// `sqlite3_*` macros of the `sqlite3ext.h`.
+static const sqlite3_api_routines* sqlite3_api = nullptr;
+
+static const char kTokenizerName[] = "messenger";
+
+// Options of the wrapped `unicode61` tokenizer, preceding the ones provided.
+static const char* const kParentOptions[] = {"remove_diacritics", "2"};
+
+// Tokenizer created by the `tokenize = 'messenger ...'` option.
+struct MessageTokenizer {
+  fts5_tokenizer parent;
+  Fts5Tokenizer* parent_instance;
+};
+
+// Context of the MessageTokenizer::parent tokenizing a text.
+struct TokenizeContext {
+  void* context;
+  int (*emit)(void* context,
+              int flags,
+              const char* token,
+              int length,
+              int start,
+              int end);
+
+  // `FTS5_TOKENIZE_*` flags the text is tokenized with.
+  int flags;
+};
+
+// Returns the length of the UTF-8 character starting with the |lead| byte.
+static int Utf8Length(unsigned char lead) {
+  if (lead < 0xC0) {
+    return 1;
+  } else if (lead < 0xE0) {
+    return 2;
+  } else if (lead < 0xF0) {
+    return 3;
+  }
+  return 4;
+}
+
+// Decodes the UTF-8 character of the |length| at the |text|.
+static uint32_t Utf8Decode(const char* text, int length) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text);
+  if (length == 1) {
+    return bytes[0];
+  }
+
+  uint32_t code = bytes[0] & (0x7F >> length);
+  for (int i = 1; i < length; ++i) {
+    code = (code << 6) | (bytes[i] & 0x3F);
+  }
+  return code;
+}
+
+// Indicates whether the |code| is of a script written without spaces between
+// the words: Han ideographs, Hiragana, Katakana, Bopomofo or Hangul.
+static bool IsCjk(uint32_t code) {
+  return (code >= 0x1100 && code <= 0x11FF) ||
+         (code >= 0x3040 && code <= 0x318F) ||
+         (code >= 0x31A0 && code <= 0x31BF) ||
+         (code >= 0x31F0 && code <= 0x31FF) ||
+         (code >= 0x3400 && code <= 0x4DBF) ||
+         (code >= 0x4E00 && code <= 0x9FFF) ||
+         (code >= 0xA960 && code <= 0xA97F) ||
+         (code >= 0xAC00 && code <= 0xD7FF) ||
+         (code >= 0xF900 && code <= 0xFAFF) ||
+         (code >= 0xFF66 && code <= 0xFFDC) ||
+         (code >= 0x20000 && code <= 0x3134F);
+}
+
+// Emits the |token| of the |parent| tokenizer as is, or split into the CJK
+// bigrams, if it contains any.
+static int EmitToken(void* parent,
+                     int flags,
+                     const char* token,
+                     int length,
+                     int start,
+                     int end) {
+  TokenizeContext* context = static_cast<TokenizeContext*>(parent);
+
+  // CJK characters are encoded with the lead bytes starting from 0xE1, so the
+  // tokens without them are emitted right away.
+  bool found = false;
+  for (int i = 0; i < length && !found; ++i) {
+    found = static_cast<unsigned char>(token[i]) >= 0xE1;
+  }
+
+  if (!found) {
+    return context->emit(context->context, flags, token, length, start, end);
+  }
+
+  // Byte offsets of the characters, and whether each of them is a CJK one.
+  std::vector<int> offsets;
+  std::vector<bool> cjk;
+  found = false;
+  for (int i = 0; i < length;) {
+    int size = Utf8Length(token[i]);
+    if (i + size > length) {
+      size = length - i;
+    }
+
+    offsets.push_back(i);
+    cjk.push_back(IsCjk(Utf8Decode(token + i, size)));
+    found = found || cjk.back();
+    i += size;
+  }
+  offsets.push_back(length);
+
+  if (!found) {
+    return context->emit(context->context, flags, token, length, start, end);
+  }
+
+  // Folding may change the length of the token, in which case the offsets of
+  // its parts within the text are unknown, so the whole token's are used.
+  bool exact = end - start == length;
+  auto emit = [&](int flags, size_t from, size_t to) {
+    return context->emit(
+        context->context, flags, token + offsets[from],
+        offsets[to] - offsets[from], exact ? start + offsets[from] : start,
+        exact ? start + offsets[to] : end);
+  };
+
+  int rc = SQLITE_OK;
+  size_t count = cjk.size();
+  for (size_t from = 0; from < count && rc == SQLITE_OK;) {
+    size_t to = from + 1;
+    while (to < count && cjk[to] == cjk[from]) {
+      ++to;
+    }
+
+    if (!cjk[from] || to - from == 1) {
+      rc = emit(flags, from, to);
+    } else {
+      for (size_t i = from; i + 1 < to && rc == SQLITE_OK; ++i) {
+        rc = emit(flags, i, i + 2);
+        flags = 0;
+      }
+
+      // Queries only need the bigrams, as the last character of a run is
+      // matched by the prefix ones.
+      if (rc == SQLITE_OK &&
+          (context->flags & FTS5_TOKENIZE_DOCUMENT) != 0) {
+        rc = emit(FTS5_TOKEN_COLOCATED, to - 1, to);
+      }
+    }
+
+    flags = 0;
+    from = to;
+  }
+
+  return rc;
+}
+
+static int CreateTokenizer(void* user_data,
+                           const char** options,
+                           int count,
+                           Fts5Tokenizer** out) {
+  fts5_api* api = static_cast<fts5_api*>(user_data);
+
+  MessageTokenizer* tokenizer = new MessageTokenizer();
+  void* parent_data = nullptr;
+  int rc = api->xFindTokenizer(api, "unicode61", &parent_data,
+                               &tokenizer->parent);
+
+  if (rc == SQLITE_OK) {
+    std::vector<const char*> parent_options(std::begin(kParentOptions),
+                                            std::end(kParentOptions));
+    parent_options.insert(parent_options.end(), options, options + count);
+
+    rc = tokenizer->parent.xCreate(parent_data, parent_options.data(),
+                                   parent_options.size(),
+                                   &tokenizer->parent_instance);
+  }
+
+  if (rc != SQLITE_OK) {
+    delete tokenizer;
+    return rc;
+  }
+
+  *out = reinterpret_cast<Fts5Tokenizer*>(tokenizer);
+  return SQLITE_OK;
+}
+
+static void DeleteTokenizer(Fts5Tokenizer* instance) {
+  MessageTokenizer* tokenizer = reinterpret_cast<MessageTokenizer*>(instance);
+  tokenizer->parent.xDelete(tokenizer->parent_instance);
+  delete tokenizer;
+}
+
+static int Tokenize(Fts5Tokenizer* instance,
+                    void* context,
+                    int flags,
+                    const char* text,
+                    int length,
+                    int (*emit)(void* context,
+                                int flags,
+                                const char* token,
+                                int length,
+                                int start,
+                                int end)) {
+  MessageTokenizer* tokenizer = reinterpret_cast<MessageTokenizer*>(instance);
+  TokenizeContext parent = {context, emit, flags};
+  return tokenizer->parent.xTokenize(tokenizer->parent_instance, &parent,
+                                     flags, text, length, EmitToken);
+}
+
+// Returns the FTS5 API of the |db|, or `nullptr`, if FTS5 isn't available.
+static fts5_api* Fts5Api(sqlite3* db) {
+  fts5_api* api = nullptr;
+
+  sqlite3_stmt* statement = nullptr;
+  if (sqlite3_prepare_v2(db, "SELECT fts5(?1)", -1, &statement, nullptr) ==
+      SQLITE_OK) {
+    sqlite3_bind_pointer(statement, 1, &api, "fts5_api_ptr", nullptr);
+    sqlite3_step(statement);
+  }
+  sqlite3_finalize(statement);
+
+  return api;
+}
+
+int RegisterMessageTokenizer(sqlite3* db, const sqlite3_api_routines* api) {
+  sqlite3_api = api;
+
+  fts5_api* fts5 = Fts5Api(db);
+  if (fts5 == nullptr) {
+    return SQLITE_OK;
+  }
+
+  fts5_tokenizer tokenizer = {CreateTokenizer, DeleteTokenizer, Tokenize};
+  return fts5->xCreateTokenizer(fts5, kTokenizerName, fts5, &tokenizer,
+                                nullptr);
+}
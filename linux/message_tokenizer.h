@@ -0,0 +1,21 @@
+#ifndef RUNNER_MESSAGE_TOKENIZER_H_
+#define RUNNER_MESSAGE_TOKENIZER_H_
+
+#include <sqlite3.h>
+
+// Registers the `messenger` FTS5 tokenizer on the |db|, calling SQLite via the
+// |api| routines of the library the |db| is opened with.
+//
+// The tokenizer wraps the built-in `unicode61` one with `remove_diacritics 2`,
+// so tokens are case and diacritic folded the same way for every script, and
+// any of its options can be passed after the name, e.g. `tokenchars`.
+// Additionally, runs of Chinese, Japanese and Korean characters, not being
+// separated by spaces, are split into overlapping bigrams instead of being a
+// single token. The last character of each run is indexed as well, so any
+// substring of such a run is found by a phrase query with the last term being
+// a prefix one.
+//
+// Returns `SQLITE_OK`, if registered or if FTS5 isn't available.
+int RegisterMessageTokenizer(sqlite3* db, const sqlite3_api_routines* api);
+
+#endif  // RUNNER_MESSAGE_TOKENIZER_H_
@@ -0,0 +1,382 @@
+#include "multipart_upload.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+
+// Interval to report the progress at.
+static const int64_t kProgressIntervalMs = 100;
+
+// Connections not sending anything for this long, unless paused, are
+// considered dropped.
+static const long kConnectTimeoutSeconds = 30;
+static const int64_t kStallTimeoutMs = 30000;
+
+// Size of the chunks the file is read into the request body in.
+static const long kChunkSize = 512 * 1024;
+
+// Responses larger than this are considered malformed.
+static const size_t kMaxResponseSize = 16 * 1024 * 1024;
+
+// Number of the first bytes of the file its MIME type is sniffed from.
+static const size_t kSniffSize = 64;
+
+static const char kDefaultContentType[] = "application/octet-stream";
+
+// Signature of the files of a MIME type at the offset of their beginning.
+struct MagicNumber {
+  size_t offset;
+  const char* bytes;
+  size_t length;
+  const char* mime;
+};
+
+// Magic numbers recognized by the `mime` package and the `MimeResolver`.
+static const MagicNumber kMagicNumbers[] = {
+    {0, "%PDF", 4, "application/pdf"},
+    {0, "%!", 2, "application/postscript"},
+    {0, "GIF87a", 6, "image/gif"},
+    {0, "GIF89a", 6, "image/gif"},
+    {0, "\xFF\xD8", 2, "image/jpeg"},
+    {0, "\x89PNG\r\n\x1A\n", 8, "image/png"},
+    {0, "II*\0", 4, "image/tiff"},
+    {0, "MM\0*", 4, "image/tiff"},
+    {0, "ID3", 3, "audio/mpeg"},
+    {0, "fLaC", 4, "audio/x-flac"},
+    {0, "OggS", 4, "audio/ogg"},
+    {0, "wOFF", 4, "font/woff"},
+    {0, "wOF2", 4, "font/woff2"},
+    {0, "glTF", 4, "model/gltf-binary"},
+    {8, "WEBP", 4, "image/webp"},
+    {8, "WAVE", 4, "audio/x-wav"},
+    {8, "AIFF", 4, "audio/x-aiff"},
+    {8, "AVI ", 4, "video/x-msvideo"},
+    {4, "moov", 4, "video/quicktime"},
+};
+
+// Brands of the ISO base media files by the prefixes of their `ftyp` box.
+static const MagicNumber kMediaBrands[] = {
+    {8, "qt  ", 4, "video/quicktime"},
+    {8, "heic", 4, "image/heic"},
+    {8, "heix", 4, "image/heic"},
+    {8, "mif1", 4, "image/heif"},
+    {8, "avif", 4, "image/avif"},
+    {8, "M4A ", 4, "audio/mp4"},
+    {8, "3gp", 3, "video/3gpp"},
+};
+
+static int64_t NowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void EnsureCurlInitialized() {
+  static std::once_flag once;
+  std::call_once(once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+static bool Matches(const uint8_t* data,
+                    size_t size,
+                    const MagicNumber& magic) {
+  return size >= magic.offset + magic.length &&
+         memcmp(data + magic.offset, magic.bytes, magic.length) == 0;
+}
+
+// Returns the MIME type of the file starting with the |size| bytes of the
+// |data|, or nullptr, if it isn't recognized.
+static const char* SniffMimeType(const uint8_t* data, size_t size) {
+  if (size >= 12 && memcmp(data + 4, "ftyp", 4) == 0) {
+    for (const MagicNumber& brand : kMediaBrands) {
+      if (Matches(data, size, brand)) {
+        return brand.mime;
+      }
+    }
+
+    return "video/mp4";
+  }
+
+  // Matroska is only told apart from WebM by its document type.
+  if (size >= 4 && memcmp(data, "\x1A\x45\xDF\xA3", 4) == 0) {
+    bool webm = memmem(data, size, "webm", 4) != nullptr;
+    return webm ? "video/webm" : "video/x-matroska";
+  }
+
+  for (const MagicNumber& magic : kMagicNumbers) {
+    if (Matches(data, size, magic)) {
+      return magic.mime;
+    }
+  }
+
+  return nullptr;
+}
+
+MultipartUpload::MultipartUpload(Options options)
+    : options_(std::move(options)) {
+  EnsureCurlInitialized();
+
+  // Created upfront, so curl_multi_wakeup() may be called on it from any
+  // thread at any time.
+  multi_ = curl_multi_init();
+}
+
+MultipartUpload::~MultipartUpload() {
+  curl_multi_cleanup(multi_);
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+void MultipartUpload::Cancel() {
+  cancelled_ = true;
+  curl_multi_wakeup(multi_);
+}
+
+void MultipartUpload::Pause() {
+  // Takes effect once the OnRead() is invoked for the next chunk.
+  paused_ = true;
+}
+
+void MultipartUpload::Resume() {
+  paused_ = false;
+  curl_multi_wakeup(multi_);
+}
+
+size_t MultipartUpload::OnRead(char* buffer,
+                               size_t size,
+                               size_t count,
+                               void* user) {
+  MultipartUpload* upload = static_cast<MultipartUpload*>(user);
+  if (upload->paused_) {
+    upload->stalled_ = true;
+    return CURL_READFUNC_PAUSE;
+  }
+
+  size_t length = static_cast<size_t>(
+      std::min<int64_t>(size * count, upload->size_ - upload->offset_));
+  if (length == 0) {
+    return 0;
+  }
+
+  ssize_t read;
+  do {
+    read = pread(upload->fd_, buffer, length, upload->offset_);
+  } while (read < 0 && errno == EINTR);
+
+  // File shrunk while uploading can't fill the declared size anymore.
+  if (read <= 0) {
+    upload->read_error_ = read < 0 ? errno : EIO;
+    return CURL_READFUNC_ABORT;
+  }
+
+  // Bytes sent again after a rewind are already hashed.
+  int64_t end = upload->offset_ + read;
+  if (upload->offset_ <= upload->hashed_ && end > upload->hashed_) {
+    size_t skipped = static_cast<size_t>(upload->hashed_ - upload->offset_);
+    upload->hasher_.Update(buffer + skipped, read - skipped);
+    upload->hashed_ = end;
+  }
+
+  upload->offset_ = end;
+  return read;
+}
+
+int MultipartUpload::OnSeek(void* user, curl_off_t offset, int origin) {
+  MultipartUpload* upload = static_cast<MultipartUpload*>(user);
+  if (origin != SEEK_SET || offset < 0 || offset > upload->size_) {
+    return CURL_SEEKFUNC_CANTSEEK;
+  }
+
+  // libcurl rewinds the body to send it again, e.g. on a redirect.
+  if (offset == 0) {
+    upload->hasher_ = Sha256();
+    upload->hashed_ = 0;
+  }
+
+  upload->offset_ = offset;
+  return CURL_SEEKFUNC_OK;
+}
+
+size_t MultipartUpload::OnWrite(char* data,
+                                size_t size,
+                                size_t count,
+                                void* user) {
+  MultipartUpload* upload = static_cast<MultipartUpload*>(user);
+  size_t length = size * count;
+  if (upload->response_.size() + length > kMaxResponseSize) {
+    return 0;
+  }
+
+  upload->response_.append(data, length);
+  return length;
+}
+
+UploadResult MultipartUpload::Run(const ProgressCallback& progress) {
+  fd_ = open(options_.path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd_ < 0 || fstat(fd_, &st) != 0) {
+    error_ = strerror(errno);
+    return UploadResult::kFileError;
+  }
+
+  size_ = st.st_size;
+  posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  // The first bytes stay in the page cache to be read again as a part of
+  // the first chunk.
+  uint8_t header[kSniffSize];
+  ssize_t sniffed = pread(fd_, header, sizeof(header), 0);
+  const char* sniffed_mime =
+      sniffed > 0 ? SniffMimeType(header, sniffed) : nullptr;
+  if (sniffed_mime != nullptr) {
+    mime_ = sniffed_mime;
+  } else if (!options_.content_type.empty()) {
+    mime_ = options_.content_type;
+  } else {
+    mime_ = kDefaultContentType;
+  }
+
+  CURL* curl = curl_easy_init();
+  curl_mime* form = curl_mime_init(curl);
+  for (const auto& field : options_.fields) {
+    curl_mimepart* part = curl_mime_addpart(form);
+    curl_mime_name(part, field.first.c_str());
+    curl_mime_data(part, field.second.data(), field.second.size());
+  }
+
+  curl_mimepart* file = curl_mime_addpart(form);
+  curl_mime_name(file, options_.field.c_str());
+  if (!options_.filename.empty()) {
+    curl_mime_filename(file, options_.filename.c_str());
+  }
+  curl_mime_type(file, mime_.c_str());
+  curl_mime_data_cb(file, size_, OnRead, OnSeek, nullptr, this);
+
+  curl_slist* headers = nullptr;
+  for (const std::string& header : options_.headers) {
+    headers = curl_slist_append(headers, header.c_str());
+  }
+
+  curl_easy_setopt(curl, CURLOPT_URL, options_.url.c_str());
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, kConnectTimeoutSeconds);
+  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+  curl_easy_setopt(curl, CURLOPT_MIMEPOST, form);
+  curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, kChunkSize);
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, OnWrite);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, this);
+
+  UploadResult result = UploadResult::kCompleted;
+  CURLcode code = CURLE_OK;
+  if (curl_multi_add_handle(multi_, curl) != CURLM_OK) {
+    error_ = "Failed to start the request";
+    result = UploadResult::kNetworkError;
+  }
+
+  int64_t last_progress = 0;
+  int64_t last_activity = NowMs();
+  curl_off_t sent = 0;
+  curl_off_t reported = -1;
+  curl_off_t total = -1;
+
+  for (bool done = result != UploadResult::kCompleted; !done;) {
+    if (cancelled_) {
+      result = UploadResult::kCancelled;
+      break;
+    }
+
+    if (stalled_ && !paused_) {
+      // May invoke the OnRead() right away, pausing it again.
+      stalled_ = false;
+      curl_easy_pause(curl, CURLPAUSE_CONT);
+    }
+
+    int running = 0;
+    curl_multi_perform(multi_, &running);
+
+    CURLMsg* message;
+    int queued;
+    while ((message = curl_multi_info_read(multi_, &queued)) != nullptr) {
+      if (message->msg == CURLMSG_DONE) {
+        code = message->data.result;
+        done = true;
+      }
+    }
+
+    if (done) {
+      break;
+    }
+
+    int64_t now = NowMs();
+    curl_off_t current = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &current);
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_UPLOAD_T, &total);
+
+    // Server may take its time to respond once the body is sent, so only the
+    // sending is considered stalled.
+    if (current != sent || stalled_ || (total >= 0 && current >= total)) {
+      sent = current;
+      last_activity = now;
+    } else if (now - last_activity >= kStallTimeoutMs) {
+      error_ = "Upload has stalled";
+      result = UploadResult::kNetworkError;
+      break;
+    }
+
+    if (now - last_progress >= kProgressIntervalMs && sent != reported &&
+        total > 0) {
+      last_progress = now;
+      reported = sent;
+      progress(sent, total);
+    }
+
+    curl_multi_poll(multi_, nullptr, 0, kProgressIntervalMs, nullptr);
+  }
+
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_);
+  curl_multi_remove_handle(multi_, curl);
+  curl_easy_cleanup(curl);
+  curl_mime_free(form);
+  curl_slist_free_all(headers);
+
+  close(fd_);
+  fd_ = -1;
+
+  if (result != UploadResult::kCompleted) {
+    return result;
+  }
+
+  // Server may reject the request before the whole body is sent.
+  if (status_ >= 400) {
+    error_ = "HTTP " + std::to_string(status_);
+    return UploadResult::kHttpError;
+  }
+
+  if (read_error_ != 0) {
+    error_ = strerror(read_error_);
+    return UploadResult::kFileError;
+  }
+
+  if (code != CURLE_OK) {
+    error_ = curl_easy_strerror(code);
+    return UploadResult::kNetworkError;
+  }
+
+  // Server may respond before the whole body is sent.
+  if (hashed_ != size_) {
+    error_ = "Upload isn't sent completely";
+    return UploadResult::kNetworkError;
+  }
+
+  sha256_ = hasher_.FinishHex();
+
+  progress(total, total);
+  return UploadResult::kCompleted;
+}
@@ -0,0 +1,141 @@
+#ifndef RUNNER_MULTIPART_UPLOAD_H_
+#define RUNNER_MULTIPART_UPLOAD_H_
+
+#include <curl/curl.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sha256.h"
+
+// Outcome of MultipartUpload::Run().
+enum class UploadResult {
+  kCompleted,
+  kCancelled,
+
+  // Server responded with an HTTP error status.
+  kHttpError,
+
+  // Connection has failed or stalled.
+  kNetworkError,
+
+  // File to upload can't be read.
+  kFileError,
+};
+
+// HTTP upload of a single file as a part of a `multipart/form-data` POST
+// request.
+//
+// The file is streamed into the request body in chunks read straight into
+// the upload buffer of libcurl, never being loaded into memory as a whole.
+// SHA-256 of the file is computed over the chunks as they're read, so the
+// file is read only once, and its MIME type is sniffed from its first bytes
+// before sending.
+//
+// Upload may be paused and resumed, which stalls sending the body while
+// keeping the connection open.
+class MultipartUpload {
+ public:
+  struct Options {
+    std::string url;
+
+    // Path of the file to upload.
+    std::string path;
+
+    // Name of the form field of the file and its file name.
+    std::string field = "file";
+    std::string filename;
+
+    // MIME type of the file, used if it can't be sniffed. Defaults to the
+    // `application/octet-stream`, if empty.
+    std::string content_type;
+
+    // Form fields to send before the file in their order.
+    std::vector<std::pair<std::string, std::string>> fields;
+
+    // Additional HTTP headers in the `Name: value` form.
+    std::vector<std::string> headers;
+  };
+
+  // Callback receiving the number of the |sent| bytes of the |total| bytes
+  // of the request body.
+  typedef std::function<void(int64_t sent, int64_t total)> ProgressCallback;
+
+  explicit MultipartUpload(Options options);
+  ~MultipartUpload();
+
+  MultipartUpload(const MultipartUpload&) = delete;
+  MultipartUpload& operator=(const MultipartUpload&) = delete;
+
+  // Uploads the file, blocking until the response is received, or the upload
+  // fails or is Cancel()ed, invoking the |progress| at most every 100 ms on
+  // the calling thread.
+  UploadResult Run(const ProgressCallback& progress);
+
+  // Stops the Run(). May be called from any thread.
+  void Cancel();
+
+  // Pauses or resumes sending the file. May be called from any thread.
+  void Pause();
+  void Resume();
+
+  // Returns the lowercase hex SHA-256 digest of the uploaded file.
+  const std::string& sha256() const { return sha256_; }
+
+  // Returns the MIME type the file was sent with.
+  const std::string& mime() const { return mime_; }
+
+  // Returns the size of the uploaded file.
+  int64_t size() const { return size_; }
+
+  // Returns the HTTP status of the response.
+  long status() const { return status_; }
+
+  // Returns the body of the response.
+  const std::string& response() const { return response_; }
+
+  // Returns the description of the failed result.
+  const std::string& error() const { return error_; }
+
+ private:
+  static size_t OnRead(char* buffer, size_t size, size_t count, void* user);
+  static int OnSeek(void* user, curl_off_t offset, int origin);
+  static size_t OnWrite(char* data, size_t size, size_t count, void* user);
+
+  Options options_;
+  CURLM* multi_;
+
+  std::atomic<bool> cancelled_{false};
+  std::atomic<bool> paused_{false};
+
+  int fd_ = -1;
+  int64_t size_ = 0;
+
+  // Offset of the next byte of the file to send.
+  int64_t offset_ = 0;
+
+  // Hasher of the bytes of the file read so far.
+  Sha256 hasher_;
+
+  // Number of the first bytes of the file hashed by the |hasher_|.
+  int64_t hashed_ = 0;
+
+  // `errno` of the failed read, if any.
+  int read_error_ = 0;
+
+  // Indicator whether the sending is paused by the OnRead().
+  bool stalled_ = false;
+
+  std::string sha256_;
+  std::string mime_;
+
+  long status_ = 0;
+  std::string response_;
+  std::string error_;
+};
+
+#endif  // RUNNER_MULTIPART_UPLOAD_H_
@@ -14,77 +14,43 @@
 #include <gdk/gdkx.h>
 #endif
 
+#include "bulk_channel.h"
+#include "cache_service.h"
+#include "database_maintenance.h"
+#include "deferred_plugins.h"
+#include "diagnostics_service.h"
+#include "download_service.h"
 #include "flutter/generated_plugin_registrant.h"
+#include "frame_monitor.h"
+#include "hash_service.h"
+#include "image_service.h"
+#include "log_mirror.h"
+#include "mapped_log_file.h"
+#include "memory_pressure_service.h"
+#include "rotating_log_file.h"
+#include "single_instance.h"
+#include "sound_service.h"
+#include "startup_prefetch.h"
+#include "startup_trace.h"
+#include "update_service.h"
+#include "upload_service.h"
+#include "websocket_service.h"
+#include "worker_pool.h"
+
+// Delay after the first frame to record the startup profile again at, so it
+// covers the files read right after the first frame as well.
+static const guint kStartupProfileDelay = 5;
 
 struct _MyApplication {
   GtkApplication parent_instance;
   char** dart_entrypoint_arguments;
   FlMethodChannel* utils_channel;
-};
-
-G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
 
-struct TeeContext {
-  int pipe_read_end;
-  int original_fd;
-  int log_file_fd;
+  // Native sink of the `LogFileProvider`, if opened.
+  MappedLogFile* log_sink;
 };
 
-static void* tee_thread(void* arg) {
-  TeeContext* ctx = static_cast<TeeContext*>(arg);
-
-  char buffer[4096];
-
-  while (true) {
-    ssize_t bytes_read =
-        read(ctx->pipe_read_end, buffer, sizeof(buffer));
-
-    if (bytes_read <= 0) {
-      break;
-    }
-
-    // Write to log file.
-    write(ctx->log_file_fd, buffer, bytes_read);
-
-    // Write back to original stream (stdout or stderr).
-    write(ctx->original_fd, buffer, bytes_read);
-  }
-
-  return nullptr;
-}
-
-static void tee_fd_to_file(int target_fd, int log_file_fd) {
-  int pipe_fds[2];
-  pipe(pipe_fds);
-
-  int pipe_read_end  = pipe_fds[0];
-  int pipe_write_end = pipe_fds[1];
-
-  // Preserve original stream FD.
-  int original_fd = dup(target_fd);
-
-  // Redirect target FD into pipe.
-  dup2(pipe_write_end, target_fd);
-  close(pipe_write_end);
-
-  // Disable buffering so output appears immediately.
-  if (target_fd == STDOUT_FILENO) {
-    setbuf(stdout, nullptr);
-  } else if (target_fd == STDERR_FILENO) {
-    setbuf(stderr, nullptr);
-  }
-
-  // Spawn background tee thread.
-  TeeContext* ctx = new TeeContext{
-      .pipe_read_end = pipe_read_end,
-      .original_fd   = original_fd,
-      .log_file_fd   = log_file_fd,
-  };
-
-  pthread_t tid;
-  pthread_create(&tid, nullptr, tee_thread, ctx);
-  pthread_detach(tid);
-}
+G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
 
 static char* build_log_path() {
   const char* xdg_data_home = getenv("XDG_DATA_HOME");
@@ -131,7 +97,36 @@ static void ensure_directory_exists(const char* path) {
   mkdir(tmp, 0755);
 }
 
-static FlMethodResponse* redirect_std_out() {
+// Reads the rotation settings passed to `redirectStdOut`, keeping the
+// defaults for the ones omitted.
+static LogRotationOptions parse_rotation_options(FlValue* args) {
+  LogRotationOptions options;
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return options;
+  }
+
+  FlValue* max_size = fl_value_lookup_string(args, "maxSize");
+  if (max_size != nullptr && fl_value_get_type(max_size) == FL_VALUE_TYPE_INT) {
+    options.max_size = MAX(fl_value_get_int(max_size), 0);
+  }
+
+  FlValue* max_files = fl_value_lookup_string(args, "maxFiles");
+  if (max_files != nullptr &&
+      fl_value_get_type(max_files) == FL_VALUE_TYPE_INT) {
+    options.max_files = MAX(fl_value_get_int(max_files), 0);
+  }
+
+  FlValue* compression = fl_value_lookup_string(args, "compression");
+  if (compression != nullptr &&
+      fl_value_get_type(compression) == FL_VALUE_TYPE_STRING) {
+    options.compression = LogCompressionFromName(
+        fl_value_get_string(compression), options.compression);
+  }
+
+  return options;
+}
+
+static FlMethodResponse* redirect_std_out(FlValue* args) {
   char* log_path = build_log_path();
 
   // Ensure parent directories exist.
@@ -143,26 +138,47 @@ static FlMethodResponse* redirect_std_out() {
   }
 
   // Open or create log file.
-  int log_file_fd = open(
-      log_path,
-      O_CREAT | O_WRONLY,
-      0644);
+  RotatingLogFile* log_file =
+      RotatingLogFile::Open(log_path, parse_rotation_options(args));
 
-  if (log_file_fd < 0) {
+  if (log_file == nullptr) {
     char error_message[256];
     snprintf(error_message, sizeof(error_message),
              "Failed to open log file: %s", strerror(errno));
+    free(log_path);
 
     return FL_METHOD_RESPONSE(fl_method_error_response_new(
         "FILE_ERROR", error_message, nullptr));
   }
 
   // Tee stdout and stderr.
-  tee_fd_to_file(STDOUT_FILENO, log_file_fd);
-  tee_fd_to_file(STDERR_FILENO, log_file_fd);
+  LogMirror* stdout_mirror = log_mirror_start(STDOUT_FILENO, log_file);
+  LogMirror* stderr_mirror = stdout_mirror == nullptr
+                                 ? nullptr
+                                 : log_mirror_start(STDERR_FILENO, log_file);
+
+  if (stderr_mirror == nullptr) {
+    int error = errno;
+
+    // Restore stdout, if only stderr has failed, so that neither stream is
+    // left mirrored into the log file being closed.
+    if (stdout_mirror != nullptr) {
+      log_mirror_stop(stdout_mirror);
+    }
+    delete log_file;
+
+    char error_message[256];
+    snprintf(error_message, sizeof(error_message),
+             "Failed to mirror stdout/stderr: %s", strerror(error));
+    free(log_path);
+
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "PIPE_ERROR", error_message, nullptr));
+  }
 
   fprintf(stdout, "stdout/stderr redirected to %s\n", log_path);
   fprintf(stderr, "stderr also mirrored to %s\n", log_path);
+  free(log_path);
 
   g_autoptr(FlValue) result =
       fl_value_new_string("ok");
@@ -171,12 +187,189 @@ static FlMethodResponse* redirect_std_out() {
       fl_method_success_response_new(result));
 }
 
+static FlMethodResponse* open_logs(MyApplication* self, FlValue* args) {
+  FlValue* path = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    path = fl_value_lookup_string(args, "path");
+  }
+
+  if (path == nullptr || fl_value_get_type(path) != FL_VALUE_TYPE_STRING) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`path` must be a string", nullptr));
+  }
+
+  // Keep the same 64 MB limit the Dart side used to apply.
+  off_t truncate_at = 64 * 1024 * 1024;
+  FlValue* limit = fl_value_lookup_string(args, "truncateAt");
+  if (limit != nullptr && fl_value_get_type(limit) == FL_VALUE_TYPE_INT) {
+    truncate_at = fl_value_get_int(limit);
+  }
+
+  delete self->log_sink;
+  self->log_sink = MappedLogFile::Open(fl_value_get_string(path), truncate_at);
+
+  if (self->log_sink == nullptr) {
+    char error_message[256];
+    snprintf(error_message, sizeof(error_message),
+             "Failed to open log file: %s", strerror(errno));
+
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "FILE_ERROR", error_message, nullptr));
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_int(self->log_sink->size());
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* append_logs(MyApplication* self, FlValue* args) {
+  if (self->log_sink == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "STATE_ERROR", "Log file isn't opened", nullptr));
+  }
+
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_UINT8_LIST) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "Logs must be passed as `Uint8List`", nullptr));
+  }
+
+  const char* data =
+      reinterpret_cast<const char*>(fl_value_get_uint8_list(args));
+  if (!self->log_sink->Append(data, fl_value_get_length(args))) {
+    char error_message[256];
+    snprintf(error_message, sizeof(error_message),
+             "Failed to append logs: %s", strerror(errno));
+
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "FILE_ERROR", error_message, nullptr));
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse* flush_logs(MyApplication* self) {
+  off_t size = self->log_sink == nullptr ? 0 : self->log_sink->Flush();
+
+  g_autoptr(FlValue) result = fl_value_new_int(size);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* close_logs(MyApplication* self) {
+  delete self->log_sink;
+  self->log_sink = nullptr;
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse* trace_startup(FlValue* args) {
+  FlValue* name = nullptr;
+  FlValue* start = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    name = fl_value_lookup_string(args, "name");
+    start = fl_value_lookup_string(args, "start");
+  }
+
+  if (name == nullptr || fl_value_get_type(name) != FL_VALUE_TYPE_STRING ||
+      start == nullptr || fl_value_get_type(start) != FL_VALUE_TYPE_INT) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`name` and `start` must be provided", nullptr));
+  }
+
+  StartupTrace* trace = StartupTrace::Shared();
+  FlValue* end = fl_value_lookup_string(args, "end");
+  if (end != nullptr && fl_value_get_type(end) == FL_VALUE_TYPE_INT) {
+    trace->Complete(fl_value_get_string(name), "dart", fl_value_get_int(start),
+                    fl_value_get_int(end));
+  } else {
+    trace->Instant(fl_value_get_string(name), "dart", fl_value_get_int(start));
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_bool(trace->enabled());
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* write_startup_trace() {
+  g_autoptr(FlValue) result =
+      fl_value_new_bool(StartupTrace::Shared()->Write());
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* database_maintenance() {
+  g_autoptr(FlValue) result = fl_value_new_list();
+
+  for (const DatabaseMaintenanceStats& stats :
+       DatabaseMaintenance::Shared()->Stats()) {
+    g_autoptr(FlValue) map = fl_value_new_map();
+    fl_value_set_string_take(map, "path",
+                             fl_value_new_string(stats.path.c_str()));
+    fl_value_set_string_take(map, "walSize",
+                             fl_value_new_int(stats.wal_size));
+    fl_value_set_string_take(map, "passiveCheckpoints",
+                             fl_value_new_int(stats.passive_checkpoints));
+    fl_value_set_string_take(map, "truncateCheckpoints",
+                             fl_value_new_int(stats.truncate_checkpoints));
+    fl_value_set_string_take(map, "checkpointedFrames",
+                             fl_value_new_int(stats.checkpointed_frames));
+    fl_value_set_string_take(map, "truncatedBytes",
+                             fl_value_new_int(stats.truncated_bytes));
+    fl_value_set_string_take(map, "vacuumedPages",
+                             fl_value_new_int(stats.vacuumed_pages));
+    fl_value_set_string_take(map, "optimizations",
+                             fl_value_new_int(stats.optimizations));
+    fl_value_set_string_take(map, "busy", fl_value_new_int(stats.busy));
+    fl_value_set_string_take(map, "lastRun",
+                             fl_value_new_int(stats.last_run));
+    if (!stats.last_error.empty()) {
+      fl_value_set_string_take(map, "lastError",
+                               fl_value_new_string(stats.last_error.c_str()));
+    }
+    fl_value_append(result, map);
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
 static void utils_method_call_handler(FlMethodChannel* channel,
                                         FlMethodCall* method_call,
                                         gpointer user_data) {
+  MyApplication* self = MY_APPLICATION(user_data);
+
+  // Services responding on their own, mostly asynchronously from the worker
+  // threads.
+  if (hash_service_handle_method_call(method_call) ||
+      cache_service_handle_method_call(method_call) ||
+      diagnostics_service_handle_method_call(method_call) ||
+      download_service_handle_method_call(method_call) ||
+      image_service_handle_method_call(method_call) ||
+      sound_service_handle_method_call(method_call) ||
+      update_service_handle_method_call(method_call) ||
+      upload_service_handle_method_call(method_call) ||
+      websocket_service_handle_method_call(method_call)) {
+    return;
+  }
+
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
   g_autoptr(FlMethodResponse) response = nullptr;
-  if (strcmp(fl_method_call_get_name(method_call), "redirectStdOut") == 0) {
-    response = redirect_std_out();
+  if (strcmp(method, "redirectStdOut") == 0) {
+    response = redirect_std_out(args);
+  } else if (strcmp(method, "openLogs") == 0) {
+    response = open_logs(self, args);
+  } else if (strcmp(method, "appendLogs") == 0) {
+    response = append_logs(self, args);
+  } else if (strcmp(method, "flushLogs") == 0) {
+    response = flush_logs(self);
+  } else if (strcmp(method, "closeLogs") == 0) {
+    response = close_logs(self);
+  } else if (strcmp(method, "traceStartup") == 0) {
+    response = trace_startup(args);
+  } else if (strcmp(method, "writeStartupTrace") == 0) {
+    response = write_startup_trace();
+  } else if (strcmp(method, "databaseMaintenance") == 0) {
+    response = database_maintenance();
+  } else if (strcmp(method, "registerDeferredPlugins") == 0) {
+    deferred_plugins_register();
+    response = FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
   } else {
     response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
   }
@@ -187,9 +380,42 @@ static void utils_method_call_handler(FlMethodChannel* channel,
   }
 }
 
+// Records the files read by the startup so far for the next startup to
+// prefetch.
+static gboolean record_startup_profile(gpointer user_data) {
+  WorkerPool::Shared()->Post(
+      [] { RecordStartupProfile(DefaultStartupPrefetchPaths()); });
+  return G_SOURCE_REMOVE;
+}
+
+// Registers the deferred plugins after the first frame rendered by the
+// Flutter engine, records the startup profile, and writes the startup trace,
+// as it may not be written by Dart.
+static void first_frame_cb(FlView* view) {
+  deferred_plugins_schedule();
+
+  record_startup_profile(nullptr);
+  g_timeout_add_seconds(kStartupProfileDelay, record_startup_profile, nullptr);
+
+  StartupTrace* trace = StartupTrace::Shared();
+  trace->Instant("first_frame", "runner", StartupTrace::Now());
+  trace->Write();
+}
+
+// Postpones the blocking maintenance of the databases while the |window| is
+// focused.
+static void window_active_cb(GtkWindow* window,
+                             GParamSpec* pspec,
+                             gpointer user_data) {
+  DatabaseMaintenance::Shared()->SetFocused(gtk_window_is_active(window));
+}
+
 // Implements GApplication::activate.
 static void my_application_activate(GApplication* application) {
   MyApplication* self = MY_APPLICATION(application);
+  StartupTrace* trace = StartupTrace::Shared();
+  int64_t phase = StartupTrace::Now();
+
   GtkWindow* window =
       GTK_WINDOW(gtk_application_window_new(GTK_APPLICATION(application)));
 
@@ -221,7 +447,10 @@ static void my_application_activate(GApplication* application) {
   }
 
   gtk_window_set_default_size(window, 1280, 720);
+  g_signal_connect(window, "notify::is-active", G_CALLBACK(window_active_cb),
+                   nullptr);
   gtk_widget_show(GTK_WIDGET(window));
+  phase = trace->Mark("gtk_window", phase);
 
   g_autoptr(FlDartProject) project = fl_dart_project_new();
   fl_dart_project_set_dart_entrypoint_arguments(project, self->dart_entrypoint_arguments);
@@ -229,8 +458,14 @@ static void my_application_activate(GApplication* application) {
   FlView* view = fl_view_new(project);
   gtk_widget_show(GTK_WIDGET(view));
   gtk_container_add(GTK_CONTAINER(window), GTK_WIDGET(view));
+  phase = trace->Mark("fl_view_new", phase);
+
+  g_signal_connect(view, "first-frame", G_CALLBACK(first_frame_cb), nullptr);
+  FrameMonitor::Shared()->Attach(GTK_WIDGET(view));
 
+  // Heavy plugins are only remembered here, see `deferred_plugins.h`.
   fl_register_plugins(FL_PLUGIN_REGISTRY(view));
+  phase = trace->Mark("fl_register_plugins", phase);
 
   g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
   self->utils_channel = fl_method_channel_new(
@@ -238,6 +473,18 @@ static void my_application_activate(GApplication* application) {
       "team113.flutter.dev/linux_utils", FL_METHOD_CODEC(codec));
   fl_method_channel_set_method_call_handler(
       self->utils_channel, utils_method_call_handler, self, nullptr);
+  bulk_channel_init(fl_engine_get_binary_messenger(fl_view_get_engine(view)));
+  download_service_init(
+      fl_engine_get_binary_messenger(fl_view_get_engine(view)));
+  memory_pressure_service_init(
+      fl_engine_get_binary_messenger(fl_view_get_engine(view)));
+  single_instance_init(
+      fl_engine_get_binary_messenger(fl_view_get_engine(view)));
+  upload_service_init(
+      fl_engine_get_binary_messenger(fl_view_get_engine(view)));
+  websocket_service_init(
+      fl_engine_get_binary_messenger(fl_view_get_engine(view)));
+  trace->Mark("native_channels", phase);
 
   gtk_widget_grab_focus(GTK_WIDGET(view));
 }
@@ -245,6 +492,8 @@ static void my_application_activate(GApplication* application) {
 // Implements GApplication::local_command_line.
 static gboolean my_application_local_command_line(GApplication* application, gchar*** arguments, int* exit_status) {
   MyApplication* self = MY_APPLICATION(application);
+  int64_t phase = StartupTrace::Now();
+
   // Strip out the first argument as it is the binary name.
   self->dart_entrypoint_arguments = g_strdupv(*arguments + 1);
 
@@ -254,6 +503,13 @@ static gboolean my_application_local_command_line(GApplication* application, gch
      *exit_status = 1;
      return TRUE;
   }
+  StartupTrace::Shared()->Mark("g_application_register", phase);
+
+  // Another instance is running already, so it handles the arguments.
+  if (single_instance_forward(application, self->dart_entrypoint_arguments)) {
+    *exit_status = 0;
+    return TRUE;
+  }
 
   g_application_activate(application);
   *exit_status = 0;
@@ -268,6 +524,8 @@ static void my_application_startup(GApplication* application) {
   // Perform any actions required at application startup.
 
   G_APPLICATION_CLASS(my_application_parent_class)->startup(application);
+
+  single_instance_startup(GTK_APPLICATION(application));
 }
 
 // Implements GApplication::shutdown.
@@ -284,6 +542,24 @@ static void my_application_dispose(GObject* object) {
   MyApplication* self = MY_APPLICATION(object);
   g_clear_pointer(&self->dart_entrypoint_arguments, g_strfreev);
   g_clear_object(&self->utils_channel);
+
+  // Trims the pre-allocated tail of the file.
+  delete self->log_sink;
+  self->log_sink = nullptr;
+
+  bulk_channel_dispose();
+  cache_service_dispose();
+  deferred_plugins_dispose();
+  download_service_dispose();
+  memory_pressure_service_dispose();
+  single_instance_dispose();
+  sound_service_dispose();
+  upload_service_dispose();
+  websocket_service_dispose();
+
+  // Includes the events recorded after the first frame.
+  StartupTrace::Shared()->Write();
+
   G_OBJECT_CLASS(my_application_parent_class)->dispose(object);
 }
 
@@ -298,8 +574,17 @@ static void my_application_class_init(MyApplicationClass* klass) {
 static void my_application_init(MyApplication* self) {}
 
 MyApplication* my_application_new() {
+#if GLIB_CHECK_VERSION(2, 74, 0)
+  GApplicationFlags flags = G_APPLICATION_DEFAULT_FLAGS;
+#else
+  GApplicationFlags flags = G_APPLICATION_FLAGS_NONE;
+#endif
+  if (!single_instance_enabled()) {
+    flags = G_APPLICATION_NON_UNIQUE;
+  }
+
   return MY_APPLICATION(g_object_new(my_application_get_type(),
                                      "application-id", APPLICATION_ID,
-                                     "flags", G_APPLICATION_NON_UNIQUE,
+                                     "flags", flags,
                                      nullptr));
 }
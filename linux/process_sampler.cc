@@ -0,0 +1,430 @@
+#include "process_sampler.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+// Returns the current CLOCK_MONOTONIC time in milliseconds.
+static int64_t NowMillis() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+// Reads the file at the |path| into the |buffer| as a null-terminated string,
+// returning false if it can't be read.
+static bool ReadFile(const char* path, char* buffer, size_t size) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+
+  ssize_t length = read(fd, buffer, size - 1);
+  close(fd);
+  if (length < 0) {
+    return false;
+  }
+
+  buffer[length] = '\0';
+  return true;
+}
+
+// Parses the `stat` of a process or a thread into its |name| and counters.
+static bool ParseStat(const char* stat,
+                      std::string* name,
+                      int64_t* cpu,
+                      int64_t* minor_faults,
+                      int64_t* major_faults) {
+  // Name may contain anything, including spaces and parentheses.
+  const char* open = strchr(stat, '(');
+  const char* close = strrchr(stat, ')');
+  if (open == nullptr || close == nullptr || close < open) {
+    return false;
+  }
+
+  if (name != nullptr) {
+    name->assign(open + 1, close);
+  }
+
+  long long minor = 0;
+  long long major = 0;
+  long long user = 0;
+  long long system = 0;
+  if (sscanf(close + 1,
+             " %*c %*d %*d %*d %*d %*d %*u %lld %*u %lld %*u %lld %lld",
+             &minor, &major, &user, &system) != 4) {
+    return false;
+  }
+
+  *cpu = user + system;
+  if (minor_faults != nullptr) {
+    *minor_faults = minor;
+    *major_faults = major;
+  }
+  return true;
+}
+
+// Returns the value of the |key| line of the `io` file |contents|, or zero.
+static int64_t ParseIo(const char* contents, const char* key) {
+  const char* line = strstr(contents, key);
+  return line == nullptr ? 0 : strtoll(line + strlen(key), nullptr, 10);
+}
+
+// Returns the sum of the voluntary and involuntary context switches from the
+// `status` file |contents|, or -1, if there are none.
+static int64_t ParseContextSwitches(const char* contents) {
+  const char* voluntary = strstr(contents, "\nvoluntary_ctxt_switches:");
+  const char* involuntary = strstr(contents, "nonvoluntary_ctxt_switches:");
+  if (voluntary == nullptr || involuntary == nullptr) {
+    return -1;
+  }
+
+  return strtoll(voluntary + strlen("\nvoluntary_ctxt_switches:"), nullptr,
+                 10) +
+         strtoll(involuntary + strlen("nonvoluntary_ctxt_switches:"), nullptr,
+                 10);
+}
+
+// Opens a `perf_event_open(2)` hardware counter of the |config| for the
+// thread |tid|, returning its file descriptor, or -1.
+static int OpenCounter(pid_t tid, uint64_t config) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+
+  // Counted in the user space only, as the unprivileged users are not allowed
+  // to count the kernel with `perf_event_paranoid` of 2.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  return static_cast<int>(
+      syscall(SYS_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+// Returns the value of the counter |fd|, or -1, if it's not opened.
+static int64_t ReadCounter(int fd) {
+  uint64_t value = 0;
+  if (fd == -1 || read(fd, &value, sizeof(value)) != sizeof(value)) {
+    return -1;
+  }
+  return static_cast<int64_t>(value);
+}
+
+static void CloseCounter(int fd) {
+  if (fd != -1) {
+    close(fd);
+  }
+}
+
+std::string ThreadLabel(pid_t tid, const char* name) {
+  if (tid == getpid()) {
+    return "platform";
+  }
+
+  // Flutter engine names its threads `1.ui` or `io.flutter.ui`, truncated to
+  // 15 characters, e.g. `io.flutter.rast`.
+  size_t length = strlen(name);
+  auto ends_with = [name, length](const char* suffix) {
+    size_t size = strlen(suffix);
+    return length > size && strcmp(name + length - size, suffix) == 0;
+  };
+
+  if (ends_with(".ui")) {
+    return "flutter.ui";
+  } else if (strstr(name, ".rast") != nullptr) {
+    return "flutter.raster";
+  } else if (ends_with(".io")) {
+    return "flutter.io";
+  }
+
+  return name;
+}
+
+ProcessSampler* ProcessSampler::Shared() {
+  // Intentionally leaked, as the sampling may still be running on exit.
+  static ProcessSampler* sampler = new ProcessSampler();
+  return sampler;
+}
+
+bool ProcessSampler::Start(const ProcessSamplerOptions& options) {
+  Stop();
+
+  ProcessSamplerOptions applied = options;
+  applied.interval = std::max(applied.interval, 10);
+  applied.capacity = std::max<size_t>(applied.capacity, 2);
+
+  // Permission is checked once for every thread by the counter of this one,
+  // also failing if the hardware counters aren't supported, e.g. in a VM.
+  bool permitted = false;
+  if (applied.perf) {
+    int fd = OpenCounter(0, PERF_COUNT_HW_INSTRUCTIONS);
+    permitted = fd != -1;
+    CloseCounter(fd);
+    applied.perf = permitted;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  samples_.clear();
+  samples_.reserve(applied.capacity);
+  next_ = 0;
+  perf_ = applied.perf;
+  stopping_ = false;
+  thread_ = std::thread(&ProcessSampler::Run, this, applied);
+
+  return permitted || !options.perf;
+}
+
+void ProcessSampler::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  stopped_.notify_all();
+
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+ProcessSummary ProcessSampler::Summarize(int64_t window) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  ProcessSummary summary;
+  summary.perf = perf_;
+
+  size_t count = samples_.size();
+  if (count == 0) {
+    return summary;
+  }
+
+  // Walks back from the newest sample till the |window| is covered.
+  size_t newest = (next_ + count - 1) % count;
+  const ProcessSample& last = samples_[newest];
+  size_t oldest = newest;
+  for (size_t i = 0; i < count; ++i) {
+    size_t index = (newest + count - i) % count;
+    if (window > 0 && last.time - samples_[index].time > window) {
+      break;
+    }
+
+    oldest = index;
+    summary.max_rss = std::max(summary.max_rss, samples_[index].rss);
+    ++summary.samples;
+  }
+  const ProcessSample& first = samples_[oldest];
+
+  summary.duration = last.time - first.time;
+  summary.rss = last.rss;
+  summary.fds = last.fds;
+  if (summary.duration <= 0) {
+    return summary;
+  }
+
+  // Percents of a single core per clock tick.
+  double scale = 100000.0 / sysconf(_SC_CLK_TCK) / summary.duration;
+  summary.cpu = (last.cpu - first.cpu) * scale;
+
+  std::map<pid_t, const ThreadSample*> before;
+  for (const ThreadSample& thread : first.threads) {
+    before[thread.tid] = &thread;
+  }
+
+  // Threads started within the window are counted from their start.
+  static const ThreadSample kStarted = [] {
+    ThreadSample sample;
+    sample.cycles = 0;
+    sample.instructions = 0;
+    sample.context_switches = 0;
+    return sample;
+  }();
+  auto delta = [](int64_t after, int64_t before) -> int64_t {
+    return after < 0 || before < 0 ? -1 : after - before;
+  };
+  auto add = [](int64_t* total, int64_t value) {
+    if (value >= 0) {
+      *total = std::max<int64_t>(*total, 0) + value;
+    }
+  };
+
+  std::map<std::string, ThreadSummary> labels;
+  for (const ThreadSample& thread : last.threads) {
+    auto it = before.find(thread.tid);
+    const ThreadSample& start = it == before.end() ? kStarted : *it->second;
+
+    ThreadSummary& label = labels[thread.label];
+    label.label = thread.label;
+    ++label.count;
+    label.cpu += (thread.cpu - start.cpu) * scale;
+    label.minor_faults += thread.minor_faults - start.minor_faults;
+    label.major_faults += thread.major_faults - start.major_faults;
+    label.read_bytes += thread.read_bytes - start.read_bytes;
+    label.write_bytes += thread.write_bytes - start.write_bytes;
+    add(&label.cycles, delta(thread.cycles, start.cycles));
+    add(&label.instructions, delta(thread.instructions, start.instructions));
+    add(&label.context_switches,
+        delta(thread.context_switches, start.context_switches));
+  }
+
+  for (auto& entry : labels) {
+    summary.threads.push_back(std::move(entry.second));
+  }
+  std::sort(summary.threads.begin(), summary.threads.end(),
+            [](const ThreadSummary& a, const ThreadSummary& b) {
+              return a.cpu > b.cpu;
+            });
+
+  return summary;
+}
+
+void ProcessSampler::Run(ProcessSamplerOptions options) {
+  pthread_setname_np(pthread_self(), "sampler");
+
+  std::map<pid_t, PerfCounters> perf;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    lock.unlock();
+    ProcessSample sample;
+    Sample(&sample, options.perf ? &perf : nullptr);
+    lock.lock();
+
+    if (samples_.size() < options.capacity) {
+      samples_.push_back(std::move(sample));
+    } else {
+      samples_[next_] = std::move(sample);
+    }
+    next_ = (next_ + 1) % options.capacity;
+
+    stopped_.wait_for(lock, std::chrono::milliseconds(options.interval),
+                      [this] { return stopping_; });
+  }
+  lock.unlock();
+
+  for (auto& entry : perf) {
+    CloseCounter(entry.second.cycles);
+    CloseCounter(entry.second.instructions);
+  }
+}
+
+void ProcessSampler::Sample(ProcessSample* sample,
+                            std::map<pid_t, PerfCounters>* perf) {
+  sample->time = NowMillis();
+
+  char buffer[1024];
+  if (ReadFile("/proc/self/stat", buffer, sizeof(buffer))) {
+    ParseStat(buffer, nullptr, &sample->cpu, nullptr, nullptr);
+  }
+
+  long long resident = 0;
+  if (ReadFile("/proc/self/statm", buffer, sizeof(buffer)) &&
+      sscanf(buffer, "%*d %lld", &resident) == 1) {
+    sample->rss = resident * sysconf(_SC_PAGESIZE);
+  }
+
+  std::map<pid_t, PerfCounters> alive;
+
+  DIR* tasks = opendir("/proc/self/task");
+  while (tasks != nullptr) {
+    struct dirent* entry = readdir(tasks);
+    if (entry == nullptr) {
+      break;
+    }
+
+    pid_t tid = atoi(entry->d_name);
+    if (tid <= 0) {
+      continue;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+    ThreadSample thread;
+    std::string name;
+    if (!ReadFile(path, buffer, sizeof(buffer)) ||
+        !ParseStat(buffer, &name, &thread.cpu, &thread.minor_faults,
+                   &thread.major_faults)) {
+      // Exited since listed.
+      continue;
+    }
+    thread.tid = tid;
+    snprintf(thread.label, sizeof(thread.label), "%s",
+             ThreadLabel(tid, name.c_str()).c_str());
+
+    snprintf(path, sizeof(path), "/proc/self/task/%d/io", tid);
+    if (ReadFile(path, buffer, sizeof(buffer))) {
+      thread.read_bytes = ParseIo(buffer, "read_bytes: ");
+      thread.write_bytes = ParseIo(buffer, "write_bytes: ");
+    }
+
+    // Context switches are at the end of the `status`, longer than the rest.
+    char status[4096];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/status", tid);
+    if (ReadFile(path, status, sizeof(status))) {
+      thread.context_switches = ParseContextSwitches(status);
+    }
+
+    if (perf != nullptr) {
+      auto it = perf->find(tid);
+      PerfCounters counters;
+      if (it == perf->end()) {
+        counters.cycles = OpenCounter(tid, PERF_COUNT_HW_CPU_CYCLES);
+        counters.instructions = OpenCounter(tid, PERF_COUNT_HW_INSTRUCTIONS);
+      } else {
+        counters = it->second;
+        perf->erase(it);
+      }
+
+      thread.cycles = ReadCounter(counters.cycles);
+      thread.instructions = ReadCounter(counters.instructions);
+      alive[tid] = counters;
+    }
+
+    sample->threads.push_back(thread);
+  }
+  if (tasks != nullptr) {
+    closedir(tasks);
+  }
+
+  // Counters left are of the exited threads.
+  int64_t counters = 0;
+  if (perf != nullptr) {
+    for (auto& entry : *perf) {
+      CloseCounter(entry.second.cycles);
+      CloseCounter(entry.second.instructions);
+    }
+    perf->swap(alive);
+
+    for (auto& entry : *perf) {
+      counters += (entry.second.cycles != -1) +
+                  (entry.second.instructions != -1);
+    }
+  }
+
+  // Neither the directory's own descriptor nor the counters are counted.
+  DIR* fds = opendir("/proc/self/fd");
+  while (fds != nullptr) {
+    struct dirent* entry = readdir(fds);
+    if (entry == nullptr) {
+      break;
+    }
+
+    if (entry->d_name[0] != '.') {
+      ++sample->fds;
+    }
+  }
+  if (fds != nullptr) {
+    closedir(fds);
+    sample->fds = std::max<int64_t>(sample->fds - 1 - counters, 0);
+  }
+}
@@ -0,0 +1,180 @@
+#ifndef RUNNER_PROCESS_SAMPLER_H_
+#define RUNNER_PROCESS_SAMPLER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Options of the ProcessSampler.
+struct ProcessSamplerOptions {
+  // Interval between the samples, in milliseconds.
+  int interval = 1000;
+
+  // Number of the samples kept, the oldest ones being overwritten.
+  size_t capacity = 120;
+
+  // Indicator whether the hardware counters of the threads should be taken
+  // via `perf_event_open(2)`, if permitted.
+  bool perf = false;
+};
+
+// Counters of a single thread as of a sample, cumulative since its start.
+struct ThreadSample {
+  pid_t tid = 0;
+
+  // Label of the thread, see ThreadLabel().
+  char label[24] = {};
+
+  // CPU time in the user and kernel modes, in clock ticks.
+  int64_t cpu = 0;
+
+  int64_t minor_faults = 0;
+  int64_t major_faults = 0;
+
+  // Bytes read from and written to the storage.
+  int64_t read_bytes = 0;
+  int64_t write_bytes = 0;
+
+  // Counters taken via `perf_event_open(2)`, or -1, if not available.
+  int64_t cycles = -1;
+  int64_t instructions = -1;
+
+  // Voluntary and involuntary context switches, or -1, if not available.
+  int64_t context_switches = -1;
+};
+
+// Sample of the whole process.
+struct ProcessSample {
+  // CLOCK_MONOTONIC time of the sample, in milliseconds.
+  int64_t time = 0;
+
+  // CPU time of the process including the exited threads, in clock ticks.
+  int64_t cpu = 0;
+
+  // Resident set size, in bytes.
+  int64_t rss = 0;
+
+  // Number of the open file descriptors.
+  int64_t fds = 0;
+
+  std::vector<ThreadSample> threads;
+};
+
+// Usage of the threads sharing the same label over a window of samples.
+struct ThreadSummary {
+  std::string label;
+
+  // Number of the threads with the label.
+  int count = 0;
+
+  // CPU time, in percents of a single core.
+  double cpu = 0;
+
+  int64_t minor_faults = 0;
+  int64_t major_faults = 0;
+  int64_t read_bytes = 0;
+  int64_t write_bytes = 0;
+
+  // Counters taken via `perf_event_open(2)`, or -1, if not available.
+  int64_t cycles = -1;
+  int64_t instructions = -1;
+
+  // Voluntary and involuntary context switches, or -1, if not available.
+  int64_t context_switches = -1;
+};
+
+// Usage of the process over a window of samples.
+struct ProcessSummary {
+  // Number of the samples and the time between the first and the last one,
+  // in milliseconds.
+  size_t samples = 0;
+  int64_t duration = 0;
+
+  // CPU time of the process, in percents of a single core.
+  double cpu = 0;
+
+  // Resident set size as of the last sample, and the maximum over the window,
+  // in bytes.
+  int64_t rss = 0;
+  int64_t max_rss = 0;
+
+  // Number of the open file descriptors as of the last sample.
+  int64_t fds = 0;
+
+  // Indicator whether the `perf_event_open(2)` counters are taken.
+  bool perf = false;
+
+  // Threads grouped by their labels, sorted by the CPU time descending.
+  std::vector<ThreadSummary> threads;
+};
+
+// Returns the label of the thread |tid| named |name|, grouping the threads of
+// the same purpose together, e.g. `flutter.ui`, `flutter.raster`, `platform`
+// for the main thread, or the |name| itself for the rest, like `DartWorker` or
+// the runner's `tee_thread`.
+std::string ThreadLabel(pid_t tid, const char* name);
+
+// Samples the CPU time, page faults, storage I/O and context switches of every
+// thread of this process from `/proc/self/task/*/stat`, `io` and `status`,
+// along with the process's RSS from `/proc/self/statm` and the number of its
+// file descriptors, on its own thread into a ring buffer.
+class ProcessSampler {
+ public:
+  // Returns the ProcessSampler of the process.
+  static ProcessSampler* Shared();
+
+  ProcessSampler(const ProcessSampler&) = delete;
+  ProcessSampler& operator=(const ProcessSampler&) = delete;
+
+  // Starts sampling with the |options|, discarding the samples taken with the
+  // previous ones, if already started.
+  //
+  // Returns false, if the `perf_event_open(2)` counters are requested, but
+  // not permitted, in which case the rest is sampled still.
+  bool Start(const ProcessSamplerOptions& options);
+
+  // Stops sampling, keeping the samples taken.
+  void Stop();
+
+  // Returns the ProcessSummary of the samples taken within the last |window|
+  // milliseconds, or all of them, if it's zero.
+  ProcessSummary Summarize(int64_t window);
+
+ private:
+  // `perf_event_open(2)` counters of a thread, grouped under the |cycles|.
+  struct PerfCounters {
+    int cycles = -1;
+    int instructions = -1;
+  };
+
+  ProcessSampler() = default;
+
+  // Body of the |thread_|.
+  void Run(ProcessSamplerOptions options);
+
+  // Takes the |sample| of the process, reading the |perf| counters of its
+  // threads, opening them for the new threads and closing for the exited ones.
+  static void Sample(ProcessSample* sample,
+                     std::map<pid_t, PerfCounters>* perf);
+
+  std::mutex mutex_;
+  std::condition_variable stopped_;
+  bool stopping_ = false;
+
+  // Ring buffer of the samples, with the |next_| one to be overwritten.
+  std::vector<ProcessSample> samples_;
+  size_t next_ = 0;
+
+  bool perf_ = false;
+
+  std::thread thread_;
+};
+
+#endif  // RUNNER_PROCESS_SAMPLER_H_
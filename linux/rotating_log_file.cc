@@ -0,0 +1,451 @@
+#include "rotating_log_file.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Size of the chunks the segments are read in while being compressed.
+static const size_t kCompressChunkSize = 128 * 1024;
+
+static const char kLogExtension[] = ".log";
+
+static const char* CompressionExtension(LogCompression compression) {
+  switch (compression) {
+    case LogCompression::kGzip:
+      return ".gz";
+    case LogCompression::kZstd:
+      return ".zst";
+    case LogCompression::kNone:
+      break;
+  }
+  return "";
+}
+
+LogCompression LogCompressionFromName(const char* name,
+                                      LogCompression fallback) {
+  if (name == nullptr) {
+    return fallback;
+  } else if (strcmp(name, "none") == 0) {
+    return LogCompression::kNone;
+  } else if (strcmp(name, "gzip") == 0) {
+    return LogCompression::kGzip;
+  } else if (strcmp(name, "zstd") == 0) {
+#ifdef HAVE_ZSTD
+    return LogCompression::kZstd;
+#else
+    return LogCompression::kGzip;
+#endif
+  }
+  return fallback;
+}
+
+// Parses the index of a rotated segment named "<stem>.<N>.log[.gz|.zst]".
+// Returns zero if the |name| isn't a segment of the |stem|.
+static unsigned long ParseSegmentIndex(const std::string& stem,
+                                       const char* name,
+                                       bool* compressed) {
+  size_t stem_length = stem.size();
+  if (strncmp(name, stem.c_str(), stem_length) != 0 ||
+      name[stem_length] != '.') {
+    return 0;
+  }
+
+  char* end = nullptr;
+  const char* digits = name + stem_length + 1;
+  if (*digits < '0' || *digits > '9') {
+    return 0;
+  }
+
+  unsigned long index = strtoul(digits, &end, 10);
+  if (strncmp(end, kLogExtension, sizeof(kLogExtension) - 1) != 0) {
+    return 0;
+  }
+
+  const char* suffix = end + sizeof(kLogExtension) - 1;
+  if (*suffix == '\0') {
+    *compressed = false;
+  } else if (strcmp(suffix, ".gz") == 0 || strcmp(suffix, ".zst") == 0) {
+    *compressed = true;
+  } else {
+    return 0;
+  }
+
+  return index;
+}
+
+// Makes the calling thread yield CPU and disk to everything else.
+static void LowerThreadPriority() {
+  sched_param param = {};
+  pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+  // Niceness is per-thread on Linux, so this doesn't affect other threads.
+  setpriority(PRIO_PROCESS, 0, 19);
+}
+
+static bool GzipFile(int in_fd, int out_fd) {
+  gzFile out = gzdopen(out_fd, "wb6");
+  if (out == nullptr) {
+    close(out_fd);
+    return false;
+  }
+
+  std::vector<char> buffer(kCompressChunkSize);
+  bool succeeded = true;
+  while (true) {
+    ssize_t bytes_read = read(in_fd, buffer.data(), buffer.size());
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes_read <= 0) {
+      succeeded = bytes_read == 0;
+      break;
+    }
+
+    if (gzwrite(out, buffer.data(), bytes_read) != bytes_read) {
+      succeeded = false;
+      break;
+    }
+  }
+
+  // Closes |out_fd| as well.
+  return gzclose(out) == Z_OK && succeeded;
+}
+
+#ifdef HAVE_ZSTD
+static bool WriteAll(int fd, const void* data, size_t length) {
+  const char* bytes = static_cast<const char*>(data);
+  while (length > 0) {
+    ssize_t written = write(fd, bytes, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+
+    bytes += written;
+    length -= written;
+  }
+
+  return true;
+}
+
+static bool ZstdFile(int in_fd, int out_fd) {
+  ZSTD_CCtx* context = ZSTD_createCCtx();
+  if (context == nullptr) {
+    close(out_fd);
+    return false;
+  }
+
+  ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, 3);
+
+  std::vector<char> input(kCompressChunkSize);
+  std::vector<char> output(ZSTD_CStreamOutSize());
+  bool succeeded = true;
+  bool finished = false;
+  while (succeeded && !finished) {
+    ssize_t bytes_read = read(in_fd, input.data(), input.size());
+    if (bytes_read < 0) {
+      succeeded = errno == EINTR;
+      continue;
+    }
+
+    finished = bytes_read == 0;
+    ZSTD_EndDirective mode = finished ? ZSTD_e_end : ZSTD_e_continue;
+    ZSTD_inBuffer in = {input.data(), static_cast<size_t>(bytes_read), 0};
+
+    size_t remaining;
+    do {
+      ZSTD_outBuffer out = {output.data(), output.size(), 0};
+      remaining = ZSTD_compressStream2(context, &out, &in, mode);
+      if (ZSTD_isError(remaining) ||
+          !WriteAll(out_fd, output.data(), out.pos)) {
+        succeeded = false;
+        break;
+      }
+    } while (finished ? remaining != 0 : in.pos < in.size);
+  }
+
+  ZSTD_freeCCtx(context);
+  return close(out_fd) == 0 && succeeded;
+}
+#endif
+
+RotatingLogFile* RotatingLogFile::Open(const char* path,
+                                       const LogRotationOptions& options) {
+  RotatingLogFile* file = new RotatingLogFile(path, options);
+
+  // `O_APPEND` isn't used, as it prevents `splice(2)` into the file, so the
+  // offset is moved to the end instead.
+  file->fd_ = open(path, O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+  if (file->fd_ < 0) {
+    int error = errno;
+    delete file;
+    errno = error;
+    return nullptr;
+  }
+
+  file->size_ = lseek(file->fd_, 0, SEEK_END);
+  if (file->size_ < 0) {
+    file->size_ = 0;
+  }
+
+  file->Recover();
+
+  std::lock_guard<std::mutex> lock(file->mutex_);
+  if (options.max_size > 0 && file->size_ >= options.max_size) {
+    file->Rotate();
+  }
+
+  return file;
+}
+
+RotatingLogFile::RotatingLogFile(const std::string& path,
+                                 const LogRotationOptions& options)
+    : path_(path), options_(options) {
+  size_t slash = path_.rfind('/');
+  directory_ = slash == std::string::npos ? "." : path_.substr(0, slash);
+  stem_ = slash == std::string::npos ? path_ : path_.substr(slash + 1);
+
+  size_t extension_length = sizeof(kLogExtension) - 1;
+  if (stem_.size() > extension_length &&
+      stem_.compare(stem_.size() - extension_length, extension_length,
+                    kLogExtension) == 0) {
+    stem_.resize(stem_.size() - extension_length);
+  }
+}
+
+RotatingLogFile::~RotatingLogFile() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stopping_ = true;
+  }
+  queue_changed_.notify_one();
+
+  // Segments left in the queue are compressed by the Recover() of the next
+  // launch.
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+int RotatingLogFile::Acquire() {
+  mutex_.lock();
+  return fd_;
+}
+
+void RotatingLogFile::Release(size_t written) {
+  size_ += written;
+  if (options_.max_size > 0 && size_ >= options_.max_size) {
+    Rotate();
+  }
+  mutex_.unlock();
+}
+
+std::string RotatingLogFile::SegmentPath(unsigned long index) const {
+  return directory_ + "/" + stem_ + "." + std::to_string(index) +
+         kLogExtension;
+}
+
+void RotatingLogFile::Recover() {
+  DIR* dir = opendir(directory_.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+
+  std::vector<unsigned long> uncompressed;
+  while (dirent* entry = readdir(dir)) {
+    bool compressed = false;
+    unsigned long index = ParseSegmentIndex(stem_, entry->d_name, &compressed);
+    if (index == 0) {
+      // Remove the leftovers of the interrupted compressions.
+      size_t length = strlen(entry->d_name);
+      if (strncmp(entry->d_name, stem_.c_str(), stem_.size()) == 0 &&
+          length > 4 && strcmp(entry->d_name + length - 4, ".tmp") == 0) {
+        unlinkat(dirfd(dir), entry->d_name, 0);
+      }
+      continue;
+    }
+
+    last_index_ = std::max(last_index_, index);
+    if (!compressed) {
+      uncompressed.push_back(index);
+    }
+  }
+  closedir(dir);
+
+  // Segments may be left uncompressed if the application was closed while
+  // compressing them.
+  std::sort(uncompressed.begin(), uncompressed.end());
+  for (unsigned long index : uncompressed) {
+    Enqueue(SegmentPath(index));
+  }
+}
+
+void RotatingLogFile::Rotate() {
+  std::string segment = SegmentPath(++last_index_);
+
+  int fd = -1;
+  if (rename(path_.c_str(), segment.c_str()) == 0) {
+    fd = open(path_.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      rename(segment.c_str(), path_.c_str());
+    }
+  }
+
+  if (fd < 0) {
+    // Keep the size bounded even if the segment can't be moved aside.
+    if (ftruncate(fd_, 0) == 0) {
+      lseek(fd_, 0, SEEK_SET);
+    }
+    size_ = 0;
+    return;
+  }
+
+  // Replace the descriptor in place, so the writers may keep using it.
+  dup3(fd, fd_, O_CLOEXEC);
+  close(fd);
+  size_ = 0;
+
+  Enqueue(segment);
+}
+
+void RotatingLogFile::Enqueue(const std::string& path) {
+  std::lock_guard<std::mutex> lock(queue_mutex_);
+  queue_.push_back(path);
+
+  if (!thread_.joinable()) {
+    thread_ = std::thread(&RotatingLogFile::Run, this);
+  }
+
+  queue_changed_.notify_one();
+}
+
+void RotatingLogFile::Run() {
+  LowerThreadPriority();
+
+  while (true) {
+    std::string path;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_changed_.wait(lock,
+                          [this] { return stopping_ || !queue_.empty(); });
+      if (stopping_) {
+        return;
+      }
+
+      path = queue_.front();
+      queue_.pop_front();
+    }
+
+    if (options_.compression != LogCompression::kNone) {
+      Compress(path);
+    }
+
+    Prune();
+  }
+}
+
+bool RotatingLogFile::Compress(const std::string& path) {
+  int in_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (in_fd < 0) {
+    return false;
+  }
+
+  posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  std::string target = path + CompressionExtension(options_.compression);
+  std::string temporary = target + ".tmp";
+  int out_fd =
+      open(temporary.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+  if (out_fd < 0) {
+    close(in_fd);
+    return false;
+  }
+
+  bool succeeded = false;
+  switch (options_.compression) {
+    case LogCompression::kGzip:
+      succeeded = GzipFile(in_fd, out_fd);
+      break;
+    case LogCompression::kZstd:
+#ifdef HAVE_ZSTD
+      succeeded = ZstdFile(in_fd, out_fd);
+#else
+      close(out_fd);
+#endif
+      break;
+    case LogCompression::kNone:
+      close(out_fd);
+      break;
+  }
+  close(in_fd);
+
+  if (!succeeded || rename(temporary.c_str(), target.c_str()) != 0) {
+    unlink(temporary.c_str());
+    return false;
+  }
+
+  unlink(path.c_str());
+  return true;
+}
+
+void RotatingLogFile::Prune() {
+  DIR* dir = opendir(directory_.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+
+  std::vector<std::pair<unsigned long, std::string>> segments;
+  while (dirent* entry = readdir(dir)) {
+    bool compressed = false;
+    unsigned long index = ParseSegmentIndex(stem_, entry->d_name, &compressed);
+    if (index != 0) {
+      segments.emplace_back(index, directory_ + "/" + entry->d_name);
+    }
+  }
+  closedir(dir);
+
+  // Newest segments go first.
+  std::sort(segments.begin(), segments.end(),
+            [](const std::pair<unsigned long, std::string>& a,
+               const std::pair<unsigned long, std::string>& b) {
+              return a.first > b.first;
+            });
+
+  // Both the compressed and not yet compressed variants of a segment may be
+  // present at the same time, so count the distinct indices.
+  int kept = 0;
+  unsigned long previous = 0;
+  for (const auto& segment : segments) {
+    if (segment.first != previous) {
+      previous = segment.first;
+      ++kept;
+    }
+
+    if (kept > options_.max_files) {
+      unlink(segment.second.c_str());
+    }
+  }
+}
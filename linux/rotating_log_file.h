@@ -0,0 +1,118 @@
+#ifndef RUNNER_ROTATING_LOG_FILE_H_
+#define RUNNER_ROTATING_LOG_FILE_H_
+
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Compression applied to the rotated log segments.
+enum class LogCompression {
+  kNone,
+  kGzip,
+  kZstd,
+};
+
+struct LogRotationOptions {
+  // Size in bytes the current segment is rotated after, or zero to never
+  // rotate it.
+  off_t max_size = 16 * 1024 * 1024;
+
+  // Number of the rotated segments to keep, besides the current one.
+  int max_files = 5;
+
+  LogCompression compression = LogCompression::kGzip;
+};
+
+// Parses the |name| of a LogCompression ("none", "gzip" or "zstd"). Returns
+// |fallback| if the |name| is unknown or not supported by this build.
+LogCompression LogCompressionFromName(const char* name,
+                                      LogCompression fallback);
+
+// A log file rolling over to a new segment once its size exceeds the limit.
+//
+// The rotated segments are renamed to "<stem>.<N>.log" with a monotonically
+// increasing N, compressed and pruned to the configured amount on a
+// low-priority background thread, so writers are never blocked on it.
+//
+// Intended to live for the whole process lifetime, unless mirroring into it
+// couldn't be started.
+class RotatingLogFile {
+ public:
+  // Opens the log file at |path| for appending, rotating it right away if it's
+  // already exceeding the limit. Returns nullptr with errno set on failure.
+  static RotatingLogFile* Open(const char* path,
+                               const LogRotationOptions& options);
+
+  // Stops the background thread, waiting for the segment being compressed, if
+  // any, and closes the file.
+  //
+  // Must not be called while there are writers left.
+  ~RotatingLogFile();
+
+  RotatingLogFile(const RotatingLogFile&) = delete;
+  RotatingLogFile& operator=(const RotatingLogFile&) = delete;
+
+  // Locks the file for writing and returns the descriptor to write at its
+  // current offset. The descriptor number stays the same across rotations.
+  //
+  // Must be followed by Release().
+  int Acquire();
+
+  // Accounts the |written| bytes and unlocks the file, rotating it if the
+  // limit is exceeded.
+  void Release(size_t written);
+
+ private:
+  RotatingLogFile(const std::string& path, const LogRotationOptions& options);
+
+  // Returns the path of the rotated segment with the provided |index|.
+  std::string SegmentPath(unsigned long index) const;
+
+  // Scans the directory for the rotated segments, restoring the last used
+  // index and scheduling the ones left uncompressed.
+  void Recover();
+
+  // Moves the current segment aside and starts a new one.
+  //
+  // Must be called with |mutex_| held.
+  void Rotate();
+
+  // Schedules the rotated segment at |path| to be compressed and pruned.
+  void Enqueue(const std::string& path);
+
+  // Body of the background thread compressing and pruning the segments.
+  void Run();
+
+  // Compresses the segment at |path|, removing it on success.
+  bool Compress(const std::string& path);
+
+  // Removes the oldest segments exceeding LogRotationOptions::max_files.
+  void Prune();
+
+  const std::string path_;
+  const LogRotationOptions options_;
+
+  // Directory and file name stem of |path_|.
+  std::string directory_;
+  std::string stem_;
+
+  std::mutex mutex_;
+  int fd_ = -1;
+  off_t size_ = 0;
+  unsigned long last_index_ = 0;
+
+  // Segments waiting for the background thread, guarded by |queue_mutex_|.
+  std::mutex queue_mutex_;
+  std::condition_variable queue_changed_;
+  std::deque<std::string> queue_;
+  bool stopping_ = false;
+
+  // Background thread, started once the first segment is enqueued.
+  std::thread thread_;
+};
+
+#endif  // RUNNER_ROTATING_LOG_FILE_H_
@@ -0,0 +1,8 @@
+#ifndef RUNNER_RUNNER_EXPORT_H_
+#define RUNNER_RUNNER_EXPORT_H_
+
+// Marks a function exported from the runner executable to be looked up by
+// Dart FFI via `DynamicLibrary.executable()`.
+#define RUNNER_EXPORT extern "C" __attribute__((visibility("default"), used))
+
+#endif  // RUNNER_RUNNER_EXPORT_H_
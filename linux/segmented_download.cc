@@ -0,0 +1,730 @@
+#include "segmented_download.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
+// Interval to report the progress and hash the downloaded data at.
+static const int64_t kProgressIntervalMs = 100;
+
+// Interval to persist the progress of the segments at.
+static const int64_t kStateIntervalMs = 1000;
+
+// Segments are split only while each half is at least this large.
+static const int64_t kMinSplitSize = 1024 * 1024;
+
+// Size of the chunks the downloaded data is read back to be hashed in, and
+// their maximum number per progress interval, so resuming a large download
+// doesn't stall the transfers.
+static const size_t kHashChunkSize = 1024 * 1024;
+static const int kHashChunksPerInterval = 32;
+
+// Connections not receiving anything for this long are considered dropped.
+static const long kConnectTimeoutSeconds = 30;
+static const long kStallTimeoutSeconds = 30;
+
+static const int64_t kMinBackoffMs = 500;
+static const int64_t kMaxBackoffMs = 30000;
+
+// First line of the state file.
+static const char kStateMagic[] = "segmented-download 1";
+
+struct SegmentedDownload::Transfer {
+  SegmentedDownload* download;
+  int segment;
+  CURL* curl;
+  curl_slist* headers;
+
+  // Status of the response, once its body starts.
+  long status = 0;
+
+  // Indicator whether the response isn't the expected one.
+  bool unexpected = false;
+
+  // `errno` of the failed write, if any.
+  int write_error = 0;
+
+  // Number of the bytes written by this transfer.
+  int64_t written = 0;
+};
+
+// Headers of the response to the probing request.
+struct ProbeHeaders {
+  int64_t content_length = -1;
+
+  // Size of the file from the `Content-Range` header.
+  int64_t range_total = -1;
+
+  std::string etag;
+  std::string last_modified;
+};
+
+static int64_t NowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void EnsureCurlInitialized() {
+  static std::once_flag once;
+  std::call_once(once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+// Returns the value of the |line| header if it's named |name|, or nullptr.
+static const char* HeaderValue(const std::string& line, const char* name) {
+  size_t length = strlen(name);
+  if (line.size() <= length || line[length] != ':' ||
+      strncasecmp(line.c_str(), name, length) != 0) {
+    return nullptr;
+  }
+
+  const char* value = line.c_str() + length + 1;
+  while (*value == ' ' || *value == '\t') {
+    ++value;
+  }
+
+  return value;
+}
+
+static size_t OnProbeHeader(char* data, size_t size, size_t count,
+                            void* user) {
+  ProbeHeaders* headers = static_cast<ProbeHeaders*>(user);
+  std::string line(data, size * count);
+  while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) {
+    line.pop_back();
+  }
+
+  const char* value;
+  if (line.compare(0, 5, "HTTP/") == 0) {
+    // Each of the followed redirects starts its own headers.
+    *headers = ProbeHeaders();
+  } else if ((value = HeaderValue(line, "Content-Length")) != nullptr) {
+    headers->content_length = strtoll(value, nullptr, 10);
+  } else if ((value = HeaderValue(line, "Content-Range")) != nullptr) {
+    const char* total = strchr(value, '/');
+    if (total != nullptr && total[1] != '*') {
+      headers->range_total = strtoll(total + 1, nullptr, 10);
+    }
+  } else if ((value = HeaderValue(line, "ETag")) != nullptr) {
+    headers->etag = value;
+  } else if ((value = HeaderValue(line, "Last-Modified")) != nullptr) {
+    headers->last_modified = value;
+  }
+
+  return size * count;
+}
+
+// Aborts the probing request once its body starts, as only the headers are
+// needed.
+static size_t OnProbeWrite(char* data, size_t size, size_t count,
+                           void* user) {
+  return 0;
+}
+
+static int64_t BackoffMs(int failures) {
+  return std::min(kMaxBackoffMs, kMinBackoffMs << std::min(failures - 1, 16));
+}
+
+// Returns whether the request failed with the |status| is worth retrying.
+static bool IsRetryableStatus(long status) {
+  return status == 408 || status == 429 || status >= 500;
+}
+
+static void ApplyCommonOptions(CURL* curl,
+                               const std::string& url,
+                               curl_slist* headers) {
+  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 10L);
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, kConnectTimeoutSeconds);
+  curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+  curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, kStallTimeoutSeconds);
+  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+}
+
+SegmentedDownload::SegmentedDownload(Options options)
+    : options_(std::move(options)),
+      part_path_(options_.path + ".part"),
+      state_path_(part_path_ + ".state") {
+  options_.connections = std::max(1, options_.connections);
+  options_.min_segment_size =
+      std::max(kMinSplitSize, options_.min_segment_size);
+  EnsureCurlInitialized();
+}
+
+SegmentedDownload::~SegmentedDownload() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+DownloadResult SegmentedDownload::Probe() {
+  curl_slist* headers = nullptr;
+  for (const std::string& header : options_.headers) {
+    headers = curl_slist_append(headers, header.c_str());
+  }
+
+  DownloadResult result = DownloadResult::kNetworkError;
+  for (int attempt = 0; attempt <= options_.retries; ++attempt) {
+    if (attempt > 0) {
+      int64_t retry_at = NowMs() + BackoffMs(attempt);
+      while (!cancelled_ && NowMs() < retry_at) {
+        usleep(kProgressIntervalMs * 1000);
+      }
+    }
+
+    if (cancelled_) {
+      result = DownloadResult::kCancelled;
+      break;
+    }
+
+    ProbeHeaders probe;
+    CURL* curl = curl_easy_init();
+    ApplyCommonOptions(curl, options_.url, headers);
+    curl_easy_setopt(curl, CURLOPT_RANGE, "0-0");
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, OnProbeHeader);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &probe);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, OnProbeWrite);
+
+    CURLcode code = curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_);
+    curl_easy_cleanup(curl);
+
+    if (code != CURLE_OK && code != CURLE_WRITE_ERROR) {
+      error_ = curl_easy_strerror(code);
+      continue;
+    }
+
+    validator_ = !probe.etag.empty() ? probe.etag : probe.last_modified;
+    if (status_ == 206 && probe.range_total >= 0) {
+      ranges_ = true;
+      total_ = probe.range_total;
+    } else if (status_ == 200) {
+      ranges_ = false;
+      total_ = probe.content_length;
+    } else if (status_ == 416) {
+      // Empty files can't satisfy any range.
+      ranges_ = false;
+      total_ = -1;
+    } else if (IsRetryableStatus(status_)) {
+      error_ = "HTTP " + std::to_string(status_);
+      continue;
+    } else {
+      error_ = "HTTP " + std::to_string(status_);
+      result = DownloadResult::kHttpError;
+      break;
+    }
+
+    result = DownloadResult::kCompleted;
+    break;
+  }
+
+  curl_slist_free_all(headers);
+  return result;
+}
+
+bool SegmentedDownload::LoadState() {
+  if (!ranges_ || total_ <= 0 || validator_.empty()) {
+    return false;
+  }
+
+  FILE* file = fopen(state_path_.c_str(), "re");
+  if (file == nullptr) {
+    return false;
+  }
+
+  char* line = nullptr;
+  size_t capacity = 0;
+  auto read_line = [&]() -> std::string {
+    ssize_t length = getline(&line, &capacity, file);
+    if (length <= 0) {
+      return std::string();
+    }
+
+    return std::string(line, line[length - 1] == '\n' ? length - 1 : length);
+  };
+
+  bool matches = read_line() == kStateMagic && read_line() == validator_ &&
+                 read_line() == std::to_string(total_);
+
+  std::vector<Segment> segments;
+  while (matches) {
+    std::string entry = read_line();
+    if (entry.empty()) {
+      break;
+    }
+
+    Segment segment;
+    long long start, end, received;
+    if (sscanf(entry.c_str(), "%lld %lld %lld", &start, &end, &received) !=
+            3 ||
+        start < 0 || end > total_ || received < 0 || start + received > end) {
+      matches = false;
+      break;
+    }
+
+    segment.start = start;
+    segment.end = end;
+    segment.received = received;
+    segments.push_back(segment);
+  }
+
+  free(line);
+  fclose(file);
+
+  // Segments must cover the whole file without any gaps or overlaps.
+  std::sort(segments.begin(), segments.end(),
+            [](const Segment& a, const Segment& b) {
+              return a.start < b.start;
+            });
+  int64_t covered = 0;
+  for (const Segment& segment : segments) {
+    matches = matches && segment.start == covered;
+    covered = segment.end;
+  }
+
+  struct stat st;
+  if (!matches || covered != total_ || stat(part_path_.c_str(), &st) != 0) {
+    return false;
+  }
+
+  segments_ = std::move(segments);
+  return true;
+}
+
+void SegmentedDownload::SaveState() {
+  if (!ranges_ || total_ <= 0 || validator_.empty() || segments_.empty()) {
+    return;
+  }
+
+  std::string temporary = state_path_ + ".tmp";
+  FILE* file = fopen(temporary.c_str(), "we");
+  if (file == nullptr) {
+    return;
+  }
+
+  fprintf(file, "%s\n%s\n%lld\n", kStateMagic, validator_.c_str(),
+          static_cast<long long>(total_));
+  for (const Segment& segment : segments_) {
+    fprintf(file, "%lld %lld %lld\n", static_cast<long long>(segment.start),
+            static_cast<long long>(segment.end),
+            static_cast<long long>(segment.received));
+  }
+
+  // The data must reach the disk before the state claiming it's there.
+  if (fdatasync(fd_) == 0 && fclose(file) == 0) {
+    rename(temporary.c_str(), state_path_.c_str());
+  } else {
+    unlink(temporary.c_str());
+  }
+}
+
+void SegmentedDownload::PlanSegments() {
+  segments_.clear();
+
+  if (!ranges_ || total_ <= 0) {
+    Segment segment;
+    segment.end = total_;
+    segments_.push_back(segment);
+    return;
+  }
+
+  int64_t count = std::max<int64_t>(
+      1, std::min<int64_t>(options_.connections,
+                           total_ / options_.min_segment_size));
+  for (int64_t i = 0; i < count; ++i) {
+    Segment segment;
+    segment.start = total_ * i / count;
+    segment.end = total_ * (i + 1) / count;
+    segments_.push_back(segment);
+  }
+}
+
+int SegmentedDownload::SplitLargestSegment() {
+  if (!ranges_) {
+    return -1;
+  }
+
+  int largest = -1;
+  int64_t largest_remaining = 0;
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    int64_t remaining = segments_[i].end - segments_[i].offset();
+    if (remaining > largest_remaining) {
+      largest = i;
+      largest_remaining = remaining;
+    }
+  }
+
+  if (largest < 0 || largest_remaining < kMinSplitSize * 2) {
+    return -1;
+  }
+
+  // The transfer of the split segment stops by itself on reaching its new
+  // end, see OnWrite().
+  Segment segment;
+  segment.end = segments_[largest].end;
+  segment.start = segments_[largest].offset() + largest_remaining / 2;
+  segments_[largest].end = segment.start;
+  segments_.push_back(segment);
+
+  return segments_.size() - 1;
+}
+
+int SegmentedDownload::NextPendingSegment(int64_t now) const {
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    const Segment& segment = segments_[i];
+    if (!segment.active && !segment.completed() && segment.retry_at <= now) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+bool SegmentedDownload::HashDownloaded() {
+  // Segments partition the file, so the prefix grows through the segment
+  // it ends in, until reaching one not downloaded up to its end.
+  int64_t prefix = hashed_;
+  for (bool advanced = true; advanced;) {
+    advanced = false;
+    for (const Segment& segment : segments_) {
+      if (segment.start <= prefix && segment.offset() > prefix) {
+        prefix = segment.offset();
+        advanced = true;
+      }
+    }
+  }
+
+  hash_buffer_.resize(kHashChunkSize);
+  for (int i = 0; i < kHashChunksPerInterval && hashed_ < prefix; ++i) {
+    size_t length =
+        std::min<int64_t>(hash_buffer_.size(), prefix - hashed_);
+    ssize_t bytes_read = pread(fd_, hash_buffer_.data(), length, hashed_);
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes_read <= 0) {
+      return false;
+    }
+
+    hasher_.Update(hash_buffer_.data(), bytes_read);
+    hashed_ += bytes_read;
+  }
+
+  return true;
+}
+
+size_t SegmentedDownload::OnWrite(char* data,
+                                  size_t size,
+                                  size_t count,
+                                  void* user) {
+  Transfer* transfer = static_cast<Transfer*>(user);
+  SegmentedDownload* download = transfer->download;
+  Segment& segment = download->segments_[transfer->segment];
+  size_t length = size * count;
+
+  if (transfer->status == 0) {
+    curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE,
+                      &transfer->status);
+    long expected = download->ranges_ ? 206 : 200;
+    if (transfer->status != expected) {
+      transfer->unexpected = true;
+      return 0;
+    }
+  }
+
+  // Segments may be split while being transferred, so anything past their
+  // end belongs to another segment.
+  size_t writable = length;
+  if (segment.end >= 0) {
+    writable = std::min<int64_t>(length, segment.end - segment.offset());
+  }
+
+  size_t written = 0;
+  while (written < writable) {
+    ssize_t result = pwrite(download->fd_, data + written,
+                            writable - written, segment.offset() + written);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (result <= 0) {
+      transfer->write_error = result < 0 ? errno : EIO;
+      segment.received += written;
+      transfer->written += written;
+      return 0;
+    }
+
+    written += result;
+  }
+
+  segment.received += written;
+  transfer->written += written;
+  return written == length ? length : 0;
+}
+
+SegmentedDownload::Transfer* SegmentedDownload::StartTransfer(CURLM* multi,
+                                                              int index) {
+  Segment& segment = segments_[index];
+
+  // Downloads without ranges can only start over.
+  if (!ranges_ && segment.received > 0) {
+    segment.received = 0;
+    hasher_ = Sha256();
+    hashed_ = 0;
+  }
+
+  std::unique_ptr<Transfer> transfer(new Transfer());
+  transfer->download = this;
+  transfer->segment = index;
+  transfer->curl = curl_easy_init();
+  transfer->headers = nullptr;
+  if (transfer->curl == nullptr) {
+    return nullptr;
+  }
+
+  for (const std::string& header : options_.headers) {
+    transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+  }
+
+  CURL* curl = transfer->curl;
+  ApplyCommonOptions(curl, options_.url, transfer->headers);
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, OnWrite);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer.get());
+  curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer.get());
+
+  if (ranges_) {
+    std::string range = std::to_string(segment.offset()) + "-" +
+                        std::to_string(segment.end - 1);
+    curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+  }
+
+  if (curl_multi_add_handle(multi, curl) != CURLM_OK) {
+    curl_slist_free_all(transfer->headers);
+    curl_easy_cleanup(curl);
+    return nullptr;
+  }
+
+  segment.active = true;
+  return transfer.release();
+}
+
+DownloadResult SegmentedDownload::FinishTransfer(Transfer* transfer,
+                                                 CURLcode code,
+                                                 int64_t now) {
+  Segment& segment = segments_[transfer->segment];
+  segment.active = false;
+
+  if (transfer->write_error != 0) {
+    error_ = strerror(transfer->write_error);
+    return DownloadResult::kFileError;
+  }
+
+  if (transfer->written > 0) {
+    segment.failures = 0;
+  }
+
+  if (segment.completed()) {
+    return DownloadResult::kCompleted;
+  }
+
+  if (code == CURLE_OK && transfer->status != 0 && !transfer->unexpected &&
+      segment.end < 0) {
+    // Size of the file is known only once it's downloaded without it.
+    segment.end = segment.offset();
+    total_ = segment.end;
+    return DownloadResult::kCompleted;
+  }
+
+  // Responses without a body never reach OnWrite().
+  long status = transfer->status;
+  if (status == 0) {
+    curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &status);
+  }
+
+  bool unexpected = status != 0 && status != (ranges_ ? 206 : 200);
+  if (unexpected && !IsRetryableStatus(status)) {
+    status_ = status;
+    error_ = status == 200 ? "Server has stopped supporting ranges"
+                           : "HTTP " + std::to_string(status);
+    return DownloadResult::kHttpError;
+  }
+
+  error_ = unexpected ? "HTTP " + std::to_string(status)
+                      : curl_easy_strerror(code);
+  if (++segment.failures > options_.retries) {
+    return DownloadResult::kNetworkError;
+  }
+
+  segment.retry_at = now + BackoffMs(segment.failures);
+  return DownloadResult::kCompleted;
+}
+
+DownloadResult SegmentedDownload::Run(const ProgressCallback& progress) {
+  DownloadResult result = Probe();
+  if (result != DownloadResult::kCompleted) {
+    return result;
+  }
+
+  bool resumed = LoadState();
+  fd_ = open(part_path_.c_str(),
+             O_RDWR | O_CREAT | O_CLOEXEC | (resumed ? 0 : O_TRUNC), 0644);
+  if (fd_ < 0) {
+    error_ = strerror(errno);
+    return DownloadResult::kFileError;
+  }
+
+  if (!resumed) {
+    unlink(state_path_.c_str());
+    PlanSegments();
+
+    // Reserves the space upfront, failing early if there's not enough of it
+    // and keeping the file from fragmenting between the segments.
+    if (total_ > 0 && fallocate(fd_, 0, 0, total_) != 0) {
+      if (errno == ENOSPC || ftruncate(fd_, total_) != 0) {
+        error_ = strerror(errno);
+        return DownloadResult::kFileError;
+      }
+    }
+  }
+
+  CURLM* multi = curl_multi_init();
+  std::vector<Transfer*> transfers;
+  int64_t last_progress = 0;
+  int64_t last_state = NowMs();
+
+  while (true) {
+    if (cancelled_) {
+      result = DownloadResult::kCancelled;
+      break;
+    }
+
+    int64_t now = NowMs();
+    while (transfers.size() < static_cast<size_t>(options_.connections)) {
+      int index = NextPendingSegment(now);
+      if (index < 0) {
+        index = SplitLargestSegment();
+      }
+
+      if (index < 0) {
+        break;
+      }
+
+      Transfer* transfer = StartTransfer(multi, index);
+      if (transfer == nullptr) {
+        segments_[index].retry_at = now + BackoffMs(1);
+        break;
+      }
+
+      transfers.push_back(transfer);
+    }
+
+    if (transfers.empty() &&
+        std::all_of(segments_.begin(), segments_.end(),
+                    [](const Segment& s) { return s.completed(); })) {
+      break;
+    }
+
+    int running = 0;
+    curl_multi_perform(multi, &running);
+
+    CURLMsg* message;
+    int queued;
+    while ((message = curl_multi_info_read(multi, &queued)) != nullptr) {
+      if (message->msg != CURLMSG_DONE) {
+        continue;
+      }
+
+      CURL* curl = message->easy_handle;
+      CURLcode code = message->data.result;
+      Transfer* transfer = nullptr;
+      curl_easy_getinfo(curl, CURLINFO_PRIVATE, &transfer);
+
+      curl_multi_remove_handle(multi, curl);
+      if (result == DownloadResult::kCompleted) {
+        result = FinishTransfer(transfer, code, now);
+      }
+
+      transfers.erase(
+          std::find(transfers.begin(), transfers.end(), transfer));
+      curl_easy_cleanup(curl);
+      curl_slist_free_all(transfer->headers);
+      delete transfer;
+    }
+
+    if (result != DownloadResult::kCompleted) {
+      break;
+    }
+
+    now = NowMs();
+    if (now - last_progress >= kProgressIntervalMs) {
+      last_progress = now;
+      if (!HashDownloaded()) {
+        error_ = strerror(errno);
+        result = DownloadResult::kFileError;
+        break;
+      }
+
+      int64_t received = 0;
+      for (const Segment& segment : segments_) {
+        received += segment.received;
+      }
+
+      progress(received, total_);
+    }
+
+    if (now - last_state >= kStateIntervalMs) {
+      last_state = now;
+      SaveState();
+    }
+
+    curl_multi_poll(multi, nullptr, 0, kProgressIntervalMs, nullptr);
+  }
+
+  // Stops the transfers left, if the download is interrupted.
+  for (Transfer* transfer : transfers) {
+    curl_multi_remove_handle(multi, transfer->curl);
+    curl_easy_cleanup(transfer->curl);
+    curl_slist_free_all(transfer->headers);
+    delete transfer;
+  }
+  curl_multi_cleanup(multi);
+
+  if (result == DownloadResult::kCompleted) {
+    int64_t hashed;
+    do {
+      hashed = hashed_;
+    } while (HashDownloaded() && hashed_ != hashed);
+
+    if (hashed_ != total_ || fdatasync(fd_) != 0 ||
+        rename(part_path_.c_str(), options_.path.c_str()) != 0) {
+      error_ = strerror(errno);
+      result = DownloadResult::kFileError;
+    } else {
+      unlink(state_path_.c_str());
+      sha256_ = hasher_.FinishHex();
+      progress(total_, total_);
+    }
+  } else if (result == DownloadResult::kCancelled ||
+             result == DownloadResult::kNetworkError) {
+    SaveState();
+  } else {
+    unlink(state_path_.c_str());
+  }
+
+  close(fd_);
+  fd_ = -1;
+  return result;
+}
@@ -0,0 +1,173 @@
+#ifndef RUNNER_SEGMENTED_DOWNLOAD_H_
+#define RUNNER_SEGMENTED_DOWNLOAD_H_
+
+#include <curl/curl.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "sha256.h"
+
+// Outcome of SegmentedDownload::Run().
+enum class DownloadResult {
+  kCompleted,
+  kCancelled,
+
+  // Server responded with an unexpected HTTP status.
+  kHttpError,
+
+  // Connection has failed more times than allowed in a row.
+  kNetworkError,
+
+  // Destination file can't be written.
+  kFileError,
+};
+
+// HTTP download of a single file over several connections, each fetching its
+// own Range segment of the file.
+//
+// The file is downloaded into a pre-allocated `.part` file next to the
+// destination, with the progress of the segments persisted in a `.part.state`
+// file, so an interrupted download is resumed from where it has stopped, as
+// long as the server reports the same size and validator (ETag or
+// Last-Modified) of the file. Connections finished early split the largest
+// of the remaining segments, and the dropped ones are retried with backoff.
+//
+// SHA-256 of the file is computed while downloading, over the contiguous
+// downloaded prefix of the file as it grows.
+class SegmentedDownload {
+ public:
+  struct Options {
+    std::string url;
+
+    // Path to write the downloaded file to.
+    std::string path;
+
+    // Additional HTTP headers in the `Name: value` form.
+    std::vector<std::string> headers;
+
+    // Maximum number of connections to download over.
+    int connections = 4;
+
+    // Minimum size of a segment worth its own connection.
+    int64_t min_segment_size = 4 * 1024 * 1024;
+
+    // Number of the failures in a row a segment is retried after.
+    int retries = 5;
+  };
+
+  // Callback receiving the number of the |received| bytes of the |total|
+  // ones, or -1 if the size isn't known.
+  typedef std::function<void(int64_t received, int64_t total)>
+      ProgressCallback;
+
+  explicit SegmentedDownload(Options options);
+  ~SegmentedDownload();
+
+  SegmentedDownload(const SegmentedDownload&) = delete;
+  SegmentedDownload& operator=(const SegmentedDownload&) = delete;
+
+  // Downloads the file, blocking until it's completed, failed or Cancel()ed,
+  // invoking the |progress| at most every 100 ms on the calling thread.
+  DownloadResult Run(const ProgressCallback& progress);
+
+  // Stops the Run() keeping the downloaded segments to be resumed later. May
+  // be called from any thread.
+  void Cancel() { cancelled_ = true; }
+
+  // Returns the lowercase hex SHA-256 digest of the completed file.
+  const std::string& sha256() const { return sha256_; }
+
+  // Returns the size of the completed file.
+  int64_t size() const { return total_; }
+
+  // Returns the HTTP status of the kHttpError result.
+  long status() const { return status_; }
+
+  // Returns the description of the failed result.
+  const std::string& error() const { return error_; }
+
+ private:
+  // Range of the file downloaded over a single connection at a time.
+  struct Segment {
+    int64_t start = 0;
+
+    // Exclusive end of the range, or -1 if the size isn't known.
+    int64_t end = -1;
+
+    int64_t received = 0;
+
+    // Number of the failures in a row and when to retry after the last one.
+    int failures = 0;
+    int64_t retry_at = 0;
+
+    // Indicator whether the segment is being transferred.
+    bool active = false;
+
+    int64_t offset() const { return start + received; }
+    bool completed() const { return end >= 0 && offset() >= end; }
+  };
+
+  struct Transfer;
+
+  // Requests the first byte of the file to determine its size, validator
+  // and whether it supports ranges.
+  DownloadResult Probe();
+
+  // Restores the segments from the state file, if it matches the file.
+  bool LoadState();
+  void SaveState();
+
+  // Splits the file into the |segments_| for the |options_.connections|.
+  void PlanSegments();
+
+  // Splits the largest of the remaining segments in half, returning the
+  // index of the new one, or -1 if none is large enough to be split.
+  int SplitLargestSegment();
+
+  // Returns the index of a segment not being transferred and not completed,
+  // due to be retried by the |now|, or -1 if there's none.
+  int NextPendingSegment(int64_t now) const;
+
+  // Hashes the contiguous downloaded prefix of the file not hashed yet.
+  bool HashDownloaded();
+
+  // Starts the transfer of the |segments_| at the |index| on the |multi|,
+  // returning nullptr if it can't be started.
+  Transfer* StartTransfer(CURLM* multi, int index);
+
+  // Handles the transfer finished with the |code|, returning kCompleted
+  // unless the whole download has to stop.
+  DownloadResult FinishTransfer(Transfer* transfer,
+                                CURLcode code,
+                                int64_t now);
+
+  static size_t OnWrite(char* data, size_t size, size_t count, void* user);
+
+  Options options_;
+  std::atomic<bool> cancelled_{false};
+
+  int fd_ = -1;
+  std::string part_path_;
+  std::string state_path_;
+
+  // Size of the file, or -1 if the server doesn't report it.
+  int64_t total_ = -1;
+  std::string validator_;
+  bool ranges_ = false;
+
+  std::vector<Segment> segments_;
+
+  Sha256 hasher_;
+  int64_t hashed_ = 0;
+  std::vector<uint8_t> hash_buffer_;
+  std::string sha256_;
+
+  long status_ = 0;
+  std::string error_;
+};
+
+#endif  // RUNNER_SEGMENTED_DOWNLOAD_H_
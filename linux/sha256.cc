@@ -0,0 +1,515 @@
+#include "sha256.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA256_X86 1
+#endif
+
+static const uint32_t kInitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static const uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t LoadBigEndian32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) |
+         (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+static inline void StoreBigEndian32(uint8_t* p, uint32_t value) {
+  p[0] = value >> 24;
+  p[1] = value >> 16;
+  p[2] = value >> 8;
+  p[3] = value;
+}
+
+static inline uint32_t RotateRight(uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+// Fills the |tail| with the padded last bytes of a message, returning the
+// number of 64-byte blocks written (either one or two).
+static size_t PadMessage(const uint8_t* remainder,
+                         size_t remainder_length,
+                         uint64_t total_length,
+                         uint8_t tail[128]) {
+  memset(tail, 0, 128);
+  memcpy(tail, remainder, remainder_length);
+  tail[remainder_length] = 0x80;
+
+  size_t blocks = remainder_length + 9 > 64 ? 2 : 1;
+  uint64_t bits = total_length * 8;
+  for (int i = 0; i < 8; ++i) {
+    tail[blocks * 64 - 1 - i] = static_cast<uint8_t>(bits >> (i * 8));
+  }
+
+  return blocks;
+}
+
+static void CompressScalar(uint32_t state[8],
+                           const uint8_t* data,
+                           size_t blocks) {
+  uint32_t w[64];
+
+  while (blocks--) {
+    for (int t = 0; t < 16; ++t) {
+      w[t] = LoadBigEndian32(data + t * 4);
+    }
+
+    for (int t = 16; t < 64; ++t) {
+      uint32_t s0 = RotateRight(w[t - 15], 7) ^ RotateRight(w[t - 15], 18) ^
+                    (w[t - 15] >> 3);
+      uint32_t s1 = RotateRight(w[t - 2], 17) ^ RotateRight(w[t - 2], 19) ^
+                    (w[t - 2] >> 10);
+      w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 64; ++t) {
+      uint32_t s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+      uint32_t ch = (e & f) ^ (~e & g);
+      uint32_t t1 = h + s1 + ch + kRoundConstants[t] + w[t];
+      uint32_t s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+      uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+      uint32_t t2 = s0 + maj;
+
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+
+    data += 64;
+  }
+}
+
+#ifdef SHA256_X86
+__attribute__((target("sha,sse4.1"))) static void CompressShaNi(
+    uint32_t state[8],
+    const uint8_t* data,
+    size_t blocks) {
+  const __m128i byte_swap =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+  // Rearrange the state into the ABEF/CDGH layout the instructions expect.
+  __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+  __m128i state1 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);
+  state1 = _mm_shuffle_epi32(state1, 0x1B);
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+  while (blocks--) {
+    __m128i abef = state0;
+    __m128i cdgh = state1;
+
+    // Sliding window of the last four message schedule groups.
+    __m128i w[4];
+
+    for (int i = 0; i < 16; ++i) {
+      __m128i group;
+      if (i < 4) {
+        group = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16)),
+            byte_swap);
+      } else {
+        group = _mm_sha256msg1_epu32(w[i % 4], w[(i + 1) % 4]);
+        group = _mm_add_epi32(
+            group, _mm_alignr_epi8(w[(i + 3) % 4], w[(i + 2) % 4], 4));
+        group = _mm_sha256msg2_epu32(group, w[(i + 3) % 4]);
+      }
+      w[i % 4] = group;
+
+      __m128i message = _mm_add_epi32(
+          group, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                     &kRoundConstants[i * 4])));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+      message = _mm_shuffle_epi32(message, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, message);
+    }
+
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+
+    data += 64;
+  }
+
+  // Rearrange the state back into the ABCD/EFGH layout.
+  tmp = _mm_shuffle_epi32(state0, 0x1B);
+  state1 = _mm_shuffle_epi32(state1, 0xB1);
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+  state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+// Number of messages hashed at once by CompressAvx2().
+static const int kLanes = 8;
+
+// Message being hashed in a lane of CompressAvx2().
+struct Lane {
+  const uint8_t* data;
+  size_t full_blocks;
+
+  // Padded last blocks of the message.
+  uint8_t tail[128];
+  size_t tail_blocks;
+
+  uint32_t state[8];
+};
+
+#define AVX2_ROTR(x, n) \
+  _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+
+// Hashes up to kLanes messages at once, each in its own 32-bit lane of the
+// AVX2 registers. Lanes running out of blocks keep their state untouched.
+__attribute__((target("avx2"))) static void CompressAvx2(Lane* lanes,
+                                                         int count) {
+  static const uint8_t kZeroBlock[64] = {};
+
+  size_t steps = 0;
+  for (int l = 0; l < count; ++l) {
+    steps = std::max(steps, lanes[l].full_blocks + lanes[l].tail_blocks);
+  }
+
+  __m256i state[8];
+  for (int i = 0; i < 8; ++i) {
+    alignas(32) uint32_t words[kLanes] = {};
+    for (int l = 0; l < count; ++l) {
+      words[l] = lanes[l].state[i];
+    }
+    state[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(words));
+  }
+
+  for (size_t step = 0; step < steps; ++step) {
+    const uint8_t* blocks[kLanes];
+    alignas(32) int32_t active[kLanes] = {};
+    for (int l = 0; l < kLanes; ++l) {
+      blocks[l] = kZeroBlock;
+      if (l >= count) {
+        continue;
+      }
+
+      const Lane& lane = lanes[l];
+      if (step < lane.full_blocks) {
+        blocks[l] = lane.data + step * 64;
+        active[l] = -1;
+      } else if (step < lane.full_blocks + lane.tail_blocks) {
+        blocks[l] = lane.tail + (step - lane.full_blocks) * 64;
+        active[l] = -1;
+      }
+    }
+
+    __m256i w[64];
+    for (int t = 0; t < 16; ++t) {
+      alignas(32) uint32_t words[kLanes];
+      for (int l = 0; l < kLanes; ++l) {
+        words[l] = LoadBigEndian32(blocks[l] + t * 4);
+      }
+      w[t] = _mm256_load_si256(reinterpret_cast<const __m256i*>(words));
+    }
+
+    for (int t = 16; t < 64; ++t) {
+      __m256i s0 = _mm256_xor_si256(
+          _mm256_xor_si256(AVX2_ROTR(w[t - 15], 7), AVX2_ROTR(w[t - 15], 18)),
+          _mm256_srli_epi32(w[t - 15], 3));
+      __m256i s1 = _mm256_xor_si256(
+          _mm256_xor_si256(AVX2_ROTR(w[t - 2], 17), AVX2_ROTR(w[t - 2], 19)),
+          _mm256_srli_epi32(w[t - 2], 10));
+      w[t] = _mm256_add_epi32(_mm256_add_epi32(w[t - 16], s0),
+                              _mm256_add_epi32(w[t - 7], s1));
+    }
+
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 64; ++t) {
+      __m256i s1 = _mm256_xor_si256(
+          _mm256_xor_si256(AVX2_ROTR(e, 6), AVX2_ROTR(e, 11)),
+          AVX2_ROTR(e, 25));
+      __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f),
+                                    _mm256_andnot_si256(e, g));
+      __m256i t1 = _mm256_add_epi32(
+          _mm256_add_epi32(_mm256_add_epi32(h, s1), ch),
+          _mm256_add_epi32(_mm256_set1_epi32(kRoundConstants[t]), w[t]));
+      __m256i s0 = _mm256_xor_si256(
+          _mm256_xor_si256(AVX2_ROTR(a, 2), AVX2_ROTR(a, 13)),
+          AVX2_ROTR(a, 22));
+      __m256i maj = _mm256_xor_si256(
+          _mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+          _mm256_and_si256(b, c));
+      __m256i t2 = _mm256_add_epi32(s0, maj);
+
+      h = g;
+      g = f;
+      f = e;
+      e = _mm256_add_epi32(d, t1);
+      d = c;
+      c = b;
+      b = a;
+      a = _mm256_add_epi32(t1, t2);
+    }
+
+    const __m256i mask =
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(active));
+    const __m256i rounds[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; ++i) {
+      state[i] = _mm256_blendv_epi8(
+          state[i], _mm256_add_epi32(state[i], rounds[i]), mask);
+    }
+  }
+
+  for (int i = 0; i < 8; ++i) {
+    alignas(32) uint32_t words[kLanes];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(words), state[i]);
+    for (int l = 0; l < count; ++l) {
+      lanes[l].state[i] = words[l];
+    }
+  }
+}
+
+#undef AVX2_ROTR
+
+static bool CpuSupportsShaNi() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  bool sha = (ebx & (1u << 29)) != 0;
+
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  bool ssse3 = (ecx & (1u << 9)) != 0;
+  bool sse41 = (ecx & (1u << 19)) != 0;
+
+  return sha && ssse3 && sse41;
+}
+
+static bool CpuSupportsAvx2() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+
+  // The OS must save the YMM registers on context switches.
+  bool osxsave = (ecx & (1u << 27)) != 0;
+  bool avx = (ecx & (1u << 28)) != 0;
+  if (!osxsave || !avx) {
+    return false;
+  }
+
+  unsigned int xcr0_low, xcr0_high;
+  __asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+  if ((xcr0_low & 0x6) != 0x6) {
+    return false;
+  }
+
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+
+  return (ebx & (1u << 5)) != 0;
+}
+#endif  // SHA256_X86
+
+Sha256Kernel Sha256SingleBufferKernel() {
+#ifdef SHA256_X86
+  static const Sha256Kernel kernel =
+      CpuSupportsShaNi() ? Sha256Kernel::kShaNi : Sha256Kernel::kScalar;
+  return kernel;
+#else
+  return Sha256Kernel::kScalar;
+#endif
+}
+
+Sha256Kernel Sha256MultiBufferKernel() {
+#ifdef SHA256_X86
+  // SHA extensions hashing the messages one by one outrun the multi-buffer
+  // AVX2 implementation, so the latter is only used without them.
+  static const Sha256Kernel kernel =
+      Sha256SingleBufferKernel() == Sha256Kernel::kShaNi
+          ? Sha256Kernel::kShaNi
+          : (CpuSupportsAvx2() ? Sha256Kernel::kAvx2MultiBuffer
+                               : Sha256Kernel::kScalar);
+  return kernel;
+#else
+  return Sha256Kernel::kScalar;
+#endif
+}
+
+const char* Sha256KernelName(Sha256Kernel kernel) {
+  switch (kernel) {
+    case Sha256Kernel::kScalar:
+      return "scalar";
+    case Sha256Kernel::kShaNi:
+      return "sha-ni";
+    case Sha256Kernel::kAvx2MultiBuffer:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+static void Compress(uint32_t state[8], const uint8_t* data, size_t blocks) {
+#ifdef SHA256_X86
+  if (Sha256SingleBufferKernel() == Sha256Kernel::kShaNi) {
+    return CompressShaNi(state, data, blocks);
+  }
+#endif
+  CompressScalar(state, data, blocks);
+}
+
+Sha256::Sha256() {
+  memcpy(state_, kInitialState, sizeof(state_));
+}
+
+void Sha256::Update(const void* data, size_t length) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  length_ += length;
+
+  if (buffered_ > 0) {
+    size_t taken = std::min(length, sizeof(buffer_) - buffered_);
+    memcpy(buffer_ + buffered_, bytes, taken);
+    buffered_ += taken;
+    bytes += taken;
+    length -= taken;
+
+    if (buffered_ < sizeof(buffer_)) {
+      return;
+    }
+
+    Compress(state_, buffer_, 1);
+    buffered_ = 0;
+  }
+
+  size_t blocks = length / 64;
+  if (blocks > 0) {
+    Compress(state_, bytes, blocks);
+    bytes += blocks * 64;
+    length -= blocks * 64;
+  }
+
+  memcpy(buffer_, bytes, length);
+  buffered_ = length;
+}
+
+void Sha256::Finish(uint8_t digest[kDigestSize]) {
+  uint8_t tail[128];
+  size_t blocks = PadMessage(buffer_, buffered_, length_, tail);
+  Compress(state_, tail, blocks);
+
+  for (int i = 0; i < 8; ++i) {
+    StoreBigEndian32(digest + i * 4, state_[i]);
+  }
+}
+
+std::string Sha256::FinishHex() {
+  uint8_t digest[kDigestSize];
+  Finish(digest);
+  return Sha256Hex(digest);
+}
+
+std::string Sha256Hex(const uint8_t digest[Sha256::kDigestSize]) {
+  static const char kHex[] = "0123456789abcdef";
+
+  std::string hex(Sha256::kDigestSize * 2, '0');
+  for (size_t i = 0; i < Sha256::kDigestSize; ++i) {
+    hex[i * 2] = kHex[digest[i] >> 4];
+    hex[i * 2 + 1] = kHex[digest[i] & 0xf];
+  }
+
+  return hex;
+}
+
+std::vector<std::string> Sha256Batch(
+    const std::vector<Sha256Message>& messages) {
+  std::vector<std::string> digests(messages.size());
+
+#ifdef SHA256_X86
+  if (Sha256MultiBufferKernel() == Sha256Kernel::kAvx2MultiBuffer &&
+      messages.size() > 1) {
+    // Group the messages of similar lengths together, so the lanes finish at
+    // roughly the same time.
+    std::vector<size_t> order(messages.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&messages](size_t a, size_t b) {
+      return messages[a].length < messages[b].length;
+    });
+
+    Lane lanes[kLanes];
+    for (size_t start = 0; start < order.size(); start += kLanes) {
+      int count = static_cast<int>(
+          std::min(order.size() - start, static_cast<size_t>(kLanes)));
+
+      for (int l = 0; l < count; ++l) {
+        const Sha256Message& message = messages[order[start + l]];
+        Lane& lane = lanes[l];
+        lane.data = message.data;
+        lane.full_blocks = message.length / 64;
+        lane.tail_blocks =
+            PadMessage(message.data + lane.full_blocks * 64,
+                       message.length % 64, message.length, lane.tail);
+        memcpy(lane.state, kInitialState, sizeof(lane.state));
+      }
+
+      CompressAvx2(lanes, count);
+
+      for (int l = 0; l < count; ++l) {
+        uint8_t digest[Sha256::kDigestSize];
+        for (int i = 0; i < 8; ++i) {
+          StoreBigEndian32(digest + i * 4, lanes[l].state[i]);
+        }
+        digests[order[start + l]] = Sha256Hex(digest);
+      }
+    }
+
+    return digests;
+  }
+#endif
+
+  for (size_t i = 0; i < messages.size(); ++i) {
+    Sha256 hasher;
+    hasher.Update(messages[i].data, messages[i].length);
+    digests[i] = hasher.FinishHex();
+  }
+
+  return digests;
+}
@@ -0,0 +1,70 @@
+#ifndef RUNNER_SHA256_H_
+#define RUNNER_SHA256_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// Implementation of the SHA-256 compression function.
+enum class Sha256Kernel {
+  // Portable C++ implementation.
+  kScalar,
+
+  // x86 SHA extensions, hashing a single message at a time.
+  kShaNi,
+
+  // AVX2 implementation, hashing up to 8 messages at once.
+  kAvx2MultiBuffer,
+};
+
+// Returns the fastest Sha256Kernel for hashing a single message supported by
+// the current CPU.
+Sha256Kernel Sha256SingleBufferKernel();
+
+// Returns the fastest Sha256Kernel for hashing a batch of messages supported
+// by the current CPU.
+Sha256Kernel Sha256MultiBufferKernel();
+
+// Returns the human-readable name of the |kernel|.
+const char* Sha256KernelName(Sha256Kernel kernel);
+
+// Incremental SHA-256 hasher of a single message.
+class Sha256 {
+ public:
+  static const size_t kDigestSize = 32;
+
+  Sha256();
+
+  // Appends the |length| bytes of |data| to the message.
+  void Update(const void* data, size_t length);
+
+  // Completes the message, writing its digest to |digest|.
+  void Finish(uint8_t digest[kDigestSize]);
+
+  // Completes the message, returning its digest as a lowercase hex string.
+  std::string FinishHex();
+
+ private:
+  uint32_t state_[8];
+  uint64_t length_ = 0;
+  uint8_t buffer_[64];
+  size_t buffered_ = 0;
+};
+
+// Message to hash with Sha256Batch().
+struct Sha256Message {
+  const uint8_t* data;
+  size_t length;
+};
+
+// Hashes the |messages| using the multi-buffer kernel when it's available,
+// returning their digests as lowercase hex strings.
+std::vector<std::string> Sha256Batch(
+    const std::vector<Sha256Message>& messages);
+
+// Returns the lowercase hex representation of the |digest|.
+std::string Sha256Hex(const uint8_t digest[Sha256::kDigestSize]);
+
+#endif  // RUNNER_SHA256_H_
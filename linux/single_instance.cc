@@ -0,0 +1,113 @@
+#include "single_instance.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char kForwardAction[] = "forward-arguments";
+
+static FlEventChannel* arguments_channel = nullptr;
+static bool arguments_listened = false;
+
+// Lists of the arguments forwarded while the channel isn't listened to.
+static FlValue* pending_arguments = nullptr;
+
+static FlMethodErrorResponse* on_arguments_listen(FlEventChannel* channel,
+                                                  FlValue* args,
+                                                  gpointer user_data) {
+  arguments_listened = true;
+
+  if (pending_arguments != nullptr) {
+    for (size_t i = 0; i < fl_value_get_length(pending_arguments); ++i) {
+      fl_event_channel_send(arguments_channel,
+                            fl_value_get_list_value(pending_arguments, i),
+                            nullptr, nullptr);
+    }
+    g_clear_pointer(&pending_arguments, fl_value_unref);
+  }
+
+  return nullptr;
+}
+
+static FlMethodErrorResponse* on_arguments_cancel(FlEventChannel* channel,
+                                                  FlValue* args,
+                                                  gpointer user_data) {
+  arguments_listened = false;
+  return nullptr;
+}
+
+static void forward_arguments_cb(GSimpleAction* action,
+                                 GVariant* parameter,
+                                 gpointer user_data) {
+  // Focus is allowed to be taken, as the `desktop-startup-id` of the
+  // forwarding process is applied by the #GtkApplication already.
+  GtkWindow* window =
+      gtk_application_get_active_window(GTK_APPLICATION(user_data));
+  if (window != nullptr) {
+    gtk_window_present(window);
+  }
+
+  g_autoptr(FlValue) event = fl_value_new_list();
+  g_autofree const gchar** arguments = g_variant_get_strv(parameter, nullptr);
+  for (const gchar** argument = arguments; *argument != nullptr; ++argument) {
+    fl_value_append_take(event, fl_value_new_string(*argument));
+  }
+
+  if (arguments_channel != nullptr && arguments_listened) {
+    fl_event_channel_send(arguments_channel, event, nullptr, nullptr);
+  } else {
+    if (pending_arguments == nullptr) {
+      pending_arguments = fl_value_new_list();
+    }
+    fl_value_append(pending_arguments, event);
+  }
+}
+
+gboolean single_instance_enabled() {
+  const char* value = getenv("MESSENGER_SINGLE_INSTANCE");
+  return value == nullptr || strcmp(value, "0") != 0;
+}
+
+gboolean single_instance_forward(GApplication* application,
+                                 gchar** arguments) {
+  if (!g_application_get_is_remote(application)) {
+    return FALSE;
+  }
+
+  g_action_group_activate_action(
+      G_ACTION_GROUP(application), kForwardAction,
+      g_variant_new_strv(arguments, -1));
+
+  // The action is sent without waiting for a reply, so it must be written
+  // out before the process exits.
+  GDBusConnection* connection = g_application_get_dbus_connection(application);
+  g_autoptr(GError) error = nullptr;
+  if (connection != nullptr &&
+      !g_dbus_connection_flush_sync(connection, nullptr, &error)) {
+    g_warning("Failed to forward the arguments: %s", error->message);
+  }
+
+  return TRUE;
+}
+
+void single_instance_startup(GtkApplication* application) {
+  g_autoptr(GSimpleAction) action =
+      g_simple_action_new(kForwardAction, G_VARIANT_TYPE_STRING_ARRAY);
+  g_signal_connect(action, "activate", G_CALLBACK(forward_arguments_cb),
+                   application);
+  g_action_map_add_action(G_ACTION_MAP(application), G_ACTION(action));
+}
+
+void single_instance_init(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  arguments_channel = fl_event_channel_new(
+      messenger, "team113.flutter.dev/linux_utils/arguments",
+      FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(arguments_channel, on_arguments_listen,
+                                       on_arguments_cancel, nullptr, nullptr);
+}
+
+void single_instance_dispose() {
+  g_clear_object(&arguments_channel);
+  g_clear_pointer(&pending_arguments, fl_value_unref);
+  arguments_listened = false;
+}
@@ -0,0 +1,67 @@
+#ifndef RUNNER_SINGLE_INSTANCE_H_
+#define RUNNER_SINGLE_INSTANCE_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+// The application is unique on the session bus: launching it again (e.g. by
+// opening a link) registers the #GApplication as a remote one, which forwards
+// its command line to the running instance via the `forward-arguments` action
+// and exits, instead of starting another Flutter engine.
+//
+// Setting the `MESSENGER_SINGLE_INSTANCE=0` environment variable allows
+// several instances to run side by side instead, e.g. to log in with
+// different accounts.
+
+/**
+ * single_instance_enabled:
+ *
+ * Returns: %TRUE if the application should be registered as a unique one.
+ */
+gboolean single_instance_enabled();
+
+/**
+ * single_instance_forward:
+ * @application: registered #GApplication.
+ * @arguments: (array zero-terminated=1): command line arguments without the
+ * binary name.
+ *
+ * Forwards the @arguments to the primary instance, if the @application is a
+ * remote one, raising its window.
+ *
+ * Returns: %TRUE if the @arguments were forwarded, so this process should
+ * exit.
+ */
+gboolean single_instance_forward(GApplication* application, gchar** arguments);
+
+/**
+ * single_instance_startup:
+ * @application: primary #GtkApplication.
+ *
+ * Adds the `forward-arguments` action to the @application, presenting its
+ * window and sending the forwarded arguments over the arguments event channel.
+ *
+ * Must be called on the #GApplication::startup, as the action is invoked by a
+ * remote instance as soon as the @application is registered, which happens
+ * before it's activated.
+ */
+void single_instance_startup(GtkApplication* application);
+
+/**
+ * single_instance_init:
+ * @messenger: #FlBinaryMessenger to create the arguments event channel on.
+ *
+ * Creates the `team113.flutter.dev/linux_utils/arguments` event channel,
+ * sending the forwarded arguments as lists of strings. Arguments forwarded
+ * before the channel is listened to are queued until it is.
+ */
+void single_instance_init(FlBinaryMessenger* messenger);
+
+/**
+ * single_instance_dispose:
+ *
+ * Closes the arguments event channel, dropping the queued arguments.
+ */
+void single_instance_dispose();
+
+#endif  // RUNNER_SINGLE_INSTANCE_H_
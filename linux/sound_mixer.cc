@@ -0,0 +1,253 @@
+#include "sound_mixer.h"
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+#ifdef HAVE_SNDFILE
+#include <sndfile.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef HAVE_SNDFILE
+// Number of the frames decoded at once.
+static const sf_count_t kDecodeChunkFrames = 4096;
+#endif
+
+// Makes the calling thread preempt everything else, if permitted, as a late
+// period is heard as a click.
+static void RaiseThreadPriority() {
+  sched_param param = {};
+  param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+  if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+    // Niceness is per-thread on Linux, so this doesn't affect other threads.
+    setpriority(PRIO_PROCESS, 0, -10);
+  }
+}
+
+// Returns the monotonic time in microseconds.
+static int64_t Now() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::unique_ptr<Sound> Sound::Decode(const std::string& path) {
+#ifndef HAVE_SNDFILE
+  return nullptr;
+#else
+  SF_INFO info = {};
+  SNDFILE* file = sf_open(path.c_str(), SFM_READ, &info);
+  if (file == nullptr) {
+    return nullptr;
+  }
+
+  if (info.channels <= 0 || info.samplerate <= 0) {
+    sf_close(file);
+    return nullptr;
+  }
+
+  // Number of the frames isn't exact for the compressed formats, so they are
+  // read till the end.
+  std::vector<float> input;
+  sf_count_t read = 0;
+  while (true) {
+    input.resize((read + kDecodeChunkFrames) * info.channels);
+    sf_count_t count = sf_readf_float(file, input.data() + read * info.channels,
+                                      kDecodeChunkFrames);
+    if (count <= 0) {
+      break;
+    }
+
+    read += count;
+  }
+  input.resize(read * info.channels);
+  sf_close(file);
+
+  if (read == 0) {
+    return nullptr;
+  }
+
+  // Resampled linearly, which is transparent enough for the short sounds
+  // being mostly at 44.1 or 48 kHz already.
+  double step = static_cast<double>(info.samplerate) / kAudioSampleRate;
+  size_t frames = static_cast<size_t>(ceil(read / step));
+
+  std::unique_ptr<Sound> sound(new Sound());
+  sound->samples.resize(frames * kAudioChannels);
+  for (size_t i = 0; i < frames; ++i) {
+    double position = i * step;
+    sf_count_t from = std::min<sf_count_t>(position, read - 1);
+    sf_count_t to = std::min<sf_count_t>(from + 1, read - 1);
+    float fraction = static_cast<float>(position - from);
+
+    // Mono is duplicated to both channels, while the channels beyond the
+    // front pair are dropped.
+    for (int channel = 0; channel < kAudioChannels; ++channel) {
+      int source = std::min(channel, info.channels - 1);
+      float a = input[from * info.channels + source];
+      float b = input[to * info.channels + source];
+      float sample = std::min(std::max(a + (b - a) * fraction, -1.0f), 1.0f);
+      sound->samples[i * kAudioChannels + channel] =
+          static_cast<int16_t>(lrintf(sample * 32767));
+    }
+  }
+
+  return sound;
+#endif
+}
+
+SoundMixer::SoundMixer()
+    : mix_(kPeriodFrames * kAudioChannels),
+      output_(kPeriodFrames * kAudioChannels) {
+  sem_init(&wake_, 0, 0);
+  voices_.reserve(kMaxVoices);
+}
+
+SoundMixer::~SoundMixer() {
+  Stop();
+  sem_destroy(&wake_);
+}
+
+void SoundMixer::Start(const std::string& spec) {
+  if (thread_.joinable()) {
+    return;
+  }
+
+  stopping_.store(false);
+  failed_.store(false);
+  thread_ = std::thread(&SoundMixer::Run, this, spec);
+}
+
+void SoundMixer::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+
+  stopping_.store(true);
+  sem_post(&wake_);
+  thread_.join();
+
+  // Commands left are dropped along with the voices.
+  head_.store(tail_.load());
+  played_.clear();
+}
+
+SoundPlayback SoundMixer::Play(const Sound* sound, float gain) {
+  if (!thread_.joinable() || failed_.load(std::memory_order_acquire)) {
+    return SoundPlayback::kFailed;
+  }
+
+  int64_t now = Now();
+  auto played = played_.find(sound);
+  if (played != played_.end() && now - played->second < kRepeatInterval) {
+    return SoundPlayback::kThrottled;
+  }
+
+  uint32_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail - head_.load(std::memory_order_acquire) == kQueueSize) {
+    return SoundPlayback::kFailed;
+  }
+
+  gain = std::min(std::max(gain, 0.0f), 1.0f);
+  commands_[tail % kQueueSize] =
+      Command{sound, static_cast<int32_t>(lrintf(gain * 32768))};
+  tail_.store(tail + 1, std::memory_order_release);
+  sem_post(&wake_);
+
+  played_[sound] = now;
+  return SoundPlayback::kQueued;
+}
+
+void SoundMixer::Run(std::string spec) {
+  pthread_setname_np(pthread_self(), "sound-mixer");
+  RaiseThreadPriority();
+
+  std::unique_ptr<AudioSink> sink =
+      AudioSink::Open(spec.empty() ? nullptr : spec.c_str());
+  if (sink == nullptr) {
+    failed_.store(true, std::memory_order_release);
+    return;
+  }
+
+  int tail_periods = 0;
+  while (!stopping_.load(std::memory_order_acquire)) {
+    Dequeue();
+
+    if (!voices_.empty()) {
+      Mix();
+      tail_periods = kTailPeriods;
+    } else if (tail_periods > 0) {
+      std::fill(output_.begin(), output_.end(), 0);
+      --tail_periods;
+    } else {
+      // Posts of the commands already dequeued only make this loop once more.
+      while (sem_wait(&wake_) != 0 && errno == EINTR) {
+      }
+      continue;
+    }
+
+    if (!sink->Write(output_.data(), kPeriodFrames)) {
+      failed_.store(true, std::memory_order_release);
+      break;
+    }
+  }
+
+  voices_.clear();
+}
+
+void SoundMixer::Dequeue() {
+  uint32_t head = head_.load(std::memory_order_relaxed);
+  uint32_t tail = tail_.load(std::memory_order_acquire);
+
+  for (; head != tail; ++head) {
+    const Command& command = commands_[head % kQueueSize];
+
+    if (voices_.size() == kMaxVoices) {
+      voices_.erase(std::max_element(
+          voices_.begin(), voices_.end(), [](const Voice& a, const Voice& b) {
+            return a.position < b.position;
+          }));
+    }
+
+    voices_.push_back(Voice{command.sound, command.gain, 0});
+  }
+
+  head_.store(head, std::memory_order_release);
+}
+
+void SoundMixer::Mix() {
+  std::fill(mix_.begin(), mix_.end(), 0);
+
+  for (Voice& voice : voices_) {
+    size_t frames = voice.sound->frames() - voice.position;
+    if (frames > kPeriodFrames) {
+      frames = kPeriodFrames;
+    }
+    const int16_t* samples =
+        voice.sound->samples.data() + voice.position * kAudioChannels;
+
+    for (size_t i = 0; i < frames * kAudioChannels; ++i) {
+      mix_[i] += (samples[i] * voice.gain) >> 15;
+    }
+
+    voice.position += frames;
+  }
+
+  voices_.erase(std::remove_if(voices_.begin(), voices_.end(),
+                               [](const Voice& voice) {
+                                 return voice.position >=
+                                        voice.sound->frames();
+                               }),
+                voices_.end());
+
+  // Sounds peaking together are clipped rather than wrapped around.
+  for (size_t i = 0; i < mix_.size(); ++i) {
+    output_[i] = static_cast<int16_t>(
+        std::min<int32_t>(std::max<int32_t>(mix_[i], INT16_MIN), INT16_MAX));
+  }
+}
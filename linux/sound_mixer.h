@@ -0,0 +1,144 @@
+#ifndef RUNNER_SOUND_MIXER_H_
+#define RUNNER_SOUND_MIXER_H_
+
+#include <semaphore.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "audio_sink.h"
+
+// Sound decoded to the frames of an AudioSink, kept resident to be played by
+// a SoundMixer without any decoding.
+struct Sound {
+  // Decodes the audio file at |path| in any of the formats libsndfile reads,
+  // including WAV, MP3 and Ogg Vorbis, resampling it to the frames of an
+  // AudioSink.
+  //
+  // Returns nullptr, if the file can't be decoded, or the runner is built
+  // without libsndfile.
+  static std::unique_ptr<Sound> Decode(const std::string& path);
+
+  // Interleaved frames of the sound.
+  std::vector<int16_t> samples;
+
+  // Returns the number of the frames of the sound.
+  size_t frames() const { return samples.size() / kAudioChannels; }
+
+  // Returns the duration of the sound in microseconds.
+  int64_t duration() const {
+    return static_cast<int64_t>(frames()) * 1000000 / kAudioSampleRate;
+  }
+};
+
+// Result of SoundMixer::Play().
+enum class SoundPlayback {
+  // Sound is queued to be mixed in.
+  kQueued,
+
+  // Sound is dropped, as the same one was played too recently.
+  kThrottled,
+
+  // Sound can't be played, as the mixer isn't running or is overloaded.
+  kFailed,
+};
+
+// Mixes the concurrently played Sounds into an AudioSink on a dedicated
+// thread, running with the real-time priority, if permitted.
+//
+// Sounds are queued from the main thread through a lock-free ring buffer, so
+// queueing never waits for the mixing, while the mixing thread never waits
+// for anything but the sink. The mixing thread sleeps, while there's nothing
+// to play.
+class SoundMixer {
+ public:
+  // Interval, within which the same Sound played again is dropped, in
+  // microseconds.
+  static const int64_t kRepeatInterval = 150000;
+
+  SoundMixer();
+  ~SoundMixer();
+
+  SoundMixer(const SoundMixer&) = delete;
+  SoundMixer& operator=(const SoundMixer&) = delete;
+
+  // Starts mixing into the AudioSink opened with the |spec|, see
+  // AudioSink::Open(). The sink is opened on the mixing thread, so this never
+  // blocks.
+  void Start(const std::string& spec);
+
+  // Stops mixing, dropping the Sounds still being played.
+  void Stop();
+
+  // Queues the |sound| to be played with the |gain| from 0 to 1. Must be
+  // called on the thread the mixer is started on.
+  //
+  // The |sound| must outlive the mixer, or at least the Stop() of it.
+  SoundPlayback Play(const Sound* sound, float gain);
+
+ private:
+  // Command queued by Play() for the mixing thread.
+  struct Command {
+    const Sound* sound;
+
+    // Gain in the Q15 fixed point.
+    int32_t gain;
+  };
+
+  // Sound being played on the mixing thread.
+  struct Voice {
+    const Sound* sound;
+    int32_t gain;
+    size_t position;
+  };
+
+  // Capacity of the |commands_| ring buffer, a power of two.
+  static const uint32_t kQueueSize = 64;
+
+  // Maximum number of the sounds played at once, the oldest one being cut
+  // off to play a new one.
+  static const size_t kMaxVoices = 16;
+
+  // Number of the frames mixed at once, which is 10 ms.
+  static const size_t kPeriodFrames = kAudioSampleRate / 100;
+
+  // Number of the silent periods written after the last sound ends, so the
+  // sink plays out its tail before going idle.
+  static const int kTailPeriods = 2;
+
+  // Body of the |thread_|.
+  void Run(std::string spec);
+
+  // Moves the commands queued into the |voices_|.
+  void Dequeue();
+
+  // Mixes the next period of the |voices_| into the |output_|.
+  void Mix();
+
+  Command commands_[kQueueSize];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+
+  // Posted on each command queued or on stopping, waking the mixing thread.
+  sem_t wake_;
+
+  std::atomic<bool> stopping_{false};
+  std::atomic<bool> failed_{false};
+  std::thread thread_;
+
+  // Accessed on the mixing thread only.
+  std::vector<Voice> voices_;
+  std::vector<int32_t> mix_;
+  std::vector<int16_t> output_;
+
+  // Accessed on the thread the mixer is started on only.
+  std::unordered_map<const Sound*, int64_t> played_;
+};
+
+#endif  // RUNNER_SOUND_MIXER_H_
@@ -0,0 +1,193 @@
+#include "sound_service.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sound_mixer.h"
+#include "worker_pool.h"
+
+// Decoding of the assets from a single `preloadSounds` call.
+struct PreloadJob {
+  FlMethodCall* method_call;
+  std::vector<std::string> assets;
+
+  // Sounds decoded from the |assets|, or nullptrs for the failed ones.
+  std::vector<std::unique_ptr<Sound>> sounds;
+};
+
+static SoundMixer* mixer = nullptr;
+
+// Sounds preloaded by their assets, accessed on the main thread only, and
+// kept until the |mixer| is stopped, as it plays them without any copying.
+static std::map<std::string, std::unique_ptr<Sound>> sounds;
+
+// Returns the path to the |asset| bundled with the application.
+static std::string asset_path(const std::string& asset) {
+  g_autofree gchar* executable =
+      g_file_read_link("/proc/self/exe", nullptr);
+  g_autofree gchar* bundle =
+      executable == nullptr ? g_strdup(".") : g_path_get_dirname(executable);
+  g_autofree gchar* path = g_build_filename(
+      bundle, "data", "flutter_assets", "assets", asset.c_str(), nullptr);
+  return path;
+}
+
+static gboolean finish_preload(gpointer user_data) {
+  std::unique_ptr<PreloadJob> job(static_cast<PreloadJob*>(user_data));
+
+  // Sounds decoded after sound_service_dispose() aren't kept, as the engine
+  // is gone.
+  if (mixer != nullptr) {
+    g_autoptr(FlValue) result = fl_value_new_list();
+    for (size_t i = 0; i < job->assets.size(); ++i) {
+      if (job->sounds[i] != nullptr) {
+        sounds.emplace(job->assets[i], std::move(job->sounds[i]));
+      }
+
+      if (sounds.count(job->assets[i]) != 0) {
+        fl_value_append_take(result,
+                             fl_value_new_string(job->assets[i].c_str()));
+      }
+    }
+
+    g_autoptr(FlMethodResponse) response =
+        FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(job->method_call, response, &error)) {
+      g_warning("Failed to send response: %s", error->message);
+    }
+  }
+
+  g_object_unref(job->method_call);
+  return G_SOURCE_REMOVE;
+}
+
+static FlMethodResponse* preload_sounds(FlMethodCall* method_call,
+                                        FlValue* args) {
+  FlValue* assets = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    assets = fl_value_lookup_string(args, "assets");
+  }
+
+  if (assets == nullptr || fl_value_get_type(assets) != FL_VALUE_TYPE_LIST) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`assets` must be a list of strings", nullptr));
+  }
+
+  std::unique_ptr<PreloadJob> job(new PreloadJob());
+  for (size_t i = 0; i < fl_value_get_length(assets); ++i) {
+    FlValue* asset = fl_value_get_list_value(assets, i);
+    if (fl_value_get_type(asset) != FL_VALUE_TYPE_STRING) {
+      continue;
+    }
+
+    // Assets must not escape the bundle.
+    std::string value = fl_value_get_string(asset);
+    if (!value.empty() && value.find("..") == std::string::npos) {
+      job->assets.push_back(value);
+    }
+  }
+  job->sounds.resize(job->assets.size());
+  job->method_call = FL_METHOD_CALL(g_object_ref(method_call));
+
+  if (mixer == nullptr) {
+    const char* sink = getenv("MESSENGER_SOUND_SINK");
+    mixer = new SoundMixer();
+    mixer->Start(sink == nullptr ? std::string() : sink);
+  }
+
+  // Sounds preloaded already are only responded with.
+  std::vector<std::string> paths;
+  for (const std::string& asset : job->assets) {
+    paths.push_back(sounds.count(asset) == 0 ? asset_path(asset)
+                                             : std::string());
+  }
+
+  PreloadJob* held = job.release();
+  WorkerPool::Shared()->Post([held, paths] {
+    for (size_t i = 0; i < paths.size(); ++i) {
+      if (!paths[i].empty()) {
+        held->sounds[i] = Sound::Decode(paths[i]);
+      }
+    }
+
+    g_main_context_invoke(nullptr, finish_preload, held);
+  });
+
+  return nullptr;
+}
+
+static FlMethodResponse* play_sound(FlValue* args) {
+  FlValue* asset = nullptr;
+  FlValue* gain = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    asset = fl_value_lookup_string(args, "asset");
+    gain = fl_value_lookup_string(args, "gain");
+  }
+
+  if (asset == nullptr || fl_value_get_type(asset) != FL_VALUE_TYPE_STRING) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`asset` must be a string", nullptr));
+  }
+
+  g_autoptr(FlValue) result = nullptr;
+
+  auto sound = sounds.find(fl_value_get_string(asset));
+  if (mixer != nullptr && sound != sounds.end()) {
+    double volume = gain != nullptr &&
+                            fl_value_get_type(gain) == FL_VALUE_TYPE_FLOAT
+                        ? fl_value_get_float(gain)
+                        : 1;
+
+    switch (mixer->Play(sound->second.get(), volume)) {
+      case SoundPlayback::kQueued:
+        result = fl_value_new_int(sound->second->duration());
+        break;
+
+      case SoundPlayback::kThrottled:
+        result = fl_value_new_int(0);
+        break;
+
+      case SoundPlayback::kFailed:
+        break;
+    }
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+gboolean sound_service_handle_method_call(FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "preloadSounds") == 0) {
+    response = preload_sounds(method_call, args);
+  } else if (strcmp(method, "playSound") == 0) {
+    response = play_sound(args);
+  } else {
+    return FALSE;
+  }
+
+  // Only the preloading is responded to asynchronously.
+  if (response != nullptr) {
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(method_call, response, &error)) {
+      g_warning("Failed to send response: %s", error->message);
+    }
+  }
+
+  return TRUE;
+}
+
+void sound_service_dispose() {
+  delete mixer;
+  mixer = nullptr;
+
+  sounds.clear();
+}
@@ -0,0 +1,32 @@
+#ifndef RUNNER_SOUND_SERVICE_H_
+#define RUNNER_SOUND_SERVICE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * sound_service_handle_method_call:
+ * @method_call: #FlMethodCall received on the utils channel.
+ *
+ * Handles the `preloadSounds` method, decoding the `{assets}` of the bundle
+ * on the #WorkerPool into the resident #Sounds and responding with the ones
+ * decoded, and the `playSound` method, queueing the preloaded `{asset, gain}`
+ * to the #SoundMixer and responding with its duration in microseconds, `0`,
+ * if it's throttled as played too recently, or %NULL, if it can't be played.
+ *
+ * The #SoundMixer is started on the first `preloadSounds`, mixing into the
+ * #AudioSink named by the `MESSENGER_SOUND_SINK` environment variable, so
+ * the headless tests may set it to `null` or `wav:<path>`.
+ *
+ * Returns: %TRUE if the @method_call was handled by this service.
+ */
+gboolean sound_service_handle_method_call(FlMethodCall* method_call);
+
+/**
+ * sound_service_dispose:
+ *
+ * Stops the #SoundMixer, waiting for its thread to finish, and frees the
+ * #Sounds preloaded.
+ */
+void sound_service_dispose();
+
+#endif  // RUNNER_SOUND_SERVICE_H_
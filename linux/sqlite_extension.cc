@@ -0,0 +1,11 @@
+#include "sqlite_extension.h"
+
+#include "database_maintenance.h"
+#include "message_tokenizer.h"
+
+int messenger_sqlite3_init(sqlite3* db,
+                           char** error,
+                           const sqlite3_api_routines* api) {
+  DatabaseMaintenance::Shared()->Watch(db, api);
+  return RegisterMessageTokenizer(db, api);
+}
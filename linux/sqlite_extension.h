@@ -0,0 +1,34 @@
+#ifndef RUNNER_SQLITE_EXTENSION_H_
+#define RUNNER_SQLITE_EXTENSION_H_
+
+#include <sqlite3.h>
+
+#include "runner_export.h"
+
+/**
+ * messenger_sqlite3_init:
+ * @db: #sqlite3 connection being opened.
+ * @error: (out): error message allocated with `sqlite3_malloc()`.
+ * @api: routines of the SQLite library the @db is opened with.
+ *
+ * SQLite extension entry point, meant to be passed to
+ * `sqlite3_auto_extension()`, e.g. by Dart via
+ * `SqliteExtension.inLibrary(DynamicLibrary.executable(), ...)`, so it's
+ * invoked for every database opened afterwards.
+ *
+ * Registers the `messenger` FTS5 tokenizer on the @db, and passes the file of
+ * the @db to the #DatabaseMaintenance to be watched.
+ *
+ * The extension doesn't link to SQLite, but uses the @api routines only, so it
+ * works with whatever SQLite library the @db belongs to. Using the same one is
+ * required for the maintenance, as POSIX locks of the database files aren't
+ * shared between the copies of SQLite within a process.
+ *
+ * Returns: `SQLITE_OK`, even if FTS5 isn't available and nothing is
+ * registered, as otherwise the @db would fail to open.
+ */
+RUNNER_EXPORT int messenger_sqlite3_init(sqlite3* db,
+                                         char** error,
+                                         const sqlite3_api_routines* api);
+
+#endif  // RUNNER_SQLITE_EXTENSION_H_
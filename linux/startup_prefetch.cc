@@ -0,0 +1,457 @@
+#include "startup_prefetch.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "startup_trace.h"
+
+static const char kProfileMagic[] = "startup-prefetch 1";
+
+// Age of the profile it's recorded anew after, so it follows the databases
+// growing and changing.
+static const int64_t kProfileMaxAgeSeconds = 7 * 24 * 60 * 60;
+
+// Upper bound of the bytes prefetched, so a bloated database doesn't evict
+// the rest of the page cache.
+static const int64_t kMaxPrefetchBytes = 512 * 1024 * 1024;
+
+// Resident pages closer than this are recorded as a single range, as reading
+// a few extra pages is cheaper than another request.
+static const int64_t kRangeGap = 64 * 1024;
+
+// Maximum number of the ranges recorded per file.
+static const size_t kMaxRanges = 4096;
+
+// Size of a single read requested, as the kernel silently truncates larger
+// ones to its readahead limit (a few megabytes, depending on the device).
+static const int64_t kRequestSize = 2 * 1024 * 1024;
+
+// File of the profile along with its ranges to prefetch.
+struct ProfiledFile {
+  std::string path;
+
+  // Offsets and lengths of the ranges.
+  std::vector<std::pair<int64_t, int64_t>> ranges;
+};
+
+// Recording of the profile started by RunStartupPrefetch() instead of
+// prefetching, as the pages cached by a prefetch can't be told apart from the
+// ones the startup needs.
+//
+// Pages already cached before the startup are recorded as well, since the
+// files are the most likely to be cached right after they're updated, which
+// is exactly when the profile is recorded anew.
+struct ProfileRecording {
+  std::mutex mutex;
+
+  // Indicator whether nothing is prefetched, so the profile is recorded.
+  bool started = false;
+
+  // Files recorded by the previous checkpoints in their order.
+  std::vector<std::string> recorded;
+};
+
+static ProfileRecording* Recording() {
+  // Intentionally leaked, as the profile may be recorded up until the exit.
+  static ProfileRecording* recording = new ProfileRecording();
+  return recording;
+}
+
+// Requests the |length| bytes of the |fd| at the |offset| to be read into the
+// page cache in the kRequestSize chunks, falling back to the advice for the
+// filesystems not supporting the `readahead(2)`.
+static void Prefetch(int fd, int64_t offset, int64_t length) {
+  for (int64_t end = offset + length; offset < end; offset += kRequestSize) {
+    int64_t size = std::min(kRequestSize, end - offset);
+    if (readahead(fd, offset, size) != 0) {
+      posix_fadvise(fd, offset, size, POSIX_FADV_WILLNEED);
+    }
+  }
+}
+
+// Returns the |variable| directory, or the |fallback| in the home one.
+static std::string XdgDirectory(const char* variable, const char* fallback) {
+  const char* value = getenv(variable);
+  if (value != nullptr && value[0] != '\0') {
+    return value;
+  }
+
+  const char* home = getenv("HOME");
+  return std::string(home != nullptr ? home : "") + "/" + fallback;
+}
+
+// Appends the regular files within the |directory| to the |files|.
+static void ListFiles(const std::string& directory,
+                      std::vector<std::string>* files) {
+  DIR* dir = opendir(directory.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+
+  std::vector<std::string> directories;
+  while (struct dirent* entry = readdir(dir)) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+      continue;
+    }
+
+    std::string path = directory + "/" + entry->d_name;
+    if (entry->d_type == DT_DIR) {
+      directories.push_back(path);
+    } else if (entry->d_type == DT_REG) {
+      files->push_back(path);
+    }
+  }
+  closedir(dir);
+
+  std::sort(directories.begin(), directories.end());
+  for (const std::string& path : directories) {
+    ListFiles(path, files);
+  }
+}
+
+// Appends the `*.sqlite` databases opened by the application to the |files|,
+// along with their WAL and shared memory files.
+static void ListOpenDatabases(std::vector<std::string>* files) {
+  DIR* dir = opendir("/proc/self/fd");
+  if (dir == nullptr) {
+    return;
+  }
+
+  std::vector<std::string> databases;
+  while (struct dirent* entry = readdir(dir)) {
+    char target[PATH_MAX];
+    ssize_t length =
+        readlinkat(dirfd(dir), entry->d_name, target, sizeof(target) - 1);
+    if (length <= 0) {
+      continue;
+    }
+
+    std::string path(target, length);
+    for (const char* suffix : {"-wal", "-shm"}) {
+      size_t size = strlen(suffix);
+      if (path.size() > size &&
+          path.compare(path.size() - size, size, suffix) == 0) {
+        path.resize(path.size() - size);
+        break;
+      }
+    }
+
+    const std::string extension = ".sqlite";
+    if (path.size() > extension.size() &&
+        path.compare(path.size() - extension.size(), std::string::npos,
+                     extension) == 0) {
+      databases.push_back(path);
+    }
+  }
+  closedir(dir);
+
+  std::sort(databases.begin(), databases.end());
+  databases.erase(std::unique(databases.begin(), databases.end()),
+                  databases.end());
+
+  for (const std::string& database : databases) {
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+      files->push_back(database + suffix);
+    }
+  }
+}
+
+// Returns the engine's ICU data and libraries in the order the startup reads
+// them in.
+static std::vector<std::string> EngineFiles(const StartupPrefetchPaths& paths) {
+  return {
+      paths.bundle + "/data/icudtl.dat",
+      paths.bundle + "/lib/libflutter_linux_gtk.so",
+      paths.bundle + "/lib/libapp.so",
+  };
+}
+
+// Returns the files of the bundle the startup reads: the EngineFiles() and
+// the assets.
+static std::vector<std::string> BundleFiles(const StartupPrefetchPaths& paths) {
+  std::vector<std::string> files = EngineFiles(paths);
+  ListFiles(paths.bundle + "/data/flutter_assets", &files);
+  return files;
+}
+
+static std::vector<ProfiledFile> LoadProfile(const std::string& path) {
+  std::vector<ProfiledFile> files;
+
+  FILE* file = fopen(path.c_str(), "re");
+  if (file == nullptr) {
+    return files;
+  }
+
+  char line[PATH_MAX + 64];
+  if (fgets(line, sizeof(line), file) == nullptr ||
+      strncmp(line, kProfileMagic, strlen(kProfileMagic)) != 0) {
+    fclose(file);
+    return files;
+  }
+
+  // Lines are either `f <path>` or `r <offset> <length>` of the last file.
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    line[strcspn(line, "\n")] = '\0';
+
+    long long first = 0;
+    long long second = 0;
+    if (strncmp(line, "f ", 2) == 0) {
+      ProfiledFile profiled;
+      profiled.path = line + 2;
+      files.push_back(std::move(profiled));
+    } else if (sscanf(line, "r %lld %lld", &first, &second) == 2 &&
+               !files.empty() && first >= 0 && second > 0) {
+      files.back().ranges.emplace_back(first, second);
+    }
+  }
+  fclose(file);
+
+  return files;
+}
+
+// Returns whether the profile is recorded after the engine's files have last
+// changed, i.e. since the application was updated, and recently enough.
+static bool IsProfileCurrent(const StartupPrefetchPaths& paths) {
+  struct stat st;
+  if (stat(paths.profile.c_str(), &st) != 0 ||
+      time(nullptr) - st.st_mtim.tv_sec > kProfileMaxAgeSeconds) {
+    return false;
+  }
+
+  // The change time is used, as the unpacked files may keep the modification
+  // time of their archive.
+  struct timespec recorded = st.st_mtim;
+  for (const std::string& path : EngineFiles(paths)) {
+    if (stat(path.c_str(), &st) == 0 &&
+        (st.st_ctim.tv_sec > recorded.tv_sec ||
+         (st.st_ctim.tv_sec == recorded.tv_sec &&
+          st.st_ctim.tv_nsec >= recorded.tv_nsec))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Fills the |resident| with the `mincore(2)` vector of the file at the |path|
+// and its |size|, returning false if the file can't be mapped.
+static bool ResidentPages(const std::string& path,
+                          std::vector<unsigned char>* resident,
+                          int64_t* size) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+
+  void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  const int64_t page = sysconf(_SC_PAGESIZE);
+  resident->resize((st.st_size + page - 1) / page);
+  bool succeeded = mincore(mapping, st.st_size, resident->data()) == 0;
+  munmap(mapping, st.st_size);
+
+  *size = st.st_size;
+  return succeeded;
+}
+
+int64_t RunStartupPrefetch(const StartupPrefetchPaths& paths) {
+  int64_t started = StartupTrace::Now();
+  int64_t requested = 0;
+
+  bool current = IsProfileCurrent(paths);
+  {
+    ProfileRecording* recording = Recording();
+    std::lock_guard<std::mutex> lock(recording->mutex);
+    recording->started = !current;
+    recording->recorded.clear();
+  }
+
+  if (!current) {
+    return 0;
+  }
+
+  for (const ProfiledFile& profiled : LoadProfile(paths.profile)) {
+    int fd = open(profiled.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+
+    // Files changed since (e.g. the databases) are likely to be read at the
+    // same offsets still, so only the ranges beyond them are dropped.
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      st.st_size = 0;
+    }
+
+    for (const auto& range : profiled.ranges) {
+      if (requested >= kMaxPrefetchBytes) {
+        break;
+      }
+
+      int64_t length =
+          std::min<int64_t>(range.second, st.st_size - range.first);
+      if (length > 0) {
+        Prefetch(fd, range.first, length);
+        requested += length;
+      }
+    }
+    close(fd);
+
+    if (requested >= kMaxPrefetchBytes) {
+      break;
+    }
+  }
+
+  StartupTrace::Shared()->Complete("startup_prefetch", "runner", started,
+                                   StartupTrace::Now());
+  return requested;
+}
+
+StartupPrefetchPaths DefaultStartupPrefetchPaths() {
+  StartupPrefetchPaths paths;
+
+  char executable[PATH_MAX];
+  ssize_t length = readlink("/proc/self/exe", executable,
+                            sizeof(executable) - 1);
+  if (length > 0) {
+    executable[length] = '\0';
+    char* slash = strrchr(executable, '/');
+    if (slash != nullptr) {
+      *slash = '\0';
+    }
+    paths.bundle = executable;
+  }
+
+  // Placed next to the cache directory named after the application ID, as
+  // the files within it are evicted, like the `.index` of the cache.
+  paths.profile = XdgDirectory("XDG_CACHE_HOME", ".cache") + "/" +
+                  APPLICATION_ID + ".startup_prefetch";
+
+  return paths;
+}
+
+void StartStartupPrefetch() {
+  const char* value = getenv("MESSENGER_STARTUP_PREFETCH");
+  if (value != nullptr && strcmp(value, "0") == 0) {
+    return;
+  }
+
+  std::thread([] {
+    pthread_setname_np(pthread_self(), "prefetch");
+    RunStartupPrefetch(DefaultStartupPrefetchPaths());
+  }).detach();
+}
+
+// Fills the |profiled| ranges with the ones of its file in the page cache.
+// Returns false if the file can't be mapped.
+static bool RecordResidentRanges(ProfiledFile* profiled) {
+  std::vector<unsigned char> resident;
+  int64_t size;
+  if (!ResidentPages(profiled->path, &resident, &size)) {
+    return false;
+  }
+
+  const int64_t page = sysconf(_SC_PAGESIZE);
+  profiled->ranges.clear();
+
+  for (size_t i = 0; i < resident.size(); ++i) {
+    if ((resident[i] & 1) == 0) {
+      continue;
+    }
+
+    int64_t offset = i * page;
+    int64_t end = std::min<int64_t>(offset + page, size);
+    auto& ranges = profiled->ranges;
+    if (!ranges.empty() &&
+        offset - (ranges.back().first + ranges.back().second) <= kRangeGap) {
+      ranges.back().second = end - ranges.back().first;
+    } else if (ranges.size() < kMaxRanges) {
+      ranges.emplace_back(offset, end - offset);
+    } else {
+      // Extends the last range to cover the rest.
+      ranges.back().second = size - ranges.back().first;
+      break;
+    }
+  }
+
+  return true;
+}
+
+bool RecordStartupProfile(const StartupPrefetchPaths& paths) {
+  ProfileRecording* recording = Recording();
+  std::lock_guard<std::mutex> lock(recording->mutex);
+  if (!recording->started) {
+    return true;
+  }
+
+  // Files of the previous checkpoints go first, followed by the new ones.
+  std::vector<std::string> candidates = BundleFiles(paths);
+  ListOpenDatabases(&candidates);
+  for (const std::string& path : candidates) {
+    if (std::find(recording->recorded.begin(), recording->recorded.end(),
+                  path) == recording->recorded.end()) {
+      recording->recorded.push_back(path);
+    }
+  }
+
+  std::string temporary_path = paths.profile + ".tmp";
+  size_t slash = paths.profile.rfind('/');
+  if (slash != std::string::npos) {
+    mkdir(paths.profile.substr(0, slash).c_str(), 0755);
+  }
+
+  FILE* file = fopen(temporary_path.c_str(), "we");
+  if (file == nullptr) {
+    return false;
+  }
+
+  fprintf(file, "%s\n", kProfileMagic);
+  for (const std::string& path : recording->recorded) {
+    // Files not read by the startup are left out.
+    ProfiledFile profiled;
+    profiled.path = path;
+    if (!RecordResidentRanges(&profiled) || profiled.ranges.empty()) {
+      continue;
+    }
+
+    fprintf(file, "f %s\n", profiled.path.c_str());
+    for (const auto& range : profiled.ranges) {
+      fprintf(file, "r %lld %lld\n", static_cast<long long>(range.first),
+              static_cast<long long>(range.second));
+    }
+  }
+
+  bool succeeded = fflush(file) == 0 && !ferror(file);
+  succeeded = fclose(file) == 0 && succeeded;
+  if (!succeeded ||
+      rename(temporary_path.c_str(), paths.profile.c_str()) != 0) {
+    unlink(temporary_path.c_str());
+    return false;
+  }
+
+  return true;
+}
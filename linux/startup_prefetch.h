@@ -0,0 +1,55 @@
+#ifndef RUNNER_STARTUP_PREFETCH_H_
+#define RUNNER_STARTUP_PREFETCH_H_
+
+#include <stdint.h>
+
+#include <string>
+
+// Locations the startup prefetch works with.
+struct StartupPrefetchPaths {
+  // Directory of the application bundle, containing the `lib/` and `data/`.
+  std::string bundle;
+
+  // Path to the recorded access profile.
+  std::string profile;
+};
+
+// Returns the StartupPrefetchPaths of the running application: the bundle of
+// its executable, and the profile next to its cache directory.
+StartupPrefetchPaths DefaultStartupPrefetchPaths();
+
+// Reads the ranges of the files the startup needs into the page cache, so the
+// first frame doesn't wait on the page faults into them: the ranges recorded
+// by RecordStartupProfile() in its order, clipped to the current sizes of the
+// files. Reads are requested via `readahead(2)`, or `POSIX_FADV_WILLNEED`
+// where it isn't supported.
+//
+// Nothing is prefetched without a profile or with an outdated one, recorded
+// before the bundle has changed or more than a week ago, as reading the files
+// whole is slower than not prefetching them at all. The RecordStartupProfile()
+// is enabled instead to record the profile anew.
+//
+// Returns the number of bytes requested to be read.
+int64_t RunStartupPrefetch(const StartupPrefetchPaths& paths);
+
+// Runs the RunStartupPrefetch() on a detached thread, unless disabled by the
+// `MESSENGER_STARTUP_PREFETCH=0` environment variable. Should be called first
+// thing in `main()`.
+void StartStartupPrefetch();
+
+// Records the ranges of the files read by the startup so far, meant to be
+// called at a few checkpoints of the startup, e.g. the first frame and a few
+// seconds after it: the files of the engine, the assets, and the databases
+// opened by the application.
+//
+// Records every page of the files in the page cache, including the ones
+// cached before the startup, e.g. by updating the files. Does nothing unless
+// enabled by RunStartupPrefetch() not prefetching anything, as the pages
+// prefetched would be recorded regardless of being read, so the profile would
+// only reinforce itself. Files keep the order of the checkpoint they were
+// first needed by.
+//
+// Returns false if the profile can't be written.
+bool RecordStartupProfile(const StartupPrefetchPaths& paths);
+
+#endif  // RUNNER_STARTUP_PREFETCH_H_
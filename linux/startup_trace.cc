@@ -0,0 +1,244 @@
+#include "startup_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <set>
+
+static const char kEnvironmentVariable[] = "MESSENGER_STARTUP_TRACE";
+static const char kArgument[] = "--startup-trace=";
+
+static int64_t ClockMicroseconds(clockid_t clock) {
+  struct timespec time;
+  clock_gettime(clock, &time);
+  return static_cast<int64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+}
+
+// Returns the CLOCK_MONOTONIC time the process was started at with the clock
+// tick precision, or the |now| if it can't be determined.
+static int64_t ProcessStartTime(int64_t now) {
+  FILE* file = fopen("/proc/self/stat", "re");
+  if (file == nullptr) {
+    return now;
+  }
+
+  char buffer[1024];
+  size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+  fclose(file);
+  buffer[length] = '\0';
+
+  // The `starttime` is the 22nd field, counted in clock ticks since boot,
+  // while the 2nd one is the executable name possibly containing spaces.
+  const char* field = strrchr(buffer, ')');
+  for (int i = 2; field != nullptr && i < 22; ++i) {
+    field = strchr(field + 1, ' ');
+  }
+
+  if (field == nullptr) {
+    return now;
+  }
+
+  int64_t ticks = strtoll(field + 1, nullptr, 10);
+  int64_t started = ticks * 1000000 / sysconf(_SC_CLK_TCK);
+
+  // Boot time includes the time suspended, unlike the CLOCK_MONOTONIC.
+  int64_t elapsed = ClockMicroseconds(CLOCK_BOOTTIME) - started;
+  return elapsed >= 0 ? now - elapsed : now;
+}
+
+static pid_t CurrentThread() {
+  static thread_local pid_t thread = syscall(SYS_gettid);
+  return thread;
+}
+
+// Writes the |text| as a JSON string literal to the |file|.
+static void WriteJsonString(FILE* file, const char* text) {
+  fputc('"', file);
+  for (const char* c = text; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', file);
+      fputc(*c, file);
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      fprintf(file, "\\u%04x", *c);
+    } else {
+      fputc(*c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+// Writes the metadata event naming the |thread| after its `comm`.
+static void WriteThreadName(FILE* file, pid_t process, pid_t thread) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/self/task/%d/comm", thread);
+
+  char name[32] = "";
+  FILE* comm = fopen(path, "re");
+  if (comm != nullptr) {
+    if (fgets(name, sizeof(name), comm) != nullptr) {
+      name[strcspn(name, "\n")] = '\0';
+    }
+    fclose(comm);
+  }
+
+  fprintf(file,
+          "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+          "\"args\":{\"name\":",
+          process, thread);
+  WriteJsonString(file, thread == process ? "main" : name);
+  fputs("}},\n", file);
+}
+
+StartupTrace* StartupTrace::Shared() {
+  // Intentionally leaked, as the events may be recorded up until the exit.
+  static StartupTrace* trace = new StartupTrace();
+  return trace;
+}
+
+void StartupTrace::Configure(int* argc, char** argv) {
+  const char* path = getenv(kEnvironmentVariable);
+
+  // Removes the argument, so it isn't passed to Dart.
+  int count = 0;
+  for (int i = 0; i < *argc; ++i) {
+    if (strncmp(argv[i], kArgument, strlen(kArgument)) == 0) {
+      path = argv[i] + strlen(kArgument);
+    } else {
+      argv[count++] = argv[i];
+    }
+  }
+  argv[count] = nullptr;
+  *argc = count;
+
+  if (path == nullptr || path[0] == '\0' || enabled()) {
+    return;
+  }
+
+  int64_t now = Now();
+  path_ = path;
+  events_.reset(new Event[kCapacity]);
+  process_start_ = ProcessStartTime(now);
+  enabled_.store(true, std::memory_order_release);
+
+  Complete("exec", "runner", process_start_, now);
+}
+
+int64_t StartupTrace::Now() {
+  return ClockMicroseconds(CLOCK_MONOTONIC);
+}
+
+void StartupTrace::Complete(const char* name,
+                            const char* category,
+                            int64_t start,
+                            int64_t end) {
+  Record('X', name, category, start, std::max<int64_t>(end - start, 0));
+}
+
+void StartupTrace::Instant(const char* name,
+                           const char* category,
+                           int64_t time) {
+  Record('i', name, category, time, 0);
+}
+
+int64_t StartupTrace::Mark(const char* name, int64_t start) {
+  if (!enabled()) {
+    return 0;
+  }
+
+  int64_t end = Now();
+  Complete(name, "runner", start, end);
+  return end;
+}
+
+void StartupTrace::Record(char phase,
+                          const char* name,
+                          const char* category,
+                          int64_t start,
+                          int64_t duration) {
+  if (!enabled()) {
+    return;
+  }
+
+  size_t index = size_.fetch_add(1, std::memory_order_relaxed);
+  if (index >= kCapacity) {
+    return;
+  }
+
+  Event* event = &events_[index];
+  event->phase = phase;
+  snprintf(event->name, sizeof(event->name), "%s", name);
+  snprintf(event->category, sizeof(event->category), "%s", category);
+  event->start = start;
+  event->duration = duration;
+  event->thread = CurrentThread();
+  event->ready.store(true, std::memory_order_release);
+}
+
+bool StartupTrace::Write() {
+  if (!enabled()) {
+    return false;
+  }
+
+  std::string temporary_path = path_ + ".tmp";
+  FILE* file = fopen(temporary_path.c_str(), "we");
+  if (file == nullptr) {
+    return false;
+  }
+
+  pid_t process = getpid();
+  size_t size = std::min(size_.load(std::memory_order_relaxed), kCapacity);
+
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+  fprintf(file,
+          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+          "\"args\":{\"name\":\"messenger\"}},\n",
+          process, process);
+
+  std::set<pid_t> threads;
+  for (size_t i = 0; i < size; ++i) {
+    const Event& event = events_[i];
+
+    // Skips the events still being recorded.
+    if (!event.ready.load(std::memory_order_acquire)) {
+      continue;
+    }
+
+    if (threads.insert(event.thread).second) {
+      WriteThreadName(file, process, event.thread);
+    }
+
+    fputs("{\"name\":", file);
+    WriteJsonString(file, event.name);
+    fputs(",\"cat\":", file);
+    WriteJsonString(file, event.category);
+    fprintf(file, ",\"ph\":\"%c\",\"ts\":%lld,", event.phase,
+            static_cast<long long>(event.start - process_start_));
+    if (event.phase == 'X') {
+      fprintf(file, "\"dur\":%lld,", static_cast<long long>(event.duration));
+    } else {
+      fputs("\"s\":\"p\",", file);
+    }
+    fprintf(file, "\"pid\":%d,\"tid\":%d},\n", process, event.thread);
+  }
+
+  // Closes the array without a trailing comma.
+  fprintf(file,
+          "{\"name\":\"trace_written\",\"cat\":\"runner\",\"ph\":\"i\","
+          "\"ts\":%lld,\"s\":\"g\",\"pid\":%d,\"tid\":%d}\n]}\n",
+          static_cast<long long>(Now() - process_start_), process,
+          CurrentThread());
+
+  bool succeeded = fflush(file) == 0 && !ferror(file);
+  succeeded = fclose(file) == 0 && succeeded;
+  if (!succeeded || rename(temporary_path.c_str(), path_.c_str()) != 0) {
+    unlink(temporary_path.c_str());
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,96 @@
+#ifndef RUNNER_STARTUP_TRACE_H_
+#define RUNNER_STARTUP_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+// Tracer of the application startup phases, written as a Chrome trace JSON
+// viewable in Perfetto or `chrome://tracing`.
+//
+// Disabled unless the `MESSENGER_STARTUP_TRACE=<path>` environment variable
+// or the `--startup-trace=<path>` argument is provided, in which case events
+// are recorded into a fixed buffer by claiming its slots with an atomic
+// counter, so recording never blocks nor allocates. Events not fitting into
+// the buffer are dropped.
+//
+// Timestamps are CLOCK_MONOTONIC microseconds, same as Dart's `Timeline.now`,
+// and are written relative to the start of the process.
+class StartupTrace {
+ public:
+  // Maximum number of the events recorded.
+  static const size_t kCapacity = 4096;
+
+  // Returns the StartupTrace of the process.
+  static StartupTrace* Shared();
+
+  StartupTrace(const StartupTrace&) = delete;
+  StartupTrace& operator=(const StartupTrace&) = delete;
+
+  // Enables the tracing if requested by the environment or the arguments,
+  // removing the `--startup-trace` one from the |argv|. Must be called first
+  // thing in `main()`.
+  void Configure(int* argc, char** argv);
+
+  // Indicates whether the events are being recorded.
+  bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+  // Returns the current CLOCK_MONOTONIC time in microseconds.
+  static int64_t Now();
+
+  // Records the |name| phase lasted from the |start| to the |end|.
+  void Complete(const char* name,
+                const char* category,
+                int64_t start,
+                int64_t end);
+
+  // Records the |name| moment at the |time|.
+  void Instant(const char* name, const char* category, int64_t time);
+
+  // Records the |name| phase lasted from the |start| till now, returning the
+  // end of it to start the next phase at.
+  int64_t Mark(const char* name, int64_t start);
+
+  // Writes the recorded events to the configured path, returning false if
+  // the tracing is disabled or the file can't be written.
+  bool Write();
+
+ private:
+  struct Event {
+    // Indicator whether the event is fully written by its recorder.
+    std::atomic<bool> ready{false};
+
+    // Chrome trace phase, either `X` (complete) or `i` (instant).
+    char phase;
+
+    char name[64];
+    char category[16];
+    int64_t start;
+    int64_t duration;
+    pid_t thread;
+  };
+
+  StartupTrace() = default;
+
+  // Claims the next slot of the |events_| and fills it in, if enabled.
+  void Record(char phase,
+              const char* name,
+              const char* category,
+              int64_t start,
+              int64_t duration);
+
+  std::atomic<bool> enabled_{false};
+  std::string path_;
+
+  std::unique_ptr<Event[]> events_;
+  std::atomic<size_t> size_{0};
+
+  // CLOCK_MONOTONIC time the process was started at.
+  int64_t process_start_ = 0;
+};
+
+#endif  // RUNNER_STARTUP_TRACE_H_
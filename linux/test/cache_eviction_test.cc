@@ -0,0 +1,156 @@
+// Checks that the files evicted from the cache stay readable through the
+// mappings created by messenger_map_file(), as evicting them never truncates
+// them, which would raise `SIGBUS` on reading the mappings instead.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "cache_index.h"
+#include "cache_scanner.h"
+#include "file_mapping.h"
+
+#define EXPECT(condition)                                              \
+  do {                                                                 \
+    if (!(condition)) {                                                \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,      \
+              #condition);                                             \
+      exit(1);                                                         \
+    }                                                                  \
+  } while (0)
+
+static const size_t kFileSize = 256 * 1024;
+
+// Returns the SHA-256 hex string like name of the |index|th cached file.
+static std::string FileName(int index) {
+  return std::string(63, '0') + static_cast<char>('a' + index);
+}
+
+// Writes the |index|th cached file into the |directory|, accessed |index|
+// seconds after the epoch, so the files are evicted in their order.
+static void WriteFile(const std::string& directory, int index) {
+  std::string path = directory + "/" + FileName(index);
+  std::vector<uint8_t> data(kFileSize, static_cast<uint8_t>(index + 1));
+
+  int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+  EXPECT(fd >= 0);
+  EXPECT(write(fd, data.data(), data.size()) ==
+         static_cast<ssize_t>(data.size()));
+
+  struct timespec times[2] = {{index, 0}, {index, 0}};
+  EXPECT(futimens(fd, times) == 0);
+  close(fd);
+}
+
+struct Mapping {
+  uint8_t* bytes;
+  int64_t length;
+  void* token;
+};
+
+static Mapping MapFile(const std::string& directory, int index) {
+  Mapping mapping;
+  std::string path = directory + "/" + FileName(index);
+  mapping.bytes = messenger_map_file(path.c_str(),
+                                     FILE_MAPPING_ADVICE_NORMAL,
+                                     &mapping.length, &mapping.token);
+  EXPECT(mapping.bytes != nullptr);
+  EXPECT(mapping.length == static_cast<int64_t>(kFileSize));
+  return mapping;
+}
+
+// Reads the whole |mapping| of the |index|th file, which raises `SIGBUS` if
+// the file was truncated, and unmaps it.
+static void ReadAndUnmap(const Mapping& mapping, int index) {
+  for (int64_t i = 0; i < mapping.length; ++i) {
+    EXPECT(mapping.bytes[i] == index + 1);
+  }
+  messenger_unmap_file(mapping.token);
+}
+
+static bool Exists(const std::string& directory, int index) {
+  std::string path = directory + "/" + FileName(index);
+  return access(path.c_str(), F_OK) == 0;
+}
+
+static void TestEvictCacheFiles(const std::string& directory) {
+  for (int i = 0; i < 3; ++i) {
+    WriteFile(directory, i);
+  }
+
+  // Scanned before mapping, as mapping the files updates their access time.
+  CacheScan scan;
+  EXPECT(ScanCacheDirectory(directory.c_str(), 2, &scan));
+  EXPECT(scan.files.size() == 3);
+
+  Mapping first = MapFile(directory, 0);
+  Mapping second = MapFile(directory, 1);
+
+  std::vector<std::string> removed =
+      EvictCacheFiles(directory.c_str(), kFileSize * 2, {}, &scan);
+  EXPECT(removed ==
+         std::vector<std::string>({FileName(0), FileName(1)}));
+  EXPECT(!Exists(directory, 0) && !Exists(directory, 1));
+  EXPECT(Exists(directory, 2));
+
+  ReadAndUnmap(first, 0);
+  ReadAndUnmap(second, 1);
+
+  unlink((directory + "/" + FileName(2)).c_str());
+}
+
+static void TestEvictCacheIndex(const std::string& directory) {
+  std::string path = directory + ".index";
+
+  bool created = false;
+  CacheIndex* index = CacheIndex::Open(path.c_str(), &created);
+  EXPECT(index != nullptr && created);
+
+  for (int i = 0; i < 3; ++i) {
+    WriteFile(directory, i);
+    EXPECT(index->Insert(FileName(i), kFileSize));
+  }
+  EXPECT(index->Touch(FileName(0)));
+
+  Mapping first = MapFile(directory, 0);
+  Mapping second = MapFile(directory, 1);
+
+  // The files are removed by the `evictCacheIndex` method the same way.
+  int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  EXPECT(fd >= 0);
+  std::vector<std::string> removed = index->Evict(kFileSize);
+  EXPECT(removed == std::vector<std::string>({FileName(1)}));
+  for (const std::string& checksum : index->Evict(kFileSize)) {
+    removed.push_back(checksum);
+  }
+  EXPECT(removed ==
+         std::vector<std::string>({FileName(1), FileName(2)}));
+  for (const std::string& checksum : removed) {
+    EXPECT(RemoveCacheFile(fd, checksum));
+  }
+  close(fd);
+
+  EXPECT(Exists(directory, 0));
+  ReadAndUnmap(first, 0);
+  ReadAndUnmap(second, 1);
+
+  delete index;
+  unlink(path.c_str());
+  unlink((directory + "/" + FileName(0)).c_str());
+}
+
+int main() {
+  char directory[] = "/tmp/cache_eviction_test.XXXXXX";
+  EXPECT(mkdtemp(directory) != nullptr);
+
+  TestEvictCacheFiles(directory);
+  TestEvictCacheIndex(directory);
+
+  EXPECT(rmdir(directory) == 0);
+  return 0;
+}
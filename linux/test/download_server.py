@@ -0,0 +1,65 @@
+"""Stand-in HTTP server of the segmented_download test.
+
+Serves the same 8 MiB file at `/data` and, with a single byte changed but the
+same size and ETag, at `/corrupt`, both slowly enough for the test to cancel
+the download in the middle. Runs the test passed as the arguments with the URL
+of the server appended, exiting with its status.
+"""
+
+import http.server
+import re
+import subprocess
+import sys
+import threading
+import time
+
+SIZE = 8 * 1024 * 1024
+CHUNK = 64 * 1024
+
+DATA = bytes((i * 31 + 7) & 0xFF for i in range(256)) * (SIZE // 256)
+CORRUPT = DATA[:SIZE - 1] + bytes([DATA[-1] ^ 0xFF])
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def log_message(self, *args):
+        pass
+
+    def do_GET(self):
+        if self.path not in ('/data', '/corrupt'):
+            self.send_response(404)
+            self.send_header('Content-Length', '0')
+            self.end_headers()
+            return
+
+        data = DATA if self.path == '/data' else CORRUPT
+        start, end = 0, SIZE - 1
+
+        match = re.match(r'bytes=(\d+)-(\d*)', self.headers.get('Range', ''))
+        if match:
+            start = int(match.group(1))
+            end = int(match.group(2)) if match.group(2) else end
+            self.send_response(206)
+            self.send_header('Content-Range', f'bytes {start}-{end}/{SIZE}')
+        else:
+            self.send_response(200)
+
+        self.send_header('Content-Length', str(end - start + 1))
+        self.send_header('ETag', '"1"')
+        self.end_headers()
+
+        try:
+            for offset in range(start, end + 1, CHUNK):
+                self.wfile.write(data[offset:min(offset + CHUNK, end + 1)])
+                time.sleep(0.01)
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+
+
+server = http.server.ThreadingHTTPServer(('127.0.0.1', 0), Handler)
+server.daemon_threads = True
+threading.Thread(target=server.serve_forever, daemon=True).start()
+
+url = f'http://127.0.0.1:{server.server_address[1]}'
+sys.exit(subprocess.run(sys.argv[1:] + [url]).returncode)
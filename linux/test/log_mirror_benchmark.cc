@@ -0,0 +1,183 @@
+// Measures the throughput and the syscalls per MB of mirroring a descriptor
+// with log_mirror_start() against the 4 KiB copy loop it has replaced.
+//
+// Usage: log_mirror_benchmark [directory of the log file] [MiB per run]
+//
+// The original stream is `/dev/null`, so the log file is the only real sink,
+// and should be placed on a tmpfs to measure the mirroring instead of a disk.
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "log_mirror.h"
+#include "rotating_log_file.h"
+
+extern "C" {
+ssize_t __real_read(int fd, void* buffer, size_t count);
+ssize_t __real_write(int fd, const void* buffer, size_t count);
+ssize_t __real_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out,
+                      size_t length, unsigned int flags);
+ssize_t __real_tee(int fd_in, int fd_out, size_t length, unsigned int flags);
+}
+
+// Number of the syscalls made by the mirroring threads.
+static std::atomic<uint64_t> syscalls{0};
+
+// Indicator whether the syscalls of the current thread are the ones of the
+// writer, so aren't counted.
+static thread_local bool writer = false;
+
+static void count_syscall() {
+  if (!writer) {
+    syscalls.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+extern "C" {
+ssize_t __wrap_read(int fd, void* buffer, size_t count) {
+  count_syscall();
+  return __real_read(fd, buffer, count);
+}
+
+ssize_t __wrap_write(int fd, const void* buffer, size_t count) {
+  count_syscall();
+  return __real_write(fd, buffer, count);
+}
+
+ssize_t __wrap_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out,
+                      size_t length, unsigned int flags) {
+  count_syscall();
+  return __real_splice(fd_in, off_in, fd_out, off_out, length, flags);
+}
+
+ssize_t __wrap_tee(int fd_in, int fd_out, size_t length, unsigned int flags) {
+  count_syscall();
+  return __real_tee(fd_in, fd_out, length, flags);
+}
+}
+
+// Former mirroring thread of `my_application.cc`.
+struct CopyLoop {
+  int pipe_read_end;
+  int log_fd;
+  int original_fd;
+};
+
+static void* copy_loop_thread(void* arg) {
+  CopyLoop* loop = static_cast<CopyLoop*>(arg);
+
+  char buffer[4096];
+  ssize_t bytes_read;
+  while ((bytes_read = read(loop->pipe_read_end, buffer, sizeof(buffer))) >
+         0) {
+    write(loop->log_fd, buffer, bytes_read);
+    write(loop->original_fd, buffer, bytes_read);
+  }
+
+  return nullptr;
+}
+
+// Writes |total| bytes in |chunk| sized writes into the |fd|.
+static void write_data(int fd, size_t chunk, size_t total) {
+  writer = true;
+  std::vector<char> data(chunk, 'x');
+  for (size_t written = 0; written < total; written += chunk) {
+    write(fd, data.data(), chunk);
+  }
+  writer = false;
+}
+
+struct Result {
+  double megabytes_per_second;
+  double syscalls_per_megabyte;
+};
+
+static Result measure(bool mirror,
+                      const std::string& log_path,
+                      size_t chunk,
+                      size_t total) {
+  int target_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  if (target_fd < 0) {
+    perror("open");
+    exit(1);
+  }
+
+  syscalls = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  if (mirror) {
+    unlink(log_path.c_str());
+    LogRotationOptions options;
+    options.max_size = 0;
+    RotatingLogFile* log_file = RotatingLogFile::Open(log_path.c_str(),
+                                                      options);
+    LogMirror* log_mirror =
+        log_file == nullptr ? nullptr : log_mirror_start(target_fd, log_file);
+    if (log_mirror == nullptr) {
+      perror("log_mirror_start");
+      exit(1);
+    }
+
+    write_data(target_fd, chunk, total);
+    log_mirror_stop(log_mirror);
+    delete log_file;
+  } else {
+    int pipe_fds[2];
+    int log_fd = open(log_path.c_str(),
+                      O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+    if (log_fd < 0 || pipe2(pipe_fds, O_CLOEXEC) != 0) {
+      perror("open");
+      exit(1);
+    }
+
+    CopyLoop loop{pipe_fds[0], log_fd, target_fd};
+    pthread_t thread;
+    pthread_create(&thread, nullptr, copy_loop_thread, &loop);
+
+    write_data(pipe_fds[1], chunk, total);
+    close(pipe_fds[1]);
+    pthread_join(thread, nullptr);
+
+    close(pipe_fds[0]);
+    close(log_fd);
+  }
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  close(target_fd);
+
+  double megabytes = static_cast<double>(total) / (1 << 20);
+  return Result{megabytes / seconds, syscalls / megabytes};
+}
+
+int main(int argc, char** argv) {
+  const char* directory = argc > 1 ? argv[1] : getenv("TMPDIR");
+  std::string log_path =
+      std::string(directory != nullptr ? directory : "/tmp") +
+      "/log_mirror_benchmark.log";
+  size_t total = static_cast<size_t>(argc > 2 ? atoi(argv[2]) : 512) << 20;
+
+  printf("%-12s %14s %14s %14s %14s\n", "write size", "loop MB/s",
+         "loop calls/MB", "mirror MB/s", "mirror calls/MB");
+  for (size_t chunk : {4096, 64 * 1024, 1024 * 1024}) {
+    Result loop = measure(false, log_path, chunk, total);
+    Result mirror = measure(true, log_path, chunk, total);
+    printf("%-12zu %14.0f %14.1f %14.0f %14.1f\n", chunk,
+           loop.megabytes_per_second, loop.syscalls_per_megabyte,
+           mirror.megabytes_per_second, mirror.syscalls_per_megabyte);
+  }
+
+  unlink(log_path.c_str());
+  return 0;
+}
@@ -0,0 +1,311 @@
+// Measures the search of the chat items over a synthetic database of the
+// generated messages: the `LIKE` pattern over their JSON the search falls
+// back to, against the full-text search index tokenized by the `messenger`
+// tokenizer, built in chunks the same way the `ScopedDatabase` does.
+//
+// Messages are mostly English with the Spanish, Russian and Chinese words
+// mixed in, and a rare word to measure the selective queries with. The
+// database is generated in the |directory| once, and is reused by the next
+// runs with the same |count| of the messages.
+//
+// Usage: message_search_benchmark <directory> [count] [runs]
+
+#include <ctype.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+#include "message_tokenizer.h"
+
+// Number of the chat items indexed at once, as by the `indexChatItems()`.
+static const int kIndexChunk = 5000;
+
+// Number of the chats the messages are spread over.
+static const int kChats = 1000;
+
+static const char* const kEnglish[] = {
+    "the",      "a",       "to",       "and",     "of",      "is",
+    "it",       "you",     "we",       "for",     "on",      "with",
+    "meeting",  "meet",    "tomorrow", "today",   "project", "release",
+    "review",   "please",  "check",    "update",  "call",    "lunch",
+    "weekend",  "photo",   "document", "budget",  "plan",    "schedule",
+    "thanks",   "hello",   "agenda",   "server",  "design",  "team",
+    "deadline", "meetup",  "report",   "invoice", "ticket",  "merge",
+};
+
+static const char* const kSpanish[] = {
+    "reunión", "mañana", "café", "año", "informe", "equipo",
+};
+
+static const char* const kRussian[] = {
+    "встреча", "завтра", "привет", "проект", "отчёт",
+    "спасибо", "релиз",  "созвон", "встречаемся",
+};
+
+static const char* const kChinese[] = {
+    "会议", "明天", "你好", "我们", "项目", "发布", "谢谢", "今天", "开会",
+};
+
+// Rare word, present in about every 20,000th message.
+static const char kRare[] = "zeppelin";
+
+// Terms searched for, as typed by the user.
+static const char* const kTerms[] = {
+    kRare, "meeting", "meet", "встреча", "会议", "reunion",
+};
+
+// Entry point of the extension, registering the tokenizer on every database
+// opened.
+static int Init(sqlite3* db, char** error, const sqlite3_api_routines* api) {
+  return RegisterMessageTokenizer(db, api);
+}
+
+static void Check(sqlite3* db, int rc) {
+  if (rc != SQLITE_OK && rc != SQLITE_DONE && rc != SQLITE_ROW) {
+    fprintf(stderr, "SQLite error: %s\n", sqlite3_errmsg(db));
+    exit(1);
+  }
+}
+
+static void Execute(sqlite3* db, const std::string& sql) {
+  Check(db, sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr));
+}
+
+// Returns the single integer result of the |sql| with the |text| bound, if
+// not empty.
+static int64_t Count(sqlite3* db,
+                     const std::string& sql,
+                     const std::string& text = "") {
+  sqlite3_stmt* statement = nullptr;
+  Check(db, sqlite3_prepare_v2(db, sql.c_str(), -1, &statement, nullptr));
+  if (!text.empty()) {
+    sqlite3_bind_text(statement, 1, text.c_str(), text.size(),
+                      SQLITE_TRANSIENT);
+  }
+  Check(db, sqlite3_step(statement));
+  int64_t count = sqlite3_column_int64(statement, 0);
+  sqlite3_finalize(statement);
+  return count;
+}
+
+// Returns the text of the next generated message, or an empty one for the
+// messages with the attachments only.
+static std::string GenerateText(uint64_t* state) {
+  auto next = [state](uint32_t bound) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return static_cast<uint32_t>(*state % bound);
+  };
+
+  if (next(20) == 0) {
+    return "";
+  }
+
+  std::string text;
+  bool chinese = false;
+  int words = 3 + next(18);
+  int rare = next(20000) == 0 ? static_cast<int>(next(words)) : -1;
+  for (int i = 0; i < words; ++i) {
+    const char* word;
+    uint32_t script = next(100);
+    bool was_chinese = chinese;
+    chinese = false;
+    if (i == rare) {
+      word = kRare;
+    } else if (script < 70) {
+      word = kEnglish[next(sizeof(kEnglish) / sizeof(*kEnglish))];
+    } else if (script < 80) {
+      word = kSpanish[next(sizeof(kSpanish) / sizeof(*kSpanish))];
+    } else if (script < 90) {
+      word = kRussian[next(sizeof(kRussian) / sizeof(*kRussian))];
+    } else {
+      word = kChinese[next(sizeof(kChinese) / sizeof(*kChinese))];
+      chinese = true;
+    }
+
+    // Chinese words aren't separated by spaces.
+    if (!text.empty() && !(chinese && was_chinese)) {
+      text += next(10) == 0 ? ", " : " ";
+    }
+    text += word;
+
+    if (i == 0 && !chinese && next(3) == 0) {
+      text[0] = static_cast<char>(toupper(text[0]));
+    }
+  }
+
+  return text;
+}
+
+// Fills the `chat_items` of the |db| with the |count| of the generated
+// messages in the JSON form they're stored by the `ChatItemDriftProvider`.
+static void Generate(sqlite3* db, int64_t count) {
+  Execute(db,
+          "CREATE TABLE chat_items (id TEXT NOT NULL PRIMARY KEY, "
+          "chat_id TEXT NOT NULL, author_id TEXT NOT NULL, "
+          "at INTEGER NOT NULL, status INTEGER NOT NULL, "
+          "data TEXT NOT NULL, cursor TEXT, ver TEXT NOT NULL);");
+
+  sqlite3_stmt* statement = nullptr;
+  Check(db, sqlite3_prepare_v2(
+                db,
+                "INSERT INTO chat_items VALUES (?1, ?2, ?3, ?4, 0, ?5, ?6, "
+                "'0');",
+                -1, &statement, nullptr));
+
+  Execute(db, "BEGIN;");
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+  for (int64_t i = 0; i < count; ++i) {
+    std::string id = "item-" + std::to_string(i);
+    std::string chat = "chat-" + std::to_string(i % kChats);
+    std::string author = "user-" + std::to_string(i % 7);
+    std::string text = GenerateText(&state);
+
+    std::string data = "{\"value\":{\"__typename\":\"ChatMessage\",\"id\":\"" +
+                       id + "\",\"chatId\":\"" + chat + "\",\"authorId\":\"" +
+                       author + "\",";
+    data += text.empty() ? "\"text\":null,\"attachments\":[{\"id\":\"file\"}]"
+                         : "\"text\":\"" + text + "\",\"attachments\":[]";
+    data += ",\"repliesTo\":[]},\"cursor\":\"cursor-" + std::to_string(i) +
+            "\",\"ver\":\"0\"}";
+
+    sqlite3_bind_text(statement, 1, id.c_str(), id.size(), SQLITE_TRANSIENT);
+    sqlite3_bind_text(statement, 2, chat.c_str(), chat.size(),
+                      SQLITE_TRANSIENT);
+    sqlite3_bind_text(statement, 3, author.c_str(), author.size(),
+                      SQLITE_TRANSIENT);
+    sqlite3_bind_int64(statement, 4, 1700000000000000 + i * 1000000);
+    sqlite3_bind_text(statement, 5, data.c_str(), data.size(),
+                      SQLITE_TRANSIENT);
+    sqlite3_bind_text(statement, 6, ("cursor-" + std::to_string(i)).c_str(),
+                      -1, SQLITE_TRANSIENT);
+    Check(db, sqlite3_step(statement));
+    sqlite3_reset(statement);
+  }
+  Execute(db, "COMMIT;");
+  sqlite3_finalize(statement);
+}
+
+// Builds the full-text search index of the `chat_items` of the |db| in the
+// chunks, as the `ScopedDatabase` does.
+static void Index(sqlite3* db) {
+  Execute(db,
+          "CREATE VIRTUAL TABLE chat_items_fts USING fts5("
+          "text, content='', tokenize='messenger', prefix='2 3');");
+
+  int64_t last = Count(db, "SELECT max(rowid) FROM chat_items;");
+  for (int64_t from = 1; from <= last; from += kIndexChunk) {
+    Execute(db,
+            "BEGIN;"
+            "INSERT INTO chat_items_fts(rowid, text) SELECT rowid, t FROM "
+            "(SELECT rowid, coalesce("
+            "json_extract(data, '$.value.text'), "
+            "json_extract(data, '$.value.quote.text')) AS t "
+            "FROM chat_items WHERE rowid BETWEEN " +
+                std::to_string(from) + " AND " +
+                std::to_string(from + kIndexChunk - 1) +
+                ") WHERE t IS NOT NULL;"
+                "COMMIT;");
+  }
+}
+
+// Returns the best time of the |runs| of the |sql| counting the rows matched
+// by the |text|, in milliseconds, storing the count into the |rows|.
+static double Measure(sqlite3* db,
+                      const std::string& sql,
+                      const std::string& text,
+                      int runs,
+                      int64_t* rows) {
+  double best = INFINITY;
+  for (int i = 0; i < runs; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    *rows = Count(db, sql, text);
+    best = std::min(best, std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - start)
+                              .count());
+  }
+  return best;
+}
+
+// Returns the size of the |table| of the |db|, including its shadow tables,
+// in MiB.
+static double TableSize(sqlite3* db, const std::string& table) {
+  return Count(db,
+               "SELECT sum(pgsize) FROM dbstat WHERE name = '" + table +
+                   "' OR name LIKE '" + table + "\\_%' ESCAPE '\\';") /
+         1048576.0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <directory> [count] [runs]\n", argv[0]);
+    return 1;
+  }
+
+  std::string directory = argv[1];
+  int64_t count = argc > 2 ? atoll(argv[2]) : 1000000;
+  int runs = argc > 3 ? atoi(argv[3]) : 3;
+
+  Check(nullptr,
+        sqlite3_auto_extension(reinterpret_cast<void (*)()>(Init)));
+
+  std::string path =
+      directory + "/messages_" + std::to_string(count) + ".sqlite";
+  struct stat st;
+  bool exists = stat(path.c_str(), &st) == 0;
+
+  sqlite3* db = nullptr;
+  if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+    fprintf(stderr, "Failed to open %s\n", path.c_str());
+    return 1;
+  }
+  Execute(db, "PRAGMA journal_mode = WAL;");
+
+  if (!exists) {
+    auto start = std::chrono::steady_clock::now();
+    Generate(db, count);
+    auto generated = std::chrono::steady_clock::now();
+    Index(db);
+    auto indexed = std::chrono::steady_clock::now();
+
+    printf("generated in %.1f s, indexed in %.1f s\n",
+           std::chrono::duration<double>(generated - start).count(),
+           std::chrono::duration<double>(indexed - generated).count());
+  }
+
+  printf("%lld messages, %.0f MiB of chat items, %.0f MiB of index, "
+         "best of %d runs\n",
+         static_cast<long long>(Count(db, "SELECT count(*) FROM chat_items;")),
+         TableSize(db, "chat_items"), TableSize(db, "chat_items_fts"), runs);
+  printf("%14s %9s %14s %9s  %s\n", "LIKE", "rows", "FTS", "rows", "term");
+
+  for (const char* term : kTerms) {
+    int64_t like_rows = 0;
+    double like = Measure(db,
+                          "SELECT count(*) FROM chat_items WHERE data LIKE ?1;",
+                          std::string("%\"text\":\"%") + term + "%\"%", runs,
+                          &like_rows);
+
+    int64_t fts_rows = 0;
+    double fts = Measure(
+        db,
+        "SELECT count(*) FROM chat_items WHERE rowid IN (SELECT rowid FROM "
+        "chat_items_fts WHERE chat_items_fts MATCH ?1);",
+        std::string("\"") + term + "\"*", runs, &fts_rows);
+
+    // Terms go last, as the width of their characters varies.
+    printf("%11.1f ms %9lld %11.1f ms %9lld  %s\n", like,
+           static_cast<long long>(like_rows), fts,
+           static_cast<long long>(fts_rows), term);
+  }
+
+  sqlite3_close(db);
+  return 0;
+}
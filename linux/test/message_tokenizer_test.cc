@@ -0,0 +1,135 @@
+// Checks the `messenger` FTS5 tokenizer registered the same way the runner's
+// SQLite extension does: the case and diacritic folding, the CJK runs split
+// into the bigrams, and the prefix queries the search is made with.
+
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <set>
+#include <string>
+
+#include "message_tokenizer.h"
+
+#define EXPECT(condition)                                              \
+  do {                                                                 \
+    if (!(condition)) {                                                \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,      \
+              #condition);                                             \
+      exit(1);                                                         \
+    }                                                                  \
+  } while (0)
+
+// Entry point of the extension, registering the tokenizer on every database
+// opened.
+static int Init(sqlite3* db, char** error, const sqlite3_api_routines* api) {
+  return RegisterMessageTokenizer(db, api);
+}
+
+// Executes the |sql|, failing the test, if it fails.
+static void Execute(sqlite3* db, const std::string& sql) {
+  char* error = nullptr;
+  if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK) {
+    fprintf(stderr, "%s: %s\n", sql.c_str(), error);
+    exit(1);
+  }
+}
+
+// Returns the single integer result of the |sql| with the |text| bound.
+static int64_t Count(sqlite3* db, const char* sql, const std::string& text) {
+  sqlite3_stmt* statement = nullptr;
+  EXPECT(sqlite3_prepare_v2(db, sql, -1, &statement, nullptr) == SQLITE_OK);
+  sqlite3_bind_text(statement, 1, text.c_str(), text.size(), SQLITE_STATIC);
+  EXPECT(sqlite3_step(statement) == SQLITE_ROW);
+  int64_t count = sqlite3_column_int64(statement, 0);
+  sqlite3_finalize(statement);
+  return count;
+}
+
+// Returns the terms the |text| is indexed with.
+static std::set<std::string> Terms(sqlite3* db, const std::string& text) {
+  Execute(db, "DELETE FROM messages;");
+  sqlite3_stmt* statement = nullptr;
+  EXPECT(sqlite3_prepare_v2(db, "INSERT INTO messages VALUES (?1);", -1,
+                            &statement, nullptr) == SQLITE_OK);
+  sqlite3_bind_text(statement, 1, text.c_str(), text.size(), SQLITE_STATIC);
+  EXPECT(sqlite3_step(statement) == SQLITE_DONE);
+  sqlite3_finalize(statement);
+
+  std::set<std::string> terms;
+  EXPECT(sqlite3_prepare_v2(db, "SELECT term FROM terms;", -1, &statement,
+                            nullptr) == SQLITE_OK);
+  while (sqlite3_step(statement) == SQLITE_ROW) {
+    terms.insert(
+        reinterpret_cast<const char*>(sqlite3_column_text(statement, 0)));
+  }
+  sqlite3_finalize(statement);
+  return terms;
+}
+
+// Indicates whether the |text| is matched by the |query| of the `"word"*`
+// form being made by the search.
+static bool Matches(sqlite3* db,
+                    const std::string& text,
+                    const std::string& query) {
+  Terms(db, text);
+  return Count(db,
+               "SELECT count(*) FROM messages WHERE messages MATCH ?1;",
+               "\"" + query + "\"*") == 1;
+}
+
+static void TestFolding(sqlite3* db) {
+  EXPECT(Terms(db, "Reunión MAÑANA Встреча") ==
+         (std::set<std::string>{"reunion", "manana", "встреча"}));
+  EXPECT(Terms(db, "Crème brûlée, naïve") ==
+         (std::set<std::string>{"creme", "brulee", "naive"}));
+
+  EXPECT(Matches(db, "Reunión mañana", "reunion"));
+  EXPECT(Matches(db, "reunion manana", "REUNIÓN"));
+  EXPECT(Matches(db, "Meeting tomorrow", "meet"));
+  EXPECT(Matches(db, "Встреча завтра", "ВСТРЕЧ"));
+  EXPECT(!Matches(db, "Meeting tomorrow", "eting"));
+}
+
+static void TestCjk(sqlite3* db) {
+  // Runs are split into the overlapping bigrams along with the last
+  // character colocated with the last bigram.
+  EXPECT(Terms(db, "明天开会议") ==
+         (std::set<std::string>{"明天", "天开", "开会", "会议", "议"}));
+  EXPECT(Terms(db, "会议") == (std::set<std::string>{"会议", "议"}));
+  EXPECT(Terms(db, "好") == (std::set<std::string>{"好"}));
+
+  // Runs within the words of the other scripts are split from them.
+  EXPECT(Terms(db, "Meeting会议 tomorrow") ==
+         (std::set<std::string>{"meeting", "会议", "议", "tomorrow"}));
+  EXPECT(Terms(db, "회의 会議") ==
+         (std::set<std::string>{"회의", "의", "会議", "議"}));
+
+  // Any substring of a run is matched, while the characters not adjacent in
+  // it aren't.
+  EXPECT(Matches(db, "明天开会议", "会议"));
+  EXPECT(Matches(db, "明天开会议", "天开会"));
+  EXPECT(Matches(db, "明天开会议", "明天开会议"));
+  EXPECT(Matches(db, "明天开会议", "天"));
+  EXPECT(Matches(db, "明天开会议", "议"));
+  EXPECT(!Matches(db, "明天开会议", "会明"));
+  EXPECT(!Matches(db, "明天开会议", "天会"));
+}
+
+int main() {
+  EXPECT(sqlite3_auto_extension(reinterpret_cast<void (*)()>(Init)) ==
+         SQLITE_OK);
+
+  sqlite3* db = nullptr;
+  EXPECT(sqlite3_open(":memory:", &db) == SQLITE_OK);
+  Execute(db,
+          "CREATE VIRTUAL TABLE messages USING fts5("
+          "text, tokenize='messenger', prefix='2 3');"
+          "CREATE VIRTUAL TABLE terms USING fts5vocab(messages, 'row');");
+
+  TestFolding(db);
+  TestCjk(db);
+
+  sqlite3_close(db);
+  return 0;
+}
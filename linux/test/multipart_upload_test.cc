@@ -0,0 +1,164 @@
+// Checks MultipartUpload against the stand-in server of the
+// `upload_server.py`, which runs this test with its URL as the argument and
+// responds with what it has received: the completed, paused and resumed,
+// cancelled and rejected uploads, and the upload of a missing file.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "multipart_upload.h"
+#include "sha256.h"
+
+#define EXPECT(condition)                                              \
+  do {                                                                 \
+    if (!(condition)) {                                                \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,      \
+              #condition);                                             \
+      exit(1);                                                         \
+    }                                                                  \
+  } while (0)
+
+// Size of the file uploaded, taking the server over a second to receive.
+static const int64_t kFileSize = 8 * 1024 * 1024;
+
+// Time to keep the upload paused for.
+static const int kPauseMs = 500;
+
+// Writes the PNG looking file to the |path|, returning its SHA-256 digest.
+static std::string WriteFile(const std::string& path) {
+  std::vector<uint8_t> data(kFileSize);
+  for (int64_t i = 0; i < kFileSize; ++i) {
+    data[i] = static_cast<uint8_t>(((i % 251) * 31 + 7) & 0xFF);
+  }
+  memcpy(data.data(), "\x89PNG\r\n\x1A\n", 8);
+
+  int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+  EXPECT(fd >= 0);
+  EXPECT(write(fd, data.data(), data.size()) ==
+         static_cast<ssize_t>(data.size()));
+  close(fd);
+
+  Sha256 hasher;
+  hasher.Update(data.data(), data.size());
+  return hasher.FinishHex();
+}
+
+static MultipartUpload::Options MakeOptions(const std::string& url,
+                                            const std::string& path) {
+  MultipartUpload::Options options;
+  options.url = url;
+  options.path = path;
+  options.filename = "image.bin";
+  options.content_type = "application/x-test";
+  options.fields = {{"operations", "{}"}, {"map", "{}"}};
+  options.headers = {"Authorization: Bearer token"};
+  return options;
+}
+
+// Expects the |upload| to be received by the server completely.
+static void ExpectReceived(const MultipartUpload& upload,
+                           const std::string& sha256) {
+  EXPECT(upload.status() == 200);
+  EXPECT(upload.sha256() == sha256);
+  EXPECT(upload.size() == kFileSize);
+  EXPECT(upload.mime() == "image/png");
+
+  const std::string& response = upload.response();
+  EXPECT(response.find("\"sha256\": \"" + sha256 + "\"") != std::string::npos);
+  EXPECT(response.find("\"size\": " + std::to_string(kFileSize)) !=
+         std::string::npos);
+  EXPECT(response.find("\"type\": \"image/png\"") != std::string::npos);
+  EXPECT(response.find("\"fields\": [\"operations\", \"map\"]") !=
+         std::string::npos);
+  EXPECT(response.find("\"authorization\": \"Bearer token\"") !=
+         std::string::npos);
+}
+
+static void TestCompleted(const std::string& url,
+                          const std::string& path,
+                          const std::string& sha256) {
+  MultipartUpload upload(MakeOptions(url + "/upload", path));
+
+  int64_t reported = 0;
+  int64_t body = 0;
+  UploadResult result = upload.Run([&](int64_t sent, int64_t total) {
+    EXPECT(sent >= reported && total > kFileSize);
+    reported = sent;
+    body = total;
+  });
+
+  EXPECT(result == UploadResult::kCompleted);
+  EXPECT(reported == body);
+  ExpectReceived(upload, sha256);
+}
+
+// Pauses the upload once its progress is first reported, and resumes it
+// after the kPauseMs, expecting it not to complete meanwhile.
+static void TestPaused(const std::string& url,
+                       const std::string& path,
+                       const std::string& sha256) {
+  MultipartUpload upload(MakeOptions(url + "/upload", path));
+
+  std::atomic<int64_t> reported{0};
+  std::atomic<int64_t> reported_paused{-1};
+  std::thread resuming;
+
+  UploadResult result = upload.Run([&](int64_t sent, int64_t total) {
+    reported = sent;
+    if (!resuming.joinable()) {
+      upload.Pause();
+      resuming = std::thread([&] {
+        usleep(kPauseMs * 1000);
+        reported_paused = reported.load();
+        upload.Resume();
+      });
+    }
+  });
+  resuming.join();
+
+  EXPECT(result == UploadResult::kCompleted);
+  EXPECT(reported_paused >= 0 && reported_paused < reported);
+  ExpectReceived(upload, sha256);
+}
+
+static void TestCancelled(const std::string& url, const std::string& path) {
+  MultipartUpload upload(MakeOptions(url + "/upload", path));
+  UploadResult result =
+      upload.Run([&](int64_t, int64_t) { upload.Cancel(); });
+
+  EXPECT(result == UploadResult::kCancelled);
+}
+
+int main(int argc, char** argv) {
+  EXPECT(argc == 2);
+  std::string url = argv[1];
+
+  char directory[] = "/tmp/multipart_upload_test.XXXXXX";
+  EXPECT(mkdtemp(directory) != nullptr);
+  std::string path = std::string(directory) + "/file";
+  std::string sha256 = WriteFile(path);
+
+  TestCompleted(url, path, sha256);
+  TestPaused(url, path, sha256);
+  TestCancelled(url, path);
+
+  // Rejected right after the headers, without sending the whole body.
+  MultipartUpload rejected(MakeOptions(url + "/reject", path));
+  EXPECT(rejected.Run([](int64_t, int64_t) {}) == UploadResult::kHttpError);
+  EXPECT(rejected.status() == 413);
+
+  MultipartUpload missing(MakeOptions(url + "/upload", path + ".missing"));
+  EXPECT(missing.Run([](int64_t, int64_t) {}) == UploadResult::kFileError);
+
+  unlink(path.c_str());
+  EXPECT(rmdir(directory) == 0);
+  return 0;
+}
@@ -0,0 +1,126 @@
+// Checks SegmentedDownload against the stand-in server of the
+// `download_server.py`, which runs this test with its URL as the argument:
+// the completed, resumed and corrupted downloads, the latter being resumed
+// from the same file changed on the server with its size and ETag kept, so
+// only the SHA-256 digest differs.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "segmented_download.h"
+#include "sha256.h"
+
+#define EXPECT(condition)                                              \
+  do {                                                                 \
+    if (!(condition)) {                                                \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,      \
+              #condition);                                             \
+      exit(1);                                                         \
+    }                                                                  \
+  } while (0)
+
+// Size of the file served, generated the same way as the server does.
+static const int64_t kFileSize = 8 * 1024 * 1024;
+
+static std::string ExpectedSha256() {
+  std::vector<uint8_t> data(kFileSize);
+  for (int64_t i = 0; i < kFileSize; ++i) {
+    data[i] = static_cast<uint8_t>(((i % 256) * 31 + 7) & 0xFF);
+  }
+
+  Sha256 hasher;
+  hasher.Update(data.data(), data.size());
+  return hasher.FinishHex();
+}
+
+static bool Exists(const std::string& path) {
+  return access(path.c_str(), F_OK) == 0;
+}
+
+static SegmentedDownload::Options MakeOptions(const std::string& url,
+                                              const std::string& path) {
+  SegmentedDownload::Options options;
+  options.url = url;
+  options.path = path;
+  options.connections = 2;
+  return options;
+}
+
+// Downloads the |url| to the |path| until the first progress is reported,
+// leaving the `.part` file to be resumed.
+static void DownloadPartially(const std::string& url,
+                              const std::string& path) {
+  SegmentedDownload download(MakeOptions(url, path));
+  DownloadResult result = download.Run([&](int64_t received, int64_t total) {
+    EXPECT(total == kFileSize);
+    if (received > 0) {
+      download.Cancel();
+    }
+  });
+
+  EXPECT(result == DownloadResult::kCancelled);
+  EXPECT(!Exists(path) && Exists(path + ".part"));
+}
+
+// Downloads the |url| to the |path| completely, returning the number of the
+// bytes reported as already received when the download started.
+static int64_t Download(const std::string& url,
+                        const std::string& path,
+                        std::string* sha256) {
+  int64_t resumed = -1;
+
+  SegmentedDownload download(MakeOptions(url, path));
+  DownloadResult result = download.Run([&](int64_t received, int64_t total) {
+    if (resumed < 0) {
+      resumed = received;
+    }
+  });
+
+  EXPECT(result == DownloadResult::kCompleted);
+  EXPECT(download.size() == kFileSize);
+  EXPECT(!Exists(path + ".part") && !Exists(path + ".part.state"));
+
+  struct stat st;
+  EXPECT(stat(path.c_str(), &st) == 0 && st.st_size == kFileSize);
+
+  *sha256 = download.sha256();
+  return resumed;
+}
+
+int main(int argc, char** argv) {
+  EXPECT(argc == 2);
+  std::string url = argv[1];
+  std::string expected = ExpectedSha256();
+
+  char directory[] = "/tmp/segmented_download_test.XXXXXX";
+  EXPECT(mkdtemp(directory) != nullptr);
+  std::string path = std::string(directory) + "/file";
+  std::string sha256;
+
+  Download(url + "/data", path, &sha256);
+  EXPECT(sha256 == expected);
+  unlink(path.c_str());
+
+  DownloadPartially(url + "/data", path);
+  EXPECT(Download(url + "/data", path, &sha256) > 0);
+  EXPECT(sha256 == expected);
+  unlink(path.c_str());
+
+  // The file is expected to be deleted by the caller comparing the digest.
+  DownloadPartially(url + "/data", path);
+  EXPECT(Download(url + "/corrupt", path, &sha256) > 0);
+  EXPECT(sha256 != expected);
+  unlink(path.c_str());
+
+  SegmentedDownload missing(MakeOptions(url + "/missing", path));
+  EXPECT(missing.Run([](int64_t, int64_t) {}) == DownloadResult::kHttpError);
+  EXPECT(missing.status() == 404);
+
+  EXPECT(rmdir(directory) == 0);
+  return 0;
+}
@@ -0,0 +1,78 @@
+// Measures the throughput of the SHA-256 kernels selected for the current CPU
+// when hashing single messages and batches of them.
+//
+// Usage: sha256_benchmark [MiB per measurement]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "sha256.h"
+
+// Digest of the "abc" message from FIPS 180-2.
+static const char kAbcDigest[] =
+    "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+
+// Returns the MB/s of invoking the |hash| processing |bytes| each time until
+// |total| bytes are processed.
+template <typename Hash>
+static double measure(size_t bytes, size_t total, const Hash& hash) {
+  size_t iterations = total / bytes > 0 ? total / bytes : 1;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    hash();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  return static_cast<double>(bytes) * iterations / (1 << 20) / seconds;
+}
+
+int main(int argc, char** argv) {
+  size_t total = static_cast<size_t>(argc > 1 ? atoi(argv[1]) : 256) << 20;
+
+  Sha256 abc;
+  abc.Update("abc", 3);
+  if (abc.FinishHex() != kAbcDigest ||
+      Sha256Batch({{reinterpret_cast<const uint8_t*>("abc"), 3}})[0] !=
+          kAbcDigest) {
+    fprintf(stderr, "Digest of \"abc\" is wrong\n");
+    return 1;
+  }
+
+  printf("single: %s, batch: %s\n",
+         Sha256KernelName(Sha256SingleBufferKernel()),
+         Sha256KernelName(Sha256MultiBufferKernel()));
+  printf("%-12s %14s %14s\n", "size", "single MB/s", "batch of 8 MB/s");
+
+  for (size_t size : {64, 1024, 64 * 1024, 1024 * 1024}) {
+    std::vector<uint8_t> data(size * 8);
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+
+    std::string digest;
+    double single = measure(size, total, [&] {
+      Sha256 sha256;
+      sha256.Update(data.data(), size);
+      digest = sha256.FinishHex();
+    });
+
+    std::vector<Sha256Message> messages;
+    for (size_t i = 0; i < 8; ++i) {
+      messages.push_back({data.data() + i * size, size});
+    }
+    double batch = measure(size * 8, total,
+                           [&] { digest = Sha256Batch(messages)[0]; });
+
+    printf("%-12zu %14.0f %14.0f\n", size, single, batch);
+  }
+
+  return 0;
+}
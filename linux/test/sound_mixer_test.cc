@@ -0,0 +1,195 @@
+// Checks the SoundMixer mixing the overlapping sounds into a WAV file, clipping
+// the samples peaking together, and dropping the sounds played again too soon.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_sink.h"
+#include "sound_mixer.h"
+
+#define EXPECT(condition)                                              \
+  do {                                                                 \
+    if (!(condition)) {                                                \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,      \
+              #condition);                                             \
+      exit(1);                                                         \
+    }                                                                  \
+  } while (0)
+
+// Number of the frames mixed at once by the SoundMixer.
+static const size_t kPeriodFrames = kAudioSampleRate / 100;
+
+// Number of the silent periods the SoundMixer writes after the sounds end.
+static const size_t kTailPeriods = 2;
+
+// Length of the sounds played, in periods.
+static const size_t kSoundPeriods = 50;
+
+// Size of the RIFF and WAVE headers of a WAV file.
+static const size_t kWavHeaderSize = 44;
+
+// Amplitude of the sounds, loud enough for two of them to clip together.
+static const int16_t kAmplitude = 20000;
+
+// Returns a Sound of the |kSoundPeriods| with the |kAmplitude| on the left
+// channel and its negation on the right one.
+static Sound ConstantSound() {
+  Sound sound;
+  sound.samples.resize(kSoundPeriods * kPeriodFrames * kAudioChannels);
+  for (size_t i = 0; i < sound.samples.size(); i += kAudioChannels) {
+    sound.samples[i] = kAmplitude;
+    sound.samples[i + 1] = -kAmplitude;
+  }
+  return sound;
+}
+
+// Returns the little-endian value of the |bytes| at the |offset|.
+static uint32_t ReadLe(const std::vector<uint8_t>& bytes,
+                       size_t offset,
+                       int size) {
+  uint32_t value = 0;
+  for (int i = 0; i < size; ++i) {
+    value |= static_cast<uint32_t>(bytes[offset + i]) << (8 * i);
+  }
+  return value;
+}
+
+// Reads everything written to the FIFO at the |path| into the |bytes| until
+// its writer closes it.
+static void ReadFifo(const std::string& path, std::vector<uint8_t>* bytes) {
+  FILE* file = fopen(path.c_str(), "rbe");
+  EXPECT(file != nullptr);
+
+  uint8_t buffer[65536];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    bytes->insert(bytes->end(), buffer, buffer + read);
+  }
+  fclose(file);
+}
+
+// Returns the frames of the WAV |bytes| written to a FIFO, checking their
+// headers. FIFO can't be seeked, so the completed header follows the frames,
+// instead of overwriting the one preceding them.
+static std::vector<int16_t> ParseWav(const std::vector<uint8_t>& bytes) {
+  EXPECT(bytes.size() >= 2 * kWavHeaderSize);
+  size_t size = bytes.size() - 2 * kWavHeaderSize;
+  size_t footer = bytes.size() - kWavHeaderSize;
+
+  for (size_t header : {static_cast<size_t>(0), footer}) {
+    EXPECT(memcmp(bytes.data() + header, "RIFF", 4) == 0);
+    EXPECT(memcmp(bytes.data() + header + 8, "WAVEfmt ", 8) == 0);
+    EXPECT(ReadLe(bytes, header + 22, 2) == kAudioChannels);
+    EXPECT(ReadLe(bytes, header + 24, 4) == kAudioSampleRate);
+    EXPECT(ReadLe(bytes, header + 34, 2) == 16);
+    EXPECT(memcmp(bytes.data() + header + 36, "data", 4) == 0);
+  }
+  EXPECT(ReadLe(bytes, footer + 4, 4) == kWavHeaderSize - 8 + size);
+  EXPECT(ReadLe(bytes, footer + 40, 4) == size);
+
+  std::vector<int16_t> samples(size / sizeof(int16_t));
+  memcpy(samples.data(), bytes.data() + kWavHeaderSize,
+         samples.size() * sizeof(int16_t));
+  return samples;
+}
+
+// Expects the |count| frames of the |samples| from the |frame| to be equal to
+// the |left| and |right| ones, advancing the |frame| past them.
+static void ExpectFrames(const std::vector<int16_t>& samples,
+                         size_t* frame,
+                         size_t count,
+                         int16_t left,
+                         int16_t right) {
+  for (size_t i = *frame; i < *frame + count; ++i) {
+    if (samples[i * kAudioChannels] != left ||
+        samples[i * kAudioChannels + 1] != right) {
+      fprintf(stderr, "Frame %zu is (%d, %d) instead of (%d, %d)\n", i,
+              samples[i * kAudioChannels], samples[i * kAudioChannels + 1],
+              left, right);
+      exit(1);
+    }
+  }
+  *frame += count;
+}
+
+static void TestMixed(const std::string& path) {
+  Sound first = ConstantSound();
+  Sound second = ConstantSound();
+
+  // Mixing thread waits in opening the FIFO for the sink until it's read, so
+  // the sounds are queued before it mixes anything, and overlap exactly.
+  EXPECT(mkfifo(path.c_str(), 0600) == 0);
+  SoundMixer mixer;
+  mixer.Start("wav:" + path);
+
+  EXPECT(mixer.Play(&first, 1) == SoundPlayback::kQueued);
+  EXPECT(mixer.Play(&second, 1) == SoundPlayback::kQueued);
+  EXPECT(mixer.Play(&first, 1) == SoundPlayback::kThrottled);
+
+  std::vector<uint8_t> bytes;
+  std::thread reader(ReadFifo, path, &bytes);
+
+  // The WAV sink is written as fast as possible, so this plays out the
+  // sounds, and lets the throttling of the |first| one expire.
+  std::this_thread::sleep_for(
+      std::chrono::microseconds(SoundMixer::kRepeatInterval + 50000));
+  EXPECT(mixer.Play(&first, 0.5f) == SoundPlayback::kQueued);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  mixer.Stop();
+  reader.join();
+  EXPECT(mixer.Play(&first, 1) == SoundPlayback::kFailed);
+
+  std::vector<int16_t> samples = ParseWav(bytes);
+  EXPECT(samples.size() == 2 * (kSoundPeriods + kTailPeriods) *
+                               kPeriodFrames * kAudioChannels);
+
+  size_t frame = 0;
+  ExpectFrames(samples, &frame, kSoundPeriods * kPeriodFrames, INT16_MAX,
+               INT16_MIN);
+  ExpectFrames(samples, &frame, kTailPeriods * kPeriodFrames, 0, 0);
+  ExpectFrames(samples, &frame, kSoundPeriods * kPeriodFrames, kAmplitude / 2,
+               -kAmplitude / 2);
+  ExpectFrames(samples, &frame, kTailPeriods * kPeriodFrames, 0, 0);
+
+  unlink(path.c_str());
+}
+
+static void TestFailedSink(const std::string& directory) {
+  Sound sound = ConstantSound();
+
+  SoundMixer mixer;
+  mixer.Start("wav:" + directory + "/missing/sound.wav");
+
+  // Sink is opened on the mixing thread, failing the mixer once it's not.
+  for (int i = 0; i < 100; ++i) {
+    if (mixer.Play(&sound, 1) == SoundPlayback::kFailed) {
+      mixer.Stop();
+      return;
+    }
+    std::this_thread::sleep_for(
+        std::chrono::microseconds(SoundMixer::kRepeatInterval));
+  }
+
+  fprintf(stderr, "Mixer hasn't failed without its sink\n");
+  exit(1);
+}
+
+int main() {
+  char directory[] = "/tmp/sound_mixer_test.XXXXXX";
+  EXPECT(mkdtemp(directory) != nullptr);
+
+  TestMixed(std::string(directory) + "/mixed.wav");
+  TestFailedSink(directory);
+
+  EXPECT(rmdir(directory) == 0);
+  return 0;
+}
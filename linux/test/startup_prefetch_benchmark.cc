@@ -0,0 +1,293 @@
+// Measures the startup simulated over a synthetic bundle and databases with
+// the page cache dropped before each run: without a prefetch, with the files
+// prefetched whole, and with the profile recorded by a run without a
+// prefetch. The simulated startup touches every 4th page of the first half
+// of each file with some CPU work between the files.
+//
+// The files are created in the |directory|, which must be on a disk-backed
+// filesystem, as the pages of e.g. `tmpfs` can't be dropped.
+//
+// Usage: startup_prefetch_benchmark <directory> [runs]
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "startup_prefetch.h"
+
+struct FixtureFile {
+  const char* path;
+  int64_t size;
+};
+
+// Files of the bundle and the databases along with their sizes.
+static const FixtureFile kFiles[] = {
+    {"bundle/data/icudtl.dat", 30 << 20},
+    {"bundle/lib/libflutter_linux_gtk.so", 40 << 20},
+    {"bundle/lib/libapp.so", 15 << 20},
+    {"data/common.sqlite", 3 << 20},
+    {"data/user.sqlite", 40 << 20},
+    {"data/user.sqlite-wal", 4 << 20},
+};
+
+// Number and size of the assets.
+static const int kAssets = 40;
+static const int64_t kAssetSize = 256 * 1024;
+
+static volatile unsigned sink;
+
+static void WriteFile(const std::string& path, int64_t size) {
+  int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    perror(path.c_str());
+    exit(1);
+  }
+
+  std::vector<unsigned char> chunk(1 << 20);
+  unsigned state = static_cast<unsigned>(size);
+  for (int64_t written = 0; written < size;) {
+    for (unsigned char& byte : chunk) {
+      state = state * 1103515245 + 12345;
+      byte = static_cast<unsigned char>(state >> 16);
+    }
+
+    size_t length = std::min<int64_t>(chunk.size(), size - written);
+    if (write(fd, chunk.data(), length) != static_cast<ssize_t>(length)) {
+      perror(path.c_str());
+      exit(1);
+    }
+    written += length;
+  }
+
+  fsync(fd);
+  close(fd);
+}
+
+// Creates the files in the |directory|, returning their paths in the order
+// the startup reads them in.
+static std::vector<std::string> CreateFixture(const std::string& directory) {
+  for (const char* subdirectory :
+       {"/bundle", "/bundle/data", "/bundle/data/flutter_assets",
+        "/bundle/lib", "/data"}) {
+    mkdir((directory + subdirectory).c_str(), 0755);
+  }
+
+  std::vector<std::string> paths;
+  for (const FixtureFile& file : kFiles) {
+    paths.push_back(directory + "/" + file.path);
+    WriteFile(paths.back(), file.size);
+  }
+
+  for (int i = 0; i < kAssets; ++i) {
+    std::string path =
+        directory + "/bundle/data/flutter_assets/" + std::to_string(i);
+    paths.insert(paths.begin() + 3 + i, path);
+    WriteFile(path, kAssetSize);
+  }
+
+  return paths;
+}
+
+// Drops the |paths| from the page cache.
+static void Evict(const std::vector<std::string>& paths) {
+  for (const std::string& path : paths) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+    }
+  }
+}
+
+// Simulates the startup reading the |paths|, keeping the databases open like
+// SQLite does, which are returned to be closed.
+static std::vector<int> Startup(const std::vector<std::string>& paths) {
+  std::vector<int> databases;
+
+  for (const std::string& path : paths) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    fstat(fd, &st);
+
+    unsigned char* bytes = static_cast<unsigned char*>(
+        mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0));
+    for (off_t offset = 0; offset < st.st_size / 2; offset += 4 * 4096) {
+      sink += bytes[offset];
+    }
+    munmap(bytes, st.st_size);
+
+    if (path.find("/bundle/") == std::string::npos) {
+      databases.push_back(fd);
+    } else {
+      close(fd);
+    }
+
+    for (int i = 0; i < 3000000; ++i) {
+      sink += i * i;
+    }
+  }
+
+  return databases;
+}
+
+static void CloseAll(const std::vector<int>& fds) {
+  for (int fd : fds) {
+    close(fd);
+  }
+}
+
+// Returns the milliseconds of the simulated startup of the |paths| after the
+// |prefetch| is started on its own thread, if any.
+template <typename Prefetch>
+static double Measure(const std::vector<std::string>& paths,
+                      const Prefetch& prefetch) {
+  Evict(paths);
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread thread(prefetch);
+  CloseAll(Startup(paths));
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+
+  thread.join();
+  return ms;
+}
+
+// Returns the median of the |runs| measurements of the |prefetch|.
+template <typename Prefetch>
+static double Median(const std::vector<std::string>& paths,
+                     int runs,
+                     const Prefetch& prefetch) {
+  std::vector<double> results;
+  for (int i = 0; i < runs; ++i) {
+    results.push_back(Measure(paths, prefetch));
+  }
+
+  std::sort(results.begin(), results.end());
+  return results[results.size() / 2];
+}
+
+// Returns the total length of the ranges in the profile at the |path|.
+static int64_t ProfiledBytes(const std::string& path) {
+  int64_t total = 0;
+
+  FILE* file = fopen(path.c_str(), "re");
+  char line[4096];
+  while (file != nullptr && fgets(line, sizeof(line), file) != nullptr) {
+    long long offset, length;
+    if (sscanf(line, "r %lld %lld", &offset, &length) == 2) {
+      total += length;
+    }
+  }
+
+  if (file != nullptr) {
+    fclose(file);
+  }
+  return total;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <directory> [runs]\n", argv[0]);
+    return 1;
+  }
+
+  std::string directory = argv[1];
+  int runs = argc > 2 ? atoi(argv[2]) : 5;
+
+  std::vector<std::string> paths = CreateFixture(directory);
+  StartupPrefetchPaths prefetch_paths;
+  prefetch_paths.bundle = directory + "/bundle";
+  prefetch_paths.profile = directory + "/startup_prefetch";
+  unlink(prefetch_paths.profile.c_str());
+
+  // Without a profile nothing is prefetched, but the profile is recorded.
+  Evict(paths);
+  if (RunStartupPrefetch(prefetch_paths) != 0) {
+    fprintf(stderr, "Prefetched without a profile\n");
+    return 1;
+  }
+  std::vector<int> databases = Startup(paths);
+  bool recorded = RecordStartupProfile(prefetch_paths);
+  CloseAll(databases);
+
+  int64_t profiled = ProfiledBytes(prefetch_paths.profile);
+  if (!recorded || profiled == 0) {
+    fprintf(stderr, "Profile isn't recorded\n");
+    return 1;
+  }
+
+  double none = Median(paths, runs, [] {});
+  double whole = Median(paths, runs, [&paths] {
+    for (const std::string& path : paths) {
+      int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      struct stat st;
+      if (fd >= 0 && fstat(fd, &st) == 0) {
+        for (int64_t offset = 0; offset < st.st_size; offset += 2 << 20) {
+          readahead(fd, offset, 2 << 20);
+        }
+      }
+      close(fd);
+    }
+  });
+  double profile = Median(paths, runs, [&prefetch_paths] {
+    RunStartupPrefetch(prefetch_paths);
+  });
+
+  // Runs prefetching mustn't record the profile, as it'd reinforce itself.
+  databases = Startup(paths);
+  RecordStartupProfile(prefetch_paths);
+  CloseAll(databases);
+  if (ProfiledBytes(prefetch_paths.profile) != profiled) {
+    fprintf(stderr, "Profile is recorded after prefetching\n");
+    return 1;
+  }
+
+  // Pages cached before the startup, e.g. by an update, must be recorded too.
+  unlink(prefetch_paths.profile.c_str());
+  RunStartupPrefetch(prefetch_paths);
+  databases = Startup(paths);
+  RecordStartupProfile(prefetch_paths);
+  CloseAll(databases);
+  if (ProfiledBytes(prefetch_paths.profile) < profiled) {
+    fprintf(stderr, "Profile misses the pages cached before the startup\n");
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  CloseAll(Startup(paths));
+  double cached = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+  int64_t total = 0;
+  for (const FixtureFile& file : kFiles) {
+    total += file.size;
+  }
+  total += kAssets * kAssetSize;
+
+  printf("%lld MiB in %zu files, %lld MiB profiled, median of %d runs\n",
+         static_cast<long long>(total >> 20), paths.size(),
+         static_cast<long long>(profiled >> 20), runs);
+  printf("%-14s %8.1f ms\n", "warm cache", cached);
+  printf("%-14s %8.1f ms\n", "no prefetch", none);
+  printf("%-14s %8.1f ms\n", "whole files", whole);
+  printf("%-14s %8.1f ms\n", "profile", profile);
+
+  for (const std::string& path : paths) {
+    unlink(path.c_str());
+  }
+  unlink(prefetch_paths.profile.c_str());
+
+  return 0;
+}
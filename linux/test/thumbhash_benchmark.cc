@@ -0,0 +1,232 @@
+// Measures decoding a batch of 1,000 ThumbHashes with
+// messenger_thumbhash_decode() against a port of the reference
+// `thumbHashToRGBA()` evaluating the cosines per pixel, which the Dart
+// `flutter_thumbhash` package decoding them before does the same way.
+//
+// Usage: thumbhash_benchmark [batches]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "thumbhash.h"
+
+// Number of the ThumbHashes in a batch.
+static const int kBatchSize = 1000;
+
+// Hashes the batch is generated from, without and with alpha.
+static const std::vector<uint8_t> kHashes[] = {
+    {0xd5, 0x07, 0x12, 0x1d, 0x04, 0x67, 0x87, 0x8f, 0x77, 0x57, 0x87,
+     0x48, 0x87, 0x87, 0x97, 0x87, 0x58, 0x78, 0x90, 0x95, 0x08},
+    {0x60, 0x9a, 0x86, 0x3d, 0x0c, 0x3b, 0xb0, 0x59, 0x6c, 0x96, 0xa8,
+     0x45, 0x69, 0xf4, 0x84, 0xf9, 0x0e, 0xa8, 0x27, 0x58, 0x76, 0x88,
+     0x70, 0x76, 0x47},
+};
+
+struct Image {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> rgba;
+};
+
+// Returns the |count| AC coefficients of the channel of |nx| by |ny|
+// frequencies, read from the |index|th nibble of the |ac|.
+static std::vector<double> ReadChannel(const uint8_t* ac,
+                                       int* index,
+                                       int nx,
+                                       int ny,
+                                       double scale) {
+  std::vector<double> values;
+  for (int cy = 0; cy < ny; ++cy) {
+    for (int cx = cy ? 0 : 1; cx * ny < nx * (ny - cy); ++cx, ++*index) {
+      int nibble = (ac[*index >> 1] >> ((*index & 1) << 2)) & 15;
+      values.push_back((nibble / 7.5 - 1) * scale);
+    }
+  }
+  return values;
+}
+
+static uint8_t ToByte(double value) {
+  return static_cast<uint8_t>(std::max(0.0, 255 * std::min(1.0, value)));
+}
+
+// Port of the reference `thumbHashToRGBA()`.
+static Image DecodeReference(const std::vector<uint8_t>& hash) {
+  int header24 = hash[0] | hash[1] << 8 | hash[2] << 16;
+  int header16 = hash[3] | hash[4] << 8;
+  double l_dc = (header24 & 63) / 63.0;
+  double p_dc = ((header24 >> 6) & 63) / 31.5 - 1;
+  double q_dc = ((header24 >> 12) & 63) / 31.5 - 1;
+  double l_scale = ((header24 >> 18) & 31) / 31.0;
+  bool has_alpha = header24 >> 23;
+  double p_scale = ((header16 >> 3) & 63) / 63.0;
+  double q_scale = ((header16 >> 9) & 63) / 63.0;
+  bool landscape = header16 >> 15;
+  int lx = std::max(3, landscape ? (has_alpha ? 5 : 7) : header16 & 7);
+  int ly = std::max(3, landscape ? header16 & 7 : (has_alpha ? 5 : 7));
+  double a_dc = has_alpha ? (hash[5] & 15) / 15.0 : 1;
+  double a_scale = has_alpha ? (hash[5] >> 4) / 15.0 : 0;
+
+  const uint8_t* ac = hash.data() + (has_alpha ? 6 : 5);
+  int index = 0;
+  std::vector<double> l_ac = ReadChannel(ac, &index, lx, ly, l_scale);
+  std::vector<double> p_ac = ReadChannel(ac, &index, 3, 3, p_scale * 1.25);
+  std::vector<double> q_ac = ReadChannel(ac, &index, 3, 3, q_scale * 1.25);
+  std::vector<double> a_ac;
+  if (has_alpha) {
+    a_ac = ReadChannel(ac, &index, 5, 5, a_scale);
+  }
+
+  // Approximate aspect ratio, as read by the reference.
+  int rx = landscape ? (has_alpha ? 5 : 7) : hash[3] & 7;
+  int ry = landscape ? hash[3] & 7 : (has_alpha ? 5 : 7);
+  double ratio = static_cast<double>(rx) / ry;
+
+  Image image;
+  image.width = static_cast<int>(round(ratio > 1 ? 32 : 32 * ratio));
+  image.height = static_cast<int>(round(ratio > 1 ? 32 / ratio : 32));
+  image.rgba.resize(image.width * image.height * 4);
+
+  double fx[7];
+  double fy[7];
+  uint8_t* pixel = image.rgba.data();
+  for (int y = 0; y < image.height; ++y) {
+    for (int x = 0; x < image.width; ++x, pixel += 4) {
+      double l = l_dc, p = p_dc, q = q_dc, a = a_dc;
+
+      for (int cx = 0, n = std::max(lx, has_alpha ? 5 : 3); cx < n; ++cx) {
+        fx[cx] = cos(M_PI / image.width * (x + 0.5) * cx);
+      }
+      for (int cy = 0, n = std::max(ly, has_alpha ? 5 : 3); cy < n; ++cy) {
+        fy[cy] = cos(M_PI / image.height * (y + 0.5) * cy);
+      }
+
+      for (int cy = 0, j = 0; cy < ly; ++cy) {
+        double fy2 = fy[cy] * 2;
+        for (int cx = cy ? 0 : 1; cx * ly < lx * (ly - cy); ++cx, ++j) {
+          l += l_ac[j] * fx[cx] * fy2;
+        }
+      }
+
+      for (int cy = 0, j = 0; cy < 3; ++cy) {
+        double fy2 = fy[cy] * 2;
+        for (int cx = cy ? 0 : 1; cx < 3 - cy; ++cx, ++j) {
+          double f = fx[cx] * fy2;
+          p += p_ac[j] * f;
+          q += q_ac[j] * f;
+        }
+      }
+
+      if (has_alpha) {
+        for (int cy = 0, j = 0; cy < 5; ++cy) {
+          double fy2 = fy[cy] * 2;
+          for (int cx = cy ? 0 : 1; cx < 5 - cy; ++cx, ++j) {
+            a += a_ac[j] * fx[cx] * fy2;
+          }
+        }
+      }
+
+      double b = l - 2.0 / 3.0 * p;
+      double r = (3 * l - b + q) / 2;
+      double g = r - q;
+      pixel[0] = ToByte(r);
+      pixel[1] = ToByte(g);
+      pixel[2] = ToByte(b);
+      pixel[3] = ToByte(a);
+    }
+  }
+
+  return image;
+}
+
+// Returns the |kBatchSize| hashes with their AC coefficients randomized.
+static std::vector<std::vector<uint8_t>> GenerateBatch() {
+  std::vector<std::vector<uint8_t>> batch;
+  unsigned state = 1;
+
+  for (int i = 0; i < kBatchSize; ++i) {
+    std::vector<uint8_t> hash = kHashes[i % 2];
+    for (size_t j = i % 2 ? 6 : 5; j < hash.size(); ++j) {
+      state = state * 1103515245 + 12345;
+      hash[j] = static_cast<uint8_t>(state >> 16);
+    }
+    batch.push_back(hash);
+  }
+
+  return batch;
+}
+
+// Returns the milliseconds of the fastest of the |runs| invocations of the
+// |decode|.
+template <typename Decode>
+static double Measure(int runs, const Decode& decode) {
+  double best = INFINITY;
+  for (int i = 0; i < runs; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    decode();
+    best = std::min(best, std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - start)
+                              .count());
+  }
+  return best;
+}
+
+int main(int argc, char** argv) {
+  int runs = argc > 1 ? atoi(argv[1]) : 20;
+
+  std::vector<std::vector<uint8_t>> batch = GenerateBatch();
+  std::vector<uint8_t> hashes;
+  std::vector<int32_t> lengths;
+  for (const std::vector<uint8_t>& hash : batch) {
+    hashes.insert(hashes.end(), hash.begin(), hash.end());
+    lengths.push_back(static_cast<int32_t>(hash.size()));
+  }
+
+  std::vector<uint8_t> rgba(kBatchSize * kThumbHashMaxRgbaSize);
+  std::vector<int32_t> sizes(kBatchSize * 2);
+  auto decode = [&] {
+    return messenger_thumbhash_decode(hashes.data(), lengths.data(),
+                                      kBatchSize, rgba.data(), sizes.data());
+  };
+
+  if (decode() != kBatchSize) {
+    fprintf(stderr, "Batch isn't decoded completely\n");
+    return 1;
+  }
+
+  // Floats are used instead of the doubles of the reference.
+  int max_error = 0;
+  for (int i = 0; i < kBatchSize; ++i) {
+    Image expected = DecodeReference(batch[i]);
+    if (sizes[i * 2] != expected.width || sizes[i * 2 + 1] != expected.height) {
+      fprintf(stderr, "Size of the hash %d is wrong\n", i);
+      return 1;
+    }
+
+    const uint8_t* actual = rgba.data() + i * kThumbHashMaxRgbaSize;
+    for (size_t j = 0; j < expected.rgba.size(); ++j) {
+      max_error = std::max(max_error, abs(actual[j] - expected.rgba[j]));
+    }
+  }
+
+  if (max_error > 1) {
+    fprintf(stderr, "Pixels differ from the reference by %d\n", max_error);
+    return 1;
+  }
+
+  double native = Measure(runs, decode);
+  double reference = Measure(runs, [&batch] {
+    for (const std::vector<uint8_t>& hash : batch) {
+      DecodeReference(hash);
+    }
+  });
+
+  printf("%d hashes, best of %d runs\n", kBatchSize, runs);
+  printf("%-12s %8.2f ms\n", "native", native);
+  printf("%-12s %8.2f ms\n", "reference", reference);
+  return 0;
+}
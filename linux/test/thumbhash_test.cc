@@ -0,0 +1,81 @@
+// Checks ThumbHashToRgba() against the reference decoder and that it rejects
+// the truncated hashes without reading past their end, which is detected by
+// the AddressSanitizer the test is built with.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "thumbhash.h"
+
+#define EXPECT(condition)                                              \
+  do {                                                                 \
+    if (!(condition)) {                                                \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,      \
+              #condition);                                             \
+      exit(1);                                                         \
+    }                                                                  \
+  } while (0)
+
+struct Pixel {
+  int x;
+  int y;
+  uint8_t rgba[4];
+};
+
+struct Case {
+  std::vector<uint8_t> hash;
+  int width;
+  int height;
+
+  // Pixels decoded by the reference `thumbHashToRGBA()`.
+  std::vector<Pixel> pixels;
+};
+
+static const Case kCases[] = {
+    // "1QcSHQRnh493V4dIh4eXh1h4kJUI", without alpha.
+    {{0xd5, 0x07, 0x12, 0x1d, 0x04, 0x67, 0x87, 0x8f, 0x77, 0x57, 0x87,
+      0x48, 0x87, 0x87, 0x97, 0x87, 0x58, 0x78, 0x90, 0x95, 0x08},
+     23,
+     32,
+     {{0, 0, {64, 77, 113, 255}}, {11, 16, {140, 109, 88, 255}}}},
+
+    // "YJqGPQw7sFlslqhFafSE+Q6oJ1h2iHB2Rw", with alpha.
+    {{0x60, 0x9a, 0x86, 0x3d, 0x0c, 0x3b, 0xb0, 0x59, 0x6c, 0x96, 0xa8,
+      0x45, 0x69, 0xf4, 0x84, 0xf9, 0x0e, 0xa8, 0x27, 0x58, 0x76, 0x88,
+      0x70, 0x76, 0x47},
+     32,
+     32,
+     {{0, 0, {228, 75, 51, 0}}, {16, 16, {107, 102, 109, 255}}}},
+};
+
+int main() {
+  std::unique_ptr<ThumbHashImage> image(new ThumbHashImage());
+
+  for (const Case& test : kCases) {
+    EXPECT(ThumbHashToRgba(test.hash.data(), test.hash.size(), image.get()));
+    EXPECT(image->width == test.width && image->height == test.height);
+
+    // Floats are used instead of the doubles of the reference.
+    for (const Pixel& pixel : test.pixels) {
+      const uint8_t* rgba =
+          image->rgba + (pixel.y * image->width + pixel.x) * 4;
+      for (int c = 0; c < 4; ++c) {
+        EXPECT(abs(rgba[c] - pixel.rgba[c]) <= 1);
+      }
+    }
+
+    // Every prefix is copied into a buffer of its exact size, so reading past
+    // it is reported.
+    for (size_t length = 0; length < test.hash.size(); ++length) {
+      std::unique_ptr<uint8_t[]> prefix(new uint8_t[length]);
+      std::copy(test.hash.begin(), test.hash.begin() + length, prefix.get());
+      EXPECT(!ThumbHashToRgba(prefix.get(), length, image.get()));
+    }
+  }
+
+  return 0;
+}
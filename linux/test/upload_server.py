@@ -0,0 +1,93 @@
+"""Stand-in HTTP server of the multipart_upload test.
+
+Accepts the `multipart/form-data` POST requests at `/upload`, reading their
+bodies slowly enough for the test to pause and cancel the uploads in the
+middle, and responds with the SHA-256 digest, the size and the MIME type of
+the file received, along with the names of the other fields and the
+`Authorization` header. Rejects the requests at `/reject` with `413` right
+after their headers. Runs the test passed as the arguments with the URL of the
+server appended, exiting with its status.
+"""
+
+import hashlib
+import http.server
+import json
+import re
+import subprocess
+import sys
+import threading
+import time
+
+CHUNK = 64 * 1024
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def log_message(self, *args):
+        pass
+
+    def handle_expect_100(self):
+        if self.path == '/reject':
+            self.reject()
+            return False
+
+        return super().handle_expect_100()
+
+    def reject(self):
+        self.send_response(413)
+        self.send_header('Content-Length', '0')
+        self.send_header('Connection', 'close')
+        self.end_headers()
+
+    def do_POST(self):
+        if self.path != '/upload':
+            self.reject()
+            return
+
+        body = bytearray()
+        remaining = int(self.headers['Content-Length'])
+        while remaining > 0:
+            chunk = self.rfile.read(min(remaining, CHUNK))
+            if not chunk:
+                return
+
+            body += chunk
+            remaining -= len(chunk)
+            time.sleep(0.01)
+
+        boundary = re.search(r'boundary=(.*)', self.headers['Content-Type'])
+        delimiter = b'--' + boundary.group(1).encode()
+
+        fields = []
+        file = None
+        for part in bytes(body).split(delimiter)[1:-1]:
+            head, _, data = part[2:-2].partition(b'\r\n\r\n')
+            name = re.search(rb'name="([^"]*)"', head).group(1).decode()
+            if name == 'file':
+                mime = re.search(rb'Content-Type: ([^\r]*)', head)
+                file = (data, mime.group(1).decode() if mime else None)
+            else:
+                fields.append(name)
+
+        reply = json.dumps({
+            'sha256': hashlib.sha256(file[0]).hexdigest(),
+            'size': len(file[0]),
+            'type': file[1],
+            'fields': fields,
+            'authorization': self.headers.get('Authorization'),
+        }).encode()
+
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(reply)))
+        self.end_headers()
+        self.wfile.write(reply)
+
+
+server = http.server.ThreadingHTTPServer(('127.0.0.1', 0), Handler)
+server.daemon_threads = True
+threading.Thread(target=server.serve_forever, daemon=True).start()
+
+url = f'http://127.0.0.1:{server.server_address[1]}'
+sys.exit(subprocess.run(sys.argv[1:] + [url]).returncode)
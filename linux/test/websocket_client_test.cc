@@ -0,0 +1,114 @@
+// Checks WebSocketClient against the stand-in server of the
+// `websocket_server.py`, which runs this test with its URL as the argument
+// and checks the frames sent by the client: the handshake negotiating the
+// `permessage-deflate`, the pings of both the WebSocket and the protocol, the
+// burst of the messages delivered in batches, the fragmented message, and
+// the closing handshake initiated by the server.
+//
+// Secured servers pass their certificate as the second argument.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "websocket_client.h"
+
+#define EXPECT(condition)                                              \
+  do {                                                                 \
+    if (!(condition)) {                                                \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,      \
+              #condition);                                             \
+      exit(1);                                                         \
+    }                                                                  \
+  } while (0)
+
+static const char kPong[] = "{\"type\":\"pong\"}";
+
+int main(int argc, char** argv) {
+  EXPECT(argc == 2 || argc == 3);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::string protocol;
+  std::vector<std::string> messages;
+  int batches = 0;
+  int pongs = 0;
+  int code = 0;
+  std::string reason;
+  bool closed = false;
+
+  WebSocketClient::Options options;
+  options.url = argv[1];
+  options.protocols = {"graphql-transport-ws"};
+  options.headers = {"User-Agent: websocket_client_test"};
+  options.ping_interval = 200;
+  if (argc == 3) {
+    options.ca_file = argv[2];
+  }
+
+  WebSocketClient* client = nullptr;
+
+  WebSocketClient::Callbacks callbacks;
+  callbacks.opened = [&](const std::string& negotiated) {
+    protocol = negotiated;
+    client->Send("{\"type\":\"connection_init\"}");
+  };
+  callbacks.received = [&](std::vector<std::string> batch) {
+    ++batches;
+
+    int pongs_in_batch = 0;
+    for (std::string& message : batch) {
+      if (message == kPong) {
+        ++pongs_in_batch;
+      }
+      messages.push_back(std::move(message));
+    }
+
+    // Pongs are delivered at most once per batch.
+    EXPECT(pongs_in_batch <= 1);
+    pongs += pongs_in_batch;
+  };
+  callbacks.closed = [&](int closed_code, const std::string& closed_reason) {
+    std::lock_guard<std::mutex> lock(mutex);
+    code = closed_code;
+    reason = closed_reason;
+    closed = true;
+    condition.notify_all();
+  };
+
+  {
+    WebSocketClient websocket(options, callbacks);
+    client = &websocket;
+    websocket.Start();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT(condition.wait_for(lock, std::chrono::seconds(10),
+                              [&] { return closed; }));
+  }
+
+  EXPECT(protocol == "graphql-transport-ws");
+  EXPECT(code == 4400 && reason == "bye");
+
+  // The acknowledgement, the burst in its order, its pongs, and the
+  // fragmented message.
+  EXPECT(messages.size() == static_cast<size_t>(1 + 1000 + pongs + 1));
+  EXPECT(pongs >= 1 && pongs <= 2);
+  EXPECT(messages.front() == "{\"type\":\"connection_ack\"}");
+  for (int i = 0; i < 1000; ++i) {
+    std::string expected = "{\"id\": \"1\", \"type\": \"next\", "
+                           "\"payload\": {\"data\": {\"n\": " +
+                           std::to_string(i) + "}}}";
+    EXPECT(messages[1 + i] == expected);
+  }
+  EXPECT(messages.back().size() == 100000 + 28);
+
+  // The burst is delivered in batches instead of one by one.
+  EXPECT(batches < 100);
+
+  return 0;
+}
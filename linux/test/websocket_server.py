@@ -0,0 +1,215 @@
+"""Stand-in `graphql-transport-ws` server of the websocket_client test.
+
+Accepts a single connection negotiating `permessage-deflate`, and exchanges
+the frames of the test with it: the compressed ones, the pings of both the
+WebSocket and the protocol, a burst of the messages to be batched, a
+fragmented message interleaved with a ping, and the closing handshake.
+Runs the test passed as the arguments with the URL of the server appended,
+exiting with its status, or with `1`, if the client sent any unexpected
+frames.
+
+With `--tls` as the first argument the connection is secured with a
+certificate generated for the run, offering the `h2` via the ALPN before the
+`http/1.1`, which the client must negotiate. The certificate is appended to
+the arguments of the test after the URL.
+"""
+
+import os
+import base64
+import hashlib
+import json
+import socket
+import struct
+import subprocess
+import ssl
+import sys
+import tempfile
+import threading
+import zlib
+
+GUID = '258EAFA5-E914-47DA-95CA-C5AB0DC85B11'
+PING = b'{"type":"ping"}'
+PONG = b'{"type":"pong"}'
+
+TEXT, CLOSE, PING_FRAME, PONG_FRAME = 1, 8, 9, 10
+
+
+def frame(opcode, payload, fin=True, compressed=False):
+    first = (0x80 if fin else 0) | (0x40 if compressed else 0) | opcode
+    length = len(payload)
+    if length < 126:
+        header = struct.pack('!BB', first, length)
+    elif length < 65536:
+        header = struct.pack('!BBH', first, 126, length)
+    else:
+        header = struct.pack('!BBQ', first, 127, length)
+    return header + payload
+
+
+class Connection:
+    def __init__(self, connection):
+        self.connection = connection
+        self.buffer = b''
+        self.deflater = zlib.compressobj(wbits=-15)
+        self.pings = 0
+
+    def deflate(self, message):
+        data = self.deflater.compress(message)
+        data += self.deflater.flush(zlib.Z_SYNC_FLUSH)
+        return data[:-4]
+
+    def read(self, length):
+        while len(self.buffer) < length:
+            data = self.connection.recv(65536)
+            if not data:
+                raise EOFError('Connection closed by the client')
+            self.buffer += data
+
+        data, self.buffer = self.buffer[:length], self.buffer[length:]
+        return data
+
+    def receive(self, skip_pings=True):
+        """Returns the next frame, skipping the pings of the protocol."""
+        while True:
+            first, second = self.read(2)
+            assert second & 0x80, 'Frames of the client must be masked'
+
+            length = second & 0x7F
+            if length == 126:
+                length = struct.unpack('!H', self.read(2))[0]
+            elif length == 127:
+                length = struct.unpack('!Q', self.read(8))[0]
+
+            key = self.read(4)
+            payload = bytes(
+                b ^ key[i % 4] for i, b in enumerate(self.read(length)))
+
+            opcode = first & 0x0F
+            if opcode == TEXT and payload == PING:
+                self.pings += 1
+                if skip_pings:
+                    continue
+
+            return opcode, payload
+
+    def expect(self, opcode, payload):
+        received = self.receive()
+        assert received == (opcode, payload), \
+            f'Expected {(opcode, payload)}, received {received}'
+
+
+def serve(connection):
+    request = b''
+    while b'\r\n\r\n' not in request:
+        request += connection.recv(4096)
+
+    lines = request.decode().split('\r\n')
+    assert lines[0] == 'GET /graphql HTTP/1.1', lines[0]
+    headers = {
+        name.lower(): value
+        for name, value in (line.split(': ', 1) for line in lines[1:] if line)
+    }
+    assert headers['user-agent'] == 'websocket_client_test'
+    assert 'graphql-transport-ws' in headers['sec-websocket-protocol']
+    assert 'permessage-deflate' in headers['sec-websocket-extensions']
+
+    accept = base64.b64encode(hashlib.sha1(
+        (headers['sec-websocket-key'] + GUID).encode()).digest()).decode()
+
+    client = Connection(connection)
+
+    # The acknowledgement is sent right along with the handshake.
+    connection.sendall(
+        ('HTTP/1.1 101 Switching Protocols\r\n'
+         'Upgrade: websocket\r\n'
+         'Connection: Upgrade\r\n'
+         f'Sec-WebSocket-Accept: {accept}\r\n'
+         'Sec-WebSocket-Protocol: graphql-transport-ws\r\n'
+         'Sec-WebSocket-Extensions: permessage-deflate\r\n\r\n').encode() +
+        frame(TEXT, client.deflate(b'{"type":"connection_ack"}'),
+              compressed=True))
+    client.expect(TEXT, b'{"type":"connection_init"}')
+
+    connection.sendall(frame(TEXT, PING))
+    client.expect(TEXT, PONG)
+
+    connection.sendall(frame(PING_FRAME, b'ping'))
+    client.expect(PONG_FRAME, b'ping')
+
+    burst = b''.join(
+        frame(TEXT,
+              client.deflate(json.dumps({
+                  'id': '1',
+                  'type': 'next',
+                  'payload': {'data': {'n': i}},
+              }).encode()),
+              compressed=True) for i in range(1000))
+    burst += frame(TEXT, PONG) + frame(TEXT, PONG)
+
+    fragmented = b'{"type":"next","payload":"' + b'x' * 100000 + b'"}'
+    burst += frame(TEXT, fragmented[:50000], fin=False)
+    burst += frame(PING_FRAME, b'')
+    burst += frame(0, fragmented[50000:])
+    connection.sendall(burst)
+    client.expect(PONG_FRAME, b'')
+
+    # The pings of the protocol are sent by the client every 200 ms.
+    if client.pings == 0:
+        received = client.receive(skip_pings=False)
+        assert received == (TEXT, PING), f'Expected a ping, received {received}'
+
+    connection.sendall(frame(CLOSE, struct.pack('!H', 4400) + b'bye'))
+    # The status code is echoed without the reason.
+    client.expect(CLOSE, struct.pack('!H', 4400))
+
+
+tls = sys.argv[1:2] == ['--tls']
+command = sys.argv[2:] if tls else sys.argv[1:]
+
+listener = socket.socket()
+listener.bind(('127.0.0.1', 0))
+listener.listen(1)
+
+directory = tempfile.TemporaryDirectory()
+certificate = os.path.join(directory.name, 'certificate.pem')
+if tls:
+    key = os.path.join(directory.name, 'key.pem')
+    subprocess.run(
+        ['openssl', 'req', '-x509', '-newkey', 'rsa:2048', '-nodes',
+         '-keyout', key, '-out', certificate, '-days', '1',
+         '-subj', '/CN=127.0.0.1', '-addext', 'subjectAltName=IP:127.0.0.1'],
+        check=True, capture_output=True)
+
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.load_cert_chain(certificate, key)
+    context.set_alpn_protocols(['h2', 'http/1.1'])
+
+failures = []
+
+
+def accept():
+    connection, _ = listener.accept()
+    try:
+        if tls:
+            connection = context.wrap_socket(connection, server_side=True)
+            protocol = connection.selected_alpn_protocol()
+            assert protocol == 'http/1.1', f'Negotiated {protocol} via ALPN'
+        serve(connection)
+    except Exception as e:
+        failures.append(e)
+        print(f'Server failed: {e!r}', file=sys.stderr)
+    finally:
+        connection.close()
+
+
+thread = threading.Thread(target=accept, daemon=True)
+thread.start()
+
+scheme = 'wss' if tls else 'ws'
+url = f'{scheme}://127.0.0.1:{listener.getsockname()[1]}/graphql'
+status = subprocess.run(
+    command + [url] + ([certificate] if tls else [])).returncode
+thread.join(timeout=5)
+directory.cleanup()
+
+sys.exit(status or (1 if failures or thread.is_alive() else 0))
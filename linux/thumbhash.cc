@@ -0,0 +1,330 @@
+#include "thumbhash.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define THUMBHASH_X86 1
+#endif
+
+// Maximum number of the DCT coefficients along an axis.
+static const int kMaxCoefficients = 8;
+
+// Channels stored in a ThumbHash.
+enum Channel { kL, kP, kQ, kA, kChannelCount };
+
+// AC coefficients of a single channel laid out densely as [cy][cx], with the
+// DC coefficient at [0][0] kept zero.
+struct ChannelCoefficients {
+  int nx;
+  int ny;
+  float dc;
+  float ac[kMaxCoefficients][kMaxCoefficients];
+};
+
+struct Coefficients {
+  bool has_alpha;
+  int width;
+  int height;
+  ChannelCoefficients channels[kChannelCount];
+};
+
+// Reader of the 4-bit AC coefficients following the header.
+class NibbleReader {
+ public:
+  NibbleReader(const uint8_t* data) : data_(data) {}
+
+  float Next() {
+    int nibble = (data_[index_ >> 1] >> ((index_ & 1) << 2)) & 15;
+    ++index_;
+    return nibble / 7.5f - 1;
+  }
+
+ private:
+  const uint8_t* data_;
+  size_t index_ = 0;
+};
+
+// Returns the number of the AC coefficients of a |nx| x |ny| channel.
+static int AcCount(int nx, int ny) {
+  int count = 0;
+  for (int cy = 0; cy < ny; ++cy) {
+    for (int cx = cy ? 0 : 1; cx * ny < nx * (ny - cy); ++cx) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+static void ReadChannel(NibbleReader* reader,
+                        int nx,
+                        int ny,
+                        float dc,
+                        float scale,
+                        ChannelCoefficients* channel) {
+  memset(channel, 0, sizeof(*channel));
+  channel->nx = nx;
+  channel->ny = ny;
+  channel->dc = dc;
+
+  for (int cy = 0; cy < ny; ++cy) {
+    for (int cx = cy ? 0 : 1; cx * ny < nx * (ny - cy); ++cx) {
+      channel->ac[cy][cx] = reader->Next() * scale;
+    }
+  }
+}
+
+static bool ParseHash(const uint8_t* hash,
+                      size_t length,
+                      Coefficients* coefficients) {
+  if (length < 5) {
+    return false;
+  }
+
+  // Hashes with alpha have the 6th byte of its DC and scale in the header.
+  uint32_t header24 = hash[0] | (hash[1] << 8) | (hash[2] << 16);
+  bool has_alpha = (header24 >> 23) != 0;
+  if (has_alpha && length < 6) {
+    return false;
+  }
+
+  uint32_t header16 = hash[3] | (hash[4] << 8);
+  bool is_landscape = (header16 >> 15) != 0;
+
+  int lx = std::max(3, is_landscape ? (has_alpha ? 5 : 7)
+                                    : static_cast<int>(header16 & 7));
+  int ly = std::max(3, is_landscape ? static_cast<int>(header16 & 7)
+                                    : (has_alpha ? 5 : 7));
+
+  size_t ac_start = has_alpha ? 6 : 5;
+  int ac_count = AcCount(lx, ly) + AcCount(3, 3) * 2 +
+                 (has_alpha ? AcCount(5, 5) : 0);
+  if (length < ac_start + (ac_count + 1) / 2) {
+    return false;
+  }
+
+  // Approximate aspect ratio uses the raw sizes, as the reference does.
+  int ratio_x = is_landscape ? (has_alpha ? 5 : 7) : (hash[3] & 7);
+  int ratio_y = is_landscape ? (hash[3] & 7) : (has_alpha ? 5 : 7);
+  if (ratio_x == 0 || ratio_y == 0) {
+    return false;
+  }
+
+  float ratio = static_cast<float>(ratio_x) / ratio_y;
+  coefficients->width = static_cast<int>(
+      floorf((ratio > 1 ? kThumbHashMaxSize : kThumbHashMaxSize * ratio) +
+             0.5f));
+  coefficients->height = static_cast<int>(
+      floorf((ratio > 1 ? kThumbHashMaxSize / ratio : kThumbHashMaxSize) +
+             0.5f));
+  coefficients->has_alpha = has_alpha;
+
+  float l_dc = (header24 & 63) / 63.0f;
+  float p_dc = ((header24 >> 6) & 63) / 31.5f - 1;
+  float q_dc = ((header24 >> 12) & 63) / 31.5f - 1;
+  float l_scale = ((header24 >> 18) & 31) / 31.0f;
+  float p_scale = ((header16 >> 3) & 63) / 63.0f;
+  float q_scale = ((header16 >> 9) & 63) / 63.0f;
+  float a_dc = has_alpha ? (hash[5] & 15) / 15.0f : 1;
+  float a_scale = has_alpha ? (hash[5] >> 4) / 15.0f : 1;
+
+  // Saturation is boosted by 1.25x to compensate for the quantization.
+  NibbleReader reader(hash + ac_start);
+  ReadChannel(&reader, lx, ly, l_dc, l_scale, &coefficients->channels[kL]);
+  ReadChannel(&reader, 3, 3, p_dc, p_scale * 1.25f,
+              &coefficients->channels[kP]);
+  ReadChannel(&reader, 3, 3, q_dc, q_scale * 1.25f,
+              &coefficients->channels[kQ]);
+  if (has_alpha) {
+    ReadChannel(&reader, 5, 5, a_dc, a_scale, &coefficients->channels[kA]);
+  } else {
+    ReadChannel(&reader, 0, 0, a_dc, 0, &coefficients->channels[kA]);
+  }
+
+  return true;
+}
+
+// Converts the |value| clamped to [0, 1] into [0, 255], truncating it.
+//
+// Clamped after the conversion, as integer selects are compiled into the
+// branchless vector code, while the float ones aren't due to trapping math.
+static inline uint32_t ToByte(float value) {
+  int32_t scaled = static_cast<int32_t>(255 * value);
+  scaled = scaled > 0 ? scaled : 0;
+  return scaled < 255 ? scaled : 255;
+}
+
+// Reconstructs the image from the |coefficients| with the cosine tables of
+// the |fx| columns and |fy| rows.
+//
+// Each row first collapses the vertical frequencies of every channel into
+// per-column weights, and then sums them over the |fx| table for the whole
+// row at once, which the loops over the padded row are vectorized on.
+__attribute__((always_inline)) static inline void Reconstruct(
+    const Coefficients& coefficients,
+    const float (&fx)[kMaxCoefficients][kThumbHashMaxSize],
+    const float (&fy)[kThumbHashMaxSize][kMaxCoefficients],
+    uint8_t* rgba) {
+  int channel_count = coefficients.has_alpha ? kChannelCount : kA;
+
+  for (int y = 0; y < coefficients.height; ++y) {
+    alignas(32) float values[kChannelCount][kThumbHashMaxSize];
+
+    for (int c = 0; c < channel_count; ++c) {
+      const ChannelCoefficients& channel = coefficients.channels[c];
+
+      float weights[kMaxCoefficients] = {};
+      for (int cy = 0; cy < channel.ny; ++cy) {
+        float fy2 = fy[y][cy] * 2;
+        for (int cx = 0; cx < channel.nx; ++cx) {
+          weights[cx] += channel.ac[cy][cx] * fy2;
+        }
+      }
+
+      float* row = values[c];
+      for (int x = 0; x < kThumbHashMaxSize; ++x) {
+        row[x] = channel.dc;
+      }
+      for (int cx = 0; cx < channel.nx; ++cx) {
+        float weight = weights[cx];
+        const float* column = fx[cx];
+        for (int x = 0; x < kThumbHashMaxSize; ++x) {
+          row[x] += weight * column[x];
+        }
+      }
+    }
+
+    if (!coefficients.has_alpha) {
+      for (int x = 0; x < kThumbHashMaxSize; ++x) {
+        values[kA][x] = 1;
+      }
+    }
+
+    // Pixels are packed into words to keep the conversion vectorized, as
+    // storing the interleaved bytes one by one isn't.
+    alignas(32) uint32_t pixels[kThumbHashMaxSize];
+    for (int x = 0; x < kThumbHashMaxSize; ++x) {
+      float l = values[kL][x];
+      float p = values[kP][x];
+      float q = values[kQ][x];
+      float b = l - 2.0f / 3.0f * p;
+      float r = (3 * l - b + q) / 2;
+      float g = r - q;
+      pixels[x] = ToByte(r) | ToByte(g) << 8 | ToByte(b) << 16 |
+                  ToByte(values[kA][x]) << 24;
+    }
+
+    // Words hold the RGBA bytes in little-endian order.
+    memcpy(rgba + y * coefficients.width * 4, pixels,
+           coefficients.width * 4);
+  }
+}
+
+static void ReconstructDefault(
+    const Coefficients& coefficients,
+    const float (&fx)[kMaxCoefficients][kThumbHashMaxSize],
+    const float (&fy)[kThumbHashMaxSize][kMaxCoefficients],
+    uint8_t* rgba) {
+  Reconstruct(coefficients, fx, fy, rgba);
+}
+
+#ifdef THUMBHASH_X86
+__attribute__((target("avx2,fma"))) static void ReconstructAvx2(
+    const Coefficients& coefficients,
+    const float (&fx)[kMaxCoefficients][kThumbHashMaxSize],
+    const float (&fy)[kThumbHashMaxSize][kMaxCoefficients],
+    uint8_t* rgba) {
+  Reconstruct(coefficients, fx, fy, rgba);
+}
+
+static bool CpuSupportsAvx2Fma() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+#endif  // THUMBHASH_X86
+
+// Cosine tables `cos(PI / size * (i + 0.5) * c)` for each of the possible
+// image sizes, |kMaxCoefficients| frequencies and padded pixels, shared by
+// all the decodes.
+struct CosineTables {
+  CosineTables() {
+    for (int size = 1; size <= kThumbHashMaxSize; ++size) {
+      for (int c = 0; c < kMaxCoefficients; ++c) {
+        for (int i = 0; i < kThumbHashMaxSize; ++i) {
+          float value = i < size ? cosf(static_cast<float>(M_PI) / size *
+                                        (i + 0.5f) * c)
+                                 : 0;
+          columns[size][c][i] = value;
+          rows[size][i][c] = value;
+        }
+      }
+    }
+  }
+
+  float columns[kThumbHashMaxSize + 1][kMaxCoefficients][kThumbHashMaxSize];
+  float rows[kThumbHashMaxSize + 1][kThumbHashMaxSize][kMaxCoefficients];
+};
+
+static const CosineTables& GetCosineTables() {
+  static const CosineTables* tables = new CosineTables();
+  return *tables;
+}
+
+// Decodes the |hash| into the |rgba| buffer of kThumbHashMaxRgbaSize bytes.
+static bool Decode(const uint8_t* hash,
+                   size_t length,
+                   int* width,
+                   int* height,
+                   uint8_t* rgba) {
+  Coefficients coefficients;
+  if (hash == nullptr || !ParseHash(hash, length, &coefficients)) {
+    *width = 0;
+    *height = 0;
+    return false;
+  }
+
+  const CosineTables& tables = GetCosineTables();
+  const auto& fx = tables.columns[coefficients.width];
+  const auto& fy = tables.rows[coefficients.height];
+
+#ifdef THUMBHASH_X86
+  static const bool avx2 = CpuSupportsAvx2Fma();
+  if (avx2) {
+    ReconstructAvx2(coefficients, fx, fy, rgba);
+  } else {
+    ReconstructDefault(coefficients, fx, fy, rgba);
+  }
+#else
+  ReconstructDefault(coefficients, fx, fy, rgba);
+#endif
+
+  *width = coefficients.width;
+  *height = coefficients.height;
+  return true;
+}
+
+bool ThumbHashToRgba(const uint8_t* hash,
+                     size_t length,
+                     ThumbHashImage* image) {
+  return Decode(hash, length, &image->width, &image->height, image->rgba);
+}
+
+int32_t messenger_thumbhash_decode(const uint8_t* hashes,
+                                   const int32_t* lengths,
+                                   int32_t count,
+                                   uint8_t* rgba,
+                                   int32_t* sizes) {
+  int32_t decoded = 0;
+  for (int32_t i = 0; i < count; ++i) {
+    size_t length = std::max(0, lengths[i]);
+    if (Decode(hashes, length, &sizes[i * 2], &sizes[i * 2 + 1],
+               rgba + i * kThumbHashMaxRgbaSize)) {
+      ++decoded;
+    }
+    hashes += length;
+  }
+
+  return decoded;
+}
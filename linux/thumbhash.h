@@ -0,0 +1,53 @@
+#ifndef RUNNER_THUMBHASH_H_
+#define RUNNER_THUMBHASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "runner_export.h"
+
+// Maximum width and height of a decoded ThumbHash.
+static const int kThumbHashMaxSize = 32;
+
+// Size of the RGBA buffer fitting any decoded ThumbHash.
+static const size_t kThumbHashMaxRgbaSize =
+    kThumbHashMaxSize * kThumbHashMaxSize * 4;
+
+// ThumbHash decoded into straight (non-premultiplied) RGBA pixels.
+struct ThumbHashImage {
+  int width;
+  int height;
+  uint8_t rgba[kThumbHashMaxRgbaSize];
+};
+
+// Decodes the |length| bytes of the |hash| into the |image|, matching the
+// reference `thumbHashToRGBA()` implementation. Returns false if the |hash| is
+// malformed.
+//
+// The inverse DCT is separated into the rows and columns passes vectorized
+// over the pixels of a row, using AVX2 and FMA when supported by the CPU.
+bool ThumbHashToRgba(const uint8_t* hash, size_t length, ThumbHashImage* image);
+
+/**
+ * messenger_thumbhash_decode:
+ * @hashes: concatenated ThumbHashes to decode.
+ * @lengths: lengths of each of the @count ThumbHashes in @hashes.
+ * @count: number of the ThumbHashes to decode.
+ * @rgba: (out): buffer of `@count * kThumbHashMaxRgbaSize` bytes, the i-th
+ *     ThumbHash is decoded into the `i * kThumbHashMaxRgbaSize` offset of.
+ * @sizes: (out): buffer of `@count * 2` integers to write the width and
+ *     height of each decoded ThumbHash to, or zeros if it's malformed.
+ *
+ * Decodes a batch of ThumbHashes into RGBA pixels in a single call into the
+ * @rgba buffer allocated by the caller, so Dart FFI may view the pixels of
+ * each ThumbHash in it without copying them.
+ *
+ * Returns: number of the successfully decoded ThumbHashes.
+ */
+RUNNER_EXPORT int32_t messenger_thumbhash_decode(const uint8_t* hashes,
+                                                 const int32_t* lengths,
+                                                 int32_t count,
+                                                 uint8_t* rgba,
+                                                 int32_t* sizes);
+
+#endif  // RUNNER_THUMBHASH_H_
@@ -0,0 +1,97 @@
+#include "update_service.h"
+
+#include <string.h>
+
+#include <string>
+
+#include "async_response.h"
+#include "delta_patch.h"
+#include "worker_pool.h"
+
+// Returns the error code of the failed DeltaPatchResult.
+static const gchar* delta_patch_error_code(DeltaPatchResult result) {
+  switch (result) {
+    case DeltaPatchResult::kCorrupted:
+      return "PATCH_ERROR";
+    case DeltaPatchResult::kSourceMismatch:
+      return "SOURCE_MISMATCH";
+    case DeltaPatchResult::kVerificationFailed:
+      return "CHECKSUM_ERROR";
+    case DeltaPatchResult::kFileError:
+    case DeltaPatchResult::kApplied:
+      break;
+  }
+  return "FILE_ERROR";
+}
+
+static FlMethodResponse* apply_delta_patch(FlMethodCall* method_call,
+                                           FlValue* args) {
+  FlValue* source = nullptr;
+  FlValue* patch = nullptr;
+  FlValue* target = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    source = fl_value_lookup_string(args, "source");
+    patch = fl_value_lookup_string(args, "patch");
+    target = fl_value_lookup_string(args, "target");
+  }
+
+  if (source == nullptr || fl_value_get_type(source) != FL_VALUE_TYPE_STRING ||
+      patch == nullptr || fl_value_get_type(patch) != FL_VALUE_TYPE_STRING ||
+      target == nullptr || fl_value_get_type(target) != FL_VALUE_TYPE_STRING) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`source`, `patch` and `target` must be provided",
+        nullptr));
+  }
+
+  DeltaPatchOptions options;
+  options.source = fl_value_get_string(source);
+  options.patch = fl_value_get_string(patch);
+  options.target = fl_value_get_string(target);
+
+  FlValue* sha256 = fl_value_lookup_string(args, "sha256");
+  if (sha256 != nullptr && fl_value_get_type(sha256) == FL_VALUE_TYPE_STRING) {
+    options.sha256 = fl_value_get_string(sha256);
+  }
+
+  FlMethodCall* held = FL_METHOD_CALL(g_object_ref(method_call));
+  WorkerPool::Shared()->Post([held, options] {
+    std::string digest;
+    std::string error;
+    DeltaPatchResult result = ApplyDeltaPatch(options, &digest, &error);
+
+    FlMethodResponse* response;
+    if (result == DeltaPatchResult::kApplied) {
+      g_autoptr(FlValue) value = fl_value_new_string(digest.c_str());
+      response = FL_METHOD_RESPONSE(fl_method_success_response_new(value));
+    } else {
+      response = FL_METHOD_RESPONSE(fl_method_error_response_new(
+          delta_patch_error_code(result), error.c_str(), nullptr));
+    }
+
+    method_call_respond_async(held, response);
+  });
+
+  return nullptr;
+}
+
+gboolean update_service_handle_method_call(FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "applyDeltaPatch") == 0) {
+    response = apply_delta_patch(method_call, args);
+  } else {
+    return FALSE;
+  }
+
+  // Errors are responded to synchronously.
+  if (response != nullptr) {
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(method_call, response, &error)) {
+      g_warning("Failed to send response: %s", error->message);
+    }
+  }
+
+  return TRUE;
+}
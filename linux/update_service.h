@@ -0,0 +1,18 @@
+#ifndef RUNNER_UPDATE_SERVICE_H_
+#define RUNNER_UPDATE_SERVICE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * update_service_handle_method_call:
+ * @method_call: #FlMethodCall received on the utils channel.
+ *
+ * Handles the `applyDeltaPatch` method, reconstructing the new release
+ * artifact from the installed bundle and a delta patch on the #WorkerPool,
+ * and responding asynchronously with its verified SHA-256 digest.
+ *
+ * Returns: %TRUE if the @method_call was handled by this service.
+ */
+gboolean update_service_handle_method_call(FlMethodCall* method_call);
+
+#endif  // RUNNER_UPDATE_SERVICE_H_
@@ -0,0 +1,320 @@
+#include "upload_service.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "multipart_upload.h"
+
+// Upload started by the `upload` method.
+struct RunningUpload {
+  std::shared_ptr<MultipartUpload> upload;
+  std::thread thread;
+};
+
+// Progress of an upload to report on the main thread.
+struct UploadProgress {
+  int64_t id;
+  int64_t sent;
+  int64_t total;
+};
+
+// Result of an upload to respond with on the main thread.
+struct FinishedUpload {
+  int64_t id;
+  FlMethodCall* method_call;
+  FlMethodResponse* response;
+};
+
+static FlEventChannel* progress_channel = nullptr;
+static bool progress_listened = false;
+
+// Uploads by their IDs, accessed on the main thread only.
+static std::map<int64_t, RunningUpload> uploads;
+
+static FlMethodErrorResponse* on_progress_listen(FlEventChannel* channel,
+                                                 FlValue* args,
+                                                 gpointer user_data) {
+  progress_listened = true;
+  return nullptr;
+}
+
+static FlMethodErrorResponse* on_progress_cancel(FlEventChannel* channel,
+                                                 FlValue* args,
+                                                 gpointer user_data) {
+  progress_listened = false;
+  return nullptr;
+}
+
+static gboolean send_progress(gpointer user_data) {
+  std::unique_ptr<UploadProgress> progress(
+      static_cast<UploadProgress*>(user_data));
+  if (progress_channel == nullptr || !progress_listened) {
+    return G_SOURCE_REMOVE;
+  }
+
+  g_autoptr(FlValue) event = fl_value_new_map();
+  fl_value_set_string_take(event, "id", fl_value_new_int(progress->id));
+  fl_value_set_string_take(event, "sent", fl_value_new_int(progress->sent));
+  fl_value_set_string_take(event, "total", fl_value_new_int(progress->total));
+  fl_event_channel_send(progress_channel, event, nullptr, nullptr);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean finish_upload(gpointer user_data) {
+  std::unique_ptr<FinishedUpload> finished(
+      static_cast<FinishedUpload*>(user_data));
+
+  // Uploads left after upload_service_dispose() aren't responded to, as the
+  // engine is gone.
+  auto it = uploads.find(finished->id);
+  if (it != uploads.end()) {
+    it->second.thread.join();
+    uploads.erase(it);
+
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(finished->method_call, finished->response,
+                                &error)) {
+      g_warning("Failed to send response: %s", error->message);
+    }
+  }
+
+  g_object_unref(finished->method_call);
+  g_object_unref(finished->response);
+  return G_SOURCE_REMOVE;
+}
+
+static FlMethodResponse* result_to_response(const MultipartUpload& upload,
+                                            UploadResult result) {
+  const gchar* code;
+  switch (result) {
+    case UploadResult::kCompleted: {
+      g_autoptr(FlValue) value = fl_value_new_map();
+      fl_value_set_string_take(value, "status",
+                               fl_value_new_int(upload.status()));
+      fl_value_set_string_take(
+          value, "response",
+          fl_value_new_uint8_list(
+              reinterpret_cast<const uint8_t*>(upload.response().data()),
+              upload.response().size()));
+      fl_value_set_string_take(value, "sha256",
+                               fl_value_new_string(upload.sha256().c_str()));
+      fl_value_set_string_take(value, "mime",
+                               fl_value_new_string(upload.mime().c_str()));
+      fl_value_set_string_take(value, "size", fl_value_new_int(upload.size()));
+      return FL_METHOD_RESPONSE(fl_method_success_response_new(value));
+    }
+
+    case UploadResult::kCancelled:
+      code = "CANCELLED";
+      break;
+
+    case UploadResult::kHttpError: {
+      // Body of the response may describe the error, e.g. as GraphQL errors.
+      g_autoptr(FlValue) details = fl_value_new_map();
+      fl_value_set_string_take(details, "status",
+                               fl_value_new_int(upload.status()));
+      fl_value_set_string_take(
+          details, "response",
+          fl_value_new_uint8_list(
+              reinterpret_cast<const uint8_t*>(upload.response().data()),
+              upload.response().size()));
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          "HTTP_ERROR", upload.error().c_str(), details));
+    }
+
+    case UploadResult::kNetworkError:
+      code = "NETWORK_ERROR";
+      break;
+
+    case UploadResult::kFileError:
+    default:
+      code = "FILE_ERROR";
+      break;
+  }
+
+  return FL_METHOD_RESPONSE(
+      fl_method_error_response_new(code, upload.error().c_str(), nullptr));
+}
+
+// Returns the string entries of the |map| in their order, or none, if it
+// isn't a map.
+static std::vector<std::pair<std::string, std::string>> string_entries(
+    FlValue* map) {
+  std::vector<std::pair<std::string, std::string>> entries;
+  if (map == nullptr || fl_value_get_type(map) != FL_VALUE_TYPE_MAP) {
+    return entries;
+  }
+
+  for (size_t i = 0; i < fl_value_get_length(map); ++i) {
+    FlValue* name = fl_value_get_map_key(map, i);
+    FlValue* value = fl_value_get_map_value(map, i);
+    if (fl_value_get_type(name) == FL_VALUE_TYPE_STRING &&
+        fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+      entries.emplace_back(fl_value_get_string(name),
+                           fl_value_get_string(value));
+    }
+  }
+
+  return entries;
+}
+
+// Returns the string value of the |key| in the |args|, or the |fallback|.
+static std::string lookup_string(FlValue* args,
+                                 const char* key,
+                                 const char* fallback) {
+  FlValue* value = fl_value_lookup_string(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+    return fallback;
+  }
+
+  return fl_value_get_string(value);
+}
+
+static FlMethodResponse* start_upload(FlMethodCall* method_call,
+                                      FlValue* args) {
+  FlValue* id = nullptr;
+  FlValue* url = nullptr;
+  FlValue* path = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    id = fl_value_lookup_string(args, "id");
+    url = fl_value_lookup_string(args, "url");
+    path = fl_value_lookup_string(args, "path");
+  }
+
+  if (id == nullptr || fl_value_get_type(id) != FL_VALUE_TYPE_INT ||
+      url == nullptr || fl_value_get_type(url) != FL_VALUE_TYPE_STRING ||
+      path == nullptr || fl_value_get_type(path) != FL_VALUE_TYPE_STRING) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`id`, `url` and `path` must be provided", nullptr));
+  }
+
+  int64_t upload_id = fl_value_get_int(id);
+  if (uploads.count(upload_id) != 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "STATE_ERROR", "Upload with this `id` is already running", nullptr));
+  }
+
+  MultipartUpload::Options options;
+  options.url = fl_value_get_string(url);
+  options.path = fl_value_get_string(path);
+  options.field = lookup_string(args, "field", "file");
+  options.filename = lookup_string(args, "filename", "");
+  options.content_type = lookup_string(args, "contentType", "");
+
+  // Fields are sent in their order, as the GraphQL multipart request
+  // requires the `operations` and the `map` to precede the files.
+  options.fields = string_entries(fl_value_lookup_string(args, "fields"));
+  for (const auto& header :
+       string_entries(fl_value_lookup_string(args, "headers"))) {
+    options.headers.push_back(header.first + ": " + header.second);
+  }
+
+  std::shared_ptr<MultipartUpload> upload =
+      std::make_shared<MultipartUpload>(std::move(options));
+  FlValue* paused = fl_value_lookup_string(args, "paused");
+  if (paused != nullptr && fl_value_get_type(paused) == FL_VALUE_TYPE_BOOL &&
+      fl_value_get_bool(paused)) {
+    upload->Pause();
+  }
+
+  FlMethodCall* held = FL_METHOD_CALL(g_object_ref(method_call));
+
+  RunningUpload& running = uploads[upload_id];
+  running.upload = upload;
+  running.thread = std::thread([upload, upload_id, held] {
+    pthread_setname_np(pthread_self(), "upload");
+    UploadResult result = upload->Run([upload_id](int64_t sent,
+                                                  int64_t total) {
+      g_main_context_invoke(nullptr, send_progress,
+                            new UploadProgress{upload_id, sent, total});
+    });
+
+    g_main_context_invoke(
+        nullptr, finish_upload,
+        new FinishedUpload{upload_id, held,
+                           result_to_response(*upload, result)});
+  });
+
+  return nullptr;
+}
+
+// Invokes the |action| on the upload with the `id` in the |args|, if it's
+// running.
+static FlMethodResponse* control_upload(FlValue* args,
+                                        void (MultipartUpload::*action)()) {
+  FlValue* id = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    id = fl_value_lookup_string(args, "id");
+  }
+
+  if (id == nullptr || fl_value_get_type(id) != FL_VALUE_TYPE_INT) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`id` must be an integer", nullptr));
+  }
+
+  auto it = uploads.find(fl_value_get_int(id));
+  if (it != uploads.end()) {
+    (it->second.upload.get()->*action)();
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+void upload_service_init(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  progress_channel = fl_event_channel_new(
+      messenger, "team113.flutter.dev/linux_utils/uploads",
+      FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(progress_channel, on_progress_listen,
+                                       on_progress_cancel, nullptr, nullptr);
+}
+
+gboolean upload_service_handle_method_call(FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "upload") == 0) {
+    response = start_upload(method_call, args);
+  } else if (strcmp(method, "pauseUpload") == 0) {
+    response = control_upload(args, &MultipartUpload::Pause);
+  } else if (strcmp(method, "resumeUpload") == 0) {
+    response = control_upload(args, &MultipartUpload::Resume);
+  } else if (strcmp(method, "cancelUpload") == 0) {
+    response = control_upload(args, &MultipartUpload::Cancel);
+  } else {
+    return FALSE;
+  }
+
+  // Errors and synchronous results are responded to right away.
+  if (response != nullptr) {
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(method_call, response, &error)) {
+      g_warning("Failed to send response: %s", error->message);
+    }
+  }
+
+  return TRUE;
+}
+
+void upload_service_dispose() {
+  for (auto& entry : uploads) {
+    entry.second.upload->Cancel();
+  }
+
+  for (auto& entry : uploads) {
+    entry.second.thread.join();
+  }
+  uploads.clear();
+
+  g_clear_object(&progress_channel);
+  progress_listened = false;
+}
@@ -0,0 +1,36 @@
+#ifndef RUNNER_UPLOAD_SERVICE_H_
+#define RUNNER_UPLOAD_SERVICE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * upload_service_init:
+ * @messenger: #FlBinaryMessenger to create the progress event channel on.
+ *
+ * Creates the `team113.flutter.dev/linux_utils/uploads` event channel
+ * reporting the `{id, sent, total}` progress of the running uploads.
+ */
+void upload_service_init(FlBinaryMessenger* messenger);
+
+/**
+ * upload_service_handle_method_call:
+ * @method_call: #FlMethodCall received on the utils channel.
+ *
+ * Handles the `upload` method, streaming the file as a `multipart/form-data`
+ * request with a #MultipartUpload on its own thread, and responding with its
+ * `{status, response, sha256, mime, size}` once the server responds, and the
+ * `pauseUpload`, `resumeUpload` and `cancelUpload` methods controlling it.
+ *
+ * Returns: %TRUE if the @method_call was handled by this service.
+ */
+gboolean upload_service_handle_method_call(FlMethodCall* method_call);
+
+/**
+ * upload_service_dispose:
+ *
+ * Cancels the running uploads, waiting for their threads to finish, and
+ * closes the progress event channel.
+ */
+void upload_service_dispose();
+
+#endif  // RUNNER_UPLOAD_SERVICE_H_
@@ -0,0 +1,659 @@
+#include "websocket_client.h"
+
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/eventfd.h>
+#include <sys/random.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+// Time to connect and complete the handshake within, in milliseconds.
+static const int64_t kConnectTimeout = 10000;
+
+// Time to wait for the server to close the connection after closing it, in
+// milliseconds.
+static const int64_t kCloseTimeout = 1000;
+
+// Maximum size of the handshake response of the server.
+static const size_t kMaxResponseSize = 16 * 1024;
+
+// Size of the chunks the data is received in.
+static const size_t kReceiveChunkSize = 64 * 1024;
+
+// Messages longer than this aren't pings or pongs of the protocol, so they
+// aren't scanned for their type.
+static const size_t kMaxKeepAliveSize = 1024;
+
+static const char kPingMessage[] = "{\"type\":\"ping\"}";
+static const char kPongMessage[] = "{\"type\":\"pong\"}";
+
+static int64_t NowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void EnsureCurlInitialized() {
+  static std::once_flag once;
+  std::call_once(once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+// Fills the |size| bytes of the |data| with the random ones, as the masking
+// keys must be unpredictable.
+static void FillRandom(uint8_t* data, size_t size) {
+  while (size > 0) {
+    ssize_t filled = getrandom(data, size, 0);
+    if (filled <= 0) {
+      continue;
+    }
+
+    data += filled;
+    size -= filled;
+  }
+}
+
+// Returns the value of the |line| header if it's named |name|, or nullptr.
+static const char* HeaderValue(const std::string& line, const char* name) {
+  size_t length = strlen(name);
+  if (line.size() <= length || line[length] != ':' ||
+      strncasecmp(line.c_str(), name, length) != 0) {
+    return nullptr;
+  }
+
+  const char* value = line.c_str() + length + 1;
+  while (*value == ' ' || *value == '\t') {
+    ++value;
+  }
+
+  return value;
+}
+
+// Returns the end of the JSON string starting at the |start| quote of the
+// |json|, or std::string::npos, if it's not terminated.
+static size_t StringEnd(const std::string& json, size_t start) {
+  for (size_t i = start + 1; i < json.size(); ++i) {
+    if (json[i] == '\\') {
+      ++i;
+    } else if (json[i] == '"') {
+      return i;
+    }
+  }
+
+  return std::string::npos;
+}
+
+// Returns the top-level `type` of the short |message| of the protocol, or an
+// empty string, if it's long or has none.
+static std::string MessageType(const std::string& message) {
+  if (message.size() > kMaxKeepAliveSize) {
+    return std::string();
+  }
+
+  int depth = 0;
+  size_t i = 0;
+  while (i < message.size()) {
+    char c = message[i];
+    if (c == '"') {
+      size_t end = StringEnd(message, i);
+      if (end == std::string::npos) {
+        break;
+      }
+
+      bool type =
+          depth == 1 && message.compare(i + 1, end - i - 1, "type") == 0;
+      i = message.find_first_not_of(" \t\r\n", end + 1);
+      if (type && i != std::string::npos && message[i] == ':') {
+        size_t start = message.find_first_not_of(" \t\r\n", i + 1);
+        if (start == std::string::npos || message[start] != '"') {
+          break;
+        }
+
+        end = StringEnd(message, start);
+        if (end == std::string::npos) {
+          break;
+        }
+
+        return message.substr(start + 1, end - start - 1);
+      }
+
+      continue;
+    }
+
+    if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      --depth;
+    }
+    ++i;
+  }
+
+  return std::string();
+}
+
+WebSocketClient::WebSocketClient(Options options, Callbacks callbacks)
+    : options_(std::move(options)),
+      callbacks_(std::move(callbacks)),
+      parser_(options_.max_message_size) {
+  wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+WebSocketClient::~WebSocketClient() {
+  if (thread_.joinable()) {
+    Close(1001, std::string());
+    thread_.join();
+  }
+
+  if (wake_fd_ >= 0) {
+    close(wake_fd_);
+  }
+}
+
+void WebSocketClient::Start() {
+  thread_ = std::thread(&WebSocketClient::Run, this);
+}
+
+void WebSocketClient::Send(std::string message) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(std::move(message));
+  }
+
+  Wake();
+}
+
+void WebSocketClient::Close(int code, std::string reason) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!closing_) {
+      closing_ = true;
+      requested_closure_.code = code;
+      requested_closure_.reason = std::move(reason);
+    }
+  }
+
+  cancelled_ = true;
+  Wake();
+}
+
+void WebSocketClient::Run() {
+  pthread_setname_np(pthread_self(), "websocket");
+
+  Closure closure;
+  if (Connect(&closure)) {
+    Loop(&closure);
+  } else if (cancelled_) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closure = requested_closure_;
+  }
+  Deliver();
+
+  if (curl_ != nullptr) {
+    curl_easy_cleanup(curl_);
+    curl_ = nullptr;
+  }
+
+  callbacks_.closed(closure.code, closure.reason);
+}
+
+bool WebSocketClient::WaitFor(short events, int64_t deadline) {
+  while (!cancelled_) {
+    int64_t timeout = deadline - NowMs();
+    if (timeout <= 0) {
+      return false;
+    }
+
+    struct pollfd fds[2] = {{socket_, events, 0}, {wake_fd_, POLLIN, 0}};
+    if (poll(fds, 2, static_cast<int>(timeout)) > 0 && fds[0].revents != 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool WebSocketClient::Connect(Closure* closure) {
+  EnsureCurlInitialized();
+
+  // Only the connection is established by libcurl, so the URL is the HTTP
+  // one of the same host, while the request target is sent in the handshake.
+  size_t scheme_end = options_.url.find("://");
+  std::string scheme = options_.url.substr(0, scheme_end);
+  if (scheme_end == std::string::npos ||
+      (scheme != "ws" && scheme != "wss")) {
+    closure->reason = "Unsupported URL: " + options_.url;
+    return false;
+  }
+
+  size_t authority_start = scheme_end + 3;
+  size_t authority_end =
+      options_.url.find_first_of("/?#", authority_start);
+  std::string authority =
+      options_.url.substr(authority_start, authority_end - authority_start);
+  std::string target = authority_end == std::string::npos
+                           ? "/"
+                           : options_.url.substr(authority_end);
+  target = target.substr(0, target.find('#'));
+  if (target.empty() || target[0] != '/') {
+    target = "/" + target;
+  }
+
+  int64_t deadline = NowMs() + kConnectTimeout;
+
+  curl_ = curl_easy_init();
+  std::string http_url =
+      (scheme == "wss" ? "https://" : "http://") + authority + "/";
+  curl_easy_setopt(curl_, CURLOPT_URL, http_url.c_str());
+  curl_easy_setopt(curl_, CURLOPT_CONNECT_ONLY, 1L);
+
+  // Handshake is sent over HTTP/1.1 by hand, so the ALPN mustn't negotiate
+  // the HTTP/2 with the servers supporting it.
+  curl_easy_setopt(curl_, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+  if (!options_.ca_file.empty()) {
+    curl_easy_setopt(curl_, CURLOPT_CAINFO, options_.ca_file.c_str());
+  }
+  curl_easy_setopt(curl_, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, kConnectTimeout);
+  curl_easy_setopt(curl_, CURLOPT_NOPROGRESS, 0L);
+  curl_easy_setopt(curl_, CURLOPT_XFERINFOFUNCTION, OnProgress);
+  curl_easy_setopt(curl_, CURLOPT_XFERINFODATA, this);
+
+  CURLcode code = curl_easy_perform(curl_);
+  curl_socket_t socket = CURL_SOCKET_BAD;
+  if (code == CURLE_OK) {
+    code = curl_easy_getinfo(curl_, CURLINFO_ACTIVESOCKET, &socket);
+  }
+  if (code != CURLE_OK || socket == CURL_SOCKET_BAD) {
+    closure->reason = curl_easy_strerror(code);
+    return false;
+  }
+  socket_ = socket;
+
+  uint8_t nonce[16];
+  FillRandom(nonce, sizeof(nonce));
+  std::string key = Base64Encode(nonce, sizeof(nonce));
+
+  std::string request = "GET " + target + " HTTP/1.1\r\n";
+  request += "Host: " + authority + "\r\n";
+  request += "Upgrade: websocket\r\n";
+  request += "Connection: Upgrade\r\n";
+  request += "Sec-WebSocket-Key: " + key + "\r\n";
+  request += "Sec-WebSocket-Version: 13\r\n";
+  request += "Sec-WebSocket-Extensions: permessage-deflate\r\n";
+  if (!options_.protocols.empty()) {
+    request += "Sec-WebSocket-Protocol: ";
+    for (size_t i = 0; i < options_.protocols.size(); ++i) {
+      request += (i == 0 ? "" : ", ") + options_.protocols[i];
+    }
+    request += "\r\n";
+  }
+  for (const std::string& header : options_.headers) {
+    request += header + "\r\n";
+  }
+  request += "\r\n";
+
+  outgoing_ = std::move(request);
+  while (!outgoing_.empty()) {
+    if (!Flush() || (!outgoing_.empty() && !WaitFor(POLLOUT, deadline))) {
+      closure->reason = "Failed to send the handshake";
+      return false;
+    }
+  }
+
+  // Response is read till the end of its headers, while the frames sent right
+  // after it are left to be parsed.
+  std::string response;
+  size_t headers_end = std::string::npos;
+  while (headers_end == std::string::npos) {
+    char buffer[4096];
+    size_t received = 0;
+    code = curl_easy_recv(curl_, buffer, sizeof(buffer), &received);
+    if (code == CURLE_AGAIN) {
+      if (!WaitFor(POLLIN, deadline)) {
+        closure->reason = "Handshake has timed out";
+        return false;
+      }
+      continue;
+    }
+
+    if (code != CURLE_OK || received == 0 ||
+        response.size() + received > kMaxResponseSize) {
+      closure->reason = "Failed to receive the handshake";
+      return false;
+    }
+
+    response.append(buffer, received);
+    headers_end = response.find("\r\n\r\n");
+  }
+  parser_.Feed(response.data() + headers_end + 4,
+               response.size() - headers_end - 4);
+  response.resize(headers_end + 2);
+
+  std::string accept;
+  std::string protocol;
+  std::string extensions;
+  size_t line_start = response.find("\r\n") + 2;
+  if (response.compare(0, 12, "HTTP/1.1 101") != 0) {
+    closure->reason = "Handshake is rejected: " +
+                      response.substr(0, line_start - 2);
+    return false;
+  }
+
+  while (line_start < response.size()) {
+    size_t line_end = response.find("\r\n", line_start);
+    std::string line = response.substr(line_start, line_end - line_start);
+    line_start = line_end + 2;
+
+    if (const char* value = HeaderValue(line, "Sec-WebSocket-Accept")) {
+      accept = value;
+    } else if (const char* value =
+                   HeaderValue(line, "Sec-WebSocket-Protocol")) {
+      protocol = value;
+    } else if (const char* value =
+                   HeaderValue(line, "Sec-WebSocket-Extensions")) {
+      extensions += extensions.empty() ? value : std::string(", ") + value;
+    }
+  }
+
+  if (accept != WebSocketAcceptKey(key)) {
+    closure->reason = "Handshake is accepted with a wrong key";
+    return false;
+  }
+
+  if (extensions.find("permessage-deflate") != std::string::npos) {
+    inflater_.reset(new WebSocketInflater(
+        extensions.find("server_no_context_takeover") != std::string::npos));
+  }
+
+  callbacks_.opened(protocol);
+  return true;
+}
+
+void WebSocketClient::Loop(Closure* closure) {
+  int64_t now = NowMs();
+  int64_t last_received = now;
+  int64_t next_ping = now + options_.ping_interval;
+  int64_t close_deadline = 0;
+
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const std::string& message : pending_) {
+        QueueFrame(WebSocketOpcode::kText, message);
+      }
+      pending_.clear();
+
+      if (closing_ && !close_sent_) {
+        std::string payload;
+        payload.push_back(static_cast<char>(requested_closure_.code >> 8));
+        payload.push_back(static_cast<char>(requested_closure_.code));
+        payload += requested_closure_.reason.substr(0, 123);
+        QueueFrame(WebSocketOpcode::kClose, payload);
+
+        close_sent_ = true;
+        close_deadline = now + kCloseTimeout;
+        *closure = requested_closure_;
+      }
+    }
+
+    if (!Flush()) {
+      closure->code = 1006;
+      closure->reason = "Failed to send";
+      return;
+    }
+
+    // Sleeps till the earliest of the timers, unless woken up earlier.
+    int64_t wake_at = INT64_MAX;
+    if (options_.ping_interval > 0 && !close_sent_) {
+      wake_at = std::min(wake_at, next_ping);
+    }
+    if (options_.inactivity_timeout > 0) {
+      wake_at = std::min(wake_at, last_received + options_.inactivity_timeout);
+    }
+    if (!batch_.empty()) {
+      wake_at = std::min(wake_at, batch_deadline_);
+    }
+    if (close_sent_) {
+      wake_at = std::min(wake_at, close_deadline);
+    }
+
+    short events = POLLIN | (outgoing_.empty() ? 0 : POLLOUT);
+    struct pollfd fds[2] = {{socket_, events, 0}, {wake_fd_, POLLIN, 0}};
+    int timeout = wake_at == INT64_MAX
+                      ? -1
+                      : static_cast<int>(std::max<int64_t>(wake_at - now, 0));
+    poll(fds, 2, timeout);
+    now = NowMs();
+
+    if (fds[1].revents != 0) {
+      uint64_t value;
+      ssize_t bytes_read = read(wake_fd_, &value, sizeof(value));
+      (void)bytes_read;
+    }
+
+    if ((fds[0].revents & (POLLIN | POLLHUP | POLLERR)) != 0) {
+      bool received = Receive(closure);
+      last_received = now;
+      if (!HandleFrames(closure, now) || !received) {
+        return;
+      }
+    }
+
+    if (!batch_.empty() && now >= batch_deadline_) {
+      Deliver();
+    }
+
+    if (options_.ping_interval > 0 && !close_sent_ && now >= next_ping) {
+      QueueFrame(WebSocketOpcode::kText, kPingMessage);
+      next_ping = now + options_.ping_interval;
+    }
+
+    if (options_.inactivity_timeout > 0 &&
+        now - last_received >= options_.inactivity_timeout) {
+      closure->code = 1006;
+      closure->reason = "Nothing is received for too long";
+      return;
+    }
+
+    if (close_sent_ && now >= close_deadline) {
+      return;
+    }
+  }
+}
+
+bool WebSocketClient::Flush() {
+  while (!outgoing_.empty()) {
+    size_t sent = 0;
+    CURLcode code =
+        curl_easy_send(curl_, outgoing_.data(), outgoing_.size(), &sent);
+    if (code == CURLE_AGAIN) {
+      return true;
+    }
+
+    if (code != CURLE_OK) {
+      return false;
+    }
+
+    outgoing_.erase(0, sent);
+  }
+
+  return true;
+}
+
+bool WebSocketClient::Receive(Closure* closure) {
+  char buffer[kReceiveChunkSize];
+  while (true) {
+    size_t received = 0;
+    CURLcode code = curl_easy_recv(curl_, buffer, sizeof(buffer), &received);
+    if (code == CURLE_AGAIN) {
+      return true;
+    }
+
+    if (code != CURLE_OK || received == 0) {
+      closure->code = 1006;
+      closure->reason = code == CURLE_OK ? "Connection is closed"
+                                         : curl_easy_strerror(code);
+      return false;
+    }
+
+    parser_.Feed(buffer, received);
+  }
+}
+
+bool WebSocketClient::HandleFrames(Closure* closure, int64_t now) {
+  WebSocketFrame frame;
+  while (true) {
+    WebSocketParseResult result = parser_.Next(&frame);
+    if (result == WebSocketParseResult::kIncomplete) {
+      return true;
+    }
+
+    if (result == WebSocketParseResult::kError) {
+      closure->code = 1002;
+      closure->reason = "Malformed frame is received";
+      return false;
+    }
+
+    switch (frame.opcode) {
+      // Control frames may be interleaved with the fragments of a message.
+      case WebSocketOpcode::kPing:
+        QueueFrame(WebSocketOpcode::kPong, frame.payload);
+        continue;
+
+      case WebSocketOpcode::kPong:
+        continue;
+
+      case WebSocketOpcode::kClose: {
+        const std::string& payload = frame.payload;
+        if (!close_sent_) {
+          QueueFrame(WebSocketOpcode::kClose, payload.substr(0, 2));
+          close_sent_ = true;
+          Flush();
+        }
+
+        closure->code =
+            payload.size() < 2
+                ? 1005
+                : static_cast<uint8_t>(payload[0]) << 8 |
+                      static_cast<uint8_t>(payload[1]);
+        closure->reason = payload.size() < 2 ? std::string()
+                                             : payload.substr(2);
+        return false;
+      }
+
+      case WebSocketOpcode::kText:
+      case WebSocketOpcode::kBinary:
+        if (fragmented_) {
+          closure->code = 1002;
+          closure->reason = "Fragmented message is interrupted";
+          return false;
+        }
+
+        fragments_.swap(frame.payload);
+        fragments_compressed_ = frame.compressed;
+        fragments_binary_ = frame.opcode == WebSocketOpcode::kBinary;
+        fragmented_ = true;
+        break;
+
+      case WebSocketOpcode::kContinuation:
+        if (!fragmented_ || fragments_.size() + frame.payload.size() >
+                                options_.max_message_size) {
+          closure->code = fragmented_ ? 1009 : 1002;
+          closure->reason = "Unexpected continuation is received";
+          return false;
+        }
+
+        fragments_ += frame.payload;
+        break;
+
+      default:
+        closure->code = 1002;
+        closure->reason = "Unknown opcode is received";
+        return false;
+    }
+
+    if (!fragmented_ || !frame.fin) {
+      continue;
+    }
+    fragmented_ = false;
+
+    std::string message;
+    if (fragments_compressed_) {
+      if (inflater_ == nullptr ||
+          !inflater_->Inflate(fragments_, options_.max_message_size,
+                              &message)) {
+        closure->code = 1007;
+        closure->reason = "Malformed compressed message is received";
+        return false;
+      }
+    } else {
+      message.swap(fragments_);
+    }
+    fragments_.clear();
+
+    // Only the text messages are used by the protocol.
+    if (!fragments_binary_) {
+      HandleMessage(std::move(message), now);
+    }
+  }
+}
+
+void WebSocketClient::HandleMessage(std::string message, int64_t now) {
+  std::string type = MessageType(message);
+  if (type == "ping") {
+    QueueFrame(WebSocketOpcode::kText, kPongMessage);
+    return;
+  }
+
+  if (type == "pong") {
+    if (batch_has_pong_) {
+      return;
+    }
+    batch_has_pong_ = true;
+  }
+
+  if (batch_.empty()) {
+    batch_deadline_ = now + options_.batch_interval;
+  }
+  batch_.push_back(std::move(message));
+
+  if (batch_.size() >= options_.max_batch_size) {
+    Deliver();
+  }
+}
+
+void WebSocketClient::QueueFrame(WebSocketOpcode opcode,
+                                 const std::string& payload) {
+  uint8_t key[4];
+  FillRandom(key, sizeof(key));
+  AppendWebSocketFrame(&outgoing_, opcode, payload.data(), payload.size(),
+                       key);
+}
+
+void WebSocketClient::Deliver() {
+  if (batch_.empty()) {
+    return;
+  }
+
+  std::vector<std::string> batch;
+  batch.swap(batch_);
+  batch_has_pong_ = false;
+  callbacks_.received(std::move(batch));
+}
+
+void WebSocketClient::Wake() {
+  uint64_t value = 1;
+  ssize_t written = write(wake_fd_, &value, sizeof(value));
+  (void)written;
+}
+
+int WebSocketClient::OnProgress(void* user,
+                                curl_off_t download_total,
+                                curl_off_t downloaded,
+                                curl_off_t upload_total,
+                                curl_off_t uploaded) {
+  return static_cast<WebSocketClient*>(user)->cancelled_ ? 1 : 0;
+}
@@ -0,0 +1,185 @@
+#ifndef RUNNER_WEBSOCKET_CLIENT_H_
+#define RUNNER_WEBSOCKET_CLIENT_H_
+
+#include <curl/curl.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "websocket_frame.h"
+
+// WebSocket client of the `graphql-transport-ws` protocol, running its own
+// event loop on a dedicated thread.
+//
+// The connection is established by libcurl, over TLS for the `wss` URLs,
+// while the handshake and the frames are handled by the client itself. The
+// `permessage-deflate` extension is negotiated and inflated on the thread as
+// well.
+//
+// Pings of the protocol are sent every |Options::ping_interval| and the ones
+// of the server are answered right away, so neither depends on the UI being
+// responsive. Pongs are delivered at most once per batch, as they are only
+// relevant for detecting the inactivity.
+//
+// Messages received within the |Options::batch_interval| of each other are
+// delivered in batches, so a burst of them is delivered at once.
+class WebSocketClient {
+ public:
+  struct Options {
+    // `ws` or `wss` URL to connect to.
+    std::string url;
+
+    // Subprotocols to negotiate.
+    std::vector<std::string> protocols;
+
+    // Additional HTTP headers in the `Name: value` form.
+    std::vector<std::string> headers;
+
+    // Certificates to verify the `wss` server with, or empty to use the ones
+    // of the system.
+    std::string ca_file;
+
+    // Interval to send the pings of the protocol at, in milliseconds, or 0
+    // to not send them.
+    int64_t ping_interval = 5000;
+
+    // Interval without receiving anything to consider the connection lost
+    // after, in milliseconds, or 0 to never consider it lost.
+    int64_t inactivity_timeout = 15000;
+
+    // Interval to collect the messages received into a batch for, in
+    // milliseconds.
+    int64_t batch_interval = 8;
+
+    // Maximum number of the messages delivered in a single batch.
+    size_t max_batch_size = 256;
+
+    // Maximum size of a single message.
+    size_t max_message_size = 16 * 1024 * 1024;
+  };
+
+  struct Callbacks {
+    // Invoked once connected with the |protocol| negotiated.
+    std::function<void(const std::string& protocol)> opened;
+
+    // Invoked with the batch of the text |messages| received.
+    std::function<void(std::vector<std::string> messages)> received;
+
+    // Invoked once the connection is closed with the |code| and the
+    // |reason|, or with 1006 and the description of the failure, if it has
+    // failed or is lost.
+    std::function<void(int code, const std::string& reason)> closed;
+  };
+
+  // Creates the client invoking the |callbacks| on its thread.
+  WebSocketClient(Options options, Callbacks callbacks);
+  ~WebSocketClient();
+
+  WebSocketClient(const WebSocketClient&) = delete;
+  WebSocketClient& operator=(const WebSocketClient&) = delete;
+
+  // Starts connecting on the client's thread.
+  void Start();
+
+  // Queues the text |message| to be sent once connected. May be called from
+  // any thread.
+  void Send(std::string message);
+
+  // Closes the connection with the |code| and the |reason|, waiting for the
+  // server to close it for up to a second. May be called from any thread.
+  void Close(int code, std::string reason);
+
+ private:
+  // Description of the connection closed.
+  struct Closure {
+    int code = 1006;
+    std::string reason;
+  };
+
+  // Body of the |thread_|.
+  void Run();
+
+  // Waits for the |events| of the |socket_| until the |deadline|, returning
+  // false, if it has passed or the client is closed.
+  bool WaitFor(short events, int64_t deadline);
+
+  // Connects and performs the handshake, returning false on failure.
+  bool Connect(Closure* closure);
+
+  // Sends and receives the frames until the connection is closed.
+  void Loop(Closure* closure);
+
+  // Sends as much of the |outgoing_| as possible without blocking,
+  // returning false on failure.
+  bool Flush();
+
+  // Receives all the data available without blocking into the |parser_|,
+  // returning false, if the connection is closed or has failed.
+  bool Receive(Closure* closure);
+
+  // Handles the frames parsed, returning false, if the connection must be
+  // closed.
+  bool HandleFrames(Closure* closure, int64_t now);
+
+  // Handles the complete text |message|.
+  void HandleMessage(std::string message, int64_t now);
+
+  // Queues the frame of the |opcode| with the |payload| to be sent.
+  void QueueFrame(WebSocketOpcode opcode, const std::string& payload);
+
+  // Delivers the |batch_| collected.
+  void Deliver();
+
+  // Wakes the |thread_| up.
+  void Wake();
+
+  // CURLOPT_XFERINFOFUNCTION aborting the connecting, once closed.
+  static int OnProgress(void* user,
+                        curl_off_t download_total,
+                        curl_off_t downloaded,
+                        curl_off_t upload_total,
+                        curl_off_t uploaded);
+
+  Options options_;
+  Callbacks callbacks_;
+
+  std::thread thread_;
+  int wake_fd_ = -1;
+
+  // Messages and the closure requested from other threads.
+  std::mutex mutex_;
+  std::deque<std::string> pending_;
+  bool closing_ = false;
+  Closure requested_closure_;
+
+  // Indicator whether the Close() is called, read without the |mutex_|.
+  std::atomic<bool> cancelled_{false};
+
+  // Accessed on the |thread_| only.
+  CURL* curl_ = nullptr;
+  int socket_ = -1;
+  std::string outgoing_;
+  WebSocketFrameParser parser_;
+  std::unique_ptr<WebSocketInflater> inflater_;
+  bool close_sent_ = false;
+
+  // Message being received in the continuation frames.
+  std::string fragments_;
+  bool fragmented_ = false;
+  bool fragments_compressed_ = false;
+  bool fragments_binary_ = false;
+
+  std::vector<std::string> batch_;
+  int64_t batch_deadline_ = 0;
+  bool batch_has_pong_ = false;
+};
+
+#endif  // RUNNER_WEBSOCKET_CLIENT_H_
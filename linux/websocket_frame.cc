@@ -0,0 +1,374 @@
+#include "websocket_frame.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define WEBSOCKET_FRAME_X86 1
+#endif
+
+// GUID appended to the `Sec-WebSocket-Key` to compute the accepting key.
+static const char kAcceptGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// Largest payload of a control frame.
+static const size_t kMaxControlPayload = 125;
+
+// Size of the blocks masked at once.
+static const size_t kMaskBlockSize = 32;
+
+// Block of the bytes masked at once, lowered to the vector registers of the
+// width the code is compiled for.
+typedef uint8_t MaskBlock __attribute__((vector_size(kMaskBlockSize)));
+
+// Masks the |blocks| of the |data| with the |pattern| of the key repeated
+// over a whole block.
+static inline void MaskBlocks(uint8_t* data,
+                              size_t blocks,
+                              const uint8_t* pattern) {
+  MaskBlock mask;
+  memcpy(&mask, pattern, kMaskBlockSize);
+
+  for (size_t i = 0; i < blocks; ++i) {
+    MaskBlock block;
+    memcpy(&block, data + i * kMaskBlockSize, kMaskBlockSize);
+    block ^= mask;
+    memcpy(data + i * kMaskBlockSize, &block, kMaskBlockSize);
+  }
+}
+
+static void MaskBlocksDefault(uint8_t* data,
+                              size_t blocks,
+                              const uint8_t* pattern) {
+  MaskBlocks(data, blocks, pattern);
+}
+
+#ifdef WEBSOCKET_FRAME_X86
+__attribute__((target("avx2"))) static void MaskBlocksAvx2(
+    uint8_t* data,
+    size_t blocks,
+    const uint8_t* pattern) {
+  MaskBlocks(data, blocks, pattern);
+}
+
+static bool CpuSupportsAvx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+#endif  // WEBSOCKET_FRAME_X86
+
+static uint32_t RotateLeft(uint32_t value, int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+// Returns the SHA-1 digest of the |size| bytes of the |data|, which is only
+// used by the handshake, as defined by RFC 6455.
+static std::string Sha1(const uint8_t* data, size_t size) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476,
+                   0xC3D2E1F0};
+
+  // Message padded with a single bit, zeros and its length in bits.
+  std::string message(reinterpret_cast<const char*>(data), size);
+  message.push_back('\x80');
+  while (message.size() % 64 != 56) {
+    message.push_back('\0');
+  }
+  uint64_t bits = static_cast<uint64_t>(size) * 8;
+  for (int i = 7; i >= 0; --i) {
+    message.push_back(static_cast<char>(bits >> (8 * i)));
+  }
+
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(message.data());
+  for (size_t chunk = 0; chunk < message.size(); chunk += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+      const uint8_t* word = bytes + chunk + i * 4;
+      w[i] = static_cast<uint32_t>(word[0]) << 24 | word[1] << 16 |
+             word[2] << 8 | word[3];
+    }
+    for (int i = 16; i < 80; ++i) {
+      w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; ++i) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+
+      uint32_t temp = RotateLeft(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = RotateLeft(b, 30);
+      b = a;
+      a = temp;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+
+  std::string digest;
+  for (uint32_t value : h) {
+    for (int i = 3; i >= 0; --i) {
+      digest.push_back(static_cast<char>(value >> (8 * i)));
+    }
+  }
+
+  return digest;
+}
+
+void WebSocketMask(uint8_t* data,
+                   size_t size,
+                   const uint8_t key[4],
+                   size_t offset) {
+  // Key is repeated every 4 bytes, so it's repeated over a block the same
+  // way as over the payload.
+  uint8_t pattern[kMaskBlockSize];
+  for (size_t i = 0; i < kMaskBlockSize; ++i) {
+    pattern[i] = key[(offset + i) & 3];
+  }
+
+  size_t blocks = size / kMaskBlockSize;
+  if (blocks != 0) {
+#ifdef WEBSOCKET_FRAME_X86
+    static const bool avx2 = CpuSupportsAvx2();
+    if (avx2) {
+      MaskBlocksAvx2(data, blocks, pattern);
+    } else {
+      MaskBlocksDefault(data, blocks, pattern);
+    }
+#else
+    MaskBlocksDefault(data, blocks, pattern);
+#endif
+  }
+
+  for (size_t i = blocks * kMaskBlockSize; i < size; ++i) {
+    data[i] ^= pattern[i % kMaskBlockSize];
+  }
+}
+
+void AppendWebSocketFrame(std::string* out,
+                          WebSocketOpcode opcode,
+                          const char* payload,
+                          size_t size,
+                          const uint8_t key[4]) {
+  out->push_back(static_cast<char>(0x80 | static_cast<uint8_t>(opcode)));
+
+  if (size < 126) {
+    out->push_back(static_cast<char>(0x80 | size));
+  } else if (size <= 0xFFFF) {
+    out->push_back(static_cast<char>(0x80 | 126));
+    out->push_back(static_cast<char>(size >> 8));
+    out->push_back(static_cast<char>(size));
+  } else {
+    out->push_back(static_cast<char>(0x80 | 127));
+    uint64_t length = size;
+    for (int i = 7; i >= 0; --i) {
+      out->push_back(static_cast<char>(length >> (8 * i)));
+    }
+  }
+
+  out->append(reinterpret_cast<const char*>(key), 4);
+
+  size_t start = out->size();
+  out->append(payload, size);
+  WebSocketMask(reinterpret_cast<uint8_t*>(&(*out)[start]), size, key);
+}
+
+std::string WebSocketAcceptKey(const std::string& key) {
+  std::string input = key + kAcceptGuid;
+  std::string digest =
+      Sha1(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+  return Base64Encode(reinterpret_cast<const uint8_t*>(digest.data()),
+                      digest.size());
+}
+
+std::string Base64Encode(const uint8_t* data, size_t size) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  std::string result;
+  result.reserve((size + 2) / 3 * 4);
+  for (size_t i = 0; i < size; i += 3) {
+    uint32_t value = static_cast<uint32_t>(data[i]) << 16;
+    if (i + 1 < size) {
+      value |= data[i + 1] << 8;
+    }
+    if (i + 2 < size) {
+      value |= data[i + 2];
+    }
+
+    result.push_back(kAlphabet[(value >> 18) & 0x3F]);
+    result.push_back(kAlphabet[(value >> 12) & 0x3F]);
+    result.push_back(i + 1 < size ? kAlphabet[(value >> 6) & 0x3F] : '=');
+    result.push_back(i + 2 < size ? kAlphabet[value & 0x3F] : '=');
+  }
+
+  return result;
+}
+
+void WebSocketFrameParser::Feed(const char* data, size_t size) {
+  // Only the incomplete frame is left to be moved.
+  if (parsed_ != 0) {
+    buffer_.erase(0, parsed_);
+    parsed_ = 0;
+  }
+
+  buffer_.append(data, size);
+}
+
+WebSocketParseResult WebSocketFrameParser::Next(WebSocketFrame* frame) {
+  const uint8_t* data =
+      reinterpret_cast<const uint8_t*>(buffer_.data()) + parsed_;
+  size_t available = buffer_.size() - parsed_;
+  if (available < 2) {
+    return WebSocketParseResult::kIncomplete;
+  }
+
+  // Neither RSV2 nor RSV3 are used by any extension negotiated.
+  if ((data[0] & 0x30) != 0) {
+    return WebSocketParseResult::kError;
+  }
+
+  bool fin = (data[0] & 0x80) != 0;
+  bool compressed = (data[0] & 0x40) != 0;
+  uint8_t opcode = data[0] & 0x0F;
+  bool masked = (data[1] & 0x80) != 0;
+
+  size_t header = 2;
+  uint64_t length = data[1] & 0x7F;
+  if (length == 126) {
+    header += 2;
+    if (available < header) {
+      return WebSocketParseResult::kIncomplete;
+    }
+    length = static_cast<uint64_t>(data[2]) << 8 | data[3];
+  } else if (length == 127) {
+    header += 8;
+    if (available < header) {
+      return WebSocketParseResult::kIncomplete;
+    }
+    length = 0;
+    for (int i = 0; i < 8; ++i) {
+      length = length << 8 | data[2 + i];
+    }
+  }
+
+  if (length > max_payload_size_) {
+    return WebSocketParseResult::kError;
+  }
+
+  bool control = (opcode & 0x08) != 0;
+  if (control && (!fin || length > kMaxControlPayload)) {
+    return WebSocketParseResult::kError;
+  }
+
+  uint8_t key[4] = {};
+  if (masked) {
+    if (available < header + 4) {
+      return WebSocketParseResult::kIncomplete;
+    }
+    memcpy(key, data + header, 4);
+    header += 4;
+  }
+
+  if (available < header + length) {
+    return WebSocketParseResult::kIncomplete;
+  }
+
+  frame->fin = fin;
+  frame->compressed = compressed;
+  frame->opcode = static_cast<WebSocketOpcode>(opcode);
+  frame->payload.assign(reinterpret_cast<const char*>(data + header),
+                        length);
+  if (masked) {
+    WebSocketMask(reinterpret_cast<uint8_t*>(&frame->payload[0]), length, key);
+  }
+
+  parsed_ += header + length;
+  if (parsed_ == buffer_.size()) {
+    buffer_.clear();
+    parsed_ = 0;
+  }
+
+  return WebSocketParseResult::kFrame;
+}
+
+WebSocketInflater::WebSocketInflater(bool no_context_takeover)
+    : no_context_takeover_(no_context_takeover) {
+  memset(&stream_, 0, sizeof(stream_));
+  inflateInit2(&stream_, -MAX_WBITS);
+}
+
+WebSocketInflater::~WebSocketInflater() {
+  inflateEnd(&stream_);
+}
+
+bool WebSocketInflater::Inflate(const std::string& message,
+                                size_t max_size,
+                                std::string* out) {
+  // Messages are sent without the tail of the final empty stored block, so
+  // it's inflated after them.
+  static const uint8_t kTail[] = {0x00, 0x00, 0xFF, 0xFF};
+
+  out->clear();
+
+  bool succeeded = true;
+  bool ended = false;
+  for (int part = 0; part < 2 && succeeded && !ended; ++part) {
+    stream_.next_in = part == 0 ? reinterpret_cast<Bytef*>(
+                                      const_cast<char*>(message.data()))
+                                : const_cast<Bytef*>(kTail);
+    stream_.avail_in = part == 0 ? message.size() : sizeof(kTail);
+
+    while (true) {
+      size_t written = out->size();
+      out->resize(written + std::max<size_t>(message.size() * 2, 4096));
+      stream_.next_out = reinterpret_cast<Bytef*>(&(*out)[written]);
+      stream_.avail_out = out->size() - written;
+
+      int result = inflate(&stream_, Z_SYNC_FLUSH);
+      out->resize(out->size() - stream_.avail_out);
+
+      if ((result != Z_OK && result != Z_BUF_ERROR &&
+           result != Z_STREAM_END) ||
+          out->size() > max_size) {
+        succeeded = false;
+        break;
+      }
+
+      // Messages may end with the final block, if the window isn't taken
+      // over, leaving the tail unused.
+      if (result == Z_STREAM_END) {
+        ended = true;
+        break;
+      }
+
+      // Inflated everything fed, as there's still room left.
+      if (stream_.avail_in == 0 && stream_.avail_out != 0) {
+        break;
+      }
+    }
+  }
+
+  if (no_context_takeover_ || ended || !succeeded) {
+    inflateReset(&stream_);
+  }
+
+  return succeeded;
+}
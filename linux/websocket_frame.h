@@ -0,0 +1,114 @@
+#ifndef RUNNER_WEBSOCKET_FRAME_H_
+#define RUNNER_WEBSOCKET_FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zlib.h>
+
+#include <string>
+
+// Opcodes of the WebSocket frames, as defined by RFC 6455.
+enum class WebSocketOpcode : uint8_t {
+  kContinuation = 0x0,
+  kText = 0x1,
+  kBinary = 0x2,
+  kClose = 0x8,
+  kPing = 0x9,
+  kPong = 0xA,
+};
+
+// Single WebSocket frame parsed by a WebSocketFrameParser.
+struct WebSocketFrame {
+  bool fin = false;
+
+  // Indicator whether the RSV1 bit is set, which marks the first frame of a
+  // message compressed with the `permessage-deflate` extension.
+  bool compressed = false;
+
+  WebSocketOpcode opcode = WebSocketOpcode::kContinuation;
+
+  // Payload of the frame, unmasked.
+  std::string payload;
+};
+
+// Result of WebSocketFrameParser::Next().
+enum class WebSocketParseResult {
+  kFrame,
+
+  // More data must be fed to parse the next frame.
+  kIncomplete,
+
+  // Data doesn't form a valid frame, or exceeds the maximum size of it.
+  kError,
+};
+
+// Masks or unmasks the |size| bytes of the |data| in place with the 4-byte
+// masking |key|, the |data| starting at the |offset| within the payload.
+//
+// Processed 16 or 32 bytes at a time with the vector instructions, if the
+// CPU supports them.
+void WebSocketMask(uint8_t* data,
+                   size_t size,
+                   const uint8_t key[4],
+                   size_t offset = 0);
+
+// Appends the client frame of the |opcode| with the |size| bytes of the
+// |payload| masked with the |key| to the |out|.
+void AppendWebSocketFrame(std::string* out,
+                          WebSocketOpcode opcode,
+                          const char* payload,
+                          size_t size,
+                          const uint8_t key[4]);
+
+// Returns the `Sec-WebSocket-Accept` value a server must respond with to the
+// handshake with the `Sec-WebSocket-Key` of the |key|.
+std::string WebSocketAcceptKey(const std::string& key);
+
+// Returns the |size| bytes of the |data| encoded in the standard Base64.
+std::string Base64Encode(const uint8_t* data, size_t size);
+
+// Parser of the frames received from a server, fed with the data as it's
+// received.
+class WebSocketFrameParser {
+ public:
+  explicit WebSocketFrameParser(size_t max_payload_size)
+      : max_payload_size_(max_payload_size) {}
+
+  // Appends the |size| bytes of the |data| received.
+  void Feed(const char* data, size_t size);
+
+  // Parses the next frame fed into the |frame|.
+  WebSocketParseResult Next(WebSocketFrame* frame);
+
+ private:
+  size_t max_payload_size_;
+
+  std::string buffer_;
+
+  // Number of the bytes at the start of the |buffer_| already parsed.
+  size_t parsed_ = 0;
+};
+
+// Inflater of the messages compressed with the `permessage-deflate`
+// extension, as defined by RFC 7692.
+class WebSocketInflater {
+ public:
+  // Creates the inflater forgetting the LZ77 window after each message, if
+  // the |no_context_takeover| is negotiated. The window of the maximum size
+  // is used, which inflates the messages compressed with any smaller one.
+  explicit WebSocketInflater(bool no_context_takeover);
+  ~WebSocketInflater();
+
+  WebSocketInflater(const WebSocketInflater&) = delete;
+  WebSocketInflater& operator=(const WebSocketInflater&) = delete;
+
+  // Inflates the compressed |message| into the |out|, returning false, if
+  // it's malformed or inflates to more than the |max_size| bytes.
+  bool Inflate(const std::string& message, size_t max_size, std::string* out);
+
+ private:
+  z_stream stream_;
+  bool no_context_takeover_;
+};
+
+#endif  // RUNNER_WEBSOCKET_FRAME_H_
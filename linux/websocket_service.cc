@@ -0,0 +1,260 @@
+#include "websocket_service.h"
+
+#include <string.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "websocket_client.h"
+
+// Event of a connection to send on the main thread.
+struct WebSocketEvent {
+  int64_t id;
+  const gchar* type;
+  std::string protocol;
+  std::vector<std::string> messages;
+  int code = 0;
+  std::string reason;
+};
+
+static FlEventChannel* event_channel = nullptr;
+static bool events_listened = false;
+
+// Connections by their IDs, accessed on the main thread only.
+static std::map<int64_t, std::unique_ptr<WebSocketClient>> clients;
+
+static FlMethodErrorResponse* on_events_listen(FlEventChannel* channel,
+                                               FlValue* args,
+                                               gpointer user_data) {
+  events_listened = true;
+  return nullptr;
+}
+
+static FlMethodErrorResponse* on_events_cancel(FlEventChannel* channel,
+                                               FlValue* args,
+                                               gpointer user_data) {
+  events_listened = false;
+  return nullptr;
+}
+
+static gboolean send_event(gpointer user_data) {
+  std::unique_ptr<WebSocketEvent> event(
+      static_cast<WebSocketEvent*>(user_data));
+
+  // Clients left after websocket_service_dispose() aren't reported, as the
+  // engine is gone.
+  auto it = clients.find(event->id);
+  if (it == clients.end()) {
+    return G_SOURCE_REMOVE;
+  }
+
+  // Thread of the client is finished once it's closed.
+  if (strcmp(event->type, "closed") == 0) {
+    clients.erase(it);
+  }
+
+  if (event_channel == nullptr || !events_listened) {
+    return G_SOURCE_REMOVE;
+  }
+
+  g_autoptr(FlValue) value = fl_value_new_map();
+  fl_value_set_string_take(value, "id", fl_value_new_int(event->id));
+  fl_value_set_string_take(value, "type", fl_value_new_string(event->type));
+
+  if (strcmp(event->type, "open") == 0) {
+    fl_value_set_string_take(value, "protocol",
+                             fl_value_new_string(event->protocol.c_str()));
+  } else if (strcmp(event->type, "messages") == 0) {
+    FlValue* messages = fl_value_new_list();
+    for (const std::string& message : event->messages) {
+      // Codec requires the strings to be valid UTF-8.
+      if (!g_utf8_validate(message.data(), message.size(), nullptr)) {
+        g_warning("Dropping WebSocket message with invalid UTF-8");
+        continue;
+      }
+
+      fl_value_append_take(messages, fl_value_new_string_sized(
+                                         message.data(), message.size()));
+    }
+    fl_value_set_string_take(value, "messages", messages);
+  } else {
+    fl_value_set_string_take(value, "code", fl_value_new_int(event->code));
+    fl_value_set_string_take(value, "reason",
+                             fl_value_new_string(event->reason.c_str()));
+  }
+
+  fl_event_channel_send(event_channel, value, nullptr, nullptr);
+  return G_SOURCE_REMOVE;
+}
+
+// Returns the integer `id` of the |args|, or -1, if there's none.
+static int64_t lookup_id(FlValue* args) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return -1;
+  }
+
+  FlValue* id = fl_value_lookup_string(args, "id");
+  if (id == nullptr || fl_value_get_type(id) != FL_VALUE_TYPE_INT) {
+    return -1;
+  }
+
+  return fl_value_get_int(id);
+}
+
+static FlMethodResponse* connect_websocket(FlValue* args) {
+  int64_t id = lookup_id(args);
+  FlValue* url = id < 0 ? nullptr : fl_value_lookup_string(args, "url");
+  if (url == nullptr || fl_value_get_type(url) != FL_VALUE_TYPE_STRING) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`id` and `url` must be provided", nullptr));
+  }
+
+  if (clients.count(id) != 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "STATE_ERROR", "WebSocket with this `id` is already connected",
+        nullptr));
+  }
+
+  WebSocketClient::Options options;
+  options.url = fl_value_get_string(url);
+
+  FlValue* protocols = fl_value_lookup_string(args, "protocols");
+  if (protocols != nullptr &&
+      fl_value_get_type(protocols) == FL_VALUE_TYPE_LIST) {
+    for (size_t i = 0; i < fl_value_get_length(protocols); ++i) {
+      FlValue* protocol = fl_value_get_list_value(protocols, i);
+      if (fl_value_get_type(protocol) == FL_VALUE_TYPE_STRING) {
+        options.protocols.push_back(fl_value_get_string(protocol));
+      }
+    }
+  }
+
+  FlValue* headers = fl_value_lookup_string(args, "headers");
+  if (headers != nullptr && fl_value_get_type(headers) == FL_VALUE_TYPE_MAP) {
+    for (size_t i = 0; i < fl_value_get_length(headers); ++i) {
+      FlValue* name = fl_value_get_map_key(headers, i);
+      FlValue* value = fl_value_get_map_value(headers, i);
+      if (fl_value_get_type(name) == FL_VALUE_TYPE_STRING &&
+          fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+        options.headers.push_back(std::string(fl_value_get_string(name)) +
+                                  ": " + fl_value_get_string(value));
+      }
+    }
+  }
+
+  WebSocketClient::Callbacks callbacks;
+  callbacks.opened = [id](const std::string& protocol) {
+    WebSocketEvent* event = new WebSocketEvent{id, "open"};
+    event->protocol = protocol;
+    g_main_context_invoke(nullptr, send_event, event);
+  };
+  callbacks.received = [id](std::vector<std::string> messages) {
+    WebSocketEvent* event = new WebSocketEvent{id, "messages"};
+    event->messages = std::move(messages);
+    g_main_context_invoke(nullptr, send_event, event);
+  };
+  callbacks.closed = [id](int code, const std::string& reason) {
+    WebSocketEvent* event = new WebSocketEvent{id, "closed"};
+    event->code = code;
+    event->reason = reason;
+    g_main_context_invoke(nullptr, send_event, event);
+  };
+
+  std::unique_ptr<WebSocketClient>& client = clients[id];
+  client.reset(new WebSocketClient(std::move(options), std::move(callbacks)));
+  client->Start();
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse* send_websocket(FlValue* args) {
+  int64_t id = lookup_id(args);
+  FlValue* text = id < 0 ? nullptr : fl_value_lookup_string(args, "text");
+  if (text == nullptr || fl_value_get_type(text) != FL_VALUE_TYPE_STRING) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`id` and `text` must be provided", nullptr));
+  }
+
+  auto it = clients.find(id);
+  if (it == clients.end()) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "STATE_ERROR", "WebSocket with this `id` is closed", nullptr));
+  }
+
+  it->second->Send(fl_value_get_string(text));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+static FlMethodResponse* close_websocket(FlValue* args) {
+  int64_t id = lookup_id(args);
+  if (id < 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "ARGUMENT_ERROR", "`id` must be an integer", nullptr));
+  }
+
+  int code = 1000;
+  FlValue* value = fl_value_lookup_string(args, "code");
+  if (value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_INT) {
+    code = fl_value_get_int(value);
+  }
+
+  std::string reason;
+  value = fl_value_lookup_string(args, "reason");
+  if (value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_STRING) {
+    reason = fl_value_get_string(value);
+  }
+
+  // Client is removed once the `closed` event is sent.
+  auto it = clients.find(id);
+  if (it != clients.end()) {
+    it->second->Close(code, std::move(reason));
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+void websocket_service_init(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  event_channel = fl_event_channel_new(
+      messenger, "team113.flutter.dev/linux_utils/websocket",
+      FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(event_channel, on_events_listen,
+                                       on_events_cancel, nullptr, nullptr);
+}
+
+gboolean websocket_service_handle_method_call(FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (strcmp(method, "connectWebSocket") == 0) {
+    response = connect_websocket(args);
+  } else if (strcmp(method, "sendWebSocket") == 0) {
+    response = send_websocket(args);
+  } else if (strcmp(method, "closeWebSocket") == 0) {
+    response = close_websocket(args);
+  } else {
+    return FALSE;
+  }
+
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send response: %s", error->message);
+  }
+
+  return TRUE;
+}
+
+void websocket_service_dispose() {
+  for (auto& entry : clients) {
+    entry.second->Close(1001, std::string());
+  }
+
+  // Destroying the clients waits for their threads to finish.
+  clients.clear();
+
+  g_clear_object(&event_channel);
+  events_listened = false;
+}
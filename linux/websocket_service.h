@@ -0,0 +1,37 @@
+#ifndef RUNNER_WEBSOCKET_SERVICE_H_
+#define RUNNER_WEBSOCKET_SERVICE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+/**
+ * websocket_service_init:
+ * @messenger: #FlBinaryMessenger to create the event channel on.
+ *
+ * Creates the `team113.flutter.dev/linux_utils/websocket` event channel
+ * reporting the `{id, type, ...}` events of the WebSocket connections: `open`
+ * with the `protocol` negotiated, `messages` with the batch of the
+ * `messages` received, and `closed` with the `code` and the `reason`.
+ */
+void websocket_service_init(FlBinaryMessenger* messenger);
+
+/**
+ * websocket_service_handle_method_call:
+ * @method_call: #FlMethodCall received on the utils channel.
+ *
+ * Handles the `connectWebSocket` method, connecting a #WebSocketClient on its
+ * own thread, the `sendWebSocket` method sending a text message over it, and
+ * the `closeWebSocket` method closing it.
+ *
+ * Returns: %TRUE if the @method_call was handled by this service.
+ */
+gboolean websocket_service_handle_method_call(FlMethodCall* method_call);
+
+/**
+ * websocket_service_dispose:
+ *
+ * Closes the WebSocket connections, waiting for their threads to finish, and
+ * closes the event channel.
+ */
+void websocket_service_dispose();
+
+#endif  // RUNNER_WEBSOCKET_SERVICE_H_
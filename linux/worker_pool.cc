@@ -0,0 +1,64 @@
+#include "worker_pool.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+
+// Upper bound of the threads in WorkerPool::Shared(), as the services are
+// mostly bound by I/O and memory bandwidth beyond that.
+static const size_t kMaxSharedThreads = 4;
+
+WorkerPool* WorkerPool::Shared() {
+  // Intentionally leaked, as the tasks may still be running on exit.
+  static WorkerPool* pool = new WorkerPool(std::max<size_t>(
+      1, std::min<size_t>(std::thread::hardware_concurrency() / 2,
+                          kMaxSharedThreads)));
+  return pool;
+}
+
+WorkerPool::WorkerPool(size_t threads) {
+  for (size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back(&WorkerPool::Run, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  tasks_changed_.notify_all();
+
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkerPool::Post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  tasks_changed_.notify_one();
+}
+
+void WorkerPool::Run() {
+  pthread_setname_np(pthread_self(), "worker_pool");
+
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      tasks_changed_.wait(lock,
+                          [this] { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
@@ -0,0 +1,44 @@
+#ifndef RUNNER_WORKER_POOL_H_
+#define RUNNER_WORKER_POOL_H_
+
+#include <stddef.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads running the posted tasks in FIFO order.
+class WorkerPool {
+ public:
+  // Returns the WorkerPool shared by the runner's native services, sized
+  // after the number of CPUs available.
+  static WorkerPool* Shared();
+
+  explicit WorkerPool(size_t threads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // Schedules the |task| to be run on one of the threads.
+  void Post(std::function<void()> task);
+
+  // Returns the number of threads in this pool.
+  size_t size() const { return threads_.size(); }
+
+ private:
+  // Body of each of the |threads_|.
+  void Run();
+
+  std::mutex mutex_;
+  std::condition_variable tasks_changed_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_ = false;
+
+  std::vector<std::thread> threads_;
+};
+
+#endif  // RUNNER_WORKER_POOL_H_
@@ -0,0 +1,129 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter/widgets.dart';
+import 'package:messenger/util/linux_utils.dart';
+
+/// Benchmark of the round-trips over the bulk channel of the Linux runner:
+/// the latency and throughput of echoing the payloads, and of hashing them
+/// with the [LinuxUtils.sha256].
+///
+/// Must be run as the application on Linux, as the channel is handled by its
+/// runner:
+///
+/// ```sh
+/// flutter run -d linux --release -t test/benchmark/bulk_channel_benchmark.dart
+/// ```
+Future<void> main() async {
+  WidgetsFlutterBinding.ensureInitialized();
+
+  stdout.writeln(
+    '${'size'.padRight(12)}'
+    '${'echo us'.padLeft(12)}'
+    '${'echo MB/s'.padLeft(12)}'
+    '${'sha256 us'.padLeft(12)}'
+    '${'sha256 MB/s'.padLeft(14)}',
+  );
+
+  for (final int size in [0, 1 << 10, 64 << 10, 1 << 20, 16 << 20]) {
+    final Uint8List payload = Uint8List.fromList(
+      List.generate(size, (i) => (i * 31 + 7) & 0xFF),
+    );
+
+    final Uint8List reply = await _echo(payload);
+    if (reply.length != size || reply.lastOrNull != payload.lastOrNull) {
+      throw StateError('Echo of $size bytes is wrong');
+    }
+
+    final double echo = await _measure(size, () => _echo(payload));
+    final double sha256 = await _measure(
+      size,
+      () => LinuxUtils.sha256(payload),
+    );
+
+    stdout.writeln(
+      '${'$size'.padRight(12)}'
+      '${echo.toStringAsFixed(1).padLeft(12)}'
+      '${_throughput(size, echo).padLeft(12)}'
+      '${sha256.toStringAsFixed(1).padLeft(12)}'
+      '${_throughput(size, sha256).padLeft(14)}',
+    );
+  }
+
+  exit(0);
+}
+
+/// ID of the last request sent by the [_echo].
+int _id = 0;
+
+/// Sends the [payload] with the echo opcode `0` over the bulk channel,
+/// returning the payload of the reply.
+Future<Uint8List> _echo(Uint8List payload) async {
+  final int id = ++_id;
+
+  final Uint8List request = Uint8List(8 + payload.length);
+  ByteData.sublistView(request)
+    ..setUint32(0, id, Endian.host)
+    ..setUint32(4, 0, Endian.host);
+  request.setRange(8, request.length, payload);
+
+  final ByteData? reply = await ServicesBinding.instance.defaultBinaryMessenger
+      .send(
+        'team113.flutter.dev/linux_utils/bulk',
+        ByteData.sublistView(request),
+      );
+
+  if (reply == null ||
+      reply.lengthInBytes < 8 ||
+      reply.getUint32(0, Endian.host) != id ||
+      reply.getUint32(4, Endian.host) != 0) {
+    throw StateError('Echo request $id failed');
+  }
+
+  return Uint8List.sublistView(reply, 8);
+}
+
+/// Returns the microseconds per round-trip of invoking the [request] of
+/// [size] bytes sequentially until 256 MiB are sent, but at least 16 and at
+/// most 10000 times.
+Future<double> _measure(int size, Future<Object> Function() request) async {
+  final int iterations = size == 0
+      ? 10000
+      : ((256 << 20) ~/ size).clamp(16, 10000);
+
+  final Stopwatch watch = Stopwatch()..start();
+  for (int i = 0; i < iterations; ++i) {
+    await request();
+  }
+
+  return watch.elapsedMicroseconds / iterations;
+}
+
+/// Returns the MB/s of the [size] bytes taking [micros] formatted, or `-` if
+/// the [size] is `0`.
+String _throughput(int size, double micros) {
+  if (size == 0) {
+    return '-';
+  }
+
+  return (size / (1 << 20) / (micros / 1e6)).toStringAsFixed(0);
+}
@@ -0,0 +1,216 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:dio/dio.dart';
+import 'package:flutter/widgets.dart';
+import 'package:messenger/util/json_tape.dart';
+
+/// Benchmark of the [JsonTapeTransformer] against the [jsonDecode] and the
+/// [BackgroundTransformer] over the pages of the chat items, as responded to
+/// the `GetMessages` query.
+///
+/// The [JsonTape] is measured both without reading it and with every of its
+/// values read, as the lazy views create only the values accessed.
+///
+/// Must be run as the application on Linux, as the native parsing is provided
+/// by its runner:
+///
+/// ```sh
+/// flutter run -d linux --release -t test/benchmark/json_tape_benchmark.dart
+/// ```
+Future<void> main() async {
+  WidgetsFlutterBinding.ensureInitialized();
+
+  final BackgroundTransformer background = BackgroundTransformer();
+  final JsonTapeTransformer tape = JsonTapeTransformer(threshold: 0);
+
+  stdout.writeln(
+    '${'items'.padRight(8)}'
+    '${'KiB'.padLeft(8)}'
+    '${'jsonDecode ms'.padLeft(16)}'
+    '${'background ms'.padLeft(16)}'
+    '${'tape ms'.padLeft(10)}'
+    '${'tape read ms'.padLeft(15)}',
+  );
+
+  for (final int items in [10, 100, 400, 2000]) {
+    final Uint8List bytes = utf8.encode(jsonEncode(_page(items)));
+
+    final Object? expected = jsonDecode(utf8.decode(bytes));
+    final Object? parsed = await _transform(tape, bytes);
+    if (jsonEncode(parsed) != jsonEncode(expected)) {
+      throw StateError('Tape of $items items differs from `jsonDecode`');
+    }
+
+    final double decoded = await _measure(
+      bytes.length,
+      () async => jsonDecode(utf8.decode(bytes)),
+    );
+    final double transformed = await _measure(
+      bytes.length,
+      () => _transform(background, bytes),
+    );
+    final double taped = await _measure(
+      bytes.length,
+      () => _transform(tape, bytes),
+    );
+    final double read = await _measure(
+      bytes.length,
+      () async => _read(await _transform(tape, bytes)),
+    );
+
+    stdout.writeln(
+      '${'$items'.padRight(8)}'
+      '${(bytes.length / 1024).toStringAsFixed(0).padLeft(8)}'
+      '${decoded.toStringAsFixed(2).padLeft(16)}'
+      '${transformed.toStringAsFixed(2).padLeft(16)}'
+      '${taped.toStringAsFixed(2).padLeft(10)}'
+      '${read.toStringAsFixed(2).padLeft(15)}',
+    );
+  }
+
+  exit(0);
+}
+
+/// Returns the [bytes] transformed by the [transformer] as a JSON response.
+Future<Object?> _transform(Transformer transformer, Uint8List bytes) async {
+  return await transformer.transformResponse(
+    RequestOptions(responseType: ResponseType.json),
+    ResponseBody.fromBytes(
+      bytes,
+      200,
+      headers: {
+        Headers.contentTypeHeader: [Headers.jsonContentType],
+      },
+    ),
+  );
+}
+
+/// Reads every value of the [json] recursively, returning their number.
+int _read(Object? json) {
+  if (json is Map) {
+    int count = 1;
+    for (final Object? key in json.keys) {
+      count += _read(json[key]);
+    }
+
+    return count;
+  } else if (json is List) {
+    int count = 1;
+    for (int i = 0; i < json.length; ++i) {
+      count += _read(json[i]);
+    }
+
+    return count;
+  }
+
+  return 1;
+}
+
+/// Returns the milliseconds per invoking the [parse] of [size] bytes
+/// sequentially until 64 MiB are parsed, but at least 16 times.
+Future<double> _measure(int size, Future<Object?> Function() parse) async {
+  final int iterations = ((64 << 20) ~/ size).clamp(16, 10000);
+
+  final Stopwatch watch = Stopwatch()..start();
+  for (int i = 0; i < iterations; ++i) {
+    await parse();
+  }
+
+  return watch.elapsedMicroseconds / 1000 / iterations;
+}
+
+/// Returns the page of the [count] chat items, as responded to the
+/// `GetMessages` query.
+Map<String, dynamic> _page(int count) {
+  return {
+    'data': {
+      'chat': {
+        'items': {
+          'edges': List.generate(count, _edge),
+          'pageInfo': {
+            'endCursor': 'Y3Vyc29yLQ0==',
+            'hasNextPage': true,
+            'startCursor': 'Y3Vyc29yLQ${count - 1}==',
+            'hasPreviousPage': false,
+          },
+          'ver': '1',
+        },
+      },
+    },
+  };
+}
+
+/// Returns the edge of the [i]th chat item, with the Cyrillic and escaped
+/// text, and the image attachment on every third one.
+Map<String, dynamic> _edge(int i) {
+  final String id = i.toRadixString(16).padLeft(8, '0');
+
+  return {
+    '__typename': 'ChatItemEdge',
+    'node': {
+      '__typename': 'ChatMessage',
+      'id': '$id-aaaa-bbbb-cccc-${id.padLeft(12, '0')}',
+      'chatId': 'c0ffee00-1111-2222-3333-444455556666',
+      'author': {
+        '__typename': 'User',
+        'id': 'u-${i % 7}',
+        'num': '1234567890123456',
+        'name': 'Юзер ${i % 7}',
+        'avatar': null,
+        'presence': 'PRESENT',
+        'online': {'__typename': 'UserOnline'},
+        'isDeleted': false,
+        'isBlocked': {'record': null, 'ver': '0'},
+        'ver': '3151871239012',
+      },
+      'at': '2024-05-0${i % 9 + 1}T12:${'${i % 60}'.padLeft(2, '0')}:00.000Z',
+      'status': 'SENT',
+      'repliesTo': [],
+      'text': 'Сообщение номер $i with some text and "quotes" and emoji 😀 ' *
+          (i % 3 + 1),
+      'editedAt': null,
+      'attachments': [
+        if (i % 3 == 0)
+          {
+            '__typename': 'ImageAttachment',
+            'id': 'a$i',
+            'filename': 'photo.jpg',
+            'original': {
+              'url': 'https://example.com/files/$i/original.jpg',
+              'checksum': 'f' * 64,
+              'size': 123456,
+            },
+            'big': {
+              'url': 'https://example.com/files/$i/big.jpg',
+              'checksum': 'e' * 64,
+              'size': 65432,
+              'width': 1920,
+              'height': 1080,
+            },
+          },
+      ],
+      'ver': '31520000$i',
+    },
+    'cursor': 'Y3Vyc29yLQ$i==',
+  };
+}
@@ -0,0 +1,83 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:crypto/crypto.dart' as crypto;
+import 'package:flutter/widgets.dart';
+import 'package:messenger/util/linux_utils.dart';
+
+/// Benchmark of the native [LinuxUtils.sha256] against the `package:crypto`
+/// used on the other platforms.
+///
+/// Must be run as the application on Linux, as the native hashing is provided
+/// by its runner:
+///
+/// ```sh
+/// flutter run -d linux --release -t test/benchmark/sha256_benchmark.dart
+/// ```
+Future<void> main() async {
+  WidgetsFlutterBinding.ensureInitialized();
+
+  stdout.writeln(
+    '${'size'.padRight(12)}'
+    '${'native MB/s'.padLeft(14)}'
+    '${'crypto MB/s'.padLeft(14)}',
+  );
+
+  for (final int size in [1 << 10, 64 << 10, 1 << 20, 16 << 20]) {
+    final Uint8List bytes = Uint8List.fromList(
+      List.generate(size, (i) => (i * 31 + 7) & 0xFF),
+    );
+
+    final String expected = crypto.sha256.convert(bytes).toString();
+    if (await LinuxUtils.sha256(bytes) != expected) {
+      throw StateError('Native SHA-256 of $size bytes is wrong');
+    }
+
+    final double native = await _measure(
+      size,
+      () => LinuxUtils.sha256(bytes),
+    );
+    final double dart = await _measure(
+      size,
+      () async => crypto.sha256.convert(bytes).toString(),
+    );
+
+    stdout.writeln(
+      '${'$size'.padRight(12)}'
+      '${native.toStringAsFixed(0).padLeft(14)}'
+      '${dart.toStringAsFixed(0).padLeft(14)}',
+    );
+  }
+
+  exit(0);
+}
+
+/// Returns the MB/s of invoking the [hash] of [size] bytes sequentially until
+/// 256 MiB are hashed.
+Future<double> _measure(int size, Future<String> Function() hash) async {
+  final int iterations = (256 << 20) ~/ size;
+
+  final Stopwatch watch = Stopwatch()..start();
+  for (int i = 0; i < iterations; ++i) {
+    await hash();
+  }
+
+  return size * iterations / (1 << 20) / (watch.elapsedMicroseconds / 1e6);
+}
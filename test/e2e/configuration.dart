@@ -258,6 +258,7 @@ FlutterTestConfiguration gherkinTestConfiguration() {
     rightClickMessage,
     rightClickWidget,
     scrollAndSee,
+    scrollBackAndForth,
     scrollToBottom,
     scrollToTop,
     scrollUntilPresent,
@@ -0,0 +1,34 @@
+# Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+#                       <https://github.com/team113>
+#
+# This program is free software: you can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License v3.0 as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+# more details.
+#
+# You should have received a copy of the GNU Affero General Public License v3.0
+# along with this program. If not, see
+# <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+Feature: Chat scrolling
+
+  Background: User has group chat with a lot of messages
+    Given user Alice with their password set
+    And Alice has "Scrolling" group
+    And Alice sends 200 messages to "Scrolling" group
+    And Alice reads all messages in "Scrolling" group
+
+  @chat
+  @common
+  Scenario: User scrolls chat with a lot of messages
+    Given I sign in as Alice
+    And I am in "Scrolling" group
+    And I wait for app to settle
+
+    When I scroll `MessagesList` back and forth 5 times
+    Then I wait until `ChatView` is present
@@ -20,12 +20,24 @@ import 'dart:async';
 import 'package:gherkin/gherkin.dart';
 import 'package:integration_test/integration_test.dart';
 import 'package:messenger/config.dart';
+import 'package:messenger/util/linux_utils.dart';
 
 /// [Hook] gathering performance results of a test.
 ///
 /// Results are embedded into the
 /// [IntegrationTestWidgetsFlutterBinding.reportData] after all the tests run.
+///
+/// On Linux the [FrameTimings] of the window recorded natively by the steps
+/// measuring the frame pacing are gathered as well, as the timelines traced
+/// don't cover the frames being presented.
 class PerformanceHook extends Hook {
+  /// [FrameTimings] of the current scenario recorded by its steps measuring
+  /// the frame pacing, e.g. the scrolling ones, if any.
+  ///
+  /// Recorded by the steps themselves, so that the signing in and navigating
+  /// done by the scenario before aren't measured.
+  static FrameTimings? frameTimings;
+
   /// [Completer] measuring the performance between [onBeforeScenario] and
   /// [onAfterScenario].
   Completer? _completer;
@@ -40,6 +52,9 @@ class PerformanceHook extends Hook {
   /// don't want to lose the performance stats.
   final Map<String, dynamic> _data = {};
 
+  /// [FrameTimings] of the scenarios in JSON, identified by their names.
+  final Map<String, dynamic> _frames = {};
+
   @override
   int get priority => 0;
 
@@ -54,6 +69,7 @@ class PerformanceHook extends Hook {
     }
 
     _completer = Completer();
+    frameTimings = null;
 
     _futures.add(
       IntegrationTestWidgetsFlutterBinding.instance.traceAction(
@@ -72,6 +88,11 @@ class PerformanceHook extends Hook {
     _completer?.complete();
     _completer = null;
 
+    if (frameTimings != null) {
+      _frames[scenario.asPath] = frameTimings!.toJson();
+      frameTimings = null;
+    }
+
     // [_futures] aren't removed, because already completed [Future]s aren't
     // awaited at all, causing no microtask and no async code.
     await Future.wait(_futures);
@@ -88,6 +109,11 @@ class PerformanceHook extends Hook {
       IntegrationTestWidgetsFlutterBinding.instance.reportData?['level'] =
           Config.logLevel.index;
     }
+
+    if (_frames.isNotEmpty) {
+      IntegrationTestWidgetsFlutterBinding.instance.reportData?['frames'] =
+          _frames;
+    }
   }
 }
 
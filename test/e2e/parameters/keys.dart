@@ -133,6 +133,7 @@ enum WidgetKey {
   MenuListView,
   MenuTab,
   MessageField,
+  MessagesList,
   MonologButton,
   MoreButton,
   MuteButton,
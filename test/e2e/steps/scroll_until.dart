@@ -22,8 +22,12 @@ import 'package:flutter_gherkin/flutter_gherkin.dart';
 import 'package:flutter_gherkin/flutter_gherkin_with_driver.dart';
 import 'package:flutter_test/flutter_test.dart';
 import 'package:gherkin/gherkin.dart';
+import 'package:integration_test/integration_test.dart';
+import 'package:messenger/util/linux_utils.dart';
+import 'package:messenger/util/platform_utils.dart';
 
 import '../configuration.dart';
+import '../hook/performance.dart';
 import '../parameters/keys.dart';
 import '../world/custom_world.dart';
 
@@ -99,6 +103,78 @@ final StepDefinitionGeneric<CustomWorld> scrollToTop =
       await _scrollScrollableTo(key, context, (_) => 0);
     });
 
+/// Scrolls the provided [Scrollable] to its end and back with an animation
+/// the specified number of times, rendering every frame requested, so the
+/// frame pacing of the scrolling is measured.
+///
+/// On Linux the [FrameTimings] of the scrolling only are recorded into the
+/// [PerformanceHook.frameTimings].
+///
+/// Examples:
+/// - When I scroll `MessagesList` back and forth 5 times
+final StepDefinitionGeneric<CustomWorld> scrollBackAndForth =
+    when2<WidgetKey, int, CustomWorld>(
+      RegExp(r'I scroll {key} back and forth {int} times'),
+      (WidgetKey key, int times, StepContext<CustomWorld> context) async {
+        await context.world.appDriver.waitForAppToSettle();
+
+        final Finder scrollable = find.descendant(
+          of: find.byKey(Key(key.name)),
+          matching: find.byWidgetPredicate((widget) {
+            if (widget is Scrollable) {
+              return widget.restorationId == null;
+            }
+            return false;
+          }),
+        );
+
+        final IntegrationTestWidgetsFlutterBinding binding =
+            IntegrationTestWidgetsFlutterBinding.instance;
+
+        // Frames are only rendered when pumped otherwise.
+        final LiveTestWidgetsFlutterBindingFramePolicy policy =
+            binding.framePolicy;
+        binding.framePolicy =
+            LiveTestWidgetsFlutterBindingFramePolicy.fullyLive;
+
+        final bool recorded = PlatformUtils.isLinux && !PlatformUtils.isWeb;
+        if (recorded) {
+          await LinuxUtils.resetFrameTimings();
+        }
+
+        try {
+          for (int i = 0; i < times * 2; ++i) {
+            final ScrollableState state =
+                context.world.appDriver.nativeDriver.state(scrollable.first)
+                    as ScrollableState;
+            final ScrollPosition position = state.position;
+
+            final double to = i.isEven
+                ? position.maxScrollExtent
+                : position.minScrollExtent;
+
+            // Scrolled with the speed of a fast swipe.
+            final double distance = (to - position.pixels).abs();
+            await position.animateTo(
+              to,
+              duration: Duration(milliseconds: max(300, distance ~/ 3)),
+              curve: Curves.easeInOut,
+            );
+          }
+
+          if (recorded) {
+            PerformanceHook.frameTimings = await LinuxUtils.frameTimings();
+          }
+        } finally {
+          binding.framePolicy = policy;
+        }
+
+        await context.world.appDriver.waitForAppToSettle();
+      },
+      configuration: StepDefinitionConfiguration()
+        ..timeout = const Duration(minutes: 5),
+    );
+
 /// Scrolls the [Scrollable] identified by its [key] to the specified in the
 /// [getPosition] position.
 Future<void> _scrollScrollableTo(
@@ -0,0 +1,192 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+import 'dart:collection';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:messenger/ui/worker/cache.dart';
+import 'package:messenger/util/platform_utils.dart';
+
+import '../mock/platform_utils.dart';
+
+void main() async {
+  TestWidgetsFlutterBinding.ensureInitialized();
+  PlatformUtils = _LinuxPlatformUtilsMock();
+
+  final Directory cache = (await PlatformUtils.cacheDirectory)!;
+  final _CacheIndexMock index = _CacheIndexMock(cache);
+
+  TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+      .setMockMethodCallHandler(
+        const MethodChannel('team113.flutter.dev/linux_utils'),
+        index.handle,
+      );
+
+  setUp(() {
+    if (cache.existsSync()) {
+      cache.deleteSync(recursive: true);
+    }
+    cache.createSync(recursive: true);
+
+    index.reset();
+  });
+
+  tearDownAll(() => cache.deleteSync(recursive: true));
+
+  test('CacheWorker touches the files it returns in the index', () async {
+    final CacheWorker worker = CacheWorker(null, null);
+    await worker.onInit();
+
+    await worker.add(Uint8List(10), 'first');
+    await worker.add(Uint8List(10), 'second');
+    expect(index.entries.keys, ['first', 'second']);
+
+    await worker.get(checksum: 'first');
+    expect(index.entries.keys, ['second', 'first']);
+
+    worker.onClose();
+  });
+
+  test('CacheWorker evicts the least recently used files', () async {
+    final CacheWorker worker = CacheWorker(null, null);
+    await worker.onInit();
+    await worker.setMaxSize(1000);
+
+    await worker.add(Uint8List(300), 'first');
+    await worker.add(Uint8List(300), 'second');
+    await worker.add(Uint8List(300), 'third');
+    await worker.get(checksum: 'first');
+
+    await worker.add(Uint8List(300), 'fourth');
+    await worker.ensureOptimized();
+
+    expect(index.entries.keys, ['third', 'first', 'fourth']);
+    expect(worker.hashes, {'first', 'third', 'fourth'});
+    expect(worker.info.value.size, 900);
+    expect(File('${cache.path}/second').existsSync(), false);
+
+    worker.onClose();
+  });
+
+  test('CacheWorker keeps working when the index fails', () async {
+    final CacheWorker worker = CacheWorker(null, null);
+    await worker.onInit();
+
+    await worker.add(Uint8List.fromList([1, 2, 3]), 'first');
+    index.failing = true;
+
+    final CacheEntry entry = await worker.get(checksum: 'first');
+    expect(entry.bytes, [1, 2, 3]);
+
+    final File? file = await worker.add(Uint8List(10), 'second');
+    expect(file?.existsSync(), true);
+    expect(worker.hashes, {'first', 'second'});
+    expect(worker.info.value.size, 13);
+
+    worker.onClose();
+
+    // Let the failed `closeCacheIndex` complete, as its error must not escape.
+    await Future.delayed(Duration.zero);
+    expect(index.calls, contains('closeCacheIndex'));
+  });
+}
+
+/// [PlatformUtilsMock] reporting to be on Linux, so the native cache index is
+/// used regardless of the platform the tests are run on.
+class _LinuxPlatformUtilsMock extends PlatformUtilsMock {
+  _LinuxPlatformUtilsMock() : super(cache: 'test/.temp_cache_index');
+
+  @override
+  bool get isLinux => true;
+}
+
+/// Mock of the native cache index of the Linux runner.
+class _CacheIndexMock {
+  _CacheIndexMock(this.directory);
+
+  /// Directory of the indexed files.
+  final Directory directory;
+
+  /// Sizes of the indexed files from the least to the most recently used.
+  final LinkedHashMap<String, int> entries = LinkedHashMap();
+
+  /// Names of the methods called.
+  final List<String> calls = [];
+
+  /// Indicator whether the methods should fail.
+  bool failing = false;
+
+  /// Empties this index.
+  void reset() {
+    entries.clear();
+    calls.clear();
+    failing = false;
+  }
+
+  /// Handles the [call] of the `team113.flutter.dev/linux_utils` channel.
+  Future<Object?> handle(MethodCall call) async {
+    calls.add(call.method);
+
+    if (failing) {
+      throw PlatformException(code: 'INDEX_ERROR');
+    }
+
+    final Map? args = call.arguments as Map?;
+
+    switch (call.method) {
+      case 'openCacheIndex':
+        return {'size': _size, 'checksums': entries.keys.toList()};
+
+      case 'touchCache':
+        final int? size = entries.remove(args!['checksum']);
+        if (size == null) {
+          return false;
+        }
+
+        entries[args['checksum']] = size;
+        return true;
+
+      case 'addCache':
+        entries[args!['checksum']] = args['size'];
+        return _size;
+
+      case 'evictCacheIndex':
+        final List<String> removed = [];
+
+        int freed = 0;
+        while (freed < args!['target'] && entries.isNotEmpty) {
+          final String checksum = entries.keys.first;
+          freed += entries.remove(checksum)!;
+          removed.add(checksum);
+          File('${directory.path}/$checksum').deleteSync();
+        }
+
+        return {'size': _size, 'removed': removed};
+
+      case 'closeCacheIndex':
+        return null;
+    }
+
+    throw MissingPluginException();
+  }
+
+  /// Returns the total size of the indexed files.
+  int get _size => entries.values.fold(0, (a, b) => a + b);
+}
@@ -0,0 +1,177 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+
+import 'dart:convert';
+
+import 'package:drift/drift.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:messenger/provider/drift/drift.dart';
+import 'package:messenger/util/platform_utils.dart';
+
+void main() async {
+  PlatformUtils = _LinuxPlatformUtils();
+
+  // `messenger` tokenizer is only registered by the Linux runner, while the
+  // built-in one folds the case and diacritics the same way.
+  ScopedDatabase.searchTokenizer = 'unicode61 remove_diacritics 2';
+
+  late ScopedDatabase db;
+
+  setUp(() => db = ScopedDriftProvider.memory().db!);
+  tearDown(() => db.close());
+
+  /// Inserts the `chat_items` with the provided [id] and [text].
+  Future<void> insert(String id, String? text) async {
+    await db.customStatement(
+      ''
+      'INSERT INTO chat_items(id, chat_id, author_id, at, status, data, ver) '
+      "VALUES (?, 'chat', 'me', 0, 0, ?, '0');",
+      [
+        id,
+        json.encode({
+          'value': {'text': text, 'attachments': []},
+        }),
+      ],
+    );
+  }
+
+  /// Returns the IDs of the `chat_items` matched by the [query].
+  Future<List<String>> search(String query) async {
+    final String? match = db.matchChatItems(query, '%"text":"%$query%"%');
+    expect(match, isNotNull);
+
+    final List<QueryRow> rows = await db
+        .customSelect('SELECT id FROM chat_items WHERE $match ORDER BY id;')
+        .get();
+
+    return rows.map((e) => e.read<String>('id')).toList();
+  }
+
+  /// Returns the number of the `chat_items` pending to be indexed.
+  Future<int> pending() async {
+    final QueryRow row = await db
+        .customSelect('SELECT count(*) AS c FROM chat_items_fts_pending;')
+        .getSingle();
+
+    return row.read<int>('c');
+  }
+
+  test('ScopedDatabase queues the inserted ChatItems to be indexed', () async {
+    await insert('1', 'Meeting tomorrow');
+    await insert('2', 'Reunión mañana');
+    await insert('3', null);
+
+    expect(db.searchable, true);
+    expect(await pending(), 3);
+
+    // Pending ones are matched by the substrings.
+    expect(await search('eeting'), ['1']);
+    expect(await search('reunion'), []);
+
+    expect(await db.indexChatItems(), 3);
+    expect(await pending(), 0);
+    expect(await db.indexChatItems(), 0);
+
+    // Indexed ones are matched by the word prefixes.
+    expect(await search('meet'), ['1']);
+    expect(await search('eeting'), []);
+    expect(await search('reunion'), ['2']);
+    expect(await search('MAÑ'), ['2']);
+    expect(await search('meeting mañana'), []);
+  });
+
+  test('ScopedDatabase indexes the most recent ChatItems first', () async {
+    await insert('1', 'first meeting');
+    await insert('2', 'second meeting');
+    await insert('3', 'third meeting');
+
+    expect(await db.indexChatItems(2), 2);
+    expect(await pending(), 1);
+
+    // Rest are still matched, but by the substrings.
+    expect(await search('meeting'), ['1', '2', '3']);
+    expect(await search('irst'), ['1']);
+    expect(await search('hird'), []);
+
+    expect(await db.indexChatItems(2), 1);
+    expect(await search('irst'), []);
+    expect(await search('first'), ['1']);
+  });
+
+  test('ScopedDatabase re-indexes the updated ChatItems', () async {
+    await insert('1', 'Meeting tomorrow');
+    await insert('2', 'Meeting today');
+    await db.indexChatItems();
+
+    await db.customStatement(
+      'UPDATE chat_items SET data = ? WHERE id = ?;',
+      [
+        json.encode({
+          'value': {'text': 'Lunch tomorrow', 'attachments': []},
+        }),
+        '1',
+      ],
+    );
+    expect(await pending(), 1);
+
+    // Old text is removed from the index right away.
+    expect(await search('meeting'), ['2']);
+    expect(await search('lunch'), ['1']);
+
+    await db.indexChatItems();
+    expect(await search('meeting'), ['2']);
+    expect(await search('lunch'), ['1']);
+    expect(await search('tomorrow'), ['1']);
+
+    // Updates not changing the text aren't queued.
+    await db.customStatement(
+      "UPDATE chat_items SET ver = '1', cursor = 'cursor' WHERE id = '2';",
+    );
+    expect(await pending(), 0);
+  });
+
+  test('ScopedDatabase removes the deleted ChatItems', () async {
+    await insert('1', 'Meeting tomorrow');
+    await insert('2', 'Meeting today');
+    await db.indexChatItems();
+    await insert('3', 'Meeting later');
+
+    await db.customStatement("DELETE FROM chat_items WHERE id IN ('1', '3');");
+    expect(await pending(), 0);
+
+    expect(await search('meeting'), ['2']);
+    expect(await search('tomorrow'), []);
+    expect(await search('later'), []);
+
+    // Contentless index would return the deleted ones, if not removed.
+    final QueryRow row = await db
+        .customSelect(
+          'SELECT count(*) AS c FROM chat_items_fts WHERE chat_items_fts '
+          "MATCH 'tomorrow';",
+        )
+        .getSingle();
+    expect(row.read<int>('c'), 0);
+  });
+}
+
+/// [PlatformUtilsImpl] reporting to be on Linux, so the search index is
+/// created.
+class _LinuxPlatformUtils extends PlatformUtilsImpl {
+  @override
+  bool get isLinux => true;
+}
@@ -0,0 +1,104 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+
+import 'dart:io';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:messenger/ui/worker/cache.dart';
+import 'package:messenger/util/platform_utils.dart';
+
+void main() async {
+  TestWidgetsFlutterBinding.ensureInitialized();
+  PlatformUtils = _LinuxPlatformUtils();
+  CacheWorker(null, null);
+
+  final Directory directory = Directory('test/.temp_download_checksum');
+  final File file = File('${directory.path}/file');
+
+  // SHA-256 the native download reports.
+  String sha256 = '';
+
+  TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+      .setMockMethodCallHandler(
+        const MethodChannel('team113.flutter.dev/linux_utils'),
+        (MethodCall call) async {
+          if (call.method == 'download') {
+            await File(call.arguments['path']).writeAsBytes([1, 2, 3]);
+            return {'sha256': sha256};
+          }
+
+          throw MissingPluginException();
+        },
+      );
+
+  setUp(() => directory.createSync(recursive: true));
+  tearDown(() => directory.deleteSync(recursive: true));
+
+  test(
+    'PlatformUtils.download() keeps the file matching the checksum',
+    () async {
+      sha256 = 'checksum';
+
+      final File? result = await PlatformUtils.download(
+        'http://localhost/file',
+        'file',
+        3,
+        path: file.path,
+        checksum: 'checksum',
+      );
+
+      expect(result?.path, file.path);
+      expect(file.existsSync(), true);
+    },
+  );
+
+  test(
+    'PlatformUtils.download() deletes the file mismatching the checksum',
+    () async {
+      sha256 = 'corrupted';
+
+      await expectLater(
+        PlatformUtils.download(
+          'http://localhost/file',
+          'file',
+          3,
+          path: file.path,
+          checksum: 'checksum',
+        ),
+        throwsA(
+          isA<ChecksumMismatchException>()
+              .having((e) => e.expected, 'expected', 'checksum')
+              .having((e) => e.actual, 'actual', 'corrupted'),
+        ),
+      );
+
+      expect(file.existsSync(), false);
+    },
+  );
+}
+
+/// [PlatformUtilsImpl] reporting to be on Linux, so the files are downloaded
+/// through the mocked native downloading.
+class _LinuxPlatformUtils extends PlatformUtilsImpl {
+  @override
+  bool get isLinux => true;
+
+  @override
+  Future<String> get userAgent async => 'messenger';
+}
@@ -0,0 +1,242 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'package:dio/dio.dart';
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:messenger/util/json_tape.dart';
+
+void main() async {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  final Map<String, dynamic> json = {
+    'null': null,
+    'false': false,
+    'true': true,
+    'int': -9007199254740993,
+    'double': 1.5e-7,
+    'string': 'Сообщение "в кавычках" 😀',
+    'empty': '',
+    'array': [
+      1,
+      [2, 3],
+      {'a': []},
+      'b',
+    ],
+    'object': {
+      'nested': {'c': {}},
+      'd': 4,
+    },
+    'last': 'value',
+  };
+
+  test('JsonTape reads the values of the tape', () {
+    expect(JsonTape(_tape(json)).root, json);
+    expect(JsonTape(_tape([])).root, []);
+    expect(JsonTape(_tape('root')).root, 'root');
+    expect(JsonTape(_tape(null)).root, null);
+  });
+
+  test('JsonTape creates the values only once accessed', () {
+    final Uint8List bytes = _tape(json);
+
+    // Corrupts the type of the `2` within the `array`, which is the 19th
+    // node, so reading its array throws, while the rest are still readable.
+    bytes[8 + 19 * 16] = 0xFF;
+
+    final Map tape = JsonTape(bytes).root as Map;
+    expect(tape['object'], json['object']);
+    expect(tape['last'], 'value');
+
+    final List array = tape['array'];
+    expect(array.length, 4);
+    expect(array[0], 1);
+    expect(array[3], 'b');
+    expect(() => (array[1] as List).length, throwsRangeError);
+
+    // Values are created once and kept.
+    expect(identical(tape['object'], tape['object']), true);
+    expect(identical(array[1], array[1]), true);
+  });
+
+  test('JsonTape views are modifiable', () {
+    final Map tape = JsonTape(_tape(json)).root as Map;
+
+    tape['int'] = 0;
+    expect(tape['int'], 0);
+    expect(tape.remove('string'), json['string']);
+    expect(tape.containsKey('string'), false);
+    expect(tape.length, json.length - 1);
+
+    final List array = tape['array'];
+    array.add(5);
+    array[0] = 0;
+    expect(array, [
+      0,
+      [2, 3],
+      {'a': []},
+      'b',
+      5,
+    ]);
+
+    tape.clear();
+    expect(tape, {});
+  });
+
+  group('JsonTapeTransformer', () {
+    final Uint8List bytes = utf8.encode(jsonEncode(json));
+
+    // Status of the replies to the bulk requests, `3` meaning a failure.
+    int status = 0;
+
+    // Number of the JSON documents parsed over the bulk channel.
+    int parsed = 0;
+
+    setUp(() {
+      status = 0;
+      parsed = 0;
+
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+          .setMockMessageHandler('team113.flutter.dev/linux_utils/bulk', (
+            ByteData? message,
+          ) async {
+            ++parsed;
+
+            final Uint8List request = Uint8List.sublistView(message!);
+            final Uint8List tape = status == 0
+                ? _tape(jsonDecode(utf8.decode(request.sublist(8))))
+                : Uint8List(0);
+
+            final Uint8List reply = Uint8List(8 + tape.length);
+            ByteData.sublistView(reply)
+              ..setUint32(0, message.getUint32(0, Endian.host), Endian.host)
+              ..setUint32(4, status, Endian.host);
+            reply.setRange(8, reply.length, tape);
+
+            return ByteData.sublistView(reply);
+          });
+    });
+
+    test('parses the responses from the threshold natively', () async {
+      final Object? result = await JsonTapeTransformer(
+        threshold: bytes.length,
+      ).transformResponse(_options(), _body(bytes));
+
+      expect(parsed, 1);
+      expect(result, json);
+    });
+
+    test('decodes the responses below the threshold in Dart', () async {
+      final Object? result = await JsonTapeTransformer(
+        threshold: bytes.length + 1,
+      ).transformResponse(_options(), _body(bytes));
+
+      expect(parsed, 0);
+      expect(result, json);
+    });
+
+    test(
+      'throws the FormatException, if the response is malformed',
+      () async {
+        status = 3;
+
+        await expectLater(
+          JsonTapeTransformer(
+            threshold: 0,
+          ).transformResponse(_options(), _body(utf8.encode('{"a": ]'))),
+          throwsFormatException,
+        );
+        expect(parsed, 1);
+      },
+    );
+  });
+}
+
+/// Returns the [RequestOptions] of the JSON request.
+RequestOptions _options() => RequestOptions(responseType: ResponseType.json);
+
+/// Returns the [ResponseBody] of the JSON response of the [bytes].
+ResponseBody _body(Uint8List bytes) {
+  return ResponseBody.fromBytes(
+    bytes,
+    200,
+    headers: {
+      Headers.contentTypeHeader: [Headers.jsonContentType],
+    },
+  );
+}
+
+/// Returns the [JsonTape] bytes of the [json], laid out as the runner does.
+Uint8List _tape(Object? json) {
+  // Type, length and value of each of the nodes.
+  final List<List<int>> nodes = [];
+  final BytesBuilder strings = BytesBuilder();
+
+  void addString(String string) {
+    final Uint8List bytes = utf8.encode(string);
+    nodes.add([5, bytes.length, strings.length]);
+    strings.add(bytes);
+  }
+
+  void add(Object? value) {
+    if (value == null) {
+      nodes.add([0, 0, 0]);
+    } else if (value is bool) {
+      nodes.add([value ? 2 : 1, 0, 0]);
+    } else if (value is int) {
+      nodes.add([3, 0, value]);
+    } else if (value is double) {
+      final ByteData bits = ByteData(8)..setFloat64(0, value, Endian.host);
+      nodes.add([4, 0, bits.getInt64(0, Endian.host)]);
+    } else if (value is String) {
+      addString(value);
+    } else if (value is List) {
+      final List<int> node = [6, value.length, 0];
+      nodes.add(node);
+      value.forEach(add);
+      node[2] = nodes.length;
+    } else if (value is Map) {
+      final List<int> node = [7, value.length, 0];
+      nodes.add(node);
+      value.forEach((key, value) {
+        addString(key);
+        add(value);
+      });
+      node[2] = nodes.length;
+    }
+  }
+
+  add(json);
+
+  final Uint8List bytes = Uint8List(8 + nodes.length * 16 + strings.length);
+  final ByteData data = ByteData.sublistView(bytes)
+    ..setUint32(0, nodes.length, Endian.host)
+    ..setUint32(4, strings.length, Endian.host);
+
+  for (int i = 0; i < nodes.length; ++i) {
+    data
+      ..setUint8(8 + i * 16, nodes[i][0])
+      ..setUint32(8 + i * 16 + 4, nodes[i][1], Endian.host)
+      ..setInt64(8 + i * 16 + 8, nodes[i][2], Endian.host);
+  }
+  bytes.setRange(8 + nodes.length * 16, bytes.length, strings.takeBytes());
+
+  return bytes;
+}
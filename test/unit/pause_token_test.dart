@@ -0,0 +1,99 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:messenger/util/linux_utils.dart';
+import 'package:messenger/util/pause_token.dart';
+
+void main() async {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  test('PauseToken reports only the changes of its state', () {
+    final PauseToken token = PauseToken();
+    final List<bool> changes = [];
+    token.changes.listen(changes.add);
+
+    expect(token.isPaused, false);
+
+    token.pause();
+    token.pause();
+    expect(token.isPaused, true);
+
+    token.resume();
+    token.resume();
+    expect(token.isPaused, false);
+
+    expect(changes, [true, false]);
+  });
+
+  test(
+    'LinuxUtils.upload() pauses and resumes the upload by the PauseToken',
+    () async {
+      final List<MethodCall> calls = [];
+      final Completer<Map> uploaded = Completer();
+
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+          .setMockMethodCallHandler(
+            const MethodChannel('team113.flutter.dev/linux_utils'),
+            (MethodCall call) async {
+              calls.add(call);
+              return call.method == 'upload' ? uploaded.future : null;
+            },
+          );
+
+      final PauseToken token = PauseToken()..pause();
+      final Future<NativeUpload> upload = LinuxUtils.upload(
+        'http://localhost/upload',
+        'file',
+        pauseToken: token,
+      );
+      await Future.delayed(Duration.zero);
+
+      // Upload paused beforehand is started paused.
+      expect(calls.single.method, 'upload');
+      expect(calls.single.arguments['paused'], true);
+      final int id = calls.single.arguments['id'];
+
+      token.resume();
+      token.pause();
+      await Future.delayed(Duration.zero);
+
+      expect(calls.skip(1).map((e) => (e.method, e.arguments['id'])), [
+        ('resumeUpload', id),
+        ('pauseUpload', id),
+      ]);
+
+      uploaded.complete({
+        'status': 200,
+        'response': Uint8List(0),
+        'sha256': 'checksum',
+        'mime': 'image/png',
+        'size': 3,
+      });
+      expect((await upload).sha256, 'checksum');
+
+      // The token isn't listened to once the upload is done.
+      token.resume();
+      await Future.delayed(Duration.zero);
+      expect(calls.length, 3);
+    },
+  );
+}
@@ -0,0 +1,221 @@
+// Copyright © 2022-2026 IT ENGINEERING MANAGEMENT INC,
+//                       <https://github.com/team113>
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License v3.0 as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License v3.0 for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License v3.0
+// along with this program. If not, see
+// <https://www.gnu.org/licenses/agpl-3.0.html>.
+
+
+import 'dart:io';
+
+import 'package:dio/dio.dart';
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:messenger/ui/worker/upgrade.dart';
+import 'package:messenger/util/platform_utils.dart';
+import 'package:xml/xml.dart';
+
+import '../mock/platform_utils.dart';
+
+void main() async {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  final _LinuxPlatformUtilsMock platform = _LinuxPlatformUtilsMock();
+  PlatformUtils = platform;
+
+  final Directory temporary = await platform.temporaryDirectory;
+  final File patch = File('${temporary.path}/messenger-linux-1.2.3.delta');
+
+  // Errors the mocked native methods throw, if any.
+  PlatformException? downloadError;
+  PlatformException? patchError;
+
+  TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+      .setMockMethodCallHandler(
+        const MethodChannel('team113.flutter.dev/linux_utils'),
+        (MethodCall call) async {
+          switch (call.method) {
+            case 'download':
+              if (downloadError != null) {
+                throw downloadError!;
+              }
+
+              await File(call.arguments['path']).writeAsBytes([1, 2, 3]);
+              return {'sha256': ''};
+
+            case 'applyDeltaPatch':
+              if (patchError != null) {
+                throw patchError!;
+              }
+
+              return '';
+          }
+
+          throw MissingPluginException();
+        },
+      );
+
+  setUp(() {
+    downloadError = null;
+    patchError = null;
+    platform.reset();
+  });
+
+  tearDownAll(() {
+    if (temporary.existsSync()) {
+      temporary.deleteSync(recursive: true);
+    }
+  });
+
+  test('Release.fromXml() parses the deltas of its artifacts', () {
+    final XmlDocument document = XmlDocument.parse('''
+<rss version="2.0" xmlns:sparkle="http://www.andymatuschak.org/xml-namespaces/sparkle">
+  <channel>
+    <item>
+      <title>v1.2.4</title>
+      <pubDate>Fri, 26 Apr 2024 09:43:16 +0000</pubDate>
+      <enclosure sparkle:os="macos" url="messenger-macos.zip" />
+      <enclosure sparkle:os="linux" url="messenger-linux.zip" />
+      <sparkle:deltas>
+        <enclosure
+          sparkle:os="linux"
+          sparkle:deltaFrom="v1.2.3"
+          url="messenger-linux-1.2.3.delta"
+          sha256="abc"
+        />
+        <enclosure
+          sparkle:os="linux"
+          sparkle:deltaFrom="1.2.2"
+          url="messenger-linux-1.2.2.delta"
+        />
+      </sparkle:deltas>
+    </item>
+  </channel>
+</rss>
+''');
+
+    final Release release = Release.fromXml(
+      document.findAllElements('item').first,
+    );
+
+    expect(release.name, '1.2.4');
+    expect(release.assets.map((e) => e.os), ['macos', 'linux']);
+    expect(release.assets.first.deltas, isEmpty);
+    expect(release.assets.last.deltas, const [
+      ReleaseDelta(
+        url: 'messenger-linux-1.2.3.delta',
+        os: 'linux',
+        from: '1.2.3',
+        sha256: 'abc',
+      ),
+      ReleaseDelta(
+        url: 'messenger-linux-1.2.2.delta',
+        os: 'linux',
+        from: '1.2.2',
+      ),
+    ]);
+  });
+
+  test('ReleaseDownload downloads in full if the delta fails', () async {
+    patchError = PlatformException(code: 'PATCH_ERROR');
+
+    final ReleaseDownload download = _download();
+    await download.start();
+
+    expect(download.file.value, null);
+    expect(platform.downloads, ['messenger-linux.zip']);
+    expect(patch.existsSync(), false);
+  });
+
+  test('ReleaseDownload downloads in full on any other exception', () async {
+    platform.downloadsError = const FileSystemException('Read-only');
+
+    final ReleaseDownload download = _download();
+    await download.start();
+
+    expect(platform.downloads, ['messenger-linux.zip']);
+    expect(patch.existsSync(), false);
+  });
+
+  test('ReleaseDownload stops once the delta is cancelled', () async {
+    downloadError = PlatformException(code: 'CANCELLED');
+
+    final ReleaseDownload download = _download();
+    await expectLater(download.start(), throwsA(isA<DioException>()));
+
+    expect(platform.downloads, isEmpty);
+  });
+}
+
+/// Returns a [ReleaseDownload] of the Linux artifact having a delta.
+ReleaseDownload _download() {
+  return ReleaseDownload(
+    'messenger-linux.zip',
+    delta: const ReleaseDelta(
+      url: 'messenger-linux-1.2.3.delta',
+      os: 'linux',
+      from: '1.2.3',
+    ),
+  );
+}
+
+/// [PlatformUtilsMock] reporting to be on Linux and recording the full
+/// [downloads].
+class _LinuxPlatformUtilsMock extends PlatformUtilsMock {
+  /// URLs of the files downloaded in full.
+  final List<String> downloads = [];
+
+  /// [Exception] to throw on accessing the [downloadsDirectory], if any.
+  Exception? downloadsError;
+
+  /// Forgets the [downloads] and the [downloadsError].
+  void reset() {
+    downloads.clear();
+    downloadsError = null;
+  }
+
+  @override
+  bool get isLinux => true;
+
+  @override
+  Future<String> get userAgent async => 'messenger';
+
+  @override
+  Future<Directory> get temporaryDirectory async =>
+      Directory('test/.temp_release_delta');
+
+  @override
+  Future<Directory> get downloadsDirectory async {
+    if (downloadsError != null) {
+      throw downloadsError!;
+    }
+
+    return Directory('test/.temp_release_delta/downloads');
+  }
+
+  @override
+  Future<File?> download(
+    String url,
+    String filename,
+    int? size, {
+    String? path,
+    String? checksum,
+    Function(int count, int total)? onReceiveProgress,
+    CancelToken? cancelToken,
+    bool temporary = false,
+    int retries = 5,
+  }) async {
+    downloads.add(url);
+    return null;
+  }
+}
@@ -42,6 +42,8 @@ Future<void> main() {
       // isn't possible due to Flutter imports happening in [Config].
       final int? level = data?['level'] is int ? data!['level'] as int : null;
 
+      const String directory = 'test/e2e/reports';
+
       final Map<String, dynamic> traces = data?['traces'] ?? {};
       for (var e in traces.entries) {
         if (e.value is! Map<String, dynamic>) {
@@ -56,8 +58,6 @@ Future<void> main() {
         // and understand.
         final summary = TimelineSummary.summarize(timeline);
 
-        const String directory = 'test/e2e/reports';
-
         // Write the whole [Timeline] to the disk, if [Config.logLevel] is or
         // bigger than [LogLevel.trace].
         //
@@ -79,6 +79,18 @@ Future<void> main() {
           );
         }
       }
+
+      // Frame timings recorded natively by the window, containing the p50,
+      // p99 and p99.9 of the intervals between the frames for tracking the
+      // regressions of the frame pacing.
+      final Map<String, dynamic> frames = data?['frames'] ?? {};
+      for (var e in frames.entries) {
+        await fs.directory(directory).create(recursive: true);
+        final File file = fs.file('$directory/${e.key}.frame_timings.json');
+        await file.writeAsString(
+          const JsonEncoder.withIndent('  ').convert(e.value),
+        );
+      }
     },
   );
 }